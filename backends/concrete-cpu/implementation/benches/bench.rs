@@ -1,3 +1,9 @@
+use concrete_cpu::c_api::keyswitch::{
+    concrete_cpu_keyswitch_key_size_u32, concrete_cpu_keyswitch_key_size_u64,
+    concrete_cpu_keyswitch_lwe_ciphertext_u64,
+    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key,
+    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch,
+};
 use concrete_cpu::c_api::linear_op::{
     concrete_cpu_add_lwe_ciphertext_u64, concrete_cpu_add_plaintext_lwe_ciphertext_u64,
     concrete_cpu_mul_cleartext_lwe_ciphertext_u64, concrete_cpu_negate_lwe_ciphertext_u64,
@@ -61,6 +67,80 @@ pub fn criterion_benchmark(c: &mut Criterion) {
             });
         });
     }
+
+    let (level, base_log) = (3, 4);
+    for (input_dimension, output_dimension) in [(2048, 750), (4096, 850)] {
+        c.bench_function(
+            &format!("keyswitch-lwe-ciphertext-u64-{input_dimension}-{output_dimension}"),
+            |b| {
+                let ksk = vec![
+                    0_u64;
+                    unsafe {
+                        concrete_cpu_keyswitch_key_size_u64(
+                            level,
+                            input_dimension,
+                            output_dimension,
+                        )
+                    }
+                ];
+                let mut out = vec![0_u64; output_dimension + 1];
+                let ct0 = vec![0_u64; input_dimension + 1];
+                b.iter(|| unsafe {
+                    concrete_cpu_keyswitch_lwe_ciphertext_u64(
+                        out.as_mut_ptr(),
+                        ct0.as_ptr(),
+                        ksk.as_ptr(),
+                        level,
+                        base_log,
+                        input_dimension,
+                        output_dimension,
+                    );
+                });
+            },
+        );
+
+        c.bench_function(
+            &format!("keyswitch-lwe-ciphertext-u32-key-{input_dimension}-{output_dimension}"),
+            |b| {
+                let ksk = vec![
+                    0_u32;
+                    unsafe {
+                        concrete_cpu_keyswitch_key_size_u32(
+                            level,
+                            input_dimension,
+                            output_dimension,
+                        )
+                    }
+                ];
+                let mut out = vec![0_u64; output_dimension + 1];
+                let ct0 = vec![0_u64; input_dimension + 1];
+                let mut stack_size = 0;
+                let mut stack_align = 0;
+                unsafe {
+                    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch(
+                        &mut stack_size,
+                        &mut stack_align,
+                        input_dimension,
+                        output_dimension,
+                    );
+                }
+                let mut stack = vec![0_u32; stack_size / 4 + 1];
+                b.iter(|| unsafe {
+                    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key(
+                        out.as_mut_ptr(),
+                        ct0.as_ptr(),
+                        ksk.as_ptr(),
+                        level,
+                        base_log,
+                        input_dimension,
+                        output_dimension,
+                        stack.as_mut_ptr() as *mut u8,
+                        stack_size,
+                    );
+                });
+            },
+        );
+    }
 }
 
 criterion_group!(benches, criterion_benchmark);
@@ -0,0 +1,234 @@
+// Measures the cost of the keyswitch, bootstrap and levelled operations over a grid of
+// parameters, and writes the cost profile of the machine used by the concrete-optimizer cpu
+// cost model.
+//
+// Usage: cargo run --release --example calibrate_cost_model -- <profile path>
+
+use std::alloc::{alloc_zeroed, dealloc, Layout};
+use std::fs::File;
+use std::io::Write;
+use std::time::{Duration, Instant};
+
+use concrete_cpu::c_api::bootstrap::{
+    concrete_cpu_bootstrap_lwe_ciphertext_u64, concrete_cpu_bootstrap_lwe_ciphertext_u64_scratch,
+    concrete_cpu_fourier_bootstrap_key_size_u64,
+};
+use concrete_cpu::c_api::fft::{
+    concrete_cpu_construct_concrete_fft, concrete_cpu_destroy_concrete_fft, Fft,
+    CONCRETE_FFT_ALIGN, CONCRETE_FFT_SIZE,
+};
+use concrete_cpu::c_api::keyswitch::{
+    concrete_cpu_keyswitch_key_size_u64, concrete_cpu_keyswitch_lwe_ciphertext_u64,
+};
+use concrete_cpu::c_api::linear_op::concrete_cpu_add_lwe_ciphertext_u64;
+use concrete_cpu::c_api::secret_key::concrete_cpu_glwe_ciphertext_size_u64;
+use concrete_cpu::c_api::types::ScratchStatus;
+use concrete_fft::c64;
+
+const KS_INPUT_DIMENSIONS: [usize; 3] = [1024, 2048, 4096];
+const KS_OUTPUT_DIMENSIONS: [usize; 2] = [600, 900];
+const KS_LEVELS: [usize; 3] = [2, 4, 6];
+const PBS_INTERNAL_DIMENSIONS: [usize; 2] = [600, 900];
+// (glwe dimension, log2 polynomial size)
+const PBS_GLWE_PARAMS: [(usize, usize); 4] = [(1, 10), (1, 11), (1, 12), (2, 10)];
+const PBS_LEVELS: [usize; 3] = [1, 2, 4];
+const LEVELLED_DIMENSIONS: [usize; 4] = [1024, 2048, 4096, 8192];
+
+// The decomposition base has no impact on the costs
+const BASE_LOG: usize = 4;
+
+// Minimal duration of a sample, and number of samples of a measure
+const SAMPLE_DURATION: Duration = Duration::from_millis(50);
+const SAMPLES: usize = 5;
+
+/// Zeroed memory with a given alignment, the content of the keys and ciphertexts doesn't change
+/// the costs of the operations.
+struct AlignedBuffer {
+    ptr: *mut u8,
+    layout: Layout,
+}
+
+impl AlignedBuffer {
+    fn new(size: usize, align: usize) -> Self {
+        let layout = Layout::from_size_align(size.max(1), align).unwrap();
+        let ptr = unsafe { alloc_zeroed(layout) };
+        assert!(!ptr.is_null());
+        Self { ptr, layout }
+    }
+}
+
+impl Drop for AlignedBuffer {
+    fn drop(&mut self) {
+        unsafe { dealloc(self.ptr, self.layout) };
+    }
+}
+
+/// Returns the time of one run of `f` in nanoseconds, as the minimum over several samples, each
+/// repeating `f` for at least SAMPLE_DURATION.
+fn measure(mut f: impl FnMut()) -> f64 {
+    f();
+    let mut best = f64::INFINITY;
+    for _ in 0..SAMPLES {
+        let mut runs = 0_u32;
+        let start = Instant::now();
+        while start.elapsed() < SAMPLE_DURATION {
+            f();
+            runs += 1;
+        }
+        best = best.min(start.elapsed().as_nanos() as f64 / f64::from(runs));
+    }
+    best
+}
+
+fn measure_ks(input_dimension: usize, output_dimension: usize, level: usize) -> f64 {
+    let ksk = vec![
+        0_u64;
+        unsafe {
+            concrete_cpu_keyswitch_key_size_u64(level, input_dimension, output_dimension)
+        }
+    ];
+    let mut out = vec![0_u64; output_dimension + 1];
+    let ct0 = vec![0_u64; input_dimension + 1];
+    measure(|| unsafe {
+        concrete_cpu_keyswitch_lwe_ciphertext_u64(
+            out.as_mut_ptr(),
+            ct0.as_ptr(),
+            ksk.as_ptr(),
+            level,
+            BASE_LOG,
+            input_dimension,
+            output_dimension,
+        );
+    })
+}
+
+fn measure_pbs(
+    internal_dimension: usize,
+    glwe_dimension: usize,
+    polynomial_size: usize,
+    level: usize,
+) -> f64 {
+    let fft_buffer = AlignedBuffer::new(CONCRETE_FFT_SIZE, CONCRETE_FFT_ALIGN);
+    let fft = fft_buffer.ptr.cast::<Fft>();
+    unsafe { concrete_cpu_construct_concrete_fft(fft, polynomial_size) };
+
+    let mut stack_size = 0;
+    let mut stack_align = 0;
+    let status = unsafe {
+        concrete_cpu_bootstrap_lwe_ciphertext_u64_scratch(
+            &mut stack_size,
+            &mut stack_align,
+            glwe_dimension,
+            polynomial_size,
+            fft,
+        )
+    };
+    assert!(matches!(status, ScratchStatus::Valid));
+    let stack = AlignedBuffer::new(stack_size, stack_align);
+
+    let fourier_bsk = vec![
+        c64::default();
+        unsafe {
+            concrete_cpu_fourier_bootstrap_key_size_u64(
+                level,
+                glwe_dimension,
+                polynomial_size,
+                internal_dimension,
+            )
+        }
+    ];
+    let accumulator =
+        vec![
+            0_u64;
+            unsafe { concrete_cpu_glwe_ciphertext_size_u64(glwe_dimension, polynomial_size) }
+        ];
+    let mut out = vec![0_u64; glwe_dimension * polynomial_size + 1];
+    let ct0 = vec![0_u64; internal_dimension + 1];
+
+    let time = measure(|| unsafe {
+        concrete_cpu_bootstrap_lwe_ciphertext_u64(
+            out.as_mut_ptr(),
+            ct0.as_ptr(),
+            accumulator.as_ptr(),
+            fourier_bsk.as_ptr(),
+            level,
+            BASE_LOG,
+            glwe_dimension,
+            polynomial_size,
+            internal_dimension,
+            fft,
+            stack.ptr,
+            stack_size,
+        );
+    });
+    unsafe { concrete_cpu_destroy_concrete_fft(fft) };
+    time
+}
+
+fn measure_levelled(lwe_dimension: usize) -> f64 {
+    let mut out = vec![0_u64; lwe_dimension + 1];
+    let ct0 = vec![0_u64; lwe_dimension + 1];
+    let ct1 = vec![0_u64; lwe_dimension + 1];
+    measure(|| unsafe {
+        concrete_cpu_add_lwe_ciphertext_u64(
+            out.as_mut_ptr(),
+            ct0.as_ptr(),
+            ct1.as_ptr(),
+            lwe_dimension,
+        );
+    })
+}
+
+fn main() -> std::io::Result<()> {
+    let path = std::env::args()
+        .nth(1)
+        .expect("usage: calibrate_cost_model <profile path>");
+    let mut profile = File::create(&path)?;
+
+    writeln!(profile, "# concrete-cpu cost profile, times in nanoseconds")?;
+    writeln!(
+        profile,
+        "# ks <input_lwe_dimension> <output_lwe_dimension> <level> <time>"
+    )?;
+    for input_dimension in KS_INPUT_DIMENSIONS {
+        for output_dimension in KS_OUTPUT_DIMENSIONS {
+            for level in KS_LEVELS {
+                let time = measure_ks(input_dimension, output_dimension, level);
+                writeln!(
+                    profile,
+                    "ks {input_dimension} {output_dimension} {level} {time}"
+                )?;
+            }
+        }
+    }
+
+    writeln!(
+        profile,
+        "# pbs <internal_lwe_dimension> <glwe_dimension> <log2_polynomial_size> <level> <time>"
+    )?;
+    for internal_dimension in PBS_INTERNAL_DIMENSIONS {
+        for (glwe_dimension, log2_polynomial_size) in PBS_GLWE_PARAMS {
+            for level in PBS_LEVELS {
+                let time = measure_pbs(
+                    internal_dimension,
+                    glwe_dimension,
+                    1 << log2_polynomial_size,
+                    level,
+                );
+                writeln!(
+                    profile,
+                    "pbs {internal_dimension} {glwe_dimension} {log2_polynomial_size} {level} {time}"
+                )?;
+            }
+        }
+    }
+
+    writeln!(profile, "# levelled <lwe_dimension> <time>")?;
+    for lwe_dimension in LEVELLED_DIMENSIONS {
+        let time = measure_levelled(lwe_dimension);
+        writeln!(profile, "levelled {lwe_dimension} {time}")?;
+    }
+
+    println!("Cost profile written to {path}");
+    Ok(())
+}
@@ -170,6 +170,8 @@ void concrete_cpu_construct_secret_csprng(struct SecCsprng *mem, struct Uint128
 
 int concrete_cpu_crypto_secure_random_128(struct Uint128 *u128);
 
+void concrete_cpu_csprng_draw_seed(struct Csprng *csprng, struct Uint128 *seed);
+
 void concrete_cpu_decompress_seeded_lwe_bootstrap_key_u64(uint64_t *lwe_bsk,
                                                           const uint64_t *seeded_lwe_bsk,
                                                           size_t input_lwe_dimension,
@@ -307,6 +309,16 @@ void concrete_cpu_init_lwe_circuit_bootstrap_private_functional_packing_keyswitc
                                                                                            Parallelism parallelism,
                                                                                            struct EncCsprng *csprng);
 
+void concrete_cpu_init_lwe_keyswitch_key_u32(uint32_t *lwe_ksk,
+                                             const uint64_t *input_lwe_sk,
+                                             const uint64_t *output_lwe_sk,
+                                             size_t input_lwe_dimension,
+                                             size_t output_lwe_dimension,
+                                             size_t decomposition_level_count,
+                                             size_t decomposition_base_log,
+                                             double variance,
+                                             struct EncCsprng *csprng);
+
 void concrete_cpu_init_lwe_keyswitch_key_u64(uint64_t *lwe_ksk,
                                              const uint64_t *input_lwe_sk,
                                              const uint64_t *output_lwe_sk,
@@ -341,6 +353,10 @@ void concrete_cpu_init_seeded_lwe_keyswitch_key_u64(uint64_t *seeded_lwe_ksk,
                                                     struct Uint128 compression_seed,
                                                     double variance);
 
+size_t concrete_cpu_keyswitch_key_size_u32(size_t decomposition_level_count,
+                                           size_t input_dimension,
+                                           size_t output_dimension);
+
 size_t concrete_cpu_keyswitch_key_size_u64(size_t decomposition_level_count,
                                            size_t input_dimension,
                                            size_t output_dimension);
@@ -353,6 +369,29 @@ void concrete_cpu_keyswitch_lwe_ciphertext_u64(uint64_t *ct_out,
                                                size_t input_dimension,
                                                size_t output_dimension);
 
+void concrete_cpu_keyswitch_lwe_ciphertext_u64_to_u32(uint32_t *ct_out,
+                                                      const uint64_t *ct_in,
+                                                      const uint32_t *keyswitch_key,
+                                                      size_t decomposition_level_count,
+                                                      size_t decomposition_base_log,
+                                                      size_t input_dimension,
+                                                      size_t output_dimension);
+
+ScratchStatus concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch(size_t *stack_size,
+                                                                            size_t *stack_align,
+                                                                            size_t input_dimension,
+                                                                            size_t output_dimension);
+
+void concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key(uint64_t *ct_out,
+                                                            const uint64_t *ct_in,
+                                                            const uint32_t *keyswitch_key,
+                                                            size_t decomposition_level_count,
+                                                            size_t decomposition_base_log,
+                                                            size_t input_dimension,
+                                                            size_t output_dimension,
+                                                            uint8_t *stack,
+                                                            size_t stack_size);
+
 size_t concrete_cpu_lwe_ciphertext_size_u64(size_t lwe_dimension);
 
 size_t concrete_cpu_lwe_packing_keyswitch_key_size(size_t output_glwe_dimension,
@@ -48,6 +48,17 @@ pub unsafe extern "C" fn concrete_cpu_destroy_csprng(mem: *mut Csprng) {
     core::ptr::drop_in_place(mem as *mut RandomGenerator<SoftwareRandomGenerator>);
 }
 
+// Draws a seed from the csprng, to seed another csprng. The seeds drawn from a csprng constructed
+// from a given seed are always the same, which allows to fork independent streams
+// deterministically.
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_csprng_draw_seed(csprng: *mut Csprng, seed: *mut Uint128) {
+    let csprng = &mut *(csprng as *mut RandomGenerator<SoftwareRandomGenerator>);
+    let low: u64 = csprng.random_uniform();
+    let high: u64 = csprng.random_uniform();
+    (*seed).little_endian_bytes = (u128::from(low) | (u128::from(high) << 64)).to_le_bytes();
+}
+
 #[no_mangle]
 pub static SECRET_CSPRNG_SIZE: usize =
     core::mem::size_of::<SecretRandomGenerator<SoftwareRandomGenerator>>();
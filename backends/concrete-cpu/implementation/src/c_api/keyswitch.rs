@@ -1,9 +1,10 @@
 use concrete_csprng::generators::SoftwareRandomGenerator;
+use dyn_stack::{PodStack, StackReq};
 use tfhe::core_crypto::commons::math::random::{CompressionSeed, Seed};
 use tfhe::core_crypto::prelude::*;
 
 use super::csprng::new_dyn_seeder;
-use super::types::{EncCsprng, Uint128};
+use super::types::{EncCsprng, ScratchStatus, Uint128};
 use super::utils::nounwind;
 
 #[no_mangle]
@@ -58,6 +59,64 @@ pub unsafe extern "C" fn concrete_cpu_init_lwe_keyswitch_key_u64(
     });
 }
 
+/// Initializes a keyswitch key operating with a 32 bits ciphertext modulus. The secret keys
+/// are the same as the ones used for 64 bits keys.
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_init_lwe_keyswitch_key_u32(
+    // keyswitch key
+    lwe_ksk: *mut u32,
+    // secret keys
+    input_lwe_sk: *const u64,
+    output_lwe_sk: *const u64,
+    // secret key dimensions
+    input_lwe_dimension: usize,
+    output_lwe_dimension: usize,
+    // keyswitch key parameters
+    decomposition_level_count: usize,
+    decomposition_base_log: usize,
+    // noise parameters
+    variance: f64,
+    // csprng
+    csprng: *mut EncCsprng,
+) {
+    nounwind(|| {
+        let input_key = LweSecretKey::from_container(
+            core::slice::from_raw_parts(input_lwe_sk, input_lwe_dimension)
+                .iter()
+                .map(|&bit| bit as u32)
+                .collect::<Vec<_>>(),
+        );
+        let output_key = LweSecretKey::from_container(
+            core::slice::from_raw_parts(output_lwe_sk, output_lwe_dimension)
+                .iter()
+                .map(|&bit| bit as u32)
+                .collect::<Vec<_>>(),
+        );
+        let mut ksk = LweKeyswitchKey::from_container(
+            core::slice::from_raw_parts_mut(
+                lwe_ksk,
+                concrete_cpu_keyswitch_key_size_u32(
+                    decomposition_level_count,
+                    input_lwe_dimension,
+                    output_lwe_dimension,
+                ),
+            ),
+            DecompositionBaseLog(decomposition_base_log),
+            DecompositionLevelCount(decomposition_level_count),
+            LweDimension(output_lwe_dimension).to_lwe_size(),
+            CiphertextModulus::new_native(),
+        );
+
+        generate_lwe_keyswitch_key(
+            &input_key,
+            &output_key,
+            &mut ksk,
+            Variance::from_variance(variance),
+            &mut *(csprng as *mut EncryptionRandomGenerator<SoftwareRandomGenerator>),
+        )
+    });
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn concrete_cpu_init_seeded_lwe_keyswitch_key_u64(
     // keyswitch key
@@ -210,6 +269,144 @@ pub unsafe extern "C" fn concrete_cpu_keyswitch_lwe_ciphertext_u64(
     })
 }
 
+/// Rounds `ct_in` to its 32 most significant bits in `ct_in_u32`, and keyswitches it to `ct_out`.
+#[allow(clippy::too_many_arguments)]
+unsafe fn keyswitch_lwe_ciphertext_u64_to_u32(
+    ct_out: &mut [u32],
+    ct_in: &[u64],
+    ct_in_u32: &mut [u32],
+    keyswitch_key: *const u32,
+    decomposition_level_count: usize,
+    decomposition_base_log: usize,
+    input_dimension: usize,
+    output_dimension: usize,
+) {
+    debug_assert!(decomposition_level_count * decomposition_base_log <= 32);
+
+    for (rounded, &coefficient) in ct_in_u32.iter_mut().zip(ct_in.iter()) {
+        *rounded = ((coefficient >> 31).wrapping_add(1) >> 1) as u32;
+    }
+    let ct_in = LweCiphertext::from_container(&*ct_in_u32, CiphertextModulus::new_native());
+    let mut ct_out = LweCiphertext::from_container(ct_out, CiphertextModulus::new_native());
+
+    let keyswitch_key = LweKeyswitchKey::from_container(
+        core::slice::from_raw_parts(
+            keyswitch_key,
+            concrete_cpu_keyswitch_key_size_u32(
+                decomposition_level_count,
+                input_dimension,
+                output_dimension,
+            ),
+        ),
+        DecompositionBaseLog(decomposition_base_log),
+        DecompositionLevelCount(decomposition_level_count),
+        LweDimension(output_dimension).to_lwe_size(),
+        CiphertextModulus::new_native(),
+    );
+    keyswitch_lwe_ciphertext(&keyswitch_key, &ct_in, &mut ct_out);
+}
+
+/// Keyswitches a 64 bits ciphertext with a 32 bits keyswitch key, and returns the result on a
+/// 32 bits ciphertext modulus.
+///
+/// The input is first rounded to its 32 most significant bits. This does not change the result
+/// of the keyswitch as long as the decomposition keeps at most 32 bits of the input.
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_keyswitch_lwe_ciphertext_u64_to_u32(
+    // ciphertexts
+    ct_out: *mut u32,
+    ct_in: *const u64,
+    // keyswitch key
+    keyswitch_key: *const u32,
+    // keyswitch parameters
+    decomposition_level_count: usize,
+    decomposition_base_log: usize,
+    input_dimension: usize,
+    output_dimension: usize,
+) {
+    nounwind(|| {
+        let mut ct_in_u32 = vec![0_u32; input_dimension + 1];
+        keyswitch_lwe_ciphertext_u64_to_u32(
+            core::slice::from_raw_parts_mut(ct_out, output_dimension + 1),
+            core::slice::from_raw_parts(ct_in, input_dimension + 1),
+            &mut ct_in_u32,
+            keyswitch_key,
+            decomposition_level_count,
+            decomposition_base_log,
+            input_dimension,
+            output_dimension,
+        );
+    })
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch(
+    stack_size: *mut usize,
+    stack_align: *mut usize,
+    // keyswitch parameters
+    input_dimension: usize,
+    output_dimension: usize,
+) -> ScratchStatus {
+    nounwind(|| {
+        let align = core::mem::align_of::<u32>();
+        let scratch =
+            StackReq::try_new_aligned::<u32>(input_dimension + 1, align).and_then(|ct_in_u32| {
+                let ct_out_u32 = StackReq::try_new_aligned::<u32>(output_dimension + 1, align)?;
+                StackReq::try_all_of([ct_in_u32, ct_out_u32])
+            });
+        if let Ok(scratch) = scratch {
+            *stack_size = scratch.size_bytes();
+            *stack_align = scratch.align_bytes();
+            ScratchStatus::Valid
+        } else {
+            ScratchStatus::SizeOverflow
+        }
+    })
+}
+
+/// Keyswitches a 64 bits ciphertext with a 32 bits keyswitch key, and returns the result in the
+/// most significant bits of a 64 bits ciphertext, such that it can be bootstrapped as is.
+///
+/// The 32 bits input and output ciphertexts are kept in `stack`, whose size is given by
+/// `concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch`.
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key(
+    // ciphertexts
+    ct_out: *mut u64,
+    ct_in: *const u64,
+    // keyswitch key
+    keyswitch_key: *const u32,
+    // keyswitch parameters
+    decomposition_level_count: usize,
+    decomposition_base_log: usize,
+    input_dimension: usize,
+    output_dimension: usize,
+    // side resources
+    stack: *mut u8,
+    stack_size: usize,
+) {
+    nounwind(|| {
+        let align = core::mem::align_of::<u32>();
+        let stack = PodStack::new(core::slice::from_raw_parts_mut(stack as _, stack_size));
+        let (ct_in_u32, stack) = stack.make_aligned_raw::<u32>(input_dimension + 1, align);
+        let (ct_out_u32, _) = stack.make_aligned_raw::<u32>(output_dimension + 1, align);
+        keyswitch_lwe_ciphertext_u64_to_u32(
+            ct_out_u32,
+            core::slice::from_raw_parts(ct_in, input_dimension + 1),
+            ct_in_u32,
+            keyswitch_key,
+            decomposition_level_count,
+            decomposition_base_log,
+            input_dimension,
+            output_dimension,
+        );
+        let ct_out = core::slice::from_raw_parts_mut(ct_out, output_dimension + 1);
+        for (out, &coefficient) in ct_out.iter_mut().zip(ct_out_u32.iter()) {
+            *out = (coefficient as u64) << 32;
+        }
+    })
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn concrete_cpu_keyswitch_key_size_u64(
     decomposition_level_count: usize,
@@ -233,3 +430,16 @@ pub unsafe extern "C" fn concrete_cpu_seeded_keyswitch_key_size_u64(
             decomposition_level_count,
         ))
 }
+
+#[no_mangle]
+pub unsafe extern "C" fn concrete_cpu_keyswitch_key_size_u32(
+    decomposition_level_count: usize,
+    input_dimension: usize,
+    output_dimension: usize,
+) -> usize {
+    concrete_cpu_keyswitch_key_size_u64(
+        decomposition_level_count,
+        input_dimension,
+        output_dimension,
+    )
+}
@@ -0,0 +1,16 @@
+# Writes the content of the binary file INPUT as a C array named VARIABLE, and
+# its size as VARIABLE_size, to the include file OUTPUT. An empty array is
+# written if INPUT doesn't exist.
+#
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<file> -DVARIABLE=<name> -P EmbedBinary.cmake
+
+if(EXISTS ${INPUT})
+  file(READ ${INPUT} content HEX)
+else()
+  set(content "")
+endif()
+string(LENGTH "${content}" hex_length)
+math(EXPR size "${hex_length} / 2")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${content}")
+file(WRITE ${OUTPUT} "static const unsigned char ${VARIABLE}[] = {${bytes}0};\n"
+                     "static const size_t ${VARIABLE}_size = ${size};\n")
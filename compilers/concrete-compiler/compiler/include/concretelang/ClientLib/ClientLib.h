@@ -24,6 +24,7 @@
 
 using concretelang::error::Result;
 using concretelang::keysets::ClientKeyset;
+using concretelang::transformers::InputStreamTransformer;
 using concretelang::transformers::InputTransformer;
 using concretelang::transformers::OutputTransformer;
 using concretelang::transformers::TransformerFactory;
@@ -44,7 +45,12 @@ public:
 
   Result<TransportValue> prepareInput(Value arg, size_t pos);
 
-  Result<Value> processOutput(TransportValue result, size_t pos);
+  /// Prepares the input at `pos`, streaming it to the file descriptor `fd` as
+  /// it is prepared, such that the prepared value is never held in memory as
+  /// a whole. The server reads it back with `ServerCircuit::callFromFds`.
+  Result<void> prepareInputToFd(Value arg, size_t pos, int fd);
+
+  Result<Value> processOutput(const TransportValue &result, size_t pos);
 
   std::string getName();
 
@@ -54,13 +60,16 @@ private:
   ClientCircuit() = delete;
   ClientCircuit(const Message<concreteprotocol::CircuitInfo> &circuitInfo,
                 std::vector<InputTransformer> inputTransformers,
+                std::vector<InputStreamTransformer> inputStreamTransformers,
                 std::vector<OutputTransformer> outputTransformers)
       : circuitInfo(circuitInfo), inputTransformers(inputTransformers),
+        inputStreamTransformers(inputStreamTransformers),
         outputTransformers(outputTransformers){};
 
 private:
   Message<concreteprotocol::CircuitInfo> circuitInfo;
   std::vector<InputTransformer> inputTransformers;
+  std::vector<InputStreamTransformer> inputStreamTransformers;
   std::vector<OutputTransformer> outputTransformers;
 };
 
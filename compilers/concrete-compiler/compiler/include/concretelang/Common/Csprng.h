@@ -37,6 +37,10 @@ public:
   SoftCSPRNG(SoftCSPRNG &) = delete;
   SoftCSPRNG(SoftCSPRNG &&other);
   ~SoftCSPRNG();
+
+  /// Draws a non-zero seed for another csprng. The seeds drawn from csprngs
+  /// built with the same (non-zero) seed are the same.
+  __uint128_t drawSeed();
 };
 
 class SecretCSPRNG : public CSPRNG<SecCsprng> {
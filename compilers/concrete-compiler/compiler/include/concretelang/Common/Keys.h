@@ -53,6 +53,12 @@ public:
   static LweSecretKey
   fromProto(const Message<concreteprotocol::LweSecretKey> &proto);
 
+  static LweSecretKey
+  fromTransportBuffer(std::shared_ptr<std::vector<uint64_t>> buffer,
+                      InfoType info) {
+    return LweSecretKey(buffer, info);
+  }
+
   Message<concreteprotocol::LweSecretKey> toProto() const;
 
   const uint64_t *getRawPtr() const;
@@ -95,6 +101,13 @@ public:
   static LweBootstrapKey
   fromProto(const Message<concreteprotocol::LweBootstrapKey> &proto);
 
+  /// @brief Initialize the key from the buffer returned by
+  /// `getTransportBuffer`, which holds the seeded key if the key is
+  /// compressed.
+  static LweBootstrapKey
+  fromTransportBuffer(std::shared_ptr<std::vector<uint64_t>> buffer,
+                      InfoType info);
+
   /// @brief Returns the serialized form of the key.
   Message<concreteprotocol::LweBootstrapKey> toProto() const;
 
@@ -147,6 +160,13 @@ public:
   static LweKeyswitchKey
   fromProto(const Message<concreteprotocol::LweKeyswitchKey> &proto);
 
+  /// @brief Initialize the key from the buffer returned by
+  /// `getTransportBuffer`, which holds the seeded key if the key is
+  /// compressed.
+  static LweKeyswitchKey
+  fromTransportBuffer(std::shared_ptr<std::vector<uint64_t>> buffer,
+                      InfoType info);
+
   /// @brief Returns the serialized form of the key.
   Message<concreteprotocol::LweKeyswitchKey> toProto() const;
 
@@ -199,6 +219,12 @@ public:
   static PackingKeyswitchKey
   fromProto(const Message<concreteprotocol::PackingKeyswitchKey> &proto);
 
+  static PackingKeyswitchKey
+  fromTransportBuffer(std::shared_ptr<std::vector<uint64_t>> buffer,
+                      InfoType info) {
+    return PackingKeyswitchKey(buffer, info);
+  }
+
   Message<concreteprotocol::PackingKeyswitchKey> toProto() const;
 
   const uint64_t *getRawPtr() const;
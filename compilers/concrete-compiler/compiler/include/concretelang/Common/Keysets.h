@@ -12,6 +12,7 @@
 #include "concretelang/Common/Keys.h"
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <stdlib.h>
 #include <string>
 
@@ -43,6 +44,27 @@ struct ServerKeyset {
   fromProto(const Message<concreteprotocol::ServerKeyset> &proto);
 
   Message<concreteprotocol::ServerKeyset> toProto() const;
+
+  /// Returns the hexadecimal SHA-256 digest of the infos and the transport
+  /// buffers of the keys. The digest is computed on the first call and shared
+  /// by the copies of the keyset, whose keys must not change afterwards.
+  const std::string &getDigest() const;
+
+  struct Digest {
+    std::once_flag computed;
+    std::string value;
+  };
+  std::shared_ptr<Digest> digest = std::make_shared<Digest>();
+};
+
+/// The options of the generation of a keyset.
+struct KeysetGenerationOptions {
+  /// The number of threads generating the keys. Zero means the number of
+  /// hardware threads.
+  size_t threads = 0;
+  /// If not empty, the directory each key is saved to as soon as it is
+  /// generated, while the generation of the other keys goes on.
+  std::string saveDirectory;
 };
 
 struct Keyset {
@@ -51,13 +73,22 @@ struct Keyset {
 
   Keyset(){};
 
-  /// Generates a fresh keyset from infos.
+  /// Generates a fresh keyset from infos, one key after the other.
   Keyset(const Message<concreteprotocol::KeysetInfo> &info,
          concretelang::csprng::SecretCSPRNG &secretCsprng,
          csprng::EncryptionCSPRNG &encryptionCsprng);
   Keyset(ServerKeyset server, ClientKeyset client)
       : server(server), client(client) {}
 
+  /// Generates a fresh keyset from infos, the server keys being generated
+  /// concurrently. Each server key is encrypted with its own csprng, seeded
+  /// by a seed forked from `encryptionSeed` in the order of the infos, so
+  /// that the keys don't depend on the order they are generated in.
+  static Result<Keyset>
+  generate(const Message<concreteprotocol::KeysetInfo> &info,
+           __uint128_t secretSeed, __uint128_t encryptionSeed,
+           KeysetGenerationOptions options = KeysetGenerationOptions());
+
   static Keyset fromProto(const Message<concreteprotocol::Keyset> &proto);
 
   Message<concreteprotocol::Keyset> toProto() const;
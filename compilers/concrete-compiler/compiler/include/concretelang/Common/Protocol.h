@@ -20,8 +20,11 @@
 #include "kj/std/iostream.h"
 #include "kj/string.h"
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <sstream>
@@ -244,86 +247,113 @@ template struct Message<concreteprotocol::ProgramEncodingInfo>;
 template struct Message<concreteprotocol::Value>;
 template struct Message<concreteprotocol::GateInfo>;
 
-/// Helper function turning a vector of integers to a payload.
+/// Returns the sizes in bytes of the blobs of a payload holding `size`
+/// integers.
+template <typename T> std::vector<uint64_t> protoPayloadBlobSizes(size_t size) {
+  size_t elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
+  std::vector<uint64_t> blobSizes;
+  for (size_t offset = 0; offset < size; offset += elmsPerBlob) {
+    blobSizes.push_back(std::min(elmsPerBlob, size - offset) * sizeof(T));
+  }
+  return blobSizes;
+}
+
+/// Helper function initializing the blobs of a payload holding `size`
+/// integers, and returning a pointer to the memory of each blob, to be filled
+/// in place. The integers are split between blobs as `Data` allows.
 template <typename T>
-Message<concreteprotocol::Payload>
-vectorToProtoPayload(const std::vector<T> &input) {
-  auto output = Message<concreteprotocol::Payload>();
-  auto elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
-  auto remainingElms = input.size() % elmsPerBlob;
-  auto nbBlobs = (input.size() / elmsPerBlob) + (remainingElms > 0);
-  auto dataBuilder = output.asBuilder().initData(nbBlobs);
-  // Process all but the last blob, which store as much as `Data` allow.
-  if (nbBlobs > 1) {
-    for (size_t blobIndex = 0; blobIndex < nbBlobs - 1; blobIndex++) {
-      auto blobPtr = input.data() + blobIndex * elmsPerBlob;
-      auto blobLen = elmsPerBlob * sizeof(T);
-      dataBuilder.set(
-          blobIndex,
-          capnp::Data::Reader(reinterpret_cast<const unsigned char *>(blobPtr),
-                              blobLen));
-    }
+std::vector<T *> initProtoPayload(concreteprotocol::Payload::Builder payload,
+                                  size_t size) {
+  auto blobSizes = protoPayloadBlobSizes<T>(size);
+  auto dataBuilder = payload.initData(blobSizes.size());
+  std::vector<T *> blobs;
+  for (size_t blobIndex = 0; blobIndex < blobSizes.size(); blobIndex++) {
+    auto blob = dataBuilder.init(blobIndex, blobSizes[blobIndex]);
+    blobs.push_back(reinterpret_cast<T *>(blob.begin()));
   }
+  return blobs;
+}
 
-  // Process the last blob which store the remainder.
-  if (nbBlobs > 0) {
-    auto lastBlobIndex = nbBlobs - 1;
-    auto lastBlobPtr = input.data() + lastBlobIndex * elmsPerBlob;
-    auto lastBlobLen = remainingElms * sizeof(T);
-    dataBuilder.set(
-        lastBlobIndex,
-        capnp::Data::Reader(
-            reinterpret_cast<const unsigned char *>(lastBlobPtr), lastBlobLen));
+/// Helper function writing integers to a payload, copying them once to the
+/// message.
+template <typename T, typename Alloc>
+void vectorIntoProtoPayload(const std::vector<T, Alloc> &input,
+                            concreteprotocol::Payload::Builder payload) {
+  size_t elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
+  auto blobs = initProtoPayload<T>(payload, input.size());
+  for (size_t blobIndex = 0; blobIndex < blobs.size(); blobIndex++) {
+    size_t offset = blobIndex * elmsPerBlob;
+    size_t blobElms = std::min(elmsPerBlob, input.size() - offset);
+    std::memcpy(blobs[blobIndex], input.data() + offset, blobElms * sizeof(T));
   }
+}
 
+/// Helper function turning a vector of integers to a payload.
+template <typename T, typename Alloc>
+Message<concreteprotocol::Payload>
+vectorToProtoPayload(const std::vector<T, Alloc> &input) {
+  auto output = Message<concreteprotocol::Payload>();
+  vectorIntoProtoPayload(input, output.asBuilder());
   return output;
 }
 
-/// Helper function turning a payload to a vector of integers.
+/// Helper function copying the integers of a payload to `output`, reading the
+/// blobs in place.
 template <typename T>
-std::vector<T>
-protoPayloadToVector(const Message<concreteprotocol::Payload> &input) {
-  auto payloadData = input.asReader().getData();
-  auto elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
-  auto totalPayloadSize = 0;
-  for (auto blob : payloadData) {
-    totalPayloadSize += blob.size();
-  }
-  assert(totalPayloadSize % sizeof(T) == 0);
-  auto dataSize = totalPayloadSize / sizeof(T);
-  auto output = std::vector<T>();
-  output.resize(dataSize);
+void protoPayloadIntoBuffer(concreteprotocol::Payload::Reader input,
+                            T *output) {
+  size_t elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
+  auto payloadData = input.getData();
   for (size_t blobIndex = 0; blobIndex < payloadData.size(); blobIndex++) {
     auto blobData = payloadData[blobIndex];
-    auto blobPtr = output.data() + blobIndex * elmsPerBlob;
-    std::memcpy(blobPtr, blobData.begin(), blobData.size());
+    std::memcpy(output + blobIndex * elmsPerBlob, blobData.begin(),
+                blobData.size());
   }
-  return output;
 }
 
-/// Helper function turning a payload to a shared vector of integers on the
-/// heap.
+/// Returns the number of integers of a payload.
 template <typename T>
-std::shared_ptr<std::vector<T>>
-protoPayloadToSharedVector(const Message<concreteprotocol::Payload> &input) {
-  auto payloadData = input.asReader().getData();
-  size_t elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(T);
+size_t getProtoPayloadSize(concreteprotocol::Payload::Reader input) {
   size_t totalPayloadSize = 0;
-  for (auto blob : payloadData) {
+  for (auto blob : input.getData()) {
     totalPayloadSize += blob.size();
   }
   assert(totalPayloadSize % sizeof(T) == 0);
-  size_t dataSize = totalPayloadSize / sizeof(T);
-  auto output = std::make_shared<std::vector<T>>();
-  output->resize(dataSize);
-  for (size_t blobIndex = 0; blobIndex < payloadData.size(); blobIndex++) {
-    auto blobData = payloadData[blobIndex];
-    auto blobPtr = output->data() + blobIndex * elmsPerBlob;
-    std::memcpy(blobPtr, blobData.begin(), blobData.size());
-  }
+  return totalPayloadSize / sizeof(T);
+}
+
+/// Helper function turning a payload to a vector of integers.
+template <typename T, typename Alloc = std::allocator<T>>
+std::vector<T, Alloc>
+protoPayloadToVector(concreteprotocol::Payload::Reader input) {
+  auto output = std::vector<T, Alloc>(getProtoPayloadSize<T>(input));
+  protoPayloadIntoBuffer(input, output.data());
+  return output;
+}
+
+template <typename T, typename Alloc = std::allocator<T>>
+std::vector<T, Alloc>
+protoPayloadToVector(const Message<concreteprotocol::Payload> &input) {
+  return protoPayloadToVector<T, Alloc>(input.asReader());
+}
+
+/// Helper function turning a payload to a shared vector of integers on the
+/// heap.
+template <typename T>
+std::shared_ptr<std::vector<T>>
+protoPayloadToSharedVector(concreteprotocol::Payload::Reader input) {
+  auto output =
+      std::make_shared<std::vector<T>>(getProtoPayloadSize<T>(input));
+  protoPayloadIntoBuffer(input, output->data());
   return output;
 }
 
+template <typename T>
+std::shared_ptr<std::vector<T>>
+protoPayloadToSharedVector(const Message<concreteprotocol::Payload> &input) {
+  return protoPayloadToSharedVector<T>(input.asReader());
+}
+
 /// Helper function turning a protocol `Shape` object into a vector of
 /// dimensions.
 std::vector<size_t>
@@ -336,6 +366,83 @@ dimensionsToProtoShape(const std::vector<size_t> &input);
 
 template <typename MessageType> size_t hashMessage(Message<MessageType> &mess);
 
+/// Writer streaming a value to a file descriptor, the payload being written
+/// incrementally, possibly while it is being computed.
+///
+/// A streamed value is made of:
+/// + the value message without its payload, serialized by capnp,
+/// + the number of blobs of the payload and their sizes in bytes,
+/// + the content of the blobs, one after the other.
+///
+/// Contrarily to `Message::writeBinaryToFd`, this never materializes the
+/// serialized value, and the reader writes the payload directly to the blobs
+/// of the value it builds, allocating each blob only once its data arrives.
+class ValueStreamWriter {
+public:
+  ValueStreamWriter(int fd) : fd(fd) {}
+
+  /// Writes the value `header`, ignoring its payload, and the sizes of the
+  /// blobs of the payload following it.
+  Result<void> writeHeader(concreteprotocol::Value::Reader header,
+                           const std::vector<uint64_t> &blobSizes);
+
+  /// Writes the next `size` bytes of the payload.
+  Result<void> writePayload(const void *data, size_t size);
+
+  /// Checks that the whole payload announced in the header was written.
+  Result<void> finish();
+
+private:
+  int fd;
+  uint64_t remainingPayloadSize = 0;
+};
+
+/// Reader of the values streamed by `ValueStreamWriter`.
+class ValueStreamReader {
+public:
+  /// Creates a reader of the values whose payload is at most `maxPayloadSize`
+  /// bytes.
+  ValueStreamReader(int fd, size_t maxPayloadSize = DEFAULT_MAX_PAYLOAD_SIZE)
+      : fd(fd), maxPayloadSize(maxPayloadSize) {}
+
+  /// Reads the header of the next value, and initializes the list of the
+  /// blobs of its payload, to be filled by `readPayload`. Fails unless the
+  /// sizes of the blobs are the ones of a payload of the shape and precision
+  /// of the value, of at most `maxPayloadSize` bytes.
+  Result<Message<concreteprotocol::Value>> readHeader();
+
+  /// Reads the payload of the value whose header was just read, directly in
+  /// its blobs, by chunks of at most `chunkSize` bytes. A blob is allocated
+  /// when its first chunk is read, such that a stream cut short never
+  /// allocates more than a blob ahead of the data it holds. `onChunk`, if
+  /// set, is called with the number of payload bytes read so far after each
+  /// chunk.
+  Result<void> readPayload(Message<concreteprotocol::Value> &value,
+                           size_t chunkSize = DEFAULT_CHUNK_SIZE,
+                           std::function<void(size_t)> onChunk = nullptr);
+
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 22;
+
+  /// The default maximal size of a payload in bytes, bounding the memory
+  /// allocated from the header of a value.
+  static constexpr size_t DEFAULT_MAX_PAYLOAD_SIZE = (size_t)1 << 34;
+
+private:
+  int fd;
+  size_t maxPayloadSize;
+  std::vector<uint64_t> blobSizes;
+};
+
+/// Writes `value` to the file descriptor `fd` as a streamed value.
+Result<void> writeValueToFd(int fd,
+                            const Message<concreteprotocol::Value> &value);
+
+/// Reads a streamed value from the file descriptor `fd`, whose payload is at
+/// most `maxPayloadSize` bytes.
+Result<Message<concreteprotocol::Value>> readValueFromFd(
+    int fd,
+    size_t maxPayloadSize = ValueStreamReader::DEFAULT_MAX_PAYLOAD_SIZE);
+
 } // namespace protocol
 } // namespace concretelang
 
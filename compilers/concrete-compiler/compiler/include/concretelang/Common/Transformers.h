@@ -29,18 +29,29 @@ typedef std::function<Result<TransportValue>(Value)> InputTransformer;
 /// A type for output transformers, that is, functions running on the client
 /// side, that process a TransportValue fetched from the server to be used as a
 /// Value.
-typedef std::function<Result<Value>(TransportValue)> OutputTransformer;
+typedef std::function<Result<Value>(const TransportValue &)>
+    OutputTransformer;
 
 /// A type for arguments transformers, that is, functions running on the server
 /// side, that transform a TransportValue fetched from the client, to be used as
 /// argument in a circuit call.
-typedef std::function<Result<Value>(TransportValue)> ArgTransformer;
+typedef std::function<Result<Value>(const TransportValue &)> ArgTransformer;
 
 /// A type for return transformers, that is, functions running on the server
 /// side, that transform a value returned from circuit call into a
 /// TransportValue to be sent to the client.
 typedef std::function<Result<TransportValue>(Value)> ReturnTransformer;
 
+/// A type for input stream transformers, that is, functions running on the
+/// client side, that prepare a Value to be sent to the server, streaming it to
+/// a file descriptor as it is prepared.
+typedef std::function<Result<void>(Value, int)> InputStreamTransformer;
+
+/// A type for argument stream transformers, that is, functions running on the
+/// server side, that read a value streamed by the client from a file
+/// descriptor, to be used as argument in a circuit call.
+typedef std::function<Result<Value>(int)> ArgStreamTransformer;
+
 /// A factory static class that generates transformers.
 class TransformerFactory {
 public:
@@ -83,6 +94,24 @@ public:
 
   static Result<ReturnTransformer> getLweCiphertextReturnTransformer(
       Message<concreteprotocol::GateInfo> gateInfo, bool useSimulation);
+
+  /// Returns an input stream transformer writing the transport values
+  /// prepared by `transformer` to the file descriptor.
+  static Result<InputStreamTransformer>
+  getInputStreamTransformer(InputTransformer transformer);
+
+  /// Returns an input stream transformer encrypting the ciphertexts by
+  /// bounded batches, each batch being written to the file descriptor before
+  /// the next one is encrypted.
+  static Result<InputStreamTransformer> getLweCiphertextInputStreamTransformer(
+      ClientKeyset keyset, Message<concreteprotocol::GateInfo> gateInfo,
+      std::shared_ptr<concretelang::csprng::EncryptionCSPRNG> csprng,
+      bool useSimulation);
+
+  /// Returns an argument stream transformer reading the transport values from
+  /// the file descriptor, and transforming them with `transformer`.
+  static Result<ArgStreamTransformer>
+  getArgStreamTransformer(ArgTransformer transformer);
 };
 
 } // namespace transformers
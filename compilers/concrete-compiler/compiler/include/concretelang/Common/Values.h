@@ -9,12 +9,18 @@
 #include "concrete-protocol.capnp.h"
 #include "concretelang/Common/Error.h"
 #include "concretelang/Common/Protocol.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
+#include <memory>
 #include <optional>
 #include <stdlib.h>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 using concretelang::error::Result;
 using concretelang::error::StringError;
@@ -31,14 +37,142 @@ namespace values {
 /// between client and server to for execution.
 typedef Message<concreteprotocol::Value> TransportValue;
 
+/// The allocator of the values of the tensors. It allocates with the standard
+/// allocator, unless it was given a buffer allocated elsewhere to adopt (e.g.
+/// an output of a circuit). The allocation of the length of this buffer then
+/// returns the buffer, leaving its values as they are, and its deallocation
+/// calls `release`, such that the values are never copied.
+template <typename T> struct StorageAllocator {
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  /// A buffer allocated elsewhere, adopted by the first vector allocating
+  /// `length` values.
+  struct Adopted {
+    T *buffer;
+    size_t length;
+    std::function<void()> release;
+    bool allocated = false;
+  };
+
+  StorageAllocator() = default;
+  StorageAllocator(std::shared_ptr<Adopted> adopted)
+      : adopted(std::move(adopted)) {}
+  template <typename U> StorageAllocator(const StorageAllocator<U> &) {}
+
+  T *allocate(size_t length) {
+    if (adopted != nullptr && !adopted->allocated &&
+        length == adopted->length) {
+      adopted->allocated = true;
+      return adopted->buffer;
+    }
+    return std::allocator<T>().allocate(length);
+  }
+
+  void deallocate(T *ptr, size_t length) {
+    if (adopted != nullptr && ptr == adopted->buffer) {
+      adopted->buffer = nullptr;
+      adopted->release();
+      return;
+    }
+    std::allocator<T>().deallocate(ptr, length);
+  }
+
+  /// Value-initializes the elements, but the adopted ones.
+  template <typename U> void construct(U *ptr) {
+    if (adopted != nullptr && adopted->buffer != nullptr &&
+        (void *)ptr >= (void *)adopted->buffer &&
+        (void *)ptr < (void *)(adopted->buffer + adopted->length)) {
+      ::new ((void *)ptr) U;
+    } else {
+      ::new ((void *)ptr) U();
+    }
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *ptr, Args &&...args) {
+    ::new ((void *)ptr) U(std::forward<Args>(args)...);
+  }
+
+  /// The copies of a vector allocate their own values.
+  StorageAllocator select_on_container_copy_construction() const {
+    return StorageAllocator();
+  }
+
+  bool operator==(const StorageAllocator &other) const {
+    return adopted == other.adopted;
+  }
+
+  bool operator!=(const StorageAllocator &other) const {
+    return adopted != other.adopted;
+  }
+
+private:
+  std::shared_ptr<Adopted> adopted;
+};
+
+template <typename T>
+bool operator==(const std::vector<T, StorageAllocator<T>> &lhs,
+                const std::vector<T> &rhs) {
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename T>
+bool operator==(const std::vector<T> &lhs,
+                const std::vector<T, StorageAllocator<T>> &rhs) {
+  return rhs == lhs;
+}
+
+template <typename T>
+bool operator!=(const std::vector<T, StorageAllocator<T>> &lhs,
+                const std::vector<T> &rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename T>
+bool operator!=(const std::vector<T> &lhs,
+                const std::vector<T, StorageAllocator<T>> &rhs) {
+  return !(rhs == lhs);
+}
+
 /// A type for tensor data.
 template <typename T> struct Tensor {
-  std::vector<T> values;
+  /// The values are stored in a vector, which can adopt a buffer allocated
+  /// elsewhere.
+  typedef std::vector<T, StorageAllocator<T>> Storage;
+
+  Storage values;
   std::vector<size_t> dimensions;
 
   Tensor<T>() = default;
-  Tensor<T>(std::vector<T> values, std::vector<size_t> dimensions)
-      : values(values), dimensions(dimensions) {}
+  Tensor<T>(Storage values, std::vector<size_t> dimensions)
+      : values(std::move(values)), dimensions(std::move(dimensions)) {}
+  Tensor<T>(const std::vector<T> &values, std::vector<size_t> dimensions)
+      : values(values.begin(), values.end()),
+        dimensions(std::move(dimensions)) {}
+
+  /// Creates a tensor whose values are the ones of `buffer`, without copying
+  /// them. The tensor owns the buffer, and calls `release` once it is done
+  /// with it.
+  static Tensor<T> adopt(T *buffer, std::vector<size_t> dimensions,
+                         std::function<void()> release) {
+    size_t length = 1;
+    for (auto dim : dimensions) {
+      length *= dim;
+    }
+    if (length == 0) {
+      release();
+      return Tensor<T>{Storage(), std::move(dimensions)};
+    }
+    auto adopted = std::make_shared<typename StorageAllocator<T>::Adopted>();
+    adopted->buffer = buffer;
+    adopted->length = length;
+    adopted->release = std::move(release);
+    return Tensor<T>{Storage(length, StorageAllocator<T>(adopted)),
+                     std::move(dimensions)};
+  }
 
   /// Creates an tensor with the shape described by the input dimensions, filled
   /// with zeros.
@@ -151,20 +285,21 @@ struct Value {
                Tensor<uint64_t>, Tensor<int64_t>>
       inner;
   Value() = default;
-  Value(Tensor<uint8_t> inner) : inner(inner){};
-  Value(Tensor<uint16_t> inner) : inner(inner){};
-  Value(Tensor<uint32_t> inner) : inner(inner){};
-  Value(Tensor<uint64_t> inner) : inner(inner){};
-  Value(Tensor<int8_t> inner) : inner(inner){};
-  Value(Tensor<int16_t> inner) : inner(inner){};
-  Value(Tensor<int32_t> inner) : inner(inner){};
-  Value(Tensor<int64_t> inner) : inner(inner){};
+  Value(Tensor<uint8_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<uint16_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<uint32_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<uint64_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<int8_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<int16_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<int32_t> inner) : inner(std::move(inner)){};
+  Value(Tensor<int64_t> inner) : inner(std::move(inner)){};
 
   /// Turns a server value to a client value, without interpreting the kind of
-  /// value.
-  static Value fromRawTransportValue(TransportValue transportVal);
+  /// value. The payload is read in place and copied once to the tensor.
+  static Value fromRawTransportValue(const TransportValue &transportVal);
 
   /// Turns a client value to a raw (without kind info attached) server value.
+  /// The tensor is copied once, directly to the message.
   TransportValue intoRawTransportValue() const;
 
   bool operator==(const Value &b) const;
@@ -175,6 +310,9 @@ struct Value {
 
   Message<concreteprotocol::Payload> intoProtoPayload() const;
 
+  /// Writes the values of the tensor to `payload`.
+  void intoProtoPayload(concreteprotocol::Payload::Builder payload) const;
+
   Message<concreteprotocol::Shape> intoProtoShape() const;
 
   std::vector<size_t> getDimensions() const;
@@ -13,7 +13,13 @@
 
 namespace mlir {
 namespace concretelang {
+struct ProgramCompilationFeedback;
+
 std::unique_ptr<OperationPass<ModuleOp>> createAddRuntimeContext();
+/// Creates the memory planning pass, reporting the size of the arena of each
+/// circuit in `feedback`, if any.
+std::unique_ptr<OperationPass<ModuleOp>>
+createMemoryPlanningPass(ProgramCompilationFeedback *feedback = nullptr);
 } // namespace concretelang
 } // namespace mlir
 
@@ -15,8 +15,13 @@
 namespace mlir {
 namespace concretelang {
 
+/// Creates the pass decomposing big integers into chunks. The carries of
+/// chunked additions are propagated with a ripple carry, or with a parallel
+/// prefix if it is expected to be faster with `parallelism` table lookups
+/// running concurrently.
 std::unique_ptr<mlir::OperationPass<>>
-createFHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth);
+createFHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth,
+                             unsigned int parallelism = 1);
 
 } // namespace concretelang
 } // namespace mlir
@@ -17,6 +17,10 @@ namespace concretelang {
 std::unique_ptr<mlir::OperationPass<>>
 createFHELinalgTilingMarkerPass(llvm::ArrayRef<int64_t> tileSizes);
 
+std::unique_ptr<mlir::OperationPass<>>
+createFHELinalgAutoTilingMarkerPass(uint64_t ciphertextSize,
+                                    uint64_t cacheBudget, uint64_t numWorkers);
+
 std::unique_ptr<mlir::OperationPass<>> createFHELinalgTilingPass();
 } // namespace concretelang
 } // namespace mlir
@@ -17,8 +17,25 @@ class BufferizeTypeConverter;
 class RewritePatternSet;
 
 namespace concretelang {
+
+/// Estimated costs of the FHE operations, in the complexity unit of the
+/// optimizer, driving the granularity of the dataflow tasks.
+struct DataflowTaskCostModel {
+  /// Cost of a bootstrap, including its keyswitch.
+  double bootstrapCost = 0.;
+  /// Cost of a leveled operation on a ciphertext.
+  double leveledCost = 0.;
+  /// Operations cheaper than this are not worth the overhead of a task and
+  /// are sunk in the tasks consuming their results.
+  double minTaskCost = 0.;
+  /// Operations costlier than this are split in several tasks, if possible.
+  /// Splitting is disabled if zero.
+  double maxTaskCost = 0.;
+};
+
 std::unique_ptr<mlir::Pass>
-createBuildDataflowTaskGraphPass(bool debug = false);
+createBuildDataflowTaskGraphPass(bool debug = false,
+                                 DataflowTaskCostModel costModel = {});
 std::unique_ptr<mlir::Pass> createLowerDataflowTasksPass(bool debug = false);
 std::unique_ptr<mlir::Pass>
 createBufferizeDataflowTaskOpsPass(bool debug = false);
@@ -19,6 +19,8 @@ std::unique_ptr<mlir::OperationPass<>> createTFHEOptimizationPass();
 std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
     createTFHECircuitSolutionParametrizationPass(
         std::optional<concrete_optimizer::dag::CircuitSolution>);
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
+createTFHEOutputShrinkingPass();
 } // namespace concretelang
 } // namespace mlir
 
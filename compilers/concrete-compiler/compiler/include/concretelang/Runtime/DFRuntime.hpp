@@ -25,6 +25,8 @@ bool _dfr_is_jit();
 bool _dfr_is_root_node();
 bool _dfr_use_omp();
 bool _dfr_is_distributed();
+/// Returns whether the calling thread runs a dataflow task.
+bool _dfr_in_task();
 
 typedef enum _dfr_task_arg_type {
   _DFR_TASK_ARG_BASE = 0,
@@ -9,6 +9,8 @@
 #include "concrete-cpu.h"
 #include "concretelang/Common/Error.h"
 #include "concretelang/Common/Keysets.h"
+#include "concretelang/Runtime/huge_pages.h"
+#include "concretelang/Runtime/numa.h"
 #include <assert.h>
 #include <complex>
 #include <map>
@@ -39,6 +41,11 @@ typedef struct FFT {
   size_t polynomial_size;
 } FFT;
 
+/// A bootstrap key converted to the Fourier domain, on huge pages if enabled.
+typedef std::vector<std::complex<double>,
+                    huge_pages::Allocator<std::complex<double>>>
+    FourierBootstrapKey;
+
 typedef struct RuntimeContext {
 
   RuntimeContext() = delete;
@@ -55,11 +62,29 @@ typedef struct RuntimeContext {
   };
 
   virtual const uint64_t *keyswitch_key_buffer(size_t keyId) {
+    if (!numa_replicas.empty())
+      return numa_replicas[numa::current_node()].keyswitch_keys[keyId].get();
+    if (!keyswitch_keys.empty())
+      return keyswitch_keys[keyId].get();
     return serverKeyset.lweKeyswitchKeys[keyId].getBuffer().data();
   }
 
+  /// Returns the precision of the integers of a keyswitch key, i.e. the log2
+  /// of the ciphertext modulus it operates on.
+  virtual uint32_t keyswitch_key_precision(size_t keyId) {
+    return serverKeyset.lweKeyswitchKeys[keyId]
+        .getInfo()
+        .asReader()
+        .getParams()
+        .getIntegerPrecision();
+  }
+
   virtual const std::complex<double> *
   fourier_bootstrap_key_buffer(size_t keyId) {
+    if (!numa_replicas.empty())
+      return numa_replicas[numa::current_node()]
+          .fourier_bootstrap_keys[keyId]
+          .get();
     return fourier_bootstrap_keys[keyId]->data();
   }
 
@@ -71,13 +96,35 @@ typedef struct RuntimeContext {
 
   const ServerKeyset getKeys() const { return serverKeyset; }
 
+  /// Returns the number of bytes mapped for the copies of the keys, replicated
+  /// on the NUMA nodes or on huge pages, rounded up to the size of the pages.
+  size_t key_copies_size() const;
+
 protected:
+  /// The keyswitch keys and the Fourier bootstrap keys bound to the memory of
+  /// a NUMA node: the original keys lying on the node, or their copies, whose
+  /// mapped size is `size`.
+  struct NumaReplica {
+    std::vector<std::shared_ptr<const uint64_t>> keyswitch_keys;
+    std::vector<std::shared_ptr<const std::complex<double>>>
+        fourier_bootstrap_keys;
+    size_t size = 0;
+  };
+
   ServerKeyset serverKeyset;
-  std::vector<std::shared_ptr<std::vector<std::complex<double>>>>
-      fourier_bootstrap_keys;
+  std::vector<std::shared_ptr<FourierBootstrapKey>> fourier_bootstrap_keys;
   std::vector<FFT> ffts;
-  std::pair<FFT, std::shared_ptr<std::vector<std::complex<double>>>>
+  /// The replicas of the keys, by NUMA node, empty unless replication is
+  /// enabled on a machine with several nodes.
+  std::vector<NumaReplica> numa_replicas;
+  /// The copies of the keyswitch keys on huge pages, empty unless huge pages
+  /// are enabled and the keys aren't replicated.
+  std::vector<std::shared_ptr<const uint64_t>> keyswitch_keys;
+  size_t keyswitch_keys_size = 0;
+  std::pair<FFT, std::shared_ptr<FourierBootstrapKey>>
   convert_to_fourier_domain(LweBootstrapKey &bsk);
+  void replicate_on_numa_nodes();
+  void copy_keyswitch_keys_on_huge_pages();
 
 #ifdef CONCRETELANG_CUDA_SUPPORT
 public:
@@ -152,6 +199,7 @@ struct DistributedRuntimeContext : public RuntimeContext {
 
   using RuntimeContext::RuntimeContext;
   const uint64_t *keyswitch_key_buffer(size_t keyId) override;
+  uint32_t keyswitch_key_precision(size_t keyId) override;
   const std::complex<double> *
   fourier_bootstrap_key_buffer(size_t keyId) override;
   const uint64_t *fp_keyswitch_key_buffer(size_t keyId) override;
@@ -161,7 +209,7 @@ private:
   void getBSKonNode(size_t keyId);
   std::mutex cm_guard;
   std::map<size_t, LweKeyswitchKey> ksks;
-  std::map<size_t, std::shared_ptr<std::vector<std::complex<double>>>> fbks;
+  std::map<size_t, std::shared_ptr<FourierBootstrapKey>> fbks;
   std::map<size_t, FFT> dffts;
   std::map<size_t, PackingKeyswitchKey> pksks;
 };
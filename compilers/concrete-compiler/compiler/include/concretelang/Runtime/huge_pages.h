@@ -0,0 +1,97 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_RUNTIME_HUGE_PAGES_H
+#define CONCRETELANG_RUNTIME_HUGE_PAGES_H
+
+#include <memory>
+#include <new>
+#include <stddef.h>
+
+namespace mlir {
+namespace concretelang {
+namespace huge_pages {
+
+/// The size of the smallest huge pages, below which buffers stay on the
+/// default pages.
+const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/// The pages backing a memory area.
+enum class Pages {
+  DEFAULT,
+  TRANSPARENT,
+  HUGETLB_2MB,
+  HUGETLB_1GB,
+};
+
+/// Returns whether the evaluation keys and the large ciphertext batches are
+/// backed by huge pages. Enabled by setting CONCRETE_HUGE_PAGES.
+bool enabled();
+
+/// Returns the name of `pages`, for reports.
+const char *name(Pages pages);
+
+/// Maps `size` bytes of zeroed memory. If huge pages are enabled, tries the 1
+/// GB then the 2 MB pages of the hugetlb pool, then the transparent huge
+/// pages, and warns once when falling back to the default pages. Returns
+/// nullptr on failure.
+void *allocate(size_t size);
+
+/// Unmaps memory mapped by `allocate`.
+void deallocate(void *ptr);
+
+/// Returns the pages backing memory mapped by `allocate`.
+Pages pages_of(const void *ptr);
+
+/// Returns the number of bytes currently mapped by `allocate` on `pages`.
+size_t mapped_size(Pages pages);
+
+/// Returns the number of bytes mapped by `allocate` for `ptr`, i.e. the size
+/// requested rounded up to the size of its pages, or 0 if `ptr` wasn't mapped
+/// by `allocate`.
+size_t mapped_size_of(const void *ptr);
+
+/// Advises the kernel to back the pages of `[ptr, ptr + size)` not touched
+/// yet by transparent huge pages, if huge pages are enabled. Only the huge
+/// pages lying entirely inside the range are advised, such that the memory
+/// around it is left alone. Used on the buffers allocated by the circuits.
+void advise(void *ptr, size_t size);
+
+/// A standard allocator mapping the allocations of at least a huge page with
+/// `allocate` when huge pages are enabled.
+template <typename T> struct Allocator {
+  typedef T value_type;
+
+  Allocator() = default;
+  template <typename U> Allocator(const Allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    if (!enabled() || n * sizeof(T) < HUGE_PAGE_SIZE)
+      return std::allocator<T>().allocate(n);
+    auto ptr = (T *)huge_pages::allocate(n * sizeof(T));
+    if (ptr == nullptr)
+      throw std::bad_alloc();
+    return ptr;
+  }
+
+  void deallocate(T *ptr, size_t n) {
+    if (!enabled() || n * sizeof(T) < HUGE_PAGE_SIZE)
+      return std::allocator<T>().deallocate(ptr, n);
+    huge_pages::deallocate(ptr);
+  }
+
+  template <typename U> bool operator==(const Allocator<U> &) const {
+    return true;
+  }
+  template <typename U> bool operator!=(const Allocator<U> &) const {
+    return false;
+  }
+};
+
+} // namespace huge_pages
+} // namespace concretelang
+} // namespace mlir
+
+#endif
@@ -6,9 +6,11 @@
 #ifndef CONCRETELANG_DFR_KEY_MANAGER_HPP
 #define CONCRETELANG_DFR_KEY_MANAGER_HPP
 
+#include <list>
 #include <memory>
 #include <mutex>
 #include <stdlib.h>
+#include <string>
 #include <utility>
 
 #include <hpx/include/runtime.hpp>
@@ -39,19 +41,21 @@ template <typename LweKeyType> struct KeyWrapper {
   std::vector<LweKeyType> keys;
 
   KeyWrapper() {}
-  KeyWrapper(KeyWrapper &&moved) noexcept : keys(moved.keys) {}
+  KeyWrapper(KeyWrapper &&moved) noexcept : keys(std::move(moved.keys)) {}
   KeyWrapper(const KeyWrapper &kw) : keys(kw.keys) {}
   KeyWrapper &operator=(const KeyWrapper &rhs) {
     this->keys = rhs.keys;
     return *this;
   }
-  KeyWrapper(std::vector<LweKeyType> keyvec) : keys(keyvec) {}
+  KeyWrapper(std::vector<LweKeyType> keyvec) : keys(std::move(keyvec)) {}
   friend class hpx::serialization::access;
   template <class Archive>
   void save(Archive &ar, const unsigned int version) const {
     ar << (size_t)keys.size();
-    for (auto k : keys) {
-      auto info = k.getInfo();
+    // Compressed keys are sent seeded and decompressed on the receiving
+    // node when first used.
+    for (const auto &k : keys) {
+      const auto &info = k.getInfo();
       auto maybe_info_string = info.writeBinaryToString();
       assert(maybe_info_string.has_value());
       auto info_string = maybe_info_string.value();
@@ -80,7 +84,7 @@ template <typename LweKeyType> struct KeyWrapper {
       auto buffer = std::make_shared<std::vector<uint64_t>>();
       buffer->resize(key_size);
       ar >> hpx::serialization::make_array(buffer->data(), key_size);
-      keys.push_back(LweKeyType(buffer, info));
+      keys.push_back(LweKeyType::fromTransportBuffer(buffer, info));
     }
   }
   HPX_SERIALIZATION_SPLIT_MEMBER()
@@ -103,17 +107,59 @@ bool operator==(const KeyWrapper<LweKeyType> &lhs,
 /************************/
 
 struct RuntimeContextManager {
-  // TODO: this is only ok so long as we don't change keys. Once we
-  // use multiple keys, should have a map.
   RuntimeContext *context;
+  // Whether the context is owned by the manager outside of the cache.
   bool allocated = false;
   bool lazy_key_transfer = false;
 
-  RuntimeContextManager(bool lazy = false) : lazy_key_transfer(lazy) {
+  // Keysets already distributed to the remote nodes, identified by
+  // their SHA-256 digest, from the least to the most recently used. The
+  // root node only records the digests, while the remote nodes
+  // keep the contexts built from the keys. As both sides see the same
+  // sequence of keysets, the root node knows which keysets are cached
+  // on the remote nodes and need not be broadcast again.
+  std::list<std::pair<std::string, RuntimeContext *>> keyset_cache;
+  size_t keyset_cache_size;
+
+  RuntimeContextManager(bool lazy = false, size_t cache_size = 1)
+      : lazy_key_transfer(lazy), keyset_cache_size(cache_size) {
     context = nullptr;
     _dfr_node_level_runtime_context_manager = this;
   }
 
+  ~RuntimeContextManager() {
+    for (auto &entry : keyset_cache)
+      delete entry.second;
+  }
+
+  /// Looks up the keyset `digest` in the cache and marks it as the most
+  /// recently used. Returns whether it was found, and its context on
+  /// remote nodes.
+  bool lookupKeyset(const std::string &digest, RuntimeContext *&cached) {
+    for (auto it = keyset_cache.begin(); it != keyset_cache.end(); ++it) {
+      if (it->first == digest) {
+        keyset_cache.splice(keyset_cache.end(), keyset_cache, it);
+        cached = it->second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Inserts the keyset `digest` in the cache, evicting the least
+  /// recently used keysets beyond the size of the cache. Returns
+  /// whether the context is now owned by the cache.
+  bool insertKeyset(const std::string &digest, RuntimeContext *ctx) {
+    if (keyset_cache_size == 0)
+      return false;
+    while (keyset_cache.size() >= keyset_cache_size) {
+      delete keyset_cache.front().second;
+      keyset_cache.pop_front();
+    }
+    keyset_cache.emplace_back(digest, ctx);
+    return true;
+  }
+
   void setContext(void *ctx) {
     assert(context == nullptr &&
            "Only one RuntimeContext can be used at a time.");
@@ -137,17 +183,34 @@ struct RuntimeContextManager {
       allocated = true;
     }
 
-    // Root node broadcasts the evaluation keys and each remote
-    // instantiates a local RuntimeContext.
+    // Root node broadcasts the digest of the keyset, then the
+    // evaluation keys unless the remote nodes already have them in
+    // their cache, and each remote instantiates a local RuntimeContext.
+    // The digest is computed once per keyset, and shared by the copies
+    // of the keyset held by the contexts.
     if (_dfr_is_root_node()) {
-      KeyWrapper<LweKeyswitchKey> kskw(context->getKeys().lweKeyswitchKeys);
-      KeyWrapper<LweBootstrapKey> bskw(context->getKeys().lweBootstrapKeys);
-      KeyWrapper<PackingKeyswitchKey> pkskw(
-          context->getKeys().packingKeyswitchKeys);
-      hpx::collectives::broadcast_to("ksk_keystore", kskw);
-      hpx::collectives::broadcast_to("bsk_keystore", bskw);
-      hpx::collectives::broadcast_to("pksk_keystore", pkskw);
+      const ServerKeyset keys = context->getKeys();
+      std::string digest = keys.getDigest();
+      hpx::collectives::broadcast_to("keyset_digest", digest);
+      RuntimeContext *cached;
+      if (lookupKeyset(digest, cached))
+        return;
+      insertKeyset(digest, nullptr);
+      KeyWrapper<LweKeyswitchKey> kskw(keys.lweKeyswitchKeys);
+      KeyWrapper<LweBootstrapKey> bskw(keys.lweBootstrapKeys);
+      KeyWrapper<PackingKeyswitchKey> pkskw(keys.packingKeyswitchKeys);
+      hpx::collectives::broadcast_to("ksk_keystore", std::move(kskw));
+      hpx::collectives::broadcast_to("bsk_keystore", std::move(bskw));
+      hpx::collectives::broadcast_to("pksk_keystore", std::move(pkskw));
     } else {
+      std::string digest =
+          hpx::collectives::broadcast_from<std::string>("keyset_digest")
+              .get();
+      RuntimeContext *cached;
+      if (lookupKeyset(digest, cached)) {
+        context = cached;
+        return;
+      }
       auto kskFut =
           hpx::collectives::broadcast_from<KeyWrapper<LweKeyswitchKey>>(
               "ksk_keystore");
@@ -160,19 +223,20 @@ struct RuntimeContextManager {
       KeyWrapper<LweKeyswitchKey> kskw = kskFut.get();
       KeyWrapper<LweBootstrapKey> bskw = bskFut.get();
       KeyWrapper<PackingKeyswitchKey> pkskw = pkskFut.get();
-      context = new mlir::concretelang::RuntimeContext(
-          ServerKeyset{bskw.keys, kskw.keys, pkskw.keys});
+      context = new mlir::concretelang::RuntimeContext(ServerKeyset{
+          std::move(bskw.keys), std::move(kskw.keys), std::move(pkskw.keys)});
+      allocated = !insertKeyset(digest, context);
     }
   }
 
   RuntimeContext *getContext() { return context; }
 
   void clearContext() {
-    if (context != nullptr)
-      // On root node deallocate only if allocated independently here
-      if (!_dfr_is_root_node() || allocated)
-        delete context;
+    // Deallocate only if allocated here and not kept in the cache
+    if (context != nullptr && allocated)
+      delete context;
     context = nullptr;
+    allocated = false;
   }
 };
 
@@ -0,0 +1,63 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_RUNTIME_NUMA_H
+#define CONCRETELANG_RUNTIME_NUMA_H
+
+#include <stddef.h>
+
+namespace mlir {
+namespace concretelang {
+namespace numa {
+
+/// Returns whether the evaluation keys are replicated on every NUMA node,
+/// such that each thread reads the keys from its local memory. Enabled by
+/// setting CONCRETE_NUMA_REPLICATION, and only effective on machines with
+/// several NUMA nodes.
+bool replication_enabled();
+
+/// Returns whether the worker threads of the runtime are pinned to the cores
+/// of the machine. Enabled by setting CONCRETE_PIN_THREADS.
+bool pinning_enabled();
+
+/// Returns the number of NUMA nodes of the machine, at least one.
+size_t num_nodes();
+
+/// Returns the index, in [0, num_nodes()), of the NUMA node of the core the
+/// calling thread runs on.
+size_t current_node();
+
+/// Pins the calling thread to the `index`-th core of the machine, the cores
+/// being enumerated node by node. Returns false if the thread couldn't be
+/// pinned.
+bool pin_current_thread(size_t index);
+
+/// Pins the worker threads of the OpenMP runtime started by the calling
+/// thread, once, if pinning is enabled and neither OMP_PLACES nor
+/// OMP_PROC_BIND is set: the `i`-th thread of the team is pinned to the `i`-th
+/// core, such that the team takes the first cores, and the dataflow runtime
+/// binds its threads to the following ones. The calling thread isn't pinned.
+/// Called by the runtime context for the loops parallelized with OpenMP, and
+/// by the dataflow runtime; otherwise the OpenMP threads are placed by
+/// OMP_PLACES and OMP_PROC_BIND.
+void pin_openmp_workers();
+
+/// Returns the index of the NUMA node holding all the pages of the `size`
+/// bytes at `ptr`, or -1 if they are spread over several nodes or unknown.
+int node_of_area(const void *ptr, size_t size);
+
+/// Allocates `size` bytes bound to the memory of the NUMA node `node`, on
+/// huge pages if enabled, and populates its pages. Returns nullptr on
+/// failure, including when the node is short of memory.
+void *allocate_on_node(size_t size, size_t node);
+
+/// Frees memory allocated by `allocate_on_node`.
+void free_on_node(void *ptr);
+
+} // namespace numa
+} // namespace concretelang
+} // namespace mlir
+
+#endif
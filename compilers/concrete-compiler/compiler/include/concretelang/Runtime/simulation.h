@@ -24,6 +24,58 @@ uint64_t sim_encrypt_lwe_u64(uint64_t message, uint32_t lwe_dim, void *csprng);
 /// \return uint64_t
 uint64_t sim_neg_lwe_u64(uint64_t plaintext);
 
+/// \brief simulate the addition of the noisy plaintexts of two 1D memrefs
+void sim_batched_add_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
+                             uint64_t out_offset, uint64_t out_size,
+                             uint64_t out_stride, uint64_t *ct0_allocated,
+                             uint64_t *ct0_aligned, uint64_t ct0_offset,
+                             uint64_t ct0_size, uint64_t ct0_stride,
+                             uint64_t *ct1_allocated, uint64_t *ct1_aligned,
+                             uint64_t ct1_offset, uint64_t ct1_size,
+                             uint64_t ct1_stride);
+
+/// \brief simulate the addition of each noisy plaintext of a 1D memref and
+/// the plaintext of the same index in another 1D memref
+void sim_batched_add_plaintext_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t *pt_allocated, uint64_t *pt_aligned,
+    uint64_t pt_offset, uint64_t pt_size, uint64_t pt_stride);
+
+/// \brief simulate the addition of each noisy plaintext of a 1D memref and
+/// the same plaintext
+void sim_batched_add_plaintext_cst_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t plaintext);
+
+/// \brief simulate the multiplication of each noisy plaintext of a 1D memref
+/// by the cleartext of the same index in another 1D memref
+void sim_batched_mul_cleartext_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t *cleartext_allocated,
+    uint64_t *cleartext_aligned, uint64_t cleartext_offset,
+    uint64_t cleartext_size, uint64_t cleartext_stride);
+
+/// \brief simulate the multiplication of each noisy plaintext of a 1D memref
+/// by the same cleartext
+void sim_batched_mul_cleartext_cst_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t cleartext);
+
+/// \brief simulate the negation of each noisy plaintext of a 1D memref
+void sim_batched_neg_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
+                             uint64_t out_offset, uint64_t out_size,
+                             uint64_t out_stride, uint64_t *ct0_allocated,
+                             uint64_t *ct0_aligned, uint64_t ct0_offset,
+                             uint64_t ct0_size, uint64_t ct0_stride);
+
 /// \brief simulate a keyswitch on a noisy plaintext
 ///
 /// \param plaintext noisy plaintext
@@ -36,6 +88,14 @@ uint64_t sim_keyswitch_lwe_u64(uint64_t plaintext, uint32_t level,
                                uint32_t base_log, uint32_t input_lwe_dim,
                                uint32_t output_lwe_dim);
 
+/// \brief simulate a keyswitch on each noisy plaintext of a 1D memref
+void sim_batched_keyswitch_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint32_t level, uint32_t base_log,
+    uint32_t input_lwe_dim, uint32_t output_lwe_dim);
+
 /// \brief simulate a bootstrap on a noisy plaintext
 ///
 /// \param plaintext noisy plaintext
@@ -57,6 +117,28 @@ uint64_t sim_bootstrap_lwe_u64(uint64_t plaintext, uint64_t *tlu_allocated,
                                uint32_t level, uint32_t base_log,
                                uint32_t glwe_dim);
 
+/// \brief simulate a bootstrap on each noisy plaintext of a 1D memref, with
+/// the same lookup table
+void sim_batched_bootstrap_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint64_t *tlu_allocated, uint64_t *tlu_aligned,
+    uint64_t tlu_offset, uint64_t tlu_size, uint64_t tlu_stride,
+    uint32_t input_lwe_dim, uint32_t poly_size, uint32_t level,
+    uint32_t base_log, uint32_t glwe_dim);
+
+/// \brief simulate a bootstrap on each noisy plaintext of a 1D memref, with
+/// the lookup table of the same index in a 2D memref
+void sim_batched_mapped_bootstrap_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint64_t *tlu_allocated, uint64_t *tlu_aligned,
+    uint64_t tlu_offset, uint64_t tlu_size0, uint64_t tlu_size1,
+    uint64_t tlu_stride0, uint64_t tlu_stride1, uint32_t input_lwe_dim,
+    uint32_t poly_size, uint32_t level, uint32_t base_log, uint32_t glwe_dim);
+
 /// simulate a WoP PBS
 void sim_wop_pbs_crt(
     // Output 1D memref
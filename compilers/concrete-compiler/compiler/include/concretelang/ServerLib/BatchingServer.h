@@ -0,0 +1,135 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_SERVERLIB_BATCHING_SERVER_H
+#define CONCRETELANG_SERVERLIB_BATCHING_SERVER_H
+
+#include "boost/outcome.h"
+#include "concrete-protocol.capnp.h"
+#include "concretelang/Common/Error.h"
+#include "concretelang/Common/Keysets.h"
+#include "concretelang/Common/Protocol.h"
+#include "concretelang/Common/Values.h"
+#include "concretelang/ServerLib/ServerLib.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using concretelang::error::Result;
+using concretelang::keysets::ServerKeyset;
+using concretelang::values::TransportValue;
+
+namespace concretelang {
+namespace serverlib {
+
+/// The options of a batching server.
+struct BatchingServerOptions {
+  /// The maximal time the oldest pending request waits for other requests to
+  /// join its batch before the batch is executed anyway.
+  std::chrono::microseconds maxLatency = std::chrono::microseconds(2000);
+};
+
+/// A server coalescing concurrent requests to the same circuit.
+///
+/// The batching server wraps circuits compiled with an additional leading
+/// batch dimension on every input and output gate, one circuit per supported
+/// batch size. Requests are submitted against the un-batched signature of the
+/// circuits (see `getUnbatchedCircuitInfo`), stacked along the leading
+/// dimension, and evaluated in a single invocation of a batched circuit. The
+/// results are then split and handed back to the individual requests.
+///
+/// A batch is executed as soon as it fills the largest circuit, or when the
+/// oldest pending request has waited for `maxLatency`. A batch is executed by
+/// the smallest circuit it fits in, padded with copies of its first request
+/// whose results are dropped, such that a lone request doesn't pay for a full
+/// batch when a circuit of batch size 1 is given.
+class BatchingServer {
+public:
+  /// Creates a batching server for circuits whose gates all share the same
+  /// leading batch dimension, and which have the same un-batched signature.
+  static Result<std::unique_ptr<BatchingServer>>
+  create(std::vector<ServerCircuit> batchedCircuits,
+         ServerKeyset serverKeyset,
+         BatchingServerOptions options = BatchingServerOptions(),
+         bool useSimulation = false);
+
+  /// Creates a batching server for a single circuit.
+  static Result<std::unique_ptr<BatchingServer>>
+  create(ServerCircuit batchedCircuit, ServerKeyset serverKeyset,
+         BatchingServerOptions options = BatchingServerOptions(),
+         bool useSimulation = false);
+
+  ~BatchingServer();
+
+  BatchingServer(const BatchingServer &) = delete;
+  BatchingServer &operator=(const BatchingServer &) = delete;
+
+  /// Submits a request to the server. The returned future is fulfilled once
+  /// the batch the request belongs to has been executed.
+  std::future<Result<std::vector<TransportValue>>>
+  submit(std::vector<TransportValue> args);
+
+  /// Submits a request and waits for its results.
+  Result<std::vector<TransportValue>> call(std::vector<TransportValue> args);
+
+  /// Returns the largest number of requests executed by a single invocation.
+  size_t getBatchSize() const { return batchSizes.back(); }
+
+  /// Returns the batch sizes of the circuits, in increasing order.
+  const std::vector<size_t> &getBatchSizes() const { return batchSizes; }
+
+  /// Returns the signature the requests are expected to follow. This is the
+  /// signature of the batched circuit with the leading dimension removed.
+  const Message<concreteprotocol::CircuitInfo> &
+  getUnbatchedCircuitInfo() const {
+    return unbatchedCircuitInfo;
+  }
+
+private:
+  struct Request {
+    std::vector<TransportValue> args;
+    std::chrono::steady_clock::time_point arrival;
+    std::promise<Result<std::vector<TransportValue>>> promise;
+  };
+
+  BatchingServer(std::vector<ServerCircuit> batchedCircuits,
+                 ServerKeyset serverKeyset, BatchingServerOptions options,
+                 bool useSimulation, std::vector<size_t> batchSizes,
+                 Message<concreteprotocol::CircuitInfo> unbatchedCircuitInfo);
+
+  /// Verifies that the arguments of a request match the un-batched signature.
+  Result<void> verify(const std::vector<TransportValue> &args);
+
+  /// The loop run by the worker thread.
+  void run();
+
+  /// Executes a batch of requests, and returns the results of each request.
+  Result<std::vector<std::vector<TransportValue>>>
+  execute(const std::vector<std::unique_ptr<Request>> &batch);
+
+  /// The batched circuits, by increasing batch size.
+  std::vector<ServerCircuit> batchedCircuits;
+  ServerKeyset serverKeyset;
+  BatchingServerOptions options;
+  bool useSimulation;
+  std::vector<size_t> batchSizes;
+  Message<concreteprotocol::CircuitInfo> unbatchedCircuitInfo;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::unique_ptr<Request>> pending;
+  bool stopping;
+  std::thread worker;
+};
+
+} // namespace serverlib
+} // namespace concretelang
+
+#endif
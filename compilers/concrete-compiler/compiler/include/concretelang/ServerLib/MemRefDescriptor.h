@@ -0,0 +1,216 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_SERVERLIB_MEMREF_DESCRIPTOR_H
+#define CONCRETELANG_SERVERLIB_MEMREF_DESCRIPTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "concretelang/Common/Values.h"
+#include "llvm/ADT/ArrayRef.h"
+
+namespace concretelang {
+namespace serverlib {
+
+using concretelang::values::Tensor;
+
+// Depending on the strides of the memref, iteration may not be linear in the
+// memory space (i.e. it may contain jumps). For this reason we have to compute
+// a memory index from the linear index of the iteration space. This structure
+// does just that.
+struct MultiDimIndexer {
+  std::vector<size_t> multiDimensionalIndex;
+  size_t offset;
+  const std::vector<size_t> &sizes;
+  const std::vector<size_t> &strides;
+
+  MultiDimIndexer(size_t offset, const std::vector<size_t> &sizes,
+                  const std::vector<size_t> &strides)
+      : sizes(sizes), strides(strides) {
+    size_t rank = sizes.size();
+    this->multiDimensionalIndex.resize(rank);
+    for (size_t i = 0; i < rank; i++) {
+      this->multiDimensionalIndex[i] = 0;
+    }
+    // this->sizes = sizes;
+    // this->strides = sizes;
+    this->offset = offset;
+  }
+
+  /// Increments the index.
+  void increment() {
+    size_t rank = sizes.size();
+    for (int r = rank - 1; r >= 0; r--) {
+      if (multiDimensionalIndex[r] < sizes[r] - 1) {
+        multiDimensionalIndex[r]++;
+        return;
+      }
+      multiDimensionalIndex[r] = 0;
+    }
+  }
+
+  /// Returns the current index.
+  size_t currentIndex() {
+    size_t rank = sizes.size();
+    size_t g_index = offset;
+    size_t default_stride = 1;
+    for (int r = rank - 1; r >= 0; r--) {
+      g_index += multiDimensionalIndex[r] *
+                 ((strides[r] == 0) ? default_stride : strides[r]);
+      default_stride *= sizes[r];
+    }
+    return g_index;
+  }
+};
+
+// A type representing the memref description of a tensor.
+struct MemRefDescriptor {
+  size_t precision;
+  bool isSigned;
+  void *allocated;
+  void *aligned;
+  size_t offset;
+  std::vector<size_t> sizes;
+  std::vector<size_t> strides;
+
+  /// Creates a memref descriptor referencing the data contained in a tensor.
+  template <typename T> static MemRefDescriptor fromTensor(Tensor<T> &input) {
+    std::vector<size_t> strides;
+    size_t stride = input.values.size();
+    for (size_t dim : input.dimensions) {
+      stride = (dim == 0 ? 0 : (stride / dim));
+      strides.push_back(stride);
+    }
+    return MemRefDescriptor{sizeof(T) * 8,
+                            std::is_signed<T>(),
+                            (void *)nullptr,
+                            (void *)input.values.data(),
+                            0,
+                            input.dimensions,
+                            strides};
+  }
+
+  /// Creates a memref descriptor from a vector of uint64_t, which is the way to
+  /// represent outputs in the current calling convention.
+  static MemRefDescriptor fromU64s(llvm::ArrayRef<uint64_t> raw,
+                                   size_t precision, bool isSigned) {
+    auto rank = (raw.size() - 3) / 2;
+    void *allocated = (void *)raw[0];
+    void *aligned = (void *)raw[1];
+    size_t offset = (size_t)raw[2];
+    std::vector<size_t> sizes(rank);
+    for (size_t i = 0; i < rank; i++) {
+      sizes[i] = (size_t)raw[3 + i];
+    }
+    std::vector<size_t> strides(rank);
+    for (size_t i = 0; i < rank; i++) {
+      strides[i] = (size_t)raw[3 + rank + i];
+    }
+    return MemRefDescriptor{
+        precision, isSigned, allocated, aligned, offset, sizes, strides,
+    };
+  }
+
+  /// Returns the number of elements of the memref.
+  size_t getLength() {
+    size_t output = 1;
+    for (size_t i = 0; i < sizes.size(); i++) {
+      output *= sizes[i];
+    }
+    return output;
+  }
+
+  /// Returns the number of innermost dimensions of the memref which are laid
+  /// out contiguously in memory, in row-major order.
+  size_t getContiguousRank() {
+    size_t rank = 0;
+    size_t blockLength = 1;
+    while (rank < sizes.size()) {
+      size_t r = sizes.size() - rank - 1;
+      if (sizes[r] != 1 && strides[r] != 0 && strides[r] != blockLength) {
+        break;
+      }
+      blockLength *= sizes[r];
+      rank++;
+    }
+    return rank;
+  }
+
+  /// Returns whether all the values of the memref are laid out contiguously in
+  /// memory, in row-major order.
+  bool isContiguous() { return getContiguousRank() == sizes.size(); }
+
+  // Creates a tensor holding the values referenced by a memref descriptor.
+  // With `release`, the memref must be contiguous, and the tensor adopts its
+  // buffer rather than copying it, calling `release` once done with it.
+  // Otherwise, the values are copied to a new tensor. The innermost
+  // dimensions laid out contiguously in memory are copied as blocks, which
+  // for the usual contiguous outputs of the circuits amounts to a single copy.
+  template <typename T>
+  Tensor<T> intoTensor(std::function<void()> release = nullptr) {
+    assert(sizeof(T) * 8 == precision);
+    assert(std::is_signed<T>() == isSigned);
+
+    T *memrefAligned = reinterpret_cast<T *>(aligned);
+    if (release) {
+      assert(isContiguous());
+      return Tensor<T>::adopt(memrefAligned + offset, sizes,
+                              std::move(release));
+    }
+
+    typename Tensor<T>::Storage values(getLength());
+    if (values.empty()) {
+      return Tensor<T>{std::move(values), sizes};
+    }
+
+    // We look for the innermost dimensions which are contiguous.
+    size_t outerRank = sizes.size() - getContiguousRank();
+    size_t blockLength = 1;
+    for (size_t r = outerRank; r < sizes.size(); r++) {
+      blockLength *= sizes[r];
+    }
+
+    // We create an indexer on the remaining outer dimensions, resolving the
+    // default strides as if the inner dimensions were still there.
+    std::vector<size_t> outerSizes(sizes.begin(), sizes.begin() + outerRank);
+    std::vector<size_t> outerStrides(outerRank);
+    size_t defaultStride = blockLength;
+    for (size_t r = outerRank; r-- > 0;) {
+      outerStrides[r] = (strides[r] == 0) ? defaultStride : strides[r];
+      defaultStride *= sizes[r];
+    }
+    auto indexer = MultiDimIndexer(offset, outerSizes, outerStrides);
+
+    // We copy the blocks one after the other.
+    for (size_t i = 0; i < values.size(); i += blockLength) {
+      std::copy_n(memrefAligned + indexer.currentIndex(), blockLength,
+                  values.begin() + i);
+      indexer.increment();
+    }
+
+    return Tensor<T>{std::move(values), sizes};
+  }
+
+  void intoOpaquePtrs(llvm::MutableArrayRef<void *> &opaquePtrs) {
+    opaquePtrs[0] = allocated;
+    opaquePtrs[1] = aligned;
+    opaquePtrs[2] = (void *)offset;
+    for (size_t i = 0; i < sizes.size(); i++) {
+      opaquePtrs[3 + i] = (void *)sizes[i];
+    }
+    for (size_t i = 0; i < strides.size(); i++) {
+      opaquePtrs[3 + sizes.size() + i] = (void *)strides[i];
+    }
+  }
+};
+
+} // namespace serverlib
+} // namespace concretelang
+
+#endif
@@ -0,0 +1,118 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_SERVERLIB_SERVER_KEY_STORE_H
+#define CONCRETELANG_SERVERLIB_SERVER_KEY_STORE_H
+
+#include "concretelang/Common/Error.h"
+#include "concretelang/Common/Keysets.h"
+#include "concretelang/Runtime/context.h"
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+using concretelang::error::Result;
+using concretelang::keysets::ServerKeyset;
+using mlir::concretelang::RuntimeContext;
+
+namespace concretelang {
+namespace serverlib {
+
+/// The options of a server key store.
+struct ServerKeyStoreOptions {
+  /// The maximal number of bytes of evaluation keys resident in memory,
+  /// including the bootstrap keys converted to the Fourier domain and the
+  /// copies of the keys on the NUMA nodes or on huge pages. Zero means no
+  /// limit.
+  size_t memoryBudget = 0;
+  /// The directory the keysets evicted from memory are written to. If empty,
+  /// only the runtime contexts are evicted, and the keys stay in memory.
+  std::string spillDirectory;
+};
+
+/// A store of the evaluation keysets of the clients of a server.
+///
+/// Keysets are registered under an identifier chosen by the server, e.g. the
+/// identifier of a client, and identical keysets registered under several
+/// identifiers are stored once. Keysets are identified by their SHA-256
+/// digest, and only shared once their keys are checked to be equal. The
+/// runtime context of a keyset, which holds its bootstrap keys converted to the
+/// Fourier domain, is built on the first call using the keyset, and shared by
+/// all the calls of all the circuits using it.
+///
+/// When the resident keys exceed the memory budget, the least recently used
+/// keysets are evicted: first their runtime contexts, then, if a spill
+/// directory is set, their keys, which are written to the spill directory and
+/// mapped back in memory when used again. Contexts in use by a call are
+/// released at the end of the call.
+class ServerKeyStore {
+public:
+  ServerKeyStore(ServerKeyStoreOptions options = ServerKeyStoreOptions())
+      : options(options) {}
+
+  ~ServerKeyStore();
+
+  ServerKeyStore(const ServerKeyStore &) = delete;
+  ServerKeyStore &operator=(const ServerKeyStore &) = delete;
+
+  /// Registers a keyset under `keysetId`, replacing the keyset previously
+  /// registered under the same identifier. Fails if a stored keyset has the
+  /// digest of `keyset` but different keys.
+  Result<void> add(const std::string &keysetId, ServerKeyset keyset);
+
+  /// Unregisters the keyset registered under `keysetId`.
+  Result<void> remove(const std::string &keysetId);
+
+  /// Returns the runtime context of the keyset registered under `keysetId`,
+  /// building it if it isn't resident.
+  Result<std::shared_ptr<RuntimeContext>>
+  getContext(const std::string &keysetId);
+
+  /// Returns the number of bytes of the keys resident in the store.
+  size_t getResidentSize();
+
+private:
+  struct StoredKeyset {
+    /// The number of identifiers the keyset is registered under.
+    size_t references = 0;
+    /// The keys, unless spilled to disk.
+    std::optional<ServerKeyset> keys;
+    size_t keysSize = 0;
+    /// The path of the keys on disk, once spilled.
+    std::string spillPath;
+    /// The runtime context, if resident.
+    std::shared_ptr<RuntimeContext> context;
+    size_t contextSize = 0;
+    /// The position of the keyset in the recency list.
+    std::list<std::string>::iterator recency;
+  };
+
+  /// Unregisters `keysetId`, the lock being held.
+  void unregister(const std::string &keysetId);
+
+  /// Makes the keys of `stored` resident, reading them from disk if spilled.
+  Result<void> load(const std::string &digest, StoredKeyset &stored);
+
+  /// Evicts the least recently used keysets but `used` until the resident
+  /// keys fit in the memory budget.
+  Result<void> evict(const std::string &used);
+
+  ServerKeyStoreOptions options;
+  std::mutex lock;
+  /// The digests of the keysets registered under each identifier.
+  std::map<std::string, std::string> digests;
+  std::map<std::string, StoredKeyset> keysets;
+  /// The digests of the keysets, from the least to the most recently used.
+  std::list<std::string> recency;
+  size_t residentSize = 0;
+};
+
+} // namespace serverlib
+} // namespace concretelang
+
+#endif
@@ -18,14 +18,22 @@
 #include <dlfcn.h>
 #include <functional>
 #include <memory>
+#include <variant>
 #include <vector>
 
 using concretelang::keysets::ServerKeyset;
+using concretelang::transformers::ArgStreamTransformer;
 using concretelang::transformers::ArgTransformer;
 using concretelang::transformers::ReturnTransformer;
 using concretelang::transformers::TransformerFactory;
 using concretelang::values::Value;
 
+namespace mlir {
+namespace concretelang {
+struct RuntimeContext;
+} // namespace concretelang
+} // namespace mlir
+
 namespace concretelang {
 namespace serverlib {
 
@@ -42,6 +50,22 @@ private:
   void *libraryHandle;
 };
 
+/// An opaque reference to a value resident on the server, produced by a
+/// circuit call, and usable as argument of later calls.
+struct ServerValueHandle {
+  uint64_t id;
+};
+
+/// An argument of a circuit call, either transported from the client, or
+/// already resident on the server.
+typedef std::variant<TransportValue, ServerValueHandle> ServerArgument;
+
+/// The store of the values resident on the server.
+class ServerValueStore;
+
+/// The store of the evaluation keysets of the clients of the server.
+class ServerKeyStore;
+
 class ServerCircuit {
   friend class ServerProgram;
 
@@ -50,12 +74,26 @@ public:
   Result<std::vector<TransportValue>> call(const ServerKeyset &serverKeyset,
                                            std::vector<TransportValue> &args);
 
+  /// Call the circuit with public arguments, using the keyset registered
+  /// under `keysetId` in the key store.
+  Result<std::vector<TransportValue>> call(ServerKeyStore &keyStore,
+                                           const std::string &keysetId,
+                                           std::vector<TransportValue> &args);
+
+  /// Call the circuit with public arguments streamed to the file descriptors
+  /// `argFds`, e.g. by `ClientCircuit::prepareInputToFd`, one per argument.
+  Result<std::vector<TransportValue>>
+  callFromFds(const ServerKeyset &serverKeyset, const std::vector<int> &argFds);
+
   Result<std::vector<TransportValue>>
   simulate(std::vector<TransportValue> &args);
 
   /// Returns the name of this circuit.
   std::string getName();
 
+  /// Returns the signature of this circuit.
+  const Message<concreteprotocol::CircuitInfo> &getCircuitInfo();
+
 private:
   ServerCircuit() = default;
 
@@ -64,13 +102,26 @@ private:
                     std::shared_ptr<DynamicModule> dynamicModule,
                     bool useSimulation);
 
-  void invoke(const ServerKeyset &serverKeyset);
+  Result<std::vector<TransportValue>>
+  call(mlir::concretelang::RuntimeContext *runtimeContext,
+       std::vector<TransportValue> &args);
+
+  /// Invokes the circuit function on the args buffer, and transforms the
+  /// results into transport values.
+  Result<std::vector<TransportValue>>
+  callWithArgsBuffer(mlir::concretelang::RuntimeContext *runtimeContext);
+
+  /// Invokes the circuit function on the values pointed by `args`, which are
+  /// only read, and loads the results in the returns buffer.
+  void invoke(mlir::concretelang::RuntimeContext *runtimeContext,
+              const std::vector<Value *> &args);
 
   Message<concreteprotocol::CircuitInfo> circuitInfo;
   bool useSimulation;
   void (*func)(void *...);
   std::shared_ptr<DynamicModule> dynamicModule;
   std::vector<ArgTransformer> argTransformers;
+  std::vector<ArgStreamTransformer> argStreamTransformers;
   std::vector<ReturnTransformer> returnTransformers;
   std::vector<Value> argsBuffer;
   std::vector<Value> returnsBuffer;
@@ -90,10 +141,40 @@ public:
 
   Result<ServerCircuit> getServerCircuit(const std::string &circuitName);
 
+  /// Calls a circuit, keeping the results on the server. Arguments can be
+  /// either transport values, or handles to values returned by previous calls
+  /// to this program, in which case they are passed to the circuit without
+  /// being serialized. The handles of the results are returned.
+  Result<std::vector<ServerValueHandle>>
+  callWithHandles(const std::string &circuitName,
+                  const ServerKeyset &serverKeyset,
+                  const std::vector<ServerArgument> &args);
+
+  /// Calls a circuit, keeping the results on the server, using the keyset
+  /// registered under `keysetId` in the key store.
+  Result<std::vector<ServerValueHandle>>
+  callWithHandles(const std::string &circuitName, ServerKeyStore &keyStore,
+                  const std::string &keysetId,
+                  const std::vector<ServerArgument> &args);
+
+  /// Turns a value resident on the server into a transport value, to be sent
+  /// to the client.
+  Result<TransportValue> fetch(ServerValueHandle handle);
+
+  /// Frees a value resident on the server. The handle can not be used anymore
+  /// afterwards.
+  Result<void> release(ServerValueHandle handle);
+
 private:
   ServerProgram() = default;
 
+  Result<std::vector<ServerValueHandle>>
+  callWithHandles(const std::string &circuitName,
+                  mlir::concretelang::RuntimeContext *runtimeContext,
+                  const std::vector<ServerArgument> &args);
+
   std::vector<ServerCircuit> serverCircuits;
+  std::shared_ptr<ServerValueStore> valueStore;
 };
 
 } // namespace serverlib
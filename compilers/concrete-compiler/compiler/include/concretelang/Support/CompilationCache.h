@@ -0,0 +1,60 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#ifndef CONCRETELANG_SUPPORT_COMPILATIONCACHE_H
+#define CONCRETELANG_SUPPORT_COMPILATIONCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+#include "concretelang/Support/CompilerEngine.h"
+
+namespace mlir {
+namespace concretelang {
+
+/// An on-disk cache of the artifacts of library compilations.
+///
+/// Every entry is a directory of the cache directory, named after the key of
+/// the compilation, and holding the shared and static libraries, the program
+/// info and the compilation feedback of the library. The key is a hash of the
+/// canonicalized input modules, of everything configuring the compilation,
+/// and of the build of the compiler, such that an entry is only reused for a
+/// compilation that would produce the same artifacts.
+class CompilationCache {
+public:
+  CompilationCache(std::string cacheDirPath) : cacheDirPath(cacheDirPath) {}
+
+  /// Returns the key of the compilation of `canonicalModules`, configured by
+  /// `configuration`, a printout of all the options and settings of the
+  /// compiler engine.
+  static std::string getKey(const std::vector<std::string> &canonicalModules,
+                            llvm::StringRef configuration);
+
+  /// Copies the requested artifacts of the entry of `key` to the output
+  /// directory of `library`, and loads them in `library`. Returns false if
+  /// the entry doesn't hold all the requested artifacts.
+  llvm::Expected<bool> restore(llvm::StringRef key,
+                               CompilerEngine::Library &library,
+                               bool sharedLib, bool staticLib,
+                               bool clientParameters, bool compilationFeedback);
+
+  /// Stores the artifacts emitted by `library` in the entry of `key`,
+  /// replacing any previous entry.
+  llvm::Error store(llvm::StringRef key,
+                    const CompilerEngine::Library &library);
+
+private:
+  std::string getEntryPath(llvm::StringRef key);
+
+  std::string cacheDirPath;
+};
+
+} // namespace concretelang
+} // namespace mlir
+
+#endif
@@ -67,6 +67,10 @@ struct CircuitCompilationFeedback {
   /// @brief memory usage per location
   std::map<std::string, int64_t> memoryUsagePerLoc;
 
+  /// @brief the number of bytes of the arena preallocated for the buffers of
+  /// the circuit by the memory planning, 0 if its memory isn't planned
+  uint64_t plannedMemoryPeak = 0;
+
   /// Fill the sizes from the program info.
   void fillFromCircuitInfo(concreteprotocol::CircuitInfo::Reader params);
 };
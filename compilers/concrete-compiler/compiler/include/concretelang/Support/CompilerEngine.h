@@ -79,6 +79,18 @@ struct CompilationOptions {
 
   std::optional<std::vector<int64_t>> fhelinalgTileSizes;
 
+  /// When set, the tile sizes of the FHELinalg operations which are not
+  /// tiled explicitly are chosen by the compiler, from the size of the
+  /// ciphertexts, the cache budget and the number of workers.
+  bool fhelinalgAutoTiling;
+  /// The number of bytes of ciphertexts a tile should keep in cache. 0 lets
+  /// the compiler use the size of the L2 cache of the host.
+  uint64_t tilingCacheBudget;
+
+  /// When set, the buffers of the circuits are placed in an arena allocated
+  /// once per invocation, buffers with disjoint live ranges sharing memory.
+  bool memoryPlanning;
+
   optimizer::Config optimizerConfig;
 
   /// When decomposing big integers into chunks, chunkSize is the total number
@@ -87,6 +99,10 @@ struct CompilationOptions {
   bool chunkIntegers;
   unsigned int chunkSize;
   unsigned int chunkWidth;
+  /// The number of table lookups on chunks expected to run concurrently, used
+  /// to choose how carries are propagated between chunks. 0 lets the compiler
+  /// infer it from the parallelization options.
+  unsigned int chunkParallelism;
 
   /// When compiling from a dialect lower than FHE, one needs to provide
   /// encodings info manually to allow the client lib to be generated.
@@ -96,15 +112,45 @@ struct CompilationOptions {
 
   bool compressEvaluationKeys;
 
+  /// When set, the ciphertexts returned by the circuits are keyswitched to the
+  /// input key of the bootstrap of their partition, and modulus switched to
+  /// the modulus of its blind rotation, before being sent back to the client.
+  /// The output keyswitch is part of the optimizer dag, which checks its noise
+  /// and the one of the modulus switch. Requires a dag optimizer strategy,
+  /// and is skipped for crt encoded circuits.
+  bool shrinkOutputs;
+
+  /// The precision, in bits, of the integers of the keyswitch keys. Keys on
+  /// 32 bits are half the size of the default 64 bits ones, and are used for
+  /// the keyswitches whose decomposition fits in 32 bits. Only the keys are
+  /// reduced: the ciphertexts keep their 64 bits storage, the keyswitch
+  /// rounding its input to 32 bits and widening its output back.
+  unsigned int keyswitchKeyPrecision;
+
+  /// Whether the passes of the pipeline operating on functions run on the
+  /// functions of a module in parallel.
+  bool multithreading;
+
+  /// When set, the artifacts of library compilations are cached in this
+  /// directory, and reused by later compilations of the same modules with
+  /// the same options.
+  std::optional<std::string> compilationCacheDir;
+
   CompilationOptions()
       : v0FHEConstraints(std::nullopt), verifyDiagnostics(false),
         autoParallelize(false), loopParallelize(false), batchTFHEOps(false),
         maxBatchSize(std::numeric_limits<int64_t>::max()), emitSDFGOps(false),
         unrollLoopsWithSDFGConvertibleOps(false), dataflowParallelize(false),
         optimizeTFHE(true), simulate(false), emitGPUOps(false),
+        fhelinalgAutoTiling(false), tilingCacheBudget(0), memoryPlanning(false),
         optimizerConfig(optimizer::DEFAULT_CONFIG), chunkIntegers(false),
-        chunkSize(4), chunkWidth(2), encodings(std::nullopt),
-        skipProgramInfo(false), compressEvaluationKeys(false){};
+        chunkSize(4), chunkWidth(2), chunkParallelism(0),
+        encodings(std::nullopt), skipProgramInfo(false),
+        compressEvaluationKeys(false), shrinkOutputs(false),
+        keyswitchKeyPrecision(64), multithreading(true),
+        compilationCacheDir(std::nullopt) {
+    optimizerConfig.cpu_cost_factors = optimizer::getDefaultCpuCostFactors();
+  };
 
   /// @brief Constructor for CompilationOptions with default parameters for a
   /// specific backend.
@@ -176,6 +222,15 @@ public:
     /// Returns the program info of the library.
     Message<concreteprotocol::ProgramInfo> getProgramInfo() const;
 
+    /// Returns the compilation feedback of the library.
+    const ProgramCompilationFeedback &getCompilationFeedback() const;
+
+    /// Loads the program info and the compilation feedback previously emitted
+    /// in `artifactsDirPath` instead of compiling the library, and sets the
+    /// paths of the libraries found in the output directory.
+    llvm::Error loadArtifacts(std::string artifactsDirPath, bool sharedLib,
+                              bool staticLib);
+
     /// Returns the path to the output dir.
     const std::string &getOutputDirPath() const;
 
@@ -276,7 +331,7 @@ public:
       : overrideMaxEintPrecision(), overrideMaxMANP(), compilerOptions(),
         generateProgramInfo(true),
         enablePass([](mlir::Pass *pass) { return true; }),
-        compilationContext(compilationContext) {}
+        customEnablePass(false), compilationContext(compilationContext) {}
 
   llvm::Expected<CompilationResult>
   compile(llvm::StringRef s, Target target,
@@ -329,12 +384,20 @@ public:
   void setGenerateProgramInfo(bool v);
   void setEnablePass(std::function<bool(mlir::Pass *)> enablePass);
 
+  /// Returns the printout of everything configuring a library compilation,
+  /// used to identify compilations in the compilation cache, or std::nullopt
+  /// if the compilation can't be cached.
+  std::optional<std::string>
+  getCacheConfiguration(llvm::StringRef runtimeLibraryPath);
+
 protected:
   std::optional<size_t> overrideMaxEintPrecision;
   std::optional<size_t> overrideMaxMANP;
   CompilationOptions compilerOptions;
   bool generateProgramInfo;
   std::function<bool(mlir::Pass *)> enablePass;
+  /// Whether passes were disabled with `setEnablePass`
+  bool customEnablePass;
 
   std::shared_ptr<CompilationContext> compilationContext;
 
@@ -7,10 +7,16 @@
 #define CONCRETELANG_SUPPORT_LLVMEMITFILE
 
 #include <llvm/ADT/StringRef.h>
+#include <llvm/Target/TargetMachine.h>
 
 namespace mlir {
 namespace concretelang {
 
+/// Returns a target machine for the host, and sets the data layout and the
+/// target triple of `llvmModule` accordingly.
+std::unique_ptr<llvm::TargetMachine>
+getTargetMachineAndSetupModule(llvm::Module *llvmModule);
+
 llvm::Error emitObject(llvm::Module &module, std::string objectPath);
 
 llvm::Error callCmd(std::string cmd);
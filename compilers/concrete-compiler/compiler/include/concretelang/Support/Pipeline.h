@@ -17,6 +17,8 @@ namespace concretelang {
 namespace pipeline {
 
 mlir::LogicalResult autopar(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                            std::optional<V0FHEContext> &fheContext,
+                            optimizer::Config config,
                             std::function<bool(mlir::Pass *)> enablePass);
 
 mlir::LogicalResult materializeOptimizerPartitionFrontiers(
@@ -38,6 +40,12 @@ markFHELinalgForTiling(mlir::MLIRContext &context, mlir::ModuleOp &module,
                        llvm::ArrayRef<int64_t> tileSizes,
                        std::function<bool(mlir::Pass *)> enablePass);
 
+mlir::LogicalResult
+markFHELinalgForAutoTiling(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                           uint64_t ciphertextSize, uint64_t cacheBudget,
+                           uint64_t numWorkers,
+                           std::function<bool(mlir::Pass *)> enablePass);
+
 mlir::LogicalResult
 transformHighLevelFHEOps(mlir::MLIRContext &context, mlir::ModuleOp &module,
                          std::function<bool(mlir::Pass *)> enablePass);
@@ -58,7 +66,8 @@ transformFHEBoolean(mlir::MLIRContext &context, mlir::ModuleOp &module,
 mlir::LogicalResult
 transformFHEBigInt(mlir::MLIRContext &context, mlir::ModuleOp &module,
                    std::function<bool(mlir::Pass *)> enablePass,
-                   unsigned int chunkSize, unsigned int chunkWidth);
+                   unsigned int chunkSize, unsigned int chunkWidth,
+                   unsigned int parallelism);
 
 mlir::LogicalResult
 lowerFHEToTFHE(mlir::MLIRContext &context, mlir::ModuleOp &module,
@@ -70,6 +79,10 @@ parametrizeTFHE(mlir::MLIRContext &context, mlir::ModuleOp &module,
                 std::optional<V0FHEContext> &fheContext,
                 std::function<bool(mlir::Pass *)> enablePass);
 
+mlir::LogicalResult
+shrinkTFHEOutputs(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                  std::function<bool(mlir::Pass *)> enablePass);
+
 mlir::LogicalResult batchTFHE(mlir::MLIRContext &context,
                               mlir::ModuleOp &module,
                               std::function<bool(mlir::Pass *)> enablePass,
@@ -93,6 +106,11 @@ computeMemoryUsage(mlir::MLIRContext &context, mlir::ModuleOp &module,
                    std::function<bool(mlir::Pass *)> enablePass,
                    ProgramCompilationFeedback &feedback);
 
+mlir::LogicalResult planMemory(mlir::MLIRContext &context,
+                               mlir::ModuleOp &module,
+                               std::function<bool(mlir::Pass *)> enablePass,
+                               ProgramCompilationFeedback *feedback);
+
 mlir::LogicalResult
 lowerConcreteLinalgToLoops(mlir::MLIRContext &context, mlir::ModuleOp &module,
                            std::function<bool(mlir::Pass *)> enablePass,
@@ -23,7 +23,8 @@ llvm::Expected<Message<concreteprotocol::ProgramInfo>>
 createProgramInfoFromTfheDialect(
     mlir::ModuleOp module, int bitsOfSecurity,
     const Message<concreteprotocol::ProgramEncodingInfo> &encodings,
-    bool compressEvaluationKeys);
+    bool compressEvaluationKeys, bool shrinkOutputs = false,
+    unsigned int keyswitchKeyPrecision = 64);
 
 } // namespace concretelang
 } // namespace mlir
@@ -9,6 +9,8 @@
 #include <variant>
 
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
 
 #include "concrete-optimizer.hpp"
 #include "concretelang/Support/CompilationFeedback.h"
@@ -81,6 +83,14 @@ constexpr bool DEFAULT_CACHE_ON_DISK = true;
 constexpr uint32_t DEFAULT_CIPHERTEXT_MODULUS_LOG = 64;
 constexpr uint32_t DEFAULT_FFT_PRECISION = 53;
 constexpr bool DEFAULT_COMPOSABLE = false;
+constexpr bool DEFAULT_SHRINK_OUTPUTS = false;
+constexpr concrete_optimizer::CpuCostFactors DEFAULT_CPU_COST_FACTORS = {
+    1.0, 1.0, 1.0};
+
+/// Environment variable holding the path of a cost profile of the machine,
+/// produced by the calibration example of concrete-cpu.
+constexpr const char *CPU_COST_PROFILE_ENV =
+    "CONCRETE_OPTIMIZER_CPU_COST_PROFILE";
 
 /// The strategy of the crypto optimization
 enum Strategy {
@@ -116,6 +126,12 @@ struct Config {
   uint32_t ciphertext_modulus_log;
   uint32_t fft_precision;
   bool composable;
+  /// Outputs are keyswitched to a smaller key before being returned, see
+  /// CompilationOptions::shrinkOutputs
+  bool shrink_outputs;
+  /// Factors calibrating the cpu cost model of the optimizer, see
+  /// readCpuCostProfile
+  concrete_optimizer::CpuCostFactors cpu_cost_factors;
 };
 
 constexpr Config DEFAULT_CONFIG = {
@@ -133,8 +149,18 @@ constexpr Config DEFAULT_CONFIG = {
     DEFAULT_CIPHERTEXT_MODULUS_LOG,
     DEFAULT_FFT_PRECISION,
     DEFAULT_COMPOSABLE,
+    DEFAULT_SHRINK_OUTPUTS,
+    DEFAULT_CPU_COST_FACTORS,
 };
 
+/// Returns the cost factors fitted on the cost profile at `path`.
+llvm::Expected<concrete_optimizer::CpuCostFactors>
+readCpuCostProfile(llvm::StringRef path);
+
+/// Returns the cost factors of the profile named by CPU_COST_PROFILE_ENV, or
+/// the default ones. The profile is read once per process.
+concrete_optimizer::CpuCostFactors getDefaultCpuCostFactors();
+
 using Dag = rust::Box<concrete_optimizer::OperationDag>;
 using DagSolution = concrete_optimizer::dag::DagSolution;
 using CircuitSolution = concrete_optimizer::dag::CircuitSolution;
@@ -153,6 +179,9 @@ typedef std::variant<V0Parameter, CircuitSolution> Solution;
 
 struct ProgramCompilationFeedback;
 
+/// Returns the options of the concrete-optimizer matching `config`.
+concrete_optimizer::Options options_from_config(optimizer::Config config);
+
 llvm::Expected<optimizer::Solution>
 getSolution(optimizer::Description &descr, ProgramCompilationFeedback &feedback,
             optimizer::Config optimizerConfig);
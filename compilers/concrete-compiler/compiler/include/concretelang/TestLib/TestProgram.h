@@ -14,6 +14,7 @@
 #include "concretelang/Common/Keysets.h"
 #include "concretelang/Common/Protocol.h"
 #include "concretelang/Common/Values.h"
+#include "concretelang/ServerLib/ServerKeyStore.h"
 #include "concretelang/ServerLib/ServerLib.h"
 #include "concretelang/Support/CompilerEngine.h"
 #include "tests_tools/keySetCache.h"
@@ -28,8 +29,12 @@ using concretelang::clientlib::ClientCircuit;
 using concretelang::clientlib::ClientProgram;
 using concretelang::error::Result;
 using concretelang::keysets::Keyset;
+using concretelang::keysets::KeysetGenerationOptions;
+using concretelang::serverlib::ServerArgument;
 using concretelang::serverlib::ServerCircuit;
+using concretelang::serverlib::ServerKeyStore;
 using concretelang::serverlib::ServerProgram;
+using concretelang::serverlib::ServerValueHandle;
 using concretelang::values::TransportValue;
 using concretelang::values::Value;
 
@@ -73,7 +78,7 @@ public:
 
   Result<void> generateKeyset(__uint128_t secretSeed = 0,
                               __uint128_t encryptionSeed = 0,
-                              bool tryCache = true) {
+                              bool tryCache = true, size_t threads = 0) {
     if (isSimulation()) {
       keyset = Keyset{};
       return outcome::success();
@@ -84,11 +89,12 @@ public:
                               lib.getProgramInfo().asReader().getKeyset(),
                               secretSeed, encryptionSeed));
     } else {
-      auto encryptionCsprng = csprng::EncryptionCSPRNG(encryptionSeed);
-      auto secretCsprng = csprng::SecretCSPRNG(secretSeed);
       Message<concreteprotocol::KeysetInfo> keysetInfo =
           lib.getProgramInfo().asReader().getKeyset();
-      keyset = Keyset(keysetInfo, secretCsprng, encryptionCsprng);
+      KeysetGenerationOptions options;
+      options.threads = threads;
+      OUTCOME_TRY(keyset, Keyset::generate(keysetInfo, secretSeed,
+                                           encryptionSeed, options));
     }
     return outcome::success();
   }
@@ -136,6 +142,66 @@ public:
     return processedOutputs;
   }
 
+  Result<std::vector<Value>>
+  compose_n_times_on_server(std::vector<Value> inputs, size_t n,
+                            std::string name = "main") {
+    // preprocess arguments
+    auto preparedArgs = std::vector<ServerArgument>();
+    OUTCOME_TRY(auto clientCircuit, getClientCircuit(name));
+    for (size_t i = 0; i < inputs.size(); i++) {
+      OUTCOME_TRY(auto preparedInput, clientCircuit.prepareInput(inputs[i], i));
+      preparedArgs.push_back(preparedInput);
+    }
+    // Call server multiple times in a row, keeping intermediate values on the
+    // server side
+    OUTCOME_TRY(auto serverProgram, getServerProgram());
+    OUTCOME_TRY(auto ks, getKeyset());
+    std::vector<ServerValueHandle> handles;
+    for (size_t i = 0; i < n; i++) {
+      auto previousHandles = handles;
+      OUTCOME_TRY(handles,
+                  serverProgram.callWithHandles(name, ks.server, preparedArgs));
+      for (auto handle : previousHandles) {
+        OUTCOME_TRYV(serverProgram.release(handle));
+      }
+      preparedArgs.assign(handles.begin(), handles.end());
+    }
+    // postprocess arguments
+    std::vector<Value> processedOutputs(handles.size());
+    for (size_t i = 0; i < processedOutputs.size(); i++) {
+      OUTCOME_TRY(auto output, serverProgram.fetch(handles[i]));
+      OUTCOME_TRYV(serverProgram.release(handles[i]));
+      OUTCOME_TRY(processedOutputs[i], clientCircuit.processOutput(output, i));
+    }
+    return processedOutputs;
+  }
+
+  Result<std::vector<Value>> call_with_key_store(std::vector<Value> inputs,
+                                                 ServerKeyStore &keyStore,
+                                                 std::string keysetId,
+                                                 std::string name = "main") {
+    // preprocess arguments
+    auto preparedArgs = std::vector<TransportValue>();
+    OUTCOME_TRY(auto clientCircuit, getClientCircuit(name));
+    for (size_t i = 0; i < inputs.size(); i++) {
+      OUTCOME_TRY(auto preparedInput, clientCircuit.prepareInput(inputs[i], i));
+      preparedArgs.push_back(preparedInput);
+    }
+    // Call server with the keyset registered in the key store
+    OUTCOME_TRY(auto ks, getKeyset());
+    OUTCOME_TRYV(keyStore.add(keysetId, ks.server));
+    OUTCOME_TRY(auto serverCircuit, getServerCircuit(name));
+    OUTCOME_TRY(auto returns,
+                serverCircuit.call(keyStore, keysetId, preparedArgs));
+    // postprocess arguments
+    std::vector<Value> processedOutputs(returns.size());
+    for (size_t i = 0; i < processedOutputs.size(); i++) {
+      OUTCOME_TRY(processedOutputs[i],
+                  clientCircuit.processOutput(returns[i], i));
+    }
+    return processedOutputs;
+  }
+
   Result<std::vector<TransportValue>>
   callServer(std::vector<TransportValue> inputs, std::string name = "main") {
     std::vector<TransportValue> returns;
@@ -159,17 +225,27 @@ public:
     return clientCircuit;
   }
 
-  Result<ServerCircuit> getServerCircuit(std::string name = "main") {
+  Result<ServerProgram> getServerProgram() {
     OUTCOME_TRY(auto lib, getLibrary());
     auto programInfo = lib.getProgramInfo();
-    OUTCOME_TRY(auto serverProgram,
-                ServerProgram::load(programInfo,
-                                    lib.getSharedLibraryPath(artifactDirectory),
-                                    isSimulation()));
+    return ServerProgram::load(programInfo,
+                               lib.getSharedLibraryPath(artifactDirectory),
+                               isSimulation());
+  }
+
+  Result<ServerCircuit> getServerCircuit(std::string name = "main") {
+    OUTCOME_TRY(auto serverProgram, getServerProgram());
     OUTCOME_TRY(auto serverCircuit, serverProgram.getServerCircuit(name));
     return serverCircuit;
   }
 
+  Result<Keyset> getKeyset() {
+    if (!keyset.has_value()) {
+      return StringError("TestProgram: keyset has not been generated\n");
+    }
+    return *keyset;
+  }
+
 private:
   std::string getArtifactDirectory() { return artifactDirectory; }
 
@@ -180,13 +256,6 @@ private:
     return *library;
   }
 
-  Result<Keyset> getKeyset() {
-    if (!keyset.has_value()) {
-      return StringError("TestProgram: keyset has not been generated\n");
-    }
-    return *keyset;
-  }
-
   bool isSimulation() { return compiler.getCompilationOptions().simulate; }
 
   std::string artifactDirectory;
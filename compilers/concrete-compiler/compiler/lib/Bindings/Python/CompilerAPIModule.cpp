@@ -9,6 +9,7 @@
 #include "concretelang/Common/Compat.h"
 #include "concretelang/Common/Csprng.h"
 #include "concretelang/Common/Keysets.h"
+#include "concretelang/Common/Protocol.h"
 #include "concretelang/Dialect/FHE/IR/FHEOpsDialect.h.inc"
 #include "concretelang/Runtime/DFRuntime.hpp"
 #include "concretelang/Support/logging.h"
@@ -166,10 +167,10 @@ key_set(concretelang::clientlib::ClientParameters clientParameters,
     concretelang::clientlib::KeySet output{keyset};
     return std::make_unique<concretelang::clientlib::KeySet>(std::move(output));
   } else {
-    concretelang::csprng::SecretCSPRNG secCsprng(secretSeed);
-    concretelang::csprng::EncryptionCSPRNG encCsprng(encryptionSeed);
-    auto keyset = Keyset(clientParameters.programInfo.asReader().getKeyset(),
-                         secCsprng, encCsprng);
+    GET_OR_THROW_RESULT(
+        Keyset keyset,
+        Keyset::generate(clientParameters.programInfo.asReader().getKeyset(),
+                         secretSeed, encryptionSeed));
     concretelang::clientlib::KeySet output{keyset};
     return std::make_unique<concretelang::clientlib::KeySet>(std::move(output));
   }
@@ -365,6 +366,24 @@ valueSerialize(const concretelang::clientlib::SharedScalarOrTensorData &value) {
   return maybeString.value();
 }
 
+concretelang::clientlib::SharedScalarOrTensorData valueReadFromFd(int fd) {
+  auto maybeValue = ::concretelang::protocol::readValueFromFd(fd);
+  if (maybeValue.has_failure()) {
+    throw std::runtime_error("Failed to read Value: " +
+                             maybeValue.as_failure().error().mesg);
+  }
+  return {maybeValue.value()};
+}
+
+void valueWriteToFd(
+    const concretelang::clientlib::SharedScalarOrTensorData &value, int fd) {
+  auto maybeError = ::concretelang::protocol::writeValueToFd(fd, value.value);
+  if (maybeError.has_failure()) {
+    throw std::runtime_error("Failed to write Value: " +
+                             maybeError.as_failure().error().mesg);
+  }
+}
+
 concretelang::clientlib::ValueExporter
 createValueExporter(concretelang::clientlib::KeySet &keySet,
                     concretelang::clientlib::ClientParameters &clientParameters,
@@ -484,18 +503,19 @@ bool lambdaArgumentIsTensor(lambdaArgument &lambda_arg) {
 std::vector<uint64_t> lambdaArgumentGetTensorData(lambdaArgument &lambda_arg) {
   if (auto tensor = lambda_arg.ptr->value.getTensor<uint8_t>(); tensor) {
     Tensor<uint64_t> out = (Tensor<uint64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<uint16_t>();
              tensor) {
     Tensor<uint64_t> out = (Tensor<uint64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<uint32_t>();
              tensor) {
     Tensor<uint64_t> out = (Tensor<uint64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<uint64_t>();
              tensor) {
-    return tensor.value().values;
+    auto &values = tensor.value().values;
+    return {values.begin(), values.end()};
   } else {
     throw std::invalid_argument(
         "LambdaArgument isn't a tensor or has an unsupported bitwidth");
@@ -506,15 +526,16 @@ std::vector<int64_t>
 lambdaArgumentGetSignedTensorData(lambdaArgument &lambda_arg) {
   if (auto tensor = lambda_arg.ptr->value.getTensor<int8_t>(); tensor) {
     Tensor<int64_t> out = (Tensor<int64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<int16_t>(); tensor) {
     Tensor<int64_t> out = (Tensor<int64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<int32_t>(); tensor) {
     Tensor<int64_t> out = (Tensor<int64_t>)tensor.value();
-    return out.values;
+    return {out.values.begin(), out.values.end()};
   } else if (auto tensor = lambda_arg.ptr->value.getTensor<int64_t>(); tensor) {
-    return tensor.value().values;
+    auto &values = tensor.value().values;
+    return {values.begin(), values.end()};
   } else {
     throw std::invalid_argument(
         "LambdaArgument isn't a tensor or has an unsupported bitwidth");
@@ -713,6 +734,30 @@ void mlir::concretelang::python::populateCompilerAPISubmodule(
            [](CompilationOptions &options, bool b) {
              options.compressEvaluationKeys = b;
            })
+      .def("set_shrink_outputs",
+           [](CompilationOptions &options, bool b) {
+             options.shrinkOutputs = b;
+           })
+      .def("set_keyswitch_key_precision",
+           [](CompilationOptions &options, unsigned int precision) {
+             options.keyswitchKeyPrecision = precision;
+           })
+      .def("set_compilation_cache_dir",
+           [](CompilationOptions &options, std::string path) {
+             options.compilationCacheDir = path;
+           })
+      .def("set_fhelinalg_auto_tiling",
+           [](CompilationOptions &options, bool b) {
+             options.fhelinalgAutoTiling = b;
+           })
+      .def("set_tiling_cache_budget",
+           [](CompilationOptions &options, uint64_t budget) {
+             options.tilingCacheBudget = budget;
+           })
+      .def("set_memory_planning",
+           [](CompilationOptions &options, bool b) {
+             options.memoryPlanning = b;
+           })
       .def("set_optimize_concrete", [](CompilationOptions &options,
                                        bool b) { options.optimizeTFHE = b; })
       .def("set_p_error",
@@ -857,7 +902,10 @@ void mlir::concretelang::python::populateCompilerAPISubmodule(
                     &mlir::concretelang::CircuitCompilationFeedback::statistics)
       .def_readonly(
           "memory_usage_per_location",
-          &mlir::concretelang::CircuitCompilationFeedback::memoryUsagePerLoc);
+          &mlir::concretelang::CircuitCompilationFeedback::memoryUsagePerLoc)
+      .def_readonly(
+          "planned_memory_peak",
+          &mlir::concretelang::CircuitCompilationFeedback::plannedMemoryPeak);
 
   pybind11::class_<mlir::concretelang::CompilationContext,
                    std::shared_ptr<mlir::concretelang::CompilationContext>>(
@@ -1184,7 +1232,11 @@ void mlir::concretelang::python::populateCompilerAPISubmodule(
           "serialize",
           [](const ::concretelang::clientlib::SharedScalarOrTensorData &value) {
             return pybind11::bytes(valueSerialize(value));
-          });
+          })
+      .def_static("read_from_fd", [](int fd) { return valueReadFromFd(fd); })
+      .def("write_to_fd",
+           [](const ::concretelang::clientlib::SharedScalarOrTensorData &value,
+              int fd) { valueWriteToFd(value, fd); });
 
   pybind11::class_<::concretelang::clientlib::ValueExporter>(m, "ValueExporter")
       .def_static(
@@ -68,6 +68,7 @@ class CircuitCompilationFeedback(WrapperCpp):
         self.memory_usage_per_location = (
             circuit_compilation_feedback.memory_usage_per_location
         )
+        self.planned_memory_peak = circuit_compilation_feedback.planned_memory_peak
 
         super().__init__(circuit_compilation_feedback)
 
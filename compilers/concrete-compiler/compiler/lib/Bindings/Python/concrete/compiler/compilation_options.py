@@ -113,6 +113,101 @@ class CompilationOptions(WrapperCpp):
             raise TypeError("can't set the option to a non-boolean value")
         self.cpp().set_compress_evaluation_keys(compress_evaluation_keys)
 
+    def set_shrink_outputs(self, shrink_outputs: bool):
+        """Set option for shrinking of output ciphertexts.
+
+        Args:
+            shrink_outputs (bool): whether to turn it on or off
+
+        Raises:
+            TypeError: if the value to set is not boolean
+        """
+        if not isinstance(shrink_outputs, bool):
+            raise TypeError("can't set the option to a non-boolean value")
+        self.cpp().set_shrink_outputs(shrink_outputs)
+
+    def set_keyswitch_key_precision(self, precision: int):
+        """Set the precision of the keyswitch keys.
+
+        Only the keys are reduced, the ciphertexts stay on 64 bits.
+
+        Args:
+            precision (int): precision in bits, either 32 or 64
+
+        Raises:
+            TypeError: if the value to set is not int
+            ValueError: if the value to set is not 32 or 64
+        """
+        if not isinstance(precision, int):
+            raise TypeError("can't set the option to a non-int value")
+        if precision not in (32, 64):
+            raise ValueError("keyswitch key precision must be 32 or 64")
+        self.cpp().set_keyswitch_key_precision(precision)
+
+    def set_compilation_cache_dir(self, path: str):
+        """Set the directory caching the artifacts of compilations.
+
+        Compiling the same program with the same options reuses the cached
+        artifacts instead of running the compilation again.
+
+        Args:
+            path (str): path of the cache directory
+
+        Raises:
+            TypeError: if the value to set is not str
+        """
+        if not isinstance(path, str):
+            raise TypeError("can't set the option to a non-str value")
+        self.cpp().set_compilation_cache_dir(path)
+
+    def set_fhelinalg_auto_tiling(self, auto_tiling: bool):
+        """Set option for automatic tiling of FHELinalg operations.
+
+        Tile sizes are chosen from the size of the ciphertexts, the cache
+        budget and the number of workers.
+
+        Args:
+            auto_tiling (bool): whether to turn it on or off
+
+        Raises:
+            TypeError: if the value to set is not boolean
+        """
+        if not isinstance(auto_tiling, bool):
+            raise TypeError("can't set the option to a non-boolean value")
+        self.cpp().set_fhelinalg_auto_tiling(auto_tiling)
+
+    def set_tiling_cache_budget(self, budget: int):
+        """Set the number of bytes of ciphertexts a tile keeps in cache.
+
+        Args:
+            budget (int): budget in bytes, 0 to use the L2 cache of the host
+
+        Raises:
+            TypeError: if the value to set is not int
+            ValueError: if the value to set is negative
+        """
+        if not isinstance(budget, int):
+            raise TypeError("can't set the option to a non-int value")
+        if budget < 0:
+            raise ValueError("tiling cache budget must be positive")
+        self.cpp().set_tiling_cache_budget(budget)
+
+    def set_memory_planning(self, memory_planning: bool):
+        """Set option for static planning of the memory of the circuits.
+
+        Buffers are placed in an arena allocated once per invocation, buffers
+        with disjoint live ranges sharing memory.
+
+        Args:
+            memory_planning (bool): whether to turn it on or off
+
+        Raises:
+            TypeError: if the value to set is not boolean
+        """
+        if not isinstance(memory_planning, bool):
+            raise TypeError("can't set the option to a non-boolean value")
+        self.cpp().set_memory_planning(memory_planning)
+
     def set_verify_diagnostics(self, verify_diagnostics: bool):
         """Set option for diagnostics verification.
 
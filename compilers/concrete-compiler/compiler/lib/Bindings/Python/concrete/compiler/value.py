@@ -66,3 +66,44 @@ class Value(WrapperCpp):
             )
 
         return Value.wrap(_Value.deserialize(serialized_value))
+
+    def write_to_fd(self, fd: int):
+        """
+        Write value to a file descriptor, without serializing it in memory first.
+
+        Args:
+            fd (int):
+                file descriptor to write to
+
+        Raises:
+            TypeError:
+                if `fd` is not of type `int`
+        """
+
+        if not isinstance(fd, int):
+            raise TypeError(f"fd must be of type int, not {type(fd)}")
+
+        self.cpp().write_to_fd(fd)
+
+    @staticmethod
+    def read_from_fd(fd: int) -> "Value":
+        """
+        Read a value written by `write_to_fd` from a file descriptor.
+
+        Args:
+            fd (int):
+                file descriptor to read from
+
+        Returns:
+            Value:
+                read value
+
+        Raises:
+            TypeError:
+                if `fd` is not of type `int`
+        """
+
+        if not isinstance(fd, int):
+            raise TypeError(f"fd must be of type int, not {type(fd)}")
+
+        return Value.wrap(_Value.read_from_fd(fd))
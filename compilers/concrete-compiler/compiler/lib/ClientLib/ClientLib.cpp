@@ -24,6 +24,7 @@
 
 using concretelang::error::Result;
 using concretelang::keysets::ClientKeyset;
+using concretelang::transformers::InputStreamTransformer;
 using concretelang::transformers::InputTransformer;
 using concretelang::transformers::OutputTransformer;
 using concretelang::transformers::TransformerFactory;
@@ -40,23 +41,33 @@ ClientCircuit::create(const Message<concreteprotocol::CircuitInfo> &info,
                       bool useSimulation) {
 
   auto inputTransformers = std::vector<InputTransformer>();
+  auto inputStreamTransformers = std::vector<InputStreamTransformer>();
 
   for (auto gateInfo : info.asReader().getInputs()) {
     InputTransformer transformer;
+    InputStreamTransformer streamTransformer;
     if (gateInfo.getTypeInfo().hasIndex()) {
       OUTCOME_TRY(transformer,
                   TransformerFactory::getIndexInputTransformer(gateInfo));
+      OUTCOME_TRY(streamTransformer,
+                  TransformerFactory::getInputStreamTransformer(transformer));
     } else if (gateInfo.getTypeInfo().hasPlaintext()) {
       OUTCOME_TRY(transformer,
                   TransformerFactory::getPlaintextInputTransformer(gateInfo));
+      OUTCOME_TRY(streamTransformer,
+                  TransformerFactory::getInputStreamTransformer(transformer));
     } else if (gateInfo.getTypeInfo().hasLweCiphertext()) {
       OUTCOME_TRY(transformer,
                   TransformerFactory::getLweCiphertextInputTransformer(
                       keyset, gateInfo, csprng, useSimulation));
+      OUTCOME_TRY(streamTransformer,
+                  TransformerFactory::getLweCiphertextInputStreamTransformer(
+                      keyset, gateInfo, csprng, useSimulation));
     } else {
       return StringError("Malformed input gate info.");
     }
     inputTransformers.push_back(transformer);
+    inputStreamTransformers.push_back(streamTransformer);
   }
 
   auto outputTransformers = std::vector<OutputTransformer>();
@@ -79,17 +90,26 @@ ClientCircuit::create(const Message<concreteprotocol::CircuitInfo> &info,
     outputTransformers.push_back(transformer);
   }
 
-  return ClientCircuit(info, inputTransformers, outputTransformers);
+  return ClientCircuit(info, inputTransformers, inputStreamTransformers,
+                       outputTransformers);
 }
 
 Result<TransportValue> ClientCircuit::prepareInput(Value arg, size_t pos) {
   if (pos >= inputTransformers.size()) {
     return StringError("Tried to prepare a Value for incorrect position.");
   }
-  return inputTransformers[pos](arg);
+  return inputTransformers[pos](std::move(arg));
+}
+
+Result<void> ClientCircuit::prepareInputToFd(Value arg, size_t pos, int fd) {
+  if (pos >= inputStreamTransformers.size()) {
+    return StringError("Tried to prepare a Value for incorrect position.");
+  }
+  return inputStreamTransformers[pos](std::move(arg), fd);
 }
 
-Result<Value> ClientCircuit::processOutput(TransportValue result, size_t pos) {
+Result<Value> ClientCircuit::processOutput(const TransportValue &result,
+                                           size_t pos) {
   if (pos >= outputTransformers.size()) {
     return StringError(
         "Tried to process a TransportValue for incorrect position.");
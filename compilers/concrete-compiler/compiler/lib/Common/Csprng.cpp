@@ -50,6 +50,19 @@ SoftCSPRNG::~SoftCSPRNG() {
   }
 }
 
+__uint128_t SoftCSPRNG::drawSeed() {
+  __uint128_t seed = 0;
+  // A zero seed would stand for a random seed.
+  while (seed == 0) {
+    struct Uint128 u128;
+    concrete_cpu_csprng_draw_seed(ptr, &u128);
+    for (int i = 0; i < 16; i++) {
+      seed |= (__uint128_t)u128.little_endian_bytes[i] << (8 * i);
+    }
+  }
+  return seed;
+}
+
 SecretCSPRNG::SecretCSPRNG(__uint128_t seed) : CSPRNG<SecCsprng>(nullptr) {
   ptr = (SecCsprng *)aligned_alloc(SECRET_CSPRNG_ALIGN, SECRET_CSPRNG_SIZE);
   struct Uint128 u128;
@@ -19,7 +19,7 @@ using concretelang::csprng::EncryptionCSPRNG;
 using concretelang::csprng::SecretCSPRNG;
 using concretelang::protocol::Message;
 using concretelang::protocol::protoPayloadToSharedVector;
-using concretelang::protocol::vectorToProtoPayload;
+using concretelang::protocol::vectorIntoProtoPayload;
 
 namespace concretelang {
 namespace keys {
@@ -29,7 +29,7 @@ Message<ProtoKey> keyToProto(const Key &key) {
   Message<ProtoKey> output;
   auto proto = output.asBuilder();
   proto.setInfo(key.getInfo().asReader());
-  proto.setPayload(vectorToProtoPayload(key.getTransportBuffer()).asReader());
+  vectorIntoProtoPayload(key.getTransportBuffer(), proto.initPayload());
   return std::move(output);
 }
 
@@ -186,6 +186,22 @@ LweBootstrapKey LweBootstrapKey::fromProto(
   return key;
 }
 
+LweBootstrapKey LweBootstrapKey::fromTransportBuffer(
+    std::shared_ptr<std::vector<uint64_t>> buffer, InfoType info) {
+  LweBootstrapKey key(info);
+  switch (info.asReader().getCompression()) {
+  case concreteprotocol::Compression::NONE:
+    key.buffer = buffer;
+    break;
+  case concreteprotocol::Compression::SEED:
+    key.seededBuffer = buffer;
+    break;
+  default:
+    assert(false && "Unsupported compression type for bootstrap key");
+  }
+  return key;
+}
+
 Message<concreteprotocol::LweBootstrapKey> LweBootstrapKey::toProto() const {
   return keyToProto<concreteprotocol::LweBootstrapKey,
                     concreteprotocol::LweBootstrapKeyInfo, LweBootstrapKey>(
@@ -257,6 +273,19 @@ LweKeyswitchKey::LweKeyswitchKey(
 
   switch (compression) {
   case concreteprotocol::Compression::NONE:
+    if (params.getIntegerPrecision() == 32) {
+      // 32 bits keys are packed two elements per word of the buffer.
+      auto keySize = concrete_cpu_keyswitch_key_size_u32(
+          params.getLevelCount(), params.getInputLweDimension(),
+          params.getOutputLweDimension());
+      buffer->resize((keySize + 1) / 2);
+      concrete_cpu_init_lwe_keyswitch_key_u32(
+          (uint32_t *)buffer->data(), inputKey.buffer->data(),
+          outputKey.buffer->data(), params.getInputLweDimension(),
+          params.getOutputLweDimension(), params.getLevelCount(),
+          params.getBaseLog(), params.getVariance(), csprng.ptr);
+      return;
+    }
     buffer->resize(concrete_cpu_keyswitch_key_size_u64(
         params.getLevelCount(), params.getInputLweDimension(),
         params.getOutputLweDimension()));
@@ -267,6 +296,8 @@ LweKeyswitchKey::LweKeyswitchKey(
         csprng.ptr);
     return;
   case concreteprotocol::Compression::SEED:
+    assert(params.getIntegerPrecision() == 64 &&
+           "Seeded keyswitch keys are only supported on 64 bits");
     seededBuffer->resize(
         concrete_cpu_seeded_keyswitch_key_size_u64(
             params.getLevelCount(), params.getInputLweDimension()) +
@@ -306,6 +337,22 @@ LweKeyswitchKey LweKeyswitchKey::fromProto(
   return key;
 }
 
+LweKeyswitchKey LweKeyswitchKey::fromTransportBuffer(
+    std::shared_ptr<std::vector<uint64_t>> buffer, InfoType info) {
+  LweKeyswitchKey key(info);
+  switch (info.asReader().getCompression()) {
+  case concreteprotocol::Compression::NONE:
+    key.buffer = buffer;
+    break;
+  case concreteprotocol::Compression::SEED:
+    key.seededBuffer = buffer;
+    break;
+  default:
+    assert(false && "Unsupported compression type for keyswitch key");
+  }
+  return key;
+}
+
 Message<concreteprotocol::LweKeyswitchKey> LweKeyswitchKey::toProto() const {
   return keyToProto<concreteprotocol::LweKeyswitchKey,
                     concreteprotocol::LweKeyswitchKeyInfo, LweKeyswitchKey>(
@@ -13,18 +13,26 @@
 #include "kj/common.h"
 #include "kj/io.h"
 #include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
+#include <atomic>
 #include <errno.h>
 #include <fcntl.h>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <stdlib.h>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unistd.h>
 #include <utime.h>
 
 using concretelang::csprng::EncryptionCSPRNG;
 using concretelang::csprng::SecretCSPRNG;
+using concretelang::csprng::SoftCSPRNG;
 using concretelang::error::Result;
 using concretelang::error::StringError;
 using concretelang::keys::LweBootstrapKey;
@@ -39,6 +47,33 @@ const capnp::ReaderOptions KEY_READER_OPTS =
 namespace concretelang {
 namespace keysets {
 
+/// Feeds `size` to `hasher` as 8 little endian bytes.
+void digestSize(llvm::SHA256 &hasher, uint64_t size) {
+  uint8_t bytes[sizeof(size)];
+  for (size_t i = 0; i < sizeof(size); i++)
+    bytes[i] = (uint8_t)(size >> (8 * i));
+  hasher.update(bytes);
+}
+
+/// Feeds the number of keys then, for each key, its info and its transport
+/// buffer, each prefixed by its size, such that distinct keysets are fed
+/// distinct sequences.
+template <typename Key>
+void digestKeys(llvm::SHA256 &hasher, const std::vector<Key> &keys) {
+  digestSize(hasher, keys.size());
+  for (const auto &key : keys) {
+    auto maybeInfoString = key.getInfo().writeBinaryToString();
+    assert(maybeInfoString.has_value());
+    const auto &info = maybeInfoString.value();
+    digestSize(hasher, info.size());
+    hasher.update(info);
+    const auto &buffer = key.getTransportBuffer();
+    digestSize(hasher, buffer.size());
+    hasher.update(llvm::ArrayRef<uint8_t>((const uint8_t *)buffer.data(),
+                                          buffer.size() * sizeof(uint64_t)));
+  }
+}
+
 ClientKeyset
 ClientKeyset::fromProto(const Message<concreteprotocol::ClientKeyset> &proto) {
   auto output = ClientKeyset();
@@ -102,6 +137,17 @@ Message<concreteprotocol::ServerKeyset> ServerKeyset::toProto() const {
   return output;
 }
 
+const std::string &ServerKeyset::getDigest() const {
+  std::call_once(digest->computed, [&]() {
+    llvm::SHA256 hasher;
+    digestKeys(hasher, lweBootstrapKeys);
+    digestKeys(hasher, lweKeyswitchKeys);
+    digestKeys(hasher, packingKeyswitchKeys);
+    digest->value = llvm::toHex(hasher.final(), true);
+  });
+  return digest->value;
+}
+
 Keyset::Keyset(const Message<concreteprotocol::KeysetInfo> &info,
                SecretCSPRNG &secretCsprng, EncryptionCSPRNG &encryptionCsprng) {
   for (auto keyInfo : info.asReader().getLweSecretKeys()) {
@@ -180,6 +226,137 @@ Result<void> saveKey(Key key, std::string path) {
   return outcome::success();
 }
 
+/// Returns the path of the key `id` saved with the file name prefix `prefix`
+/// in `folderPath`.
+std::string keyPath(llvm::StringRef folderPath, std::string prefix,
+                    uint32_t id) {
+  llvm::SmallString<0> path(folderPath);
+  llvm::sys::path::append(path, prefix + std::to_string(id));
+  return (std::string)path;
+}
+
+/// Runs `jobs` on `threads` threads, and returns the error of the first
+/// failing job, if any.
+Result<void> runJobs(std::vector<std::function<Result<void>()>> &jobs,
+                     size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, jobs.size());
+
+  std::atomic<size_t> next(0);
+  std::mutex errorLock;
+  std::optional<StringError> error;
+  auto worker = [&]() {
+    for (size_t job = next++; job < jobs.size(); job = next++) {
+      auto result = jobs[job]();
+      if (result.has_error()) {
+        std::lock_guard<std::mutex> guard(errorLock);
+        if (!error.has_value()) {
+          error = result.error();
+        }
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < threads; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+
+  if (error.has_value()) {
+    return error.value();
+  }
+  return outcome::success();
+}
+
+/// Adds to `jobs` the generation of the server keys described by `infos`,
+/// each with the seed drawn from `seedCsprng` in the order of the infos.
+template <typename ProtoKey, typename Key, typename KeyInfos>
+void addKeyGenerationJobs(std::vector<std::function<Result<void>()>> &jobs,
+                          std::vector<std::optional<Key>> &keys,
+                          KeyInfos infos, SoftCSPRNG &seedCsprng,
+                          const std::vector<LweSecretKey> &secretKeys,
+                          const std::string &saveDirectory,
+                          std::string prefix) {
+  keys.resize(infos.size());
+  for (size_t i = 0; i < infos.size(); i++) {
+    auto seed = seedCsprng.drawSeed();
+    jobs.push_back([=, &keys, &secretKeys]() -> Result<void> {
+      auto keyInfo = infos[i];
+      auto encryptionCsprng = EncryptionCSPRNG(seed);
+      keys[i].emplace(Key(keyInfo, secretKeys[keyInfo.getInputId()],
+                          secretKeys[keyInfo.getOutputId()],
+                          encryptionCsprng));
+      if (saveDirectory.empty()) {
+        return outcome::success();
+      }
+      return saveKey<ProtoKey, Key>(
+          keys[i].value(), keyPath(saveDirectory, prefix, keyInfo.getId()));
+    });
+  }
+}
+
+template <typename Key>
+std::vector<Key> unwrapKeys(std::vector<std::optional<Key>> &keys) {
+  std::vector<Key> output;
+  for (auto &key : keys) {
+    output.push_back(std::move(key.value()));
+  }
+  return output;
+}
+
+Result<Keyset>
+Keyset::generate(const Message<concreteprotocol::KeysetInfo> &info,
+                 __uint128_t secretSeed, __uint128_t encryptionSeed,
+                 KeysetGenerationOptions options) {
+  auto infoReader = info.asReader();
+  auto &saveDirectory = options.saveDirectory;
+  Keyset keyset;
+
+  // The secret keys are cheap to generate and needed by all the server keys,
+  // so they are generated first.
+  auto secretCsprng = SecretCSPRNG(secretSeed);
+  for (auto keyInfo : infoReader.getLweSecretKeys()) {
+    keyset.client.lweSecretKeys.push_back(LweSecretKey(keyInfo, secretCsprng));
+  }
+
+  // The server keys are independent, and generated concurrently, the largest
+  // kinds of keys first.
+  std::vector<std::function<Result<void>()>> jobs;
+  auto seedCsprng = SoftCSPRNG(encryptionSeed);
+  std::vector<std::optional<LweBootstrapKey>> bootstrapKeys;
+  std::vector<std::optional<PackingKeyswitchKey>> packingKeyswitchKeys;
+  std::vector<std::optional<LweKeyswitchKey>> keyswitchKeys;
+  addKeyGenerationJobs<concreteprotocol::LweBootstrapKey>(
+      jobs, bootstrapKeys, infoReader.getLweBootstrapKeys(), seedCsprng,
+      keyset.client.lweSecretKeys, saveDirectory, "pbsKey_");
+  addKeyGenerationJobs<concreteprotocol::PackingKeyswitchKey>(
+      jobs, packingKeyswitchKeys, infoReader.getPackingKeyswitchKeys(),
+      seedCsprng, keyset.client.lweSecretKeys, saveDirectory, "pksKey_");
+  addKeyGenerationJobs<concreteprotocol::LweKeyswitchKey>(
+      jobs, keyswitchKeys, infoReader.getLweKeyswitchKeys(), seedCsprng,
+      keyset.client.lweSecretKeys, saveDirectory, "ksKey_");
+  if (!saveDirectory.empty()) {
+    for (auto &key : keyset.client.lweSecretKeys) {
+      jobs.push_back([&]() -> Result<void> {
+        return saveKey<concreteprotocol::LweSecretKey, LweSecretKey>(
+            key, keyPath(saveDirectory, "secretKey_",
+                         key.getInfo().asReader().getId()));
+      });
+    }
+  }
+  OUTCOME_TRYV(runJobs(jobs, options.threads));
+
+  keyset.server.lweBootstrapKeys = unwrapKeys(bootstrapKeys);
+  keyset.server.lweKeyswitchKeys = unwrapKeys(keyswitchKeys);
+  keyset.server.packingKeyswitchKeys = unwrapKeys(packingKeyswitchKeys);
+  return std::move(keyset);
+}
+
 Result<Keyset>
 loadKeysFromFiles(const Message<concreteprotocol::KeysetInfo> &keysetInfo,
                   __uint128_t secret_seed, __uint128_t encryption_seed,
@@ -251,7 +428,13 @@ loadKeysFromFiles(const Message<concreteprotocol::KeysetInfo> &keysetInfo,
   return keyset;
 }
 
-Result<void> saveKeys(Keyset &keyset, llvm::SmallString<0> &folderPath) {
+/// Generates the keyset, saving the keys to `folderPath` while the generation
+/// goes on. The keys are saved to a temporary folder first, renamed once all
+/// the keys are saved, so that the folder only exists when complete.
+Result<Keyset>
+generateAndSaveKeys(const Message<concreteprotocol::KeysetInfo> &keysetInfo,
+                    __uint128_t secret_seed, __uint128_t encryption_seed,
+                    llvm::SmallString<0> &folderPath) {
 #ifdef CONCRETELANG_GENERATE_UNSECURE_SECRET_KEYS
   getApproval();
 #endif
@@ -265,41 +448,13 @@ Result<void> saveKeys(Keyset &keyset, llvm::SmallString<0> &folderPath) {
            << std::string(folderIncompletePath) << "\": " << err.message();
   }
 
-  auto clientKeyset = keyset.client;
-  auto serverKeyset = keyset.server;
-
-  // Save LWE secret keys
-  for (auto key : clientKeyset.lweSecretKeys) {
-    llvm::SmallString<0> path = folderIncompletePath;
-    llvm::sys::path::append(
-        path, "secretKey_" + std::to_string(key.getInfo().asReader().getId()));
-    OUTCOME_TRYV(saveKey<concreteprotocol::LweSecretKey, LweSecretKey>(
-        key, path.c_str()));
-  }
-  // Save bootstrap keys
-  for (auto key : serverKeyset.lweBootstrapKeys) {
-    llvm::SmallString<0> path = folderIncompletePath;
-    llvm::sys::path::append(
-        path, "pbsKey_" + std::to_string(key.getInfo().asReader().getId()));
-    OUTCOME_TRYV(saveKey<concreteprotocol::LweBootstrapKey, LweBootstrapKey>(
-        key, path.c_str()));
-  }
-  // Save keyswitch keys
-  for (auto key : serverKeyset.lweKeyswitchKeys) {
-    llvm::SmallString<0> path = folderIncompletePath;
-    llvm::sys::path::append(
-        path, "ksKey_" + std::to_string(key.getInfo().asReader().getId()));
-    OUTCOME_TRYV(saveKey<concreteprotocol::LweKeyswitchKey, LweKeyswitchKey>(
-        key, path.c_str()));
-  }
-  // Save packing keyswitch keys
-  for (auto key : serverKeyset.packingKeyswitchKeys) {
-    llvm::SmallString<0> path = folderIncompletePath;
-    llvm::sys::path::append(
-        path, "pksKey_" + std::to_string(key.getInfo().asReader().getId()));
-    OUTCOME_TRYV(
-        saveKey<concreteprotocol::PackingKeyswitchKey, PackingKeyswitchKey>(
-            key, path.c_str()));
+  KeysetGenerationOptions options;
+  options.saveDirectory = std::string(folderIncompletePath);
+  auto keyset =
+      Keyset::generate(keysetInfo, secret_seed, encryption_seed, options);
+  if (keyset.has_error()) {
+    llvm::sys::fs::remove_directories(folderIncompletePath);
+    return keyset;
   }
 
   err = llvm::sys::fs::rename(folderIncompletePath, folderPath);
@@ -311,7 +466,7 @@ Result<void> saveKeys(Keyset &keyset, llvm::SmallString<0> &folderPath) {
            << std::string(folderPath) << "\"";
   }
 
-  return outcome::success();
+  return keyset;
 }
 
 KeysetCache::KeysetCache(std::string backingDirectoryPath) {
@@ -380,13 +535,8 @@ KeysetCache::getKeyset(const Message<concreteprotocol::KeysetInfo> &keysetInfo,
   std::cerr << "KeySetCache: miss, regenerating " << std::string(folderPath)
             << "\n";
 
-  auto encryptionCsprng = csprng::EncryptionCSPRNG(encryption_seed);
-  auto secretCsprng = csprng::SecretCSPRNG(secret_seed);
-  Keyset keyset(keysetInfo, secretCsprng, encryptionCsprng);
-
-  OUTCOME_TRYV(saveKeys(keyset, folderPath));
-
-  return std::move(keyset);
+  return generateAndSaveKeys(keysetInfo, secret_seed, encryption_seed,
+                             folderPath);
 }
 
 } // namespace keysets
@@ -7,8 +7,11 @@
 #include "concrete-protocol.capnp.h"
 #include "concretelang/Common/Error.h"
 #include "llvm/ADT/Hashing.h"
+#include <cerrno>
 #include <memory>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 namespace concretelang {
 namespace protocol {
@@ -40,5 +43,200 @@ template <typename Message> size_t hashMessage(Message &mess) {
   return llvm::hash_value(MessageToJSONString(mess));
 }
 
+/// Writes `size` bytes to `fd`, retrying on partial writes.
+Result<void> writeBytes(int fd, const void *data, size_t size) {
+  auto bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    auto written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return StringError("Failed to write to file descriptor: ")
+             << strerror(errno);
+    }
+    bytes += written;
+    size -= written;
+  }
+  return outcome::success();
+}
+
+/// Reads exactly `size` bytes from `fd`, retrying on partial reads.
+Result<void> readBytes(int fd, void *data, size_t size) {
+  auto bytes = static_cast<char *>(data);
+  while (size > 0) {
+    auto read = ::read(fd, bytes, size);
+    if (read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return StringError("Failed to read from file descriptor: ")
+             << strerror(errno);
+    }
+    if (read == 0) {
+      return StringError(
+          "Failed to read from file descriptor: premature end of stream.");
+    }
+    bytes += read;
+    size -= read;
+  }
+  return outcome::success();
+}
+
+Result<void>
+ValueStreamWriter::writeHeader(concreteprotocol::Value::Reader header,
+                               const std::vector<uint64_t> &blobSizes) {
+  if (remainingPayloadSize != 0) {
+    return StringError("Tried to write a value header before the end of the "
+                       "previous payload.");
+  }
+  auto headerMessage = Message<concreteprotocol::Value>();
+  headerMessage.asBuilder().setRawInfo(header.getRawInfo());
+  headerMessage.asBuilder().setTypeInfo(header.getTypeInfo());
+  OUTCOME_TRYV(headerMessage.writeBinaryToFd(fd));
+  uint64_t nbBlobs = blobSizes.size();
+  OUTCOME_TRYV(writeBytes(fd, &nbBlobs, sizeof(nbBlobs)));
+  OUTCOME_TRYV(
+      writeBytes(fd, blobSizes.data(), blobSizes.size() * sizeof(uint64_t)));
+  for (auto blobSize : blobSizes) {
+    remainingPayloadSize += blobSize;
+  }
+  return outcome::success();
+}
+
+Result<void> ValueStreamWriter::writePayload(const void *data, size_t size) {
+  if (size > remainingPayloadSize) {
+    return StringError(
+        "Tried to write more payload than announced in the value header.");
+  }
+  OUTCOME_TRYV(writeBytes(fd, data, size));
+  remainingPayloadSize -= size;
+  return outcome::success();
+}
+
+Result<void> ValueStreamWriter::finish() {
+  if (remainingPayloadSize != 0) {
+    return StringError("Tried to finish a value stream with ")
+           << remainingPayloadSize << " bytes of payload left to write.";
+  }
+  return outcome::success();
+}
+
+/// Returns the sizes of the blobs of the payload described by `rawInfo`, as
+/// written by `initProtoPayload`, unless the payload is more than
+/// `maxPayloadSize` bytes.
+Result<std::vector<uint64_t>>
+expectedBlobSizes(concreteprotocol::RawInfo::Reader rawInfo,
+                  size_t maxPayloadSize) {
+  size_t elementSize;
+  switch (rawInfo.getIntegerPrecision()) {
+  case 8:
+    elementSize = sizeof(uint8_t);
+    break;
+  case 16:
+    elementSize = sizeof(uint16_t);
+    break;
+  case 32:
+    elementSize = sizeof(uint32_t);
+    break;
+  case 64:
+    elementSize = sizeof(uint64_t);
+    break;
+  default:
+    return StringError("Tried to read a value of unsupported precision ")
+           << rawInfo.getIntegerPrecision() << ".";
+  }
+  size_t maxElms = maxPayloadSize / elementSize;
+  size_t size = 1;
+  for (auto dim : rawInfo.getShape().getDimensions()) {
+    if (dim != 0 && size > maxElms / dim) {
+      return StringError("Tried to read a value with a payload of more than ")
+             << maxPayloadSize << " bytes.";
+    }
+    size *= dim;
+  }
+  switch (elementSize) {
+  case sizeof(uint8_t):
+    return protoPayloadBlobSizes<uint8_t>(size);
+  case sizeof(uint16_t):
+    return protoPayloadBlobSizes<uint16_t>(size);
+  case sizeof(uint32_t):
+    return protoPayloadBlobSizes<uint32_t>(size);
+  default:
+    return protoPayloadBlobSizes<uint64_t>(size);
+  }
+}
+
+Result<Message<concreteprotocol::Value>> ValueStreamReader::readHeader() {
+  auto value = Message<concreteprotocol::Value>();
+  OUTCOME_TRYV(value.readBinaryFromFd(fd));
+  OUTCOME_TRY(auto expected, expectedBlobSizes(value.asReader().getRawInfo(),
+                                              maxPayloadSize));
+  uint64_t nbBlobs;
+  OUTCOME_TRYV(readBytes(fd, &nbBlobs, sizeof(nbBlobs)));
+  if (nbBlobs != expected.size()) {
+    return StringError("Tried to read a value with ")
+           << nbBlobs << " payload blobs instead of " << expected.size()
+           << ".";
+  }
+  blobSizes.resize(nbBlobs);
+  OUTCOME_TRYV(readBytes(fd, blobSizes.data(), nbBlobs * sizeof(uint64_t)));
+  if (blobSizes != expected) {
+    blobSizes.clear();
+    return StringError("Tried to read a value whose payload blob sizes don't "
+                       "match its shape and precision.");
+  }
+  value.asBuilder().initPayload().initData(nbBlobs);
+  return std::move(value);
+}
+
+Result<void>
+ValueStreamReader::readPayload(Message<concreteprotocol::Value> &value,
+                               size_t chunkSize,
+                               std::function<void(size_t)> onChunk) {
+  auto dataBuilder = value.asBuilder().getPayload().getData();
+  if (dataBuilder.size() != blobSizes.size()) {
+    return StringError(
+        "Tried to read the payload of a value whose header wasn't read.");
+  }
+  size_t readSize = 0;
+  for (size_t blobIndex = 0; blobIndex < blobSizes.size(); blobIndex++) {
+    auto blob = dataBuilder.init(blobIndex, blobSizes[blobIndex]);
+    for (size_t offset = 0; offset < blob.size(); offset += chunkSize) {
+      auto size = std::min(chunkSize, blob.size() - offset);
+      OUTCOME_TRYV(readBytes(fd, blob.begin() + offset, size));
+      readSize += size;
+      if (onChunk) {
+        onChunk(readSize);
+      }
+    }
+  }
+  blobSizes.clear();
+  return outcome::success();
+}
+
+Result<void> writeValueToFd(int fd,
+                            const Message<concreteprotocol::Value> &value) {
+  auto payload = value.asReader().getPayload().getData();
+  std::vector<uint64_t> blobSizes;
+  for (auto blob : payload) {
+    blobSizes.push_back(blob.size());
+  }
+  ValueStreamWriter writer(fd);
+  OUTCOME_TRYV(writer.writeHeader(value.asReader(), blobSizes));
+  for (auto blob : payload) {
+    OUTCOME_TRYV(writer.writePayload(blob.begin(), blob.size()));
+  }
+  return writer.finish();
+}
+
+Result<Message<concreteprotocol::Value>>
+readValueFromFd(int fd, size_t maxPayloadSize) {
+  ValueStreamReader reader(fd, maxPayloadSize);
+  OUTCOME_TRY(auto value, reader.readHeader());
+  OUTCOME_TRYV(reader.readPayload(value));
+  return std::move(value);
+}
+
 } // namespace protocol
 } // namespace concretelang
@@ -12,12 +12,21 @@
 #include "concretelang/Common/Keysets.h"
 #include "concretelang/Common/Values.h"
 #include "concretelang/Runtime/simulation.h"
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <stdlib.h>
 #include <string>
 
 using concretelang::error::Result;
 using concretelang::keysets::ClientKeyset;
+using concretelang::protocol::dimensionsToProtoShape;
+using concretelang::protocol::initProtoPayload;
+using concretelang::protocol::protoPayloadBlobSizes;
+using concretelang::protocol::readValueFromFd;
+using concretelang::protocol::ValueStreamReader;
+using concretelang::protocol::ValueStreamWriter;
+using concretelang::protocol::writeValueToFd;
 using concretelang::values::getCorrespondingPrecision;
 using concretelang::values::Tensor;
 using concretelang::values::TransportValue;
@@ -241,14 +250,13 @@ getTransportValueVerifier(const Message<concreteprotocol::GateInfo> &gateInfo) {
 
 Result<Transformer> getBooleanEncodingTransformer() {
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
+    auto tensor = std::move(*input.getTensorPtr<uint64_t>());
 
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
-      outputTensor.values[i] = inputTensor.values[i] << 61;
+    for (auto &value : tensor.values) {
+      value <<= 61;
     }
 
-    return Value{outputTensor};
+    return Value{std::move(tensor)};
   };
 }
 
@@ -258,18 +266,17 @@ Result<Transformer> getNativeModeIntegerEncodingTransformer(
   auto isSigned = info.asReader().getIsSigned();
 
   return [=](Value input) {
-    Tensor<uint64_t> inputTensor;
+    Tensor<uint64_t> tensor;
     if (isSigned) {
-      inputTensor = (Tensor<uint64_t>)input.getTensor<int64_t>().value();
+      tensor = (Tensor<uint64_t>)input.getTensor<int64_t>().value();
     } else {
-      inputTensor = input.getTensor<uint64_t>().value();
+      tensor = std::move(*input.getTensorPtr<uint64_t>());
     }
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
 
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
-      outputTensor.values[i] = inputTensor.values[i] << (64 - (width + 1));
+    for (auto &value : tensor.values) {
+      value <<= (64 - (width + 1));
     }
-    return Value{outputTensor};
+    return Value{std::move(tensor)};
   };
 }
 
@@ -279,11 +286,10 @@ Result<Transformer> getNativeModeIntegerDecodingTransformer(
   auto isSigned = info.asReader().getIsSigned();
 
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
+    auto outputTensor = std::move(*input.getTensorPtr<uint64_t>());
 
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
-      auto input = inputTensor.values[i];
+    for (size_t i = 0; i < outputTensor.values.size(); i++) {
+      auto input = outputTensor.values[i];
 
       // Decode unsigned integer
       uint64_t output = input >> (64 - precision - 2);
@@ -310,7 +316,7 @@ Result<Transformer> getNativeModeIntegerDecodingTransformer(
       auto signedOutputTensor = (Tensor<int64_t>)outputTensor;
       output = Value{signedOutputTensor};
     } else {
-      output = Value{outputTensor};
+      output = Value{std::move(outputTensor)};
     }
 
     return output;
@@ -345,7 +351,7 @@ Result<Transformer> getChunkedModeIntegerEncodingTransformer(
       }
     }
 
-    return Value{outputTensor};
+    return Value{std::move(outputTensor)};
   };
 }
 
@@ -395,7 +401,7 @@ Result<Transformer> getChunkedModeIntegerDecodingTransformer(
       auto signedOutputTensor = (Tensor<int64_t>)outputTensor;
       output = Value{signedOutputTensor};
     } else {
-      output = Value{outputTensor};
+      output = Value{std::move(outputTensor)};
     }
 
     return output;
@@ -431,7 +437,7 @@ Result<Transformer> getCrtModeIntegerEncodingTransformer(
       }
     }
 
-    return Value{outputTensor};
+    return Value{std::move(outputTensor)};
   };
 }
 
@@ -480,14 +486,18 @@ Result<Transformer> getCrtModeIntegerDecodingTransformer(
       auto signedOutputTensor = (Tensor<int64_t>)outputTensor;
       output = Value{signedOutputTensor};
     } else {
-      output = Value{outputTensor};
+      output = Value{std::move(outputTensor)};
     }
 
     return output;
   };
 }
 
-Result<Transformer> getEncryptionTransformer(
+/// A private type for transformers encrypting a value directly into the
+/// payload of a transport value.
+typedef std::function<TransportValue(Value)> EncryptionTransformer;
+
+Result<EncryptionTransformer> getEncryptionTransformer(
     ClientKeyset keyset,
     const Message<concreteprotocol::LweCiphertextEncryptionInfo> &info,
     std::shared_ptr<csprng::EncryptionCSPRNG> csprng) {
@@ -498,18 +508,93 @@ Result<Transformer> getEncryptionTransformer(
   auto variance = info.asReader().getVariance();
 
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
-    outputTensor.dimensions.push_back(lweSize);
-    outputTensor.values.resize(outputTensor.values.size() * lweSize);
-
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
+    auto inputTensor = input.getTensorPtr<uint64_t>();
+    auto dimensions = inputTensor->dimensions;
+    dimensions.push_back(lweSize);
+
+    auto output = Message<concreteprotocol::Value>();
+    auto rawInfo = output.asBuilder().initRawInfo();
+    rawInfo.setShape(dimensionsToProtoShape(dimensions).asReader());
+    rawInfo.setIntegerPrecision(64);
+    rawInfo.setIsSigned(false);
+
+    // The ciphertexts are encrypted in place in the blobs of the payload,
+    // the few of them spanning two blobs going through a temporary buffer.
+    auto elmsPerBlob = capnp::MAX_TEXT_SIZE / sizeof(uint64_t);
+    auto blobs = initProtoPayload<uint64_t>(
+        output.asBuilder().initPayload(),
+        inputTensor->values.size() * lweSize);
+    std::vector<uint64_t> straddling(lweSize);
+    for (size_t i = 0; i < inputTensor->values.size(); i++) {
+      auto offset = i * lweSize;
+      auto blobIndex = offset / elmsPerBlob;
+      auto blobOffset = offset % elmsPerBlob;
+      if (blobOffset + lweSize <= elmsPerBlob) {
+        concrete_cpu_encrypt_lwe_ciphertext_u64(
+            key.getRawPtr(), blobs[blobIndex] + blobOffset,
+            inputTensor->values[i], lweDimension, variance, csprng->ptr);
+        continue;
+      }
       concrete_cpu_encrypt_lwe_ciphertext_u64(
-          key.getRawPtr(), &outputTensor.values[i * lweSize],
-          inputTensor.values[i], lweDimension, variance, csprng->ptr);
+          key.getRawPtr(), straddling.data(), inputTensor->values[i],
+          lweDimension, variance, csprng->ptr);
+      auto head = elmsPerBlob - blobOffset;
+      std::memcpy(blobs[blobIndex] + blobOffset, straddling.data(),
+                  head * sizeof(uint64_t));
+      std::memcpy(blobs[blobIndex + 1], straddling.data() + head,
+                  (lweSize - head) * sizeof(uint64_t));
     }
 
-    return Value{outputTensor};
+    return output;
+  };
+}
+
+/// A private type for transformers encrypting a value directly to a value
+/// stream, the header of the value holding its type infos.
+typedef std::function<Result<void>(Value, TransportValue, ValueStreamWriter &)>
+    EncryptionStreamTransformer;
+
+Result<EncryptionStreamTransformer> getEncryptionStreamTransformer(
+    ClientKeyset keyset,
+    const Message<concreteprotocol::LweCiphertextEncryptionInfo> &info,
+    std::shared_ptr<csprng::EncryptionCSPRNG> csprng) {
+
+  auto key = keyset.lweSecretKeys[info.asReader().getKeyId()];
+  auto lweDimension = info.asReader().getLweDimension();
+  auto lweSize = lweDimension + 1;
+  auto variance = info.asReader().getVariance();
+
+  return [=](Value input, TransportValue header,
+             ValueStreamWriter &writer) -> Result<void> {
+    auto inputTensor = input.getTensorPtr<uint64_t>();
+    auto dimensions = inputTensor->dimensions;
+    dimensions.push_back(lweSize);
+
+    auto rawInfo = header.asBuilder().initRawInfo();
+    rawInfo.setShape(dimensionsToProtoShape(dimensions).asReader());
+    rawInfo.setIntegerPrecision(64);
+    rawInfo.setIsSigned(false);
+    OUTCOME_TRYV(writer.writeHeader(
+        header.asReader(), protoPayloadBlobSizes<uint64_t>(
+                               inputTensor->values.size() * lweSize)));
+
+    // The ciphertexts are encrypted by batches of about a chunk, each batch
+    // being written to the stream before the next one is encrypted.
+    size_t lweBytes = lweSize * sizeof(uint64_t);
+    size_t batchSize = std::min(
+        std::max<size_t>(1, ValueStreamReader::DEFAULT_CHUNK_SIZE / lweBytes),
+        inputTensor->values.size());
+    std::vector<uint64_t> batch(batchSize * lweSize);
+    for (size_t i = 0; i < inputTensor->values.size(); i += batchSize) {
+      size_t count = std::min(batchSize, inputTensor->values.size() - i);
+      for (size_t j = 0; j < count; j++) {
+        concrete_cpu_encrypt_lwe_ciphertext_u64(
+            key.getRawPtr(), &batch[j * lweSize], inputTensor->values[i + j],
+            lweDimension, variance, csprng->ptr);
+      }
+      OUTCOME_TRYV(writer.writePayload(batch.data(), count * lweBytes));
+    }
+    return writer.finish();
   };
 }
 
@@ -520,15 +605,13 @@ Result<Transformer> getEncryptionSimulationTransformer(
   auto lweDimension = info.asReader().getLweDimension();
 
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
+    auto tensor = std::move(*input.getTensorPtr<uint64_t>());
 
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
-      outputTensor.values[i] = sim_encrypt_lwe_u64(
-          inputTensor.values[i], lweDimension, (void *)(*csprng).ptr);
+    for (auto &value : tensor.values) {
+      value = sim_encrypt_lwe_u64(value, lweDimension, (void *)(*csprng).ptr);
     }
 
-    return Value{outputTensor};
+    return Value{std::move(tensor)};
   };
 }
 
@@ -541,18 +624,19 @@ Result<Transformer> getDecryptionTransformer(
   auto lweSize = lweDimension + 1;
 
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
+    auto inputTensor = input.getTensorPtr<uint64_t>();
+    auto outputTensor = Tensor<uint64_t>();
+    outputTensor.dimensions = inputTensor->dimensions;
     outputTensor.dimensions.pop_back();
-    outputTensor.values.resize(outputTensor.values.size() / lweSize);
+    outputTensor.values.resize(inputTensor->values.size() / lweSize);
 
     for (size_t i = 0; i < outputTensor.values.size(); i++) {
       concrete_cpu_decrypt_lwe_ciphertext_u64(
-          key.getRawPtr(), &inputTensor.values[i * lweSize], lweDimension,
+          key.getRawPtr(), &inputTensor->values[i * lweSize], lweDimension,
           &outputTensor.values[i]);
     }
 
-    return Value{outputTensor};
+    return Value{std::move(outputTensor)};
   };
 }
 
@@ -568,13 +652,62 @@ Result<Transformer> getNoneDecompressionTransformer() {
   return [](auto input) { return input; };
 }
 
+Result<Transformer> getModulusSwitchingTransformer(uint32_t modulusLog) {
+  auto shift = 64 - modulusLog;
+  uint64_t mask = (((uint64_t)1) << modulusLog) - 1;
+  auto storagePrecision = getCorrespondingPrecision(modulusLog);
+
+  return [=](Value input) {
+    auto outputTensor = std::move(*input.getTensorPtr<uint64_t>());
+
+    for (auto &value : outputTensor.values) {
+      // Rounds to the closest multiple of 2^shift, and wraps around 2^b.
+      auto rounded = ((value >> (shift - 1)) + 1) >> 1;
+      value = rounded & mask;
+    }
+
+    switch (storagePrecision) {
+    case 8:
+      return Value{(Tensor<uint8_t>)outputTensor};
+    case 16:
+      return Value{(Tensor<uint16_t>)outputTensor};
+    case 32:
+      return Value{(Tensor<uint32_t>)outputTensor};
+    default:
+      return Value{std::move(outputTensor)};
+    }
+  };
+}
+
+Result<Transformer> getModulusRestoringTransformer(uint32_t modulusLog) {
+  auto shift = 64 - modulusLog;
+
+  return [=](Value input) {
+    Tensor<uint64_t> outputTensor;
+    if (input.hasElementType<uint8_t>()) {
+      outputTensor = (Tensor<uint64_t>)input.getTensor<uint8_t>().value();
+    } else if (input.hasElementType<uint16_t>()) {
+      outputTensor = (Tensor<uint64_t>)input.getTensor<uint16_t>().value();
+    } else if (input.hasElementType<uint32_t>()) {
+      outputTensor = (Tensor<uint64_t>)input.getTensor<uint32_t>().value();
+    } else {
+      outputTensor = std::move(*input.getTensorPtr<uint64_t>());
+    }
+
+    for (auto &value : outputTensor.values) {
+      value <<= shift;
+    }
+
+    return Value{std::move(outputTensor)};
+  };
+}
+
 Result<Transformer> getBooleanDecodingTransformer() {
   return [=](Value input) {
-    auto inputTensor = input.getTensor<uint64_t>().value();
-    auto outputTensor = Tensor<uint64_t>(inputTensor);
+    auto outputTensor = std::move(*input.getTensorPtr<uint64_t>());
 
-    for (size_t i = 0; i < inputTensor.values.size(); i++) {
-      auto input = inputTensor.values[i];
+    for (size_t i = 0; i < outputTensor.values.size(); i++) {
+      auto input = outputTensor.values[i];
       uint64_t output = input >> 60;
       uint64_t carry = output % 2;
       uint64_t mod = 1 << 3;
@@ -582,7 +715,7 @@ Result<Transformer> getBooleanDecodingTransformer() {
       outputTensor.values[i] = output;
     }
 
-    return Value{outputTensor};
+    return Value{std::move(outputTensor)};
   };
 }
 
@@ -640,7 +773,7 @@ Result<OutputTransformer> TransformerFactory::getIndexOutputTransformer(
         "Tried to get index output transformer from non-index gate info.");
   }
   OUTCOME_TRY(auto verify, getTransportValueVerifier(gateInfo));
-  return [=](TransportValue transportVal) -> Result<Value> {
+  return [=](const TransportValue &transportVal) -> Result<Value> {
     OUTCOME_TRYV(verify(transportVal));
     return Value::fromRawTransportValue(transportVal);
   };
@@ -692,7 +825,7 @@ Result<OutputTransformer> TransformerFactory::getPlaintextOutputTransformer(
                        "non-plaintext gate info.");
   }
   OUTCOME_TRY(auto verify, getTransportValueVerifier(gateInfo));
-  return [=](TransportValue transportVal) -> Result<Value> {
+  return [=](const TransportValue &transportVal) -> Result<Value> {
     OUTCOME_TRYV(verify(transportVal));
     return Value::fromRawTransportValue(transportVal);
   };
@@ -718,9 +851,11 @@ Result<ReturnTransformer> TransformerFactory::getPlaintextReturnTransformer(
   return getPlaintextInputTransformer(std::move(gateInfo));
 }
 
-Result<InputTransformer> TransformerFactory::getLweCiphertextInputTransformer(
-    ClientKeyset keyset, Message<concreteprotocol::GateInfo> gateInfo,
-    std::shared_ptr<csprng::EncryptionCSPRNG> csprng, bool useSimulation) {
+/// Returns the encoding transformer of an lwe ciphertext input gate, checking
+/// that the gate can be encrypted with the keyset.
+Result<Transformer> getLweCiphertextInputEncodingTransformer(
+    const ClientKeyset &keyset,
+    const Message<concreteprotocol::GateInfo> &gateInfo, bool useSimulation) {
   if (!gateInfo.asReader().getTypeInfo().hasLweCiphertext()) {
     return StringError("Tried to get lwe ciphertext input transformer from "
                        "non-ciphertext gate info.");
@@ -761,15 +896,36 @@ Result<InputTransformer> TransformerFactory::getLweCiphertextInputTransformer(
     return StringError("Malformed gate info");
   }
 
+  /// The encryption transformers also take care of the compression, only none
+  /// compression being supported.
+  if (gateInfo.asReader().getTypeInfo().getLweCiphertext().getCompression() !=
+      concreteprotocol::Compression::NONE) {
+    return StringError(
+        "Only none compression is currently supported for lwe ciphertext "
+        "currently.");
+  }
+  return encodingTransformer;
+}
+
+Result<InputTransformer> TransformerFactory::getLweCiphertextInputTransformer(
+    ClientKeyset keyset, Message<concreteprotocol::GateInfo> gateInfo,
+    std::shared_ptr<csprng::EncryptionCSPRNG> csprng, bool useSimulation) {
+  OUTCOME_TRY(auto encodingTransformer,
+              getLweCiphertextInputEncodingTransformer(keyset, gateInfo,
+                                                       useSimulation));
+
   /// Generating the encryption transformer.
-  Transformer encryptionTransformer;
+  EncryptionTransformer encryptionTransformer;
   if (useSimulation) {
-    OUTCOME_TRY(encryptionTransformer,
+    OUTCOME_TRY(auto simulationTransformer,
                 getEncryptionSimulationTransformer(gateInfo.asReader()
                                                        .getTypeInfo()
                                                        .getLweCiphertext()
                                                        .getEncryption(),
                                                    csprng));
+    encryptionTransformer = [=](Value input) {
+      return simulationTransformer(std::move(input)).intoRawTransportValue();
+    };
   } else {
     OUTCOME_TRY(encryptionTransformer,
                 getEncryptionTransformer(keyset,
@@ -780,23 +936,10 @@ Result<InputTransformer> TransformerFactory::getLweCiphertextInputTransformer(
                                          csprng));
   }
 
-  /// Generating the compression transformer.
-  Transformer compressionTransformer;
-  if (gateInfo.asReader().getTypeInfo().getLweCiphertext().getCompression() ==
-      concreteprotocol::Compression::NONE) {
-    OUTCOME_TRY(compressionTransformer, getNoneCompressionTransformer());
-  } else {
-    return StringError(
-        "Only none compression is currently supported for lwe ciphertext "
-        "currently.");
-  }
-
   OUTCOME_TRY(auto verify, getLweCiphertextInputValueVerifier(gateInfo));
   return [=](Value val) -> Result<TransportValue> {
     OUTCOME_TRYV(verify(val));
-    auto output =
-        compressionTransformer(encryptionTransformer(encodingTransformer(val)))
-            .intoRawTransportValue();
+    auto output = encryptionTransformer(encodingTransformer(std::move(val)));
     output.asBuilder().initTypeInfo().setLweCiphertext(
         gateInfo.asReader().getTypeInfo().getLweCiphertext());
     return output;
@@ -829,7 +972,7 @@ Result<ArgTransformer> TransformerFactory::getLweCiphertextArgTransformer(
     OUTCOME_TRY(verify, getTransportValueVerifier(gateInfo));
   }
 
-  return [=](TransportValue transportVal) -> Result<Value> {
+  return [=](const TransportValue &transportVal) -> Result<Value> {
     OUTCOME_TRYV(verify(transportVal));
     return decompressionTransformer(Value::fromRawTransportValue(transportVal));
   };
@@ -853,6 +996,20 @@ Result<ReturnTransformer> TransformerFactory::getLweCiphertextReturnTransformer(
         "currently.");
   }
 
+  /// Generating the modulus switching transformer.
+  Transformer modulusSwitchingTransformer = [](Value input) { return input; };
+  auto modulus = gateInfo.asReader()
+                     .getTypeInfo()
+                     .getLweCiphertext()
+                     .getEncryption()
+                     .getModulus()
+                     .getMod();
+  if (modulus.isPowerOfTwo()) {
+    OUTCOME_TRY(modulusSwitchingTransformer,
+                getModulusSwitchingTransformer(
+                    modulus.getPowerOfTwo().getPower()));
+  }
+
   // Generating the verifier.
   ValueVerifier verify;
   if (useSimulation) {
@@ -863,7 +1020,9 @@ Result<ReturnTransformer> TransformerFactory::getLweCiphertextReturnTransformer(
 
   return [=](Value val) -> Result<TransportValue> {
     OUTCOME_TRYV(verify(val));
-    auto output = compressionTransformer(val).intoRawTransportValue();
+    auto output =
+        compressionTransformer(modulusSwitchingTransformer(std::move(val)))
+            .intoRawTransportValue();
     output.asBuilder().initTypeInfo().setLweCiphertext(
         gateInfo.asReader().getTypeInfo().getLweCiphertext());
     return output;
@@ -901,6 +1060,20 @@ Result<OutputTransformer> TransformerFactory::getLweCiphertextOutputTransformer(
         "currently.");
   }
 
+  /// Generating the modulus restoring transformer.
+  Transformer modulusRestoringTransformer = [](Value input) { return input; };
+  auto modulus = gateInfo.asReader()
+                     .getTypeInfo()
+                     .getLweCiphertext()
+                     .getEncryption()
+                     .getModulus()
+                     .getMod();
+  if (modulus.isPowerOfTwo()) {
+    OUTCOME_TRY(modulusRestoringTransformer,
+                getModulusRestoringTransformer(
+                    modulus.getPowerOfTwo().getPower()));
+  }
+
   /// Generating the decryption transformer.
   Transformer decryptionTransformer;
   if (useSimulation) {
@@ -944,10 +1117,63 @@ Result<OutputTransformer> TransformerFactory::getLweCiphertextOutputTransformer(
     OUTCOME_TRY(verify, getTransportValueVerifier(gateInfo));
   }
 
-  return [=](TransportValue transportVal) -> Result<Value> {
+  return [=](const TransportValue &transportVal) -> Result<Value> {
     OUTCOME_TRYV(verify(transportVal));
-    return decodingTransformer(decryptionTransformer(
-        decompressionTransformer(Value::fromRawTransportValue(transportVal))));
+    return decodingTransformer(
+        decryptionTransformer(modulusRestoringTransformer(
+            decompressionTransformer(
+                Value::fromRawTransportValue(transportVal)))));
+  };
+}
+
+Result<InputStreamTransformer>
+TransformerFactory::getInputStreamTransformer(InputTransformer transformer) {
+  return [=](Value val, int fd) -> Result<void> {
+    OUTCOME_TRY(auto output, transformer(std::move(val)));
+    return writeValueToFd(fd, output);
+  };
+}
+
+Result<InputStreamTransformer>
+TransformerFactory::getLweCiphertextInputStreamTransformer(
+    ClientKeyset keyset, Message<concreteprotocol::GateInfo> gateInfo,
+    std::shared_ptr<csprng::EncryptionCSPRNG> csprng, bool useSimulation) {
+  // The simulated ciphertexts are single integers, which are not worth
+  // streaming while they are encrypted.
+  if (useSimulation) {
+    OUTCOME_TRY(auto transformer, getLweCiphertextInputTransformer(
+                                      keyset, gateInfo, csprng, useSimulation));
+    return getInputStreamTransformer(transformer);
+  }
+
+  OUTCOME_TRY(auto encodingTransformer,
+              getLweCiphertextInputEncodingTransformer(keyset, gateInfo,
+                                                       useSimulation));
+  OUTCOME_TRY(auto encryptionTransformer,
+              getEncryptionStreamTransformer(keyset,
+                                             gateInfo.asReader()
+                                                 .getTypeInfo()
+                                                 .getLweCiphertext()
+                                                 .getEncryption(),
+                                             csprng));
+
+  OUTCOME_TRY(auto verify, getLweCiphertextInputValueVerifier(gateInfo));
+  return [=](Value val, int fd) -> Result<void> {
+    OUTCOME_TRYV(verify(val));
+    auto header = TransportValue();
+    header.asBuilder().initTypeInfo().setLweCiphertext(
+        gateInfo.asReader().getTypeInfo().getLweCiphertext());
+    ValueStreamWriter writer(fd);
+    return encryptionTransformer(encodingTransformer(std::move(val)),
+                                 std::move(header), writer);
+  };
+}
+
+Result<ArgStreamTransformer>
+TransformerFactory::getArgStreamTransformer(ArgTransformer transformer) {
+  return [=](int fd) -> Result<Value> {
+    OUTCOME_TRY(auto transportVal, readValueFromFd(fd));
+    return transformer(transportVal);
   };
 }
 
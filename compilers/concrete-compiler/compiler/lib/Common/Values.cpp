@@ -20,12 +20,12 @@ using concretelang::protocol::dimensionsToProtoShape;
 using concretelang::protocol::Message;
 using concretelang::protocol::protoPayloadToVector;
 using concretelang::protocol::protoShapeToDimensions;
-using concretelang::protocol::vectorToProtoPayload;
+using concretelang::protocol::vectorIntoProtoPayload;
 
 namespace concretelang {
 namespace values {
 
-Value Value::fromRawTransportValue(TransportValue transportVal) {
+Value Value::fromRawTransportValue(const TransportValue &transportVal) {
   Value output;
   auto integerPrecision =
       transportVal.asReader().getRawInfo().getIntegerPrecision();
@@ -34,29 +34,36 @@ Value Value::fromRawTransportValue(TransportValue transportVal) {
       protoShapeToDimensions(transportVal.asReader().getRawInfo().getShape());
   auto data = transportVal.asReader().getPayload();
   if (integerPrecision == 8 && isSigned) {
-    auto values = protoPayloadToVector<int8_t>(data);
-    output.inner = Tensor<int8_t>{values, dimensions};
+    auto values = protoPayloadToVector<int8_t, StorageAllocator<int8_t>>(data);
+    output.inner = Tensor<int8_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 16 && isSigned) {
-    auto values = protoPayloadToVector<int16_t>(data);
-    output.inner = Tensor<int16_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<int16_t, StorageAllocator<int16_t>>(data);
+    output.inner = Tensor<int16_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 32 && isSigned) {
-    auto values = protoPayloadToVector<int32_t>(data);
-    output.inner = Tensor<int32_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<int32_t, StorageAllocator<int32_t>>(data);
+    output.inner = Tensor<int32_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 64 && isSigned) {
-    auto values = protoPayloadToVector<int64_t>(data);
-    output.inner = Tensor<int64_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<int64_t, StorageAllocator<int64_t>>(data);
+    output.inner = Tensor<int64_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 8 && !isSigned) {
-    auto values = protoPayloadToVector<uint8_t>(data);
-    output.inner = Tensor<uint8_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<uint8_t, StorageAllocator<uint8_t>>(data);
+    output.inner = Tensor<uint8_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 16 && !isSigned) {
-    auto values = protoPayloadToVector<uint16_t>(data);
-    output.inner = Tensor<uint16_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<uint16_t, StorageAllocator<uint16_t>>(data);
+    output.inner = Tensor<uint16_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 32 && !isSigned) {
-    auto values = protoPayloadToVector<uint32_t>(data);
-    output.inner = Tensor<uint32_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<uint32_t, StorageAllocator<uint32_t>>(data);
+    output.inner = Tensor<uint32_t>{std::move(values), std::move(dimensions)};
   } else if (integerPrecision == 64 && !isSigned) {
-    auto values = protoPayloadToVector<uint64_t>(data);
-    output.inner = Tensor<uint64_t>{values, dimensions};
+    auto values =
+        protoPayloadToVector<uint64_t, StorageAllocator<uint64_t>>(data);
+    output.inner = Tensor<uint64_t>{std::move(values), std::move(dimensions)};
   } else {
     assert(false);
   }
@@ -70,7 +77,7 @@ TransportValue Value::intoRawTransportValue() const {
   rawInfo.setShape(intoProtoShape().asReader());
   rawInfo.setIntegerPrecision(getIntegerPrecision());
   rawInfo.setIsSigned(isSigned());
-  output.asBuilder().setPayload(intoProtoPayload().asReader());
+  intoProtoPayload(output.asBuilder().initPayload());
   return output;
 }
 
@@ -102,22 +109,28 @@ bool Value::isSigned() const {
 }
 
 Message<concreteprotocol::Payload> Value::intoProtoPayload() const {
+  auto output = Message<concreteprotocol::Payload>();
+  intoProtoPayload(output.asBuilder());
+  return output;
+}
+
+void Value::intoProtoPayload(concreteprotocol::Payload::Builder payload) const {
   if (hasElementType<uint8_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<uint8_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<uint8_t>>(inner).values, payload);
   } else if (hasElementType<uint16_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<uint16_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<uint16_t>>(inner).values, payload);
   } else if (hasElementType<uint32_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<uint32_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<uint32_t>>(inner).values, payload);
   } else if (hasElementType<uint64_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<uint64_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<uint64_t>>(inner).values, payload);
   } else if (hasElementType<int8_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<int8_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<int8_t>>(inner).values, payload);
   } else if (hasElementType<int16_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<int16_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<int16_t>>(inner).values, payload);
   } else if (hasElementType<int32_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<int32_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<int32_t>>(inner).values, payload);
   } else if (hasElementType<int64_t>()) {
-    return vectorToProtoPayload(std::get<Tensor<int64_t>>(inner).values);
+    vectorIntoProtoPayload(std::get<Tensor<int64_t>>(inner).values, payload);
   } else {
     assert(false);
   }
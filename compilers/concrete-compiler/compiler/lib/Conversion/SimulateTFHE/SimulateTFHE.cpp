@@ -4,6 +4,7 @@
 // for license information.
 
 #include "mlir/Dialect/Bufferization/IR/Bufferization.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
 
@@ -522,6 +523,251 @@ struct KeySwitchGLWEOpPattern
   }
 };
 
+struct BatchedKeySwitchGLWEOpPattern
+    : public mlir::OpConversionPattern<TFHE::BatchedKeySwitchGLWEOp> {
+
+  BatchedKeySwitchGLWEOpPattern(mlir::MLIRContext *context,
+                                mlir::TypeConverter &typeConverter)
+      : mlir::OpConversionPattern<TFHE::BatchedKeySwitchGLWEOp>(
+            typeConverter, context,
+            mlir::concretelang::DEFAULT_PATTERN_BENEFIT) {}
+
+  ::mlir::LogicalResult
+  matchAndRewrite(TFHE::BatchedKeySwitchGLWEOp ksOp,
+                  TFHE::BatchedKeySwitchGLWEOp::Adaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+
+    const std::string funcName = "sim_batched_keyswitch_lwe_u64";
+
+    TFHE::GLWECipherTextType resultType =
+        ksOp.getType().getElementType().cast<TFHE::GLWECipherTextType>();
+    TFHE::GLWECipherTextType inputType =
+        ksOp.getCiphertexts()
+            .getType()
+            .getElementType()
+            .cast<TFHE::GLWECipherTextType>();
+
+    auto levels = adaptor.getKey().getLevels();
+    auto baseLog = adaptor.getKey().getBaseLog();
+    auto inputDim = inputType.getKey().getNormalized().value().dimension;
+    auto outputDim = resultType.getKey().getNormalized().value().dimension;
+
+    mlir::Value levelCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(ksOp.getLoc(), levels, 32);
+    mlir::Value baseLogCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(ksOp.getLoc(), baseLog, 32);
+    mlir::Value inputDimCst = rewriter.create<mlir::arith::ConstantIntOp>(
+        ksOp.getLoc(), inputDim, 32);
+    mlir::Value outputDimCst = rewriter.create<mlir::arith::ConstantIntOp>(
+        ksOp.getLoc(), outputDim, 32);
+
+    auto convertedResultType = this->getTypeConverter()
+                                   ->convertType(ksOp.getType())
+                                   .cast<mlir::RankedTensorType>();
+    mlir::Value outputBuffer =
+        rewriter.create<mlir::bufferization::AllocTensorOp>(
+            ksOp.getLoc(), convertedResultType, mlir::ValueRange{});
+
+    auto dynamicResultType = toDynamicTensorType(convertedResultType);
+    auto dynamicInputType = toDynamicTensorType(
+        adaptor.getCiphertexts().getType().cast<mlir::RankedTensorType>());
+
+    mlir::Value castedOutputBuffer = rewriter.create<mlir::tensor::CastOp>(
+        ksOp.getLoc(), dynamicResultType, outputBuffer);
+    mlir::Value castedInput = rewriter.create<mlir::tensor::CastOp>(
+        ksOp.getLoc(), dynamicInputType, adaptor.getCiphertexts());
+
+    // void sim_batched_keyswitch_lwe_u64(uint64_t *out_allocated, uint64_t
+    // *out_aligned, uint64_t out_offset, uint64_t out_size, uint64_t
+    // out_stride, uint64_t *in_allocated, uint64_t *in_aligned, uint64_t
+    // in_offset, uint64_t in_size, uint64_t in_stride, uint32_t level,
+    // uint32_t base_log, uint32_t input_lwe_dim, uint32_t output_lwe_dim)
+    if (insertForwardDeclaration(
+            ksOp, rewriter, funcName,
+            rewriter.getFunctionType(
+                {dynamicResultType, dynamicInputType,
+                 rewriter.getIntegerType(32), rewriter.getIntegerType(32),
+                 rewriter.getIntegerType(32), rewriter.getIntegerType(32)},
+                {}))
+            .failed()) {
+      return mlir::failure();
+    }
+
+    rewriter.create<mlir::func::CallOp>(
+        ksOp.getLoc(), funcName, mlir::TypeRange{},
+        mlir::ValueRange({castedOutputBuffer, castedInput, levelCst,
+                          baseLogCst, inputDimCst, outputDimCst}));
+
+    rewriter.replaceOp(ksOp, outputBuffer);
+
+    return mlir::success();
+  }
+};
+
+/// Lowers the batched bootstraps, with a single lookup table or with one
+/// lookup table per ciphertext, to the batched entry points of the
+/// simulation runtime.
+template <typename BatchedBootstrapOp>
+struct BatchedBootstrapGLWEOpPattern
+    : public mlir::OpConversionPattern<BatchedBootstrapOp> {
+
+  BatchedBootstrapGLWEOpPattern(mlir::MLIRContext *context,
+                                mlir::TypeConverter &typeConverter,
+                                llvm::StringRef funcName)
+      : mlir::OpConversionPattern<BatchedBootstrapOp>(
+            typeConverter, context,
+            mlir::concretelang::DEFAULT_PATTERN_BENEFIT),
+        funcName(funcName) {}
+
+  ::mlir::LogicalResult
+  matchAndRewrite(BatchedBootstrapOp bsOp,
+                  typename BatchedBootstrapOp::Adaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+
+    TFHE::GLWECipherTextType inputType =
+        bsOp.getCiphertexts()
+            .getType()
+            .getElementType()
+            .template cast<TFHE::GLWECipherTextType>();
+
+    auto polySize = adaptor.getKey().getPolySize();
+    auto glweDimension = adaptor.getKey().getGlweDim();
+    auto levels = adaptor.getKey().getLevels();
+    auto baseLog = adaptor.getKey().getBaseLog();
+    auto inputLweDimension =
+        inputType.getKey().getNormalized().value().dimension;
+
+    auto polySizeCst = rewriter.create<mlir::arith::ConstantIntOp>(
+        bsOp.getLoc(), polySize, 32);
+    auto glweDimensionCst = rewriter.create<mlir::arith::ConstantIntOp>(
+        bsOp.getLoc(), glweDimension, 32);
+    auto levelsCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(bsOp.getLoc(), levels, 32);
+    auto baseLogCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(bsOp.getLoc(), baseLog, 32);
+    auto inputLweDimensionCst = rewriter.create<mlir::arith::ConstantIntOp>(
+        bsOp.getLoc(), inputLweDimension, 32);
+
+    auto convertedResultType = this->getTypeConverter()
+                                   ->convertType(bsOp.getType())
+                                   .template cast<mlir::RankedTensorType>();
+    mlir::Value outputBuffer =
+        rewriter.create<mlir::bufferization::AllocTensorOp>(
+            bsOp.getLoc(), convertedResultType, mlir::ValueRange{});
+
+    auto dynamicResultType = toDynamicTensorType(convertedResultType);
+    auto dynamicInputType =
+        toDynamicTensorType(adaptor.getCiphertexts()
+                                .getType()
+                                .template cast<mlir::RankedTensorType>());
+    auto dynamicLutType = toDynamicTensorType(bsOp.getLookupTable().getType());
+
+    mlir::Value castedOutputBuffer = rewriter.create<mlir::tensor::CastOp>(
+        bsOp.getLoc(), dynamicResultType, outputBuffer);
+    mlir::Value castedInput = rewriter.create<mlir::tensor::CastOp>(
+        bsOp.getLoc(), dynamicInputType, adaptor.getCiphertexts());
+    mlir::Value castedLUT = rewriter.create<mlir::tensor::CastOp>(
+        bsOp.getLoc(), dynamicLutType, adaptor.getLookupTable());
+
+    // void sim_batched_(mapped_)bootstrap_lwe_u64(out memref, in memref, tlu
+    // memref, uint32_t input_lwe_dim, uint32_t poly_size, uint32_t level,
+    // uint32_t base_log, uint32_t glwe_dim)
+    if (insertForwardDeclaration(
+            bsOp, rewriter, funcName,
+            rewriter.getFunctionType(
+                {dynamicResultType, dynamicInputType, dynamicLutType,
+                 rewriter.getIntegerType(32), rewriter.getIntegerType(32),
+                 rewriter.getIntegerType(32), rewriter.getIntegerType(32),
+                 rewriter.getIntegerType(32)},
+                {}))
+            .failed()) {
+      return mlir::failure();
+    }
+
+    rewriter.create<mlir::func::CallOp>(
+        bsOp.getLoc(), funcName, mlir::TypeRange{},
+        mlir::ValueRange({castedOutputBuffer, castedInput, castedLUT,
+                          inputLweDimensionCst, polySizeCst, levelsCst,
+                          baseLogCst, glweDimensionCst}));
+
+    rewriter.replaceOp(bsOp, outputBuffer);
+
+    return mlir::success();
+  }
+
+private:
+  std::string funcName;
+};
+
+/// Lowers the batched leveled operations to the batched entry points of the
+/// simulation runtime, passing the tensor operands as 1D memrefs and the
+/// scalar operands as 64 bits integers. As ciphertexts and integers are both
+/// simulated by 64 bits integers, an operation between a scalar ciphertext
+/// and a tensor of integers is lowered to the entry point of the commuted
+/// operation.
+template <typename BatchedOp>
+struct BatchedLeveledOpPattern : public mlir::OpConversionPattern<BatchedOp> {
+
+  BatchedLeveledOpPattern(mlir::MLIRContext *context,
+                          mlir::TypeConverter &typeConverter,
+                          llvm::StringRef funcName, bool commute = false)
+      : mlir::OpConversionPattern<BatchedOp>(
+            typeConverter, context,
+            mlir::concretelang::DEFAULT_PATTERN_BENEFIT),
+        funcName(funcName), commute(commute) {}
+
+  ::mlir::LogicalResult
+  matchAndRewrite(BatchedOp op, typename BatchedOp::Adaptor adaptor,
+                  mlir::ConversionPatternRewriter &rewriter) const override {
+
+    llvm::SmallVector<mlir::Value> inputs(adaptor.getOperands());
+    if (commute)
+      std::reverse(inputs.begin(), inputs.end());
+    for (mlir::Value input : inputs) {
+      if (!mlir::getElementTypeOrSelf(input.getType()).isInteger(64))
+        return rewriter.notifyMatchFailure(op, "expected 64 bits integers");
+    }
+
+    auto convertedResultType = this->getTypeConverter()
+                                   ->convertType(op.getType())
+                                   .template cast<mlir::RankedTensorType>();
+    mlir::Value outputBuffer =
+        rewriter.create<mlir::bufferization::AllocTensorOp>(
+            op.getLoc(), convertedResultType, mlir::ValueRange{});
+
+    auto dynamicResultType = toDynamicTensorType(convertedResultType);
+    llvm::SmallVector<mlir::Value> operands{
+        rewriter.create<mlir::tensor::CastOp>(op.getLoc(), dynamicResultType,
+                                              outputBuffer)};
+    for (mlir::Value input : inputs) {
+      if (auto tensorType = input.getType().dyn_cast<mlir::RankedTensorType>())
+        input = rewriter.create<mlir::tensor::CastOp>(
+            op.getLoc(), toDynamicTensorType(tensorType), input);
+      operands.push_back(input);
+    }
+
+    // void sim_batched_<op>_lwe_u64(out memref, in memref, memref or uint64_t)
+    if (insertForwardDeclaration(
+            op, rewriter, funcName,
+            rewriter.getFunctionType(mlir::ValueRange(operands).getTypes(),
+                                     {}))
+            .failed()) {
+      return mlir::failure();
+    }
+
+    rewriter.create<mlir::func::CallOp>(op.getLoc(), funcName,
+                                        mlir::TypeRange{}, operands);
+
+    rewriter.replaceOp(op, outputBuffer);
+
+    return mlir::success();
+  }
+
+private:
+  std::string funcName;
+  bool commute;
+};
+
 struct ZeroOpPattern : public mlir::OpConversionPattern<TFHE::ZeroGLWEOp> {
   ZeroOpPattern(mlir::MLIRContext *context, mlir::TypeConverter &typeConverter)
       : mlir::OpConversionPattern<TFHE::ZeroGLWEOp>(
@@ -641,8 +887,31 @@ void SimulateTFHEPass::runOnOperation() {
                   BootstrapGLWEOpPattern, WopPBSGLWEOpPattern,
                   EncodeExpandLutForBootstrapOpPattern,
                   EncodeLutForCrtWopPBSOpPattern,
-                  EncodePlaintextWithCrtOpPattern, NegOpPattern>(&getContext(),
-                                                                 converter);
+                  EncodePlaintextWithCrtOpPattern, NegOpPattern,
+                  BatchedKeySwitchGLWEOpPattern>(&getContext(), converter);
+  patterns.insert<BatchedBootstrapGLWEOpPattern<TFHE::BatchedBootstrapGLWEOp>>(
+      &getContext(), converter, "sim_batched_bootstrap_lwe_u64");
+  patterns.insert<
+      BatchedBootstrapGLWEOpPattern<TFHE::BatchedMappedBootstrapGLWEOp>>(
+      &getContext(), converter, "sim_batched_mapped_bootstrap_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::ABatchedAddGLWEOp>>(
+      &getContext(), converter, "sim_batched_add_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::ABatchedAddGLWEIntOp>>(
+      &getContext(), converter, "sim_batched_add_plaintext_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::ABatchedAddGLWEIntCstOp>>(
+      &getContext(), converter, "sim_batched_add_plaintext_cst_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::ABatchedAddGLWECstIntOp>>(
+      &getContext(), converter, "sim_batched_add_plaintext_cst_lwe_u64",
+      true);
+  patterns.insert<BatchedLeveledOpPattern<TFHE::BatchedMulGLWEIntOp>>(
+      &getContext(), converter, "sim_batched_mul_cleartext_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::BatchedMulGLWEIntCstOp>>(
+      &getContext(), converter, "sim_batched_mul_cleartext_cst_lwe_u64");
+  patterns.insert<BatchedLeveledOpPattern<TFHE::BatchedMulGLWECstIntOp>>(
+      &getContext(), converter, "sim_batched_mul_cleartext_cst_lwe_u64",
+      true);
+  patterns.insert<BatchedLeveledOpPattern<TFHE::BatchedNegGLWEOp>>(
+      &getContext(), converter, "sim_batched_neg_lwe_u64");
   patterns.insert<SubIntGLWEOpPattern>(&getContext());
 
   patterns.add<mlir::concretelang::TypeConvertingReinstantiationPattern<
@@ -0,0 +1,273 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/MemRef/IR/MemRef.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/IR/BuiltinOps.h>
+#include <mlir/Interfaces/ViewLikeInterface.h>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <concretelang/Dialect/Concrete/IR/ConcreteOps.h>
+#include <concretelang/Dialect/Concrete/Transforms/Passes.h>
+#include <concretelang/Dialect/RT/IR/RTDialect.h>
+#include <concretelang/Support/CompilationFeedback.h>
+
+namespace mlir {
+namespace concretelang {
+
+namespace {
+
+/// Alignment of the buffers placed in the arena, such that the operations on
+/// ciphertexts can be vectorized.
+const uint64_t kBufferAlignment = 64;
+
+/// A buffer placed in the arena.
+struct PlannedBuffer {
+  memref::AllocOp alloc;
+  memref::DeallocOp dealloc;
+  uint64_t size;
+  /// Live range of the buffer, from its allocation to its deallocation, in
+  /// the pre-order numbering of the operations of the function.
+  uint64_t start;
+  uint64_t end;
+  uint64_t offset;
+};
+
+/// Returns the number of bytes of a buffer of type `type`, or std::nullopt if
+/// it isn't known statically.
+std::optional<uint64_t> getStaticBufferSize(MemRefType type) {
+  if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+      type.getMemorySpace() != nullptr)
+    return std::nullopt;
+  uint64_t elementSize;
+  if (type.getElementType().isa<IndexType>())
+    elementSize = 8;
+  else if (auto intType = type.getElementType().dyn_cast<IntegerType>())
+    elementSize = llvm::divideCeil(intType.getWidth(), 8);
+  else
+    return std::nullopt;
+  return elementSize * type.getNumElements();
+}
+
+/// Returns true if `buffer`, or a view of it, is returned by a function or
+/// yielded by a region, and so lives beyond its deallocation in the block of
+/// its allocation.
+bool escapes(Value buffer) {
+  for (Operation *user : buffer.getUsers()) {
+    if (user->hasTrait<OpTrait::ReturnLike>())
+      return true;
+    if (auto view = dyn_cast<ViewLikeOpInterface>(user))
+      if (view.getViewSource() == buffer && escapes(view->getResult(0)))
+        return true;
+  }
+  return false;
+}
+
+/// Returns the deallocation of the buffer allocated by `alloc` if the buffer
+/// can be placed in the arena: its size is static, it is deallocated once in
+/// the block of its allocation, and it is only allocated in sequential code,
+/// such that two live ranges which don't overlap in the numbering of the
+/// operations never overlap during the execution.
+memref::DeallocOp getPlannableDealloc(memref::AllocOp alloc,
+                                      func::FuncOp func) {
+  if (!getStaticBufferSize(alloc.getType()).has_value() ||
+      escapes(alloc.getResult()))
+    return nullptr;
+  for (Operation *parent = alloc->getParentOp(); parent != func;
+       parent = parent->getParentOp())
+    if (!isa<scf::ForOp, scf::IfOp>(parent))
+      return nullptr;
+
+  memref::DeallocOp dealloc;
+  for (Operation *user : alloc->getUsers()) {
+    if (auto userDealloc = dyn_cast<memref::DeallocOp>(user)) {
+      if (dealloc || userDealloc->getBlock() != alloc->getBlock())
+        return nullptr;
+      dealloc = userDealloc;
+    }
+  }
+  return dealloc;
+}
+
+/// Returns the result and the operand of `op` which can share a buffer, if
+/// `op` is an element-wise operation on a ciphertext, implemented by a plain
+/// loop which reads each element of its operand before writing the same
+/// element of its result. The batched operations are implemented in
+/// concrete-cpu, which doesn't allow aliasing.
+std::optional<std::pair<Value, Value>> getInPlaceOperands(Operation *op) {
+  if (auto addOp = dyn_cast<Concrete::AddLweBufferOp>(op))
+    return std::make_pair(addOp.getResult(), addOp.getLhs());
+  if (auto addOp = dyn_cast<Concrete::AddPlaintextLweBufferOp>(op))
+    return std::make_pair(addOp.getResult(), addOp.getLhs());
+  if (auto mulOp = dyn_cast<Concrete::MulCleartextLweBufferOp>(op))
+    return std::make_pair(mulOp.getResult(), mulOp.getLhs());
+  if (auto negOp = dyn_cast<Concrete::NegateLweBufferOp>(op))
+    return std::make_pair(negOp.getResult(), negOp.getCiphertext());
+  return std::nullopt;
+}
+
+/// Makes `op` update its operand in place, when the buffer of the operand is
+/// deallocated right after `op`, and the buffer of the result is not used
+/// before `op`. The buffer of the operand then takes the place of the buffer
+/// of the result.
+void updateInPlace(Operation *op, func::FuncOp func) {
+  auto inPlaceOperands = getInPlaceOperands(op);
+  if (!inPlaceOperands.has_value())
+    return;
+  auto [result, operand] = *inPlaceOperands;
+  auto resultAlloc = result.getDefiningOp<memref::AllocOp>();
+  auto operandAlloc = operand.getDefiningOp<memref::AllocOp>();
+  if (resultAlloc == nullptr || operandAlloc == nullptr ||
+      resultAlloc == operandAlloc ||
+      resultAlloc.getType() != operandAlloc.getType() ||
+      resultAlloc->getBlock() != op->getBlock())
+    return;
+
+  auto resultDealloc = getPlannableDealloc(resultAlloc, func);
+  auto operandDealloc = getPlannableDealloc(operandAlloc, func);
+  if (resultDealloc == nullptr || operandDealloc == nullptr ||
+      operandDealloc->getPrevNode() != op)
+    return;
+  Block *block = op->getBlock();
+  for (Operation *user : resultAlloc->getUsers()) {
+    Operation *ancestor = block->findAncestorOpInBlock(*user);
+    if (ancestor != op && ancestor->isBeforeInBlock(op))
+      return;
+  }
+
+  resultAlloc.getResult().replaceAllUsesWith(operandAlloc.getResult());
+  resultAlloc->erase();
+  operandDealloc->erase();
+}
+
+/// Places the buffers in the arena, such that buffers with overlapping live
+/// ranges don't overlap in memory, and returns the size of the arena. The
+/// buffers are placed from the largest to the smallest, each at the lowest
+/// offset not used by the buffers placed before during its live range.
+uint64_t placeBuffers(SmallVectorImpl<PlannedBuffer> &buffers) {
+  SmallVector<PlannedBuffer *> order;
+  for (auto &buffer : buffers)
+    order.push_back(&buffer);
+  std::stable_sort(order.begin(), order.end(),
+                   [](PlannedBuffer *a, PlannedBuffer *b) {
+                     return a->size > b->size;
+                   });
+
+  uint64_t arenaSize = 0;
+  SmallVector<PlannedBuffer *> placed;
+  for (PlannedBuffer *buffer : order) {
+    SmallVector<PlannedBuffer *> overlapping;
+    for (PlannedBuffer *other : placed)
+      if (other->start <= buffer->end && buffer->start <= other->end)
+        overlapping.push_back(other);
+    llvm::sort(overlapping, [](PlannedBuffer *a, PlannedBuffer *b) {
+      return a->offset < b->offset;
+    });
+
+    uint64_t offset = 0;
+    for (PlannedBuffer *other : overlapping) {
+      if (offset + buffer->size <= other->offset)
+        break;
+      offset = std::max(
+          offset, llvm::alignTo(other->offset + other->size, kBufferAlignment));
+    }
+    buffer->offset = offset;
+    arenaSize = std::max(arenaSize, offset + buffer->size);
+    placed.push_back(buffer);
+  }
+  return arenaSize;
+}
+
+/// Replaces the buffers of `func` allocated and deallocated around their uses
+/// by views of an arena, allocated once per invocation of `func`, and returns
+/// the size of the arena.
+uint64_t planFunctionMemory(func::FuncOp func) {
+  // Buffers of functions creating dataflow tasks are managed by the runtime
+  if (func.isExternal() || !func.getBody().hasOneBlock() ||
+      func.walk([](Operation *op) {
+            return isa_and_nonnull<RT::RTDialect>(op->getDialect())
+                       ? WalkResult::interrupt()
+                       : WalkResult::advance();
+          }).wasInterrupted())
+    return 0;
+
+  SmallVector<Operation *> inPlaceCandidates;
+  func.walk([&](Operation *op) {
+    if (getInPlaceOperands(op).has_value())
+      inPlaceCandidates.push_back(op);
+  });
+  for (Operation *op : inPlaceCandidates)
+    updateInPlace(op, func);
+
+  llvm::DenseMap<Operation *, uint64_t> numbering;
+  uint64_t index = 0;
+  func.walk<WalkOrder::PreOrder>(
+      [&](Operation *op) { numbering[op] = index++; });
+
+  SmallVector<PlannedBuffer> buffers;
+  func.walk([&](memref::AllocOp alloc) {
+    if (auto dealloc = getPlannableDealloc(alloc, func)) {
+      buffers.push_back({alloc, dealloc,
+                         *getStaticBufferSize(alloc.getType()),
+                         numbering[alloc], numbering[dealloc], 0});
+    }
+  });
+  if (buffers.empty())
+    return 0;
+
+  uint64_t arenaSize = placeBuffers(buffers);
+
+  Block &entryBlock = func.getBody().front();
+  OpBuilder builder = OpBuilder::atBlockBegin(&entryBlock);
+  auto arenaType = MemRefType::get({(int64_t)arenaSize}, builder.getI8Type());
+  Value arena = builder.create<memref::AllocOp>(
+      func.getLoc(), arenaType, builder.getI64IntegerAttr(kBufferAlignment));
+  for (auto &buffer : buffers) {
+    builder.setInsertionPoint(buffer.alloc);
+    Value offset = builder.create<arith::ConstantIndexOp>(buffer.alloc.getLoc(),
+                                                          buffer.offset);
+    Value view = builder.create<memref::ViewOp>(
+        buffer.alloc.getLoc(), buffer.alloc.getType(), arena, offset,
+        ValueRange{});
+    buffer.alloc.getResult().replaceAllUsesWith(view);
+    buffer.alloc->erase();
+    buffer.dealloc->erase();
+  }
+  builder.setInsertionPoint(entryBlock.getTerminator());
+  builder.create<memref::DeallocOp>(func.getLoc(), arena);
+  return arenaSize;
+}
+
+struct MemoryPlanningPass : public MemoryPlanningBase<MemoryPlanningPass> {
+  MemoryPlanningPass(ProgramCompilationFeedback *feedback)
+      : feedback(feedback) {}
+
+  void runOnOperation() override {
+    getOperation().walk([&](func::FuncOp func) {
+      uint64_t arenaSize = planFunctionMemory(func);
+      if (feedback == nullptr)
+        return;
+      for (auto &circuitFeedback : feedback->circuitFeedbacks)
+        if (circuitFeedback.name == func.getName())
+          circuitFeedback.plannedMemoryPeak = arenaSize;
+    });
+  }
+
+  ProgramCompilationFeedback *feedback;
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createMemoryPlanningPass(ProgramCompilationFeedback *feedback) {
+  return std::make_unique<MemoryPlanningPass>(feedback);
+}
+
+} // namespace concretelang
+} // namespace mlir
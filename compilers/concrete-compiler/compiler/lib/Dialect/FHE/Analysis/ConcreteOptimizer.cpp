@@ -6,6 +6,8 @@
 #include <chrono>
 #include <cmath>
 #include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -132,7 +134,11 @@ struct FunctionToDag {
     auto encrypted_inputs = encryptedInputs(op);
     if (isReturn(op)) {
       for (auto op : encrypted_inputs) {
-        dag->tag_operator_as_output(op);
+        if (config.shrink_outputs) {
+          dag->tag_operator_as_shrunk_output(op);
+        } else {
+          dag->tag_operator_as_output(op);
+        }
       }
       return;
     }
@@ -954,6 +960,8 @@ struct FunctionToDag {
 struct DagPass : ConcreteOptimizerBase<DagPass> {
   optimizer::Config config;
   optimizer::FunctionsDag &dags;
+  // Shared by the clones of the pass running on functions in parallel
+  std::shared_ptr<std::mutex> dagsGuard;
 
   void runOnOperation() override {
     mlir::func::FuncOp func = getOperation();
@@ -961,6 +969,7 @@ struct DagPass : ConcreteOptimizerBase<DagPass> {
     DEBUG("ConcreteOptimizer Dag: " << name);
     auto dag = FunctionToDag(func, config).build();
     if (dag) {
+      std::lock_guard<std::mutex> guard(*dagsGuard);
       dags.insert(
           optimizer::FunctionsDag::value_type(name, std::move(dag.value())));
     } else {
@@ -970,7 +979,8 @@ struct DagPass : ConcreteOptimizerBase<DagPass> {
 
   DagPass() = delete;
   DagPass(optimizer::Config config, optimizer::FunctionsDag &dags)
-      : config(config), dags(dags) {}
+      : config(config), dags(dags),
+        dagsGuard(std::make_shared<std::mutex>()) {}
 };
 
 // Create an instance of the ConcreteOptimizerPass pass.
@@ -3,6 +3,8 @@
 // https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
 // for license information.
 
+#include <functional>
+
 #include <mlir/Dialect/Affine/IR/AffineOps.h>
 #include <mlir/Dialect/Arith/IR/Arith.h>
 #include <mlir/Dialect/Func/IR/FuncOps.h>
@@ -43,8 +45,49 @@ mlir::Value getTruthTableCarryExtract(mlir::PatternRewriter &rewriter,
   return truthTable.getResult();
 }
 
+/// Construct a table lookup applying `function` on every value of a chunk
+mlir::Value getTruthTable(mlir::PatternRewriter &rewriter, mlir::Location loc,
+                          unsigned int chunkSize,
+                          std::function<uint64_t(uint64_t)> function) {
+  auto tableSize = 1 << chunkSize;
+  std::vector<llvm::APInt> values;
+  values.reserve(tableSize);
+  for (auto i = 0; i < tableSize; i++)
+    values.push_back(llvm::APInt(64, function(i), false));
+  auto truthTableAttr = mlir::DenseElementsAttr::get(
+      mlir::RankedTensorType::get({tableSize}, rewriter.getIntegerType(64)),
+      values);
+  auto truthTable =
+      rewriter.create<mlir::arith::ConstantOp>(loc, truthTableAttr);
+  return truthTable.getResult();
+}
+
 namespace {
 
+/// The carry status of a range of chunks in a parallel-prefix addition: the
+/// range either produces no carry, produces a carry, or propagates its
+/// incoming carry.
+const uint64_t CARRY_KILL = 0;
+const uint64_t CARRY_GENERATE = 1;
+const uint64_t CARRY_PROPAGATE = 2;
+const uint64_t CARRY_STATES = 3;
+
+/// Returns true if propagating the carries of an addition on
+/// `numberOfChunks` chunks with a parallel prefix is expected to be faster
+/// than with a ripple carry, when `parallelism` table lookups run
+/// concurrently. The ripple carry applies one table lookup per chunk, all in
+/// sequence, while the parallel prefix applies more of them, but in a
+/// logarithmic number of levels of independent lookups.
+bool preferParallelPrefix(int64_t numberOfChunks, unsigned int parallelism) {
+  auto levelLatency = [&](int64_t lookups) {
+    return (lookups + parallelism - 1) / parallelism;
+  };
+  int64_t prefixLatency = levelLatency(numberOfChunks);
+  for (int64_t distance = 1; distance < numberOfChunks; distance *= 2)
+    prefixLatency += levelLatency(numberOfChunks - distance);
+  return prefixLatency < numberOfChunks;
+}
+
 namespace typing {
 
 /// Converts `FHE::ChunkedEncryptedInteger` into a tensor of
@@ -86,10 +129,12 @@ class AddEintPattern
     : public mlir::OpConversionPattern<mlir::concretelang::FHE::AddEintOp> {
 public:
   AddEintPattern(mlir::TypeConverter &converter, mlir::MLIRContext *context,
-                 unsigned int chunkSize, unsigned int chunkWidth)
+                 unsigned int chunkSize, unsigned int chunkWidth,
+                 unsigned int parallelism)
       : mlir::OpConversionPattern<mlir::concretelang::FHE::AddEintOp>(
             converter, context, ::mlir::concretelang::DEFAULT_PATTERN_BENEFIT),
-        chunkSize(chunkSize), chunkWidth(chunkWidth) {}
+        chunkSize(chunkSize), chunkWidth(chunkWidth),
+        parallelism(parallelism) {}
 
   mlir::LogicalResult
   matchAndRewrite(FHE::AddEintOp op, FHE::AddEintOp::Adaptor adaptor,
@@ -106,52 +151,66 @@ public:
     assert(eintChunkWidth == chunkSize && "wrong tensor elements width");
     auto numberOfChunks = shape[0];
 
+    // Combining two carry states in a single lookup needs chunks of at least
+    // 4 bits.
+    if (chunkSize >= 4 && preferParallelPrefix(numberOfChunks, parallelism)) {
+      rewriter.replaceOp(op, parallelPrefixAdd(rewriter, op.getLoc(),
+                                               adaptor.getA(), adaptor.getB(),
+                                               numberOfChunks));
+    } else {
+      rewriter.replaceOp(op, rippleCarryAdd(rewriter, op.getLoc(),
+                                            adaptor.getA(), adaptor.getB(),
+                                            numberOfChunks));
+    }
+    return mlir::success();
+  }
+
+private:
+  /// Adds the chunks in sequence, each chunk extracting the carry to add to
+  /// the next one.
+  mlir::Value rippleCarryAdd(mlir::ConversionPatternRewriter &rewriter,
+                             mlir::Location loc, mlir::Value a, mlir::Value b,
+                             int64_t numberOfChunks) const {
+    auto eintType = FHE::EncryptedUnsignedIntegerType::get(
+        rewriter.getContext(), chunkSize);
     mlir::Value carry =
-        rewriter
-            .create<FHE::ZeroEintOp>(op.getLoc(),
-                                     FHE::EncryptedUnsignedIntegerType::get(
-                                         rewriter.getContext(), chunkSize))
-            .getResult();
+        rewriter.create<FHE::ZeroEintOp>(loc, eintType).getResult();
 
     mlir::Value resultTensor =
-        rewriter
-            .create<FHE::ZeroTensorOp>(op.getLoc(), adaptor.getA().getType())
-            .getResult();
+        rewriter.create<FHE::ZeroTensorOp>(loc, a.getType()).getResult();
     // used to shift the carry bit to the left
     mlir::Value twoPowerChunkSizeCst =
         rewriter
-            .create<mlir::arith::ConstantIntOp>(op.getLoc(), 1 << chunkWidth,
+            .create<mlir::arith::ConstantIntOp>(loc, 1 << chunkWidth,
                                                 chunkSize + 1)
             .getResult();
-    // Create the loop
+    // Create the loop, carrying the result tensor and the carry
     int64_t lb = 0, step = 1;
     auto forOp = rewriter.create<mlir::AffineForOp>(
-        op.getLoc(), lb, numberOfChunks, step, resultTensor,
+        loc, lb, numberOfChunks, step, mlir::ValueRange{resultTensor, carry},
         [&](mlir::OpBuilder &builder, mlir::Location loc, mlir::Value iter,
             mlir::ValueRange args) {
           // add inputs with the previous carry (init to 0)
-          mlir::Value leftEint = builder.create<mlir::tensor::ExtractOp>(
-              loc, adaptor.getA(), iter);
-          mlir::Value rightEint = builder.create<mlir::tensor::ExtractOp>(
-              loc, adaptor.getB(), iter);
+          mlir::Value leftEint =
+              builder.create<mlir::tensor::ExtractOp>(loc, a, iter);
+          mlir::Value rightEint =
+              builder.create<mlir::tensor::ExtractOp>(loc, b, iter);
           mlir::Value result =
               builder.create<FHE::AddEintOp>(loc, leftEint, rightEint)
                   .getResult();
           mlir::Value resultWithCarry =
-              builder.create<FHE::AddEintOp>(loc, result, carry).getResult();
+              builder.create<FHE::AddEintOp>(loc, result, args[1]).getResult();
           // compute the new carry: either 1 or 0
-          carry =
-              rewriter.create<mlir::concretelang::FHE::ApplyLookupTableEintOp>(
-                  op.getLoc(),
-                  FHE::EncryptedUnsignedIntegerType::get(rewriter.getContext(),
-                                                         chunkSize),
-                  resultWithCarry,
-                  getTruthTableCarryExtract(rewriter, op.getLoc(), chunkSize,
+          mlir::Value newCarry =
+              builder.create<mlir::concretelang::FHE::ApplyLookupTableEintOp>(
+                  loc, eintType, resultWithCarry,
+                  getTruthTableCarryExtract(rewriter, loc, chunkSize,
                                             chunkWidth));
           // remove the carry bit from the result
           mlir::Value shiftedCarry =
               builder
-                  .create<FHE::MulEintIntOp>(loc, carry, twoPowerChunkSizeCst)
+                  .create<FHE::MulEintIntOp>(loc, newCarry,
+                                             twoPowerChunkSizeCst)
                   .getResult();
           mlir::Value finalResult =
               builder.create<FHE::SubEintOp>(loc, resultWithCarry, shiftedCarry)
@@ -159,22 +218,104 @@ public:
           // insert the result in the result tensor
           mlir::Value tensorResult = builder.create<mlir::tensor::InsertOp>(
               loc, finalResult, args[0], iter);
-          builder.create<mlir::AffineYieldOp>(loc, tensorResult);
+          builder.create<mlir::AffineYieldOp>(
+              loc, mlir::ValueRange{tensorResult, newCarry});
         });
-    rewriter.replaceOp(op, forOp.getResult(0));
-    return mlir::success();
+    return forOp.getResult(0);
+  }
+
+  /// Computes the carries of all chunks with a parallel prefix (Kogge-Stone)
+  /// on their carry states, such that the table lookups of each level of the
+  /// prefix are independent, and the depth is logarithmic in the number of
+  /// chunks.
+  mlir::Value parallelPrefixAdd(mlir::ConversionPatternRewriter &rewriter,
+                                mlir::Location loc, mlir::Value a,
+                                mlir::Value b, int64_t numberOfChunks) const {
+    auto eintType = FHE::EncryptedUnsignedIntegerType::get(
+        rewriter.getContext(), chunkSize);
+    uint64_t chunkModulus = 1 << chunkWidth;
+
+    // add the chunks of the inputs, without carries
+    llvm::SmallVector<mlir::Value> sums;
+    for (int64_t i = 0; i < numberOfChunks; i++) {
+      mlir::Value index = rewriter.create<mlir::arith::ConstantIndexOp>(loc, i);
+      mlir::Value leftEint =
+          rewriter.create<mlir::tensor::ExtractOp>(loc, a, index);
+      mlir::Value rightEint =
+          rewriter.create<mlir::tensor::ExtractOp>(loc, b, index);
+      sums.push_back(
+          rewriter.create<FHE::AddEintOp>(loc, leftEint, rightEint));
+    }
+
+    // compute the carry state of every chunk, the first chunk having no
+    // incoming carry, it can't propagate one
+    llvm::SmallVector<mlir::Value> prefixes;
+    for (int64_t i = 0; i < numberOfChunks; i++) {
+      auto table = getTruthTable(rewriter, loc, chunkSize, [&](uint64_t sum) {
+        if (sum >= chunkModulus)
+          return CARRY_GENERATE;
+        if (i != 0 && sum == chunkModulus - 1)
+          return CARRY_PROPAGATE;
+        return CARRY_KILL;
+      });
+      prefixes.push_back(rewriter.create<FHE::ApplyLookupTableEintOp>(
+          loc, eintType, sums[i], table));
+    }
+
+    // combine the states of ranges of chunks, a range propagating a carry
+    // taking the state of the range preceding it
+    mlir::Value carryStatesCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(loc, CARRY_STATES,
+                                                    chunkSize + 1);
+    auto combineTable =
+        getTruthTable(rewriter, loc, chunkSize, [](uint64_t packed) {
+          uint64_t high = packed / CARRY_STATES, low = packed % CARRY_STATES;
+          return (high == CARRY_PROPAGATE) ? low : high;
+        });
+    for (int64_t distance = 1; distance < numberOfChunks; distance *= 2) {
+      llvm::SmallVector<mlir::Value> next(prefixes);
+      for (int64_t i = distance; i < numberOfChunks; i++) {
+        mlir::Value shifted = rewriter.create<FHE::MulEintIntOp>(
+            loc, prefixes[i], carryStatesCst);
+        mlir::Value packed = rewriter.create<FHE::AddEintOp>(
+            loc, shifted, prefixes[i - distance]);
+        next[i] = rewriter.create<FHE::ApplyLookupTableEintOp>(
+            loc, eintType, packed, combineTable);
+      }
+      prefixes = next;
+    }
+
+    // the prefix of a chunk is now its outgoing carry, either 0 or 1, which
+    // is added to the next chunk and removed from the chunk itself
+    mlir::Value twoPowerChunkSizeCst =
+        rewriter.create<mlir::arith::ConstantIntOp>(loc, chunkModulus,
+                                                    chunkSize + 1);
+    llvm::SmallVector<mlir::Value> results;
+    for (int64_t i = 0; i < numberOfChunks; i++) {
+      mlir::Value result = sums[i];
+      if (i != 0)
+        result = rewriter.create<FHE::AddEintOp>(loc, result, prefixes[i - 1]);
+      mlir::Value shiftedCarry = rewriter.create<FHE::MulEintIntOp>(
+          loc, prefixes[i], twoPowerChunkSizeCst);
+      results.push_back(
+          rewriter.create<FHE::SubEintOp>(loc, result, shiftedCarry));
+    }
+    return rewriter.create<mlir::tensor::FromElementsOp>(loc, a.getType(),
+                                                         results);
   }
 
-private:
   unsigned int chunkSize, chunkWidth;
+  unsigned int parallelism;
 };
 
 /// Perfoms the transformation of big integer operations
 class FHEBigIntTransformPass
     : public FHEBigIntTransformBase<FHEBigIntTransformPass> {
 public:
-  FHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth)
-      : chunkSize(chunkSize), chunkWidth(chunkWidth){};
+  FHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth,
+                         unsigned int parallelism)
+      : chunkSize(chunkSize), chunkWidth(chunkWidth),
+        parallelism(parallelism){};
 
   void runOnOperation() override {
     mlir::Operation *op = getOperation();
@@ -188,7 +329,7 @@ public:
                       FHE::ZeroEintOp, FHE::ZeroTensorOp, FHE::AddEintOp,
                       FHE::MulEintIntOp, FHE::SubEintOp,
                       FHE::ApplyLookupTableEintOp, mlir::tensor::ExtractOp,
-                      mlir::tensor::InsertOp>();
+                      mlir::tensor::InsertOp, mlir::tensor::FromElementsOp>();
     concretelang::addDynamicallyLegalTypeOp<FHE::AddEintOp>(target, converter);
     // Func ops are only legal with converted types
     target.addDynamicallyLegalOp<mlir::func::FuncOp>(
@@ -204,7 +345,7 @@ public:
                                                                   converter);
 
     patterns.add<AddEintPattern>(converter, &getContext(), chunkSize,
-                                 chunkWidth);
+                                 chunkWidth, parallelism);
 
     if (mlir::applyPartialConversion(op, target, std::move(patterns))
             .failed()) {
@@ -214,15 +355,19 @@ public:
 
 private:
   unsigned int chunkSize, chunkWidth;
+  unsigned int parallelism;
 };
 
 } // end anonymous namespace
 
 std::unique_ptr<mlir::OperationPass<>>
-createFHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth) {
+createFHEBigIntTransformPass(unsigned int chunkSize, unsigned int chunkWidth,
+                             unsigned int parallelism) {
   assert(chunkSize >= chunkWidth + 1 &&
          "chunkSize must be greater than chunkWidth");
-  return std::make_unique<FHEBigIntTransformPass>(chunkSize, chunkWidth);
+  assert(parallelism >= 1 && "parallelism must be at least 1");
+  return std::make_unique<FHEBigIntTransformPass>(chunkSize, chunkWidth,
+                                                  parallelism);
 }
 
 } // namespace concretelang
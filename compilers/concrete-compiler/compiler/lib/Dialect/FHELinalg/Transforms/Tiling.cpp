@@ -11,6 +11,8 @@
 #include <mlir/IR/PatternMatch.h>
 #include <mlir/Transforms/GreedyPatternRewriteDriver.h>
 
+#include "llvm/ADT/TypeSwitch.h"
+
 #include <concretelang/Dialect/FHE/IR/FHEOps.h>
 #include <concretelang/Dialect/FHE/IR/FHETypes.h>
 #include <concretelang/Dialect/FHELinalg/IR/FHELinalgOps.h>
@@ -23,24 +25,48 @@ namespace concretelang {
 namespace {
 
 /// Creates a `tensor.extract_slice` operation that extracts a
-/// contiguous, 2-dimensional slice with a static size specified by
-/// `sizes` at the dynamic offset `offsets`.
+/// contiguous slice with a static size specified by `sizes` at the
+/// dynamic offset `offsets`.
 mlir::tensor::ExtractSliceOp
-extractContiguous2DSlice(mlir::OpBuilder &builder, mlir::Location loc,
-                         mlir::Value T, llvm::ArrayRef<int64_t> sizes,
-                         llvm::ArrayRef<mlir::OpFoldResult> offsets) {
-  assert(sizes.size() == 2 && offsets.size() == 2 &&
-         "The number of dimensions for the size and offset must be 2");
+extractContiguousSlice(mlir::OpBuilder &builder, mlir::Location loc,
+                       mlir::Value T, llvm::ArrayRef<int64_t> sizes,
+                       llvm::ArrayRef<mlir::OpFoldResult> offsets) {
+  assert(sizes.size() == offsets.size() &&
+         "The number of dimensions for the size and offset must match");
 
   mlir::Type elTy = T.getType().cast<mlir::TensorType>().getElementType();
 
+  llvm::SmallVector<mlir::OpFoldResult> sizeAttrs, strideAttrs;
+  for (int64_t size : sizes) {
+    sizeAttrs.push_back(builder.getI64IntegerAttr(size));
+    strideAttrs.push_back(builder.getI64IntegerAttr(1));
+  }
+
   return builder.create<mlir::tensor::ExtractSliceOp>(
-      loc, mlir::RankedTensorType::get(sizes, elTy), T, offsets,
-      llvm::SmallVector<mlir::OpFoldResult, 2>{
-          builder.getI64IntegerAttr(sizes[0]),
-          builder.getI64IntegerAttr(sizes[1])},
-      llvm::SmallVector<mlir::OpFoldResult, 2>{builder.getI64IntegerAttr(1),
-                                               builder.getI64IntegerAttr(1)});
+      loc, mlir::RankedTensorType::get(sizes, elTy), T, offsets, sizeAttrs,
+      strideAttrs);
+}
+
+/// Creates a `tensor.insert_slice` operation that inserts `tile` as a
+/// contiguous slice of `T` at the dynamic offset `offsets`.
+mlir::tensor::InsertSliceOp
+insertContiguousSlice(mlir::OpBuilder &builder, mlir::Location loc,
+                      mlir::Value tile, mlir::Value T,
+                      llvm::ArrayRef<mlir::OpFoldResult> offsets) {
+  llvm::ArrayRef<int64_t> sizes =
+      tile.getType().cast<mlir::TensorType>().getShape();
+
+  assert(sizes.size() == offsets.size() &&
+         "The number of dimensions for the size and offset must match");
+
+  llvm::SmallVector<mlir::OpFoldResult> sizeAttrs, strideAttrs;
+  for (int64_t size : sizes) {
+    sizeAttrs.push_back(builder.getI64IntegerAttr(size));
+    strideAttrs.push_back(builder.getI64IntegerAttr(1));
+  }
+
+  return builder.create<mlir::tensor::InsertSliceOp>(loc, tile, T, offsets,
+                                                     sizeAttrs, strideAttrs);
 }
 
 /// Creates a perfect loop nest of SCF for loops with the lower bounds
@@ -251,14 +277,14 @@ public:
                                     mlir::ValueRange inductionVars,
                                     mlir::ValueRange iterArgs) {
       // TxU tile from A
-      mlir::tensor::ExtractSliceOp ATile = extractContiguous2DSlice(
+      mlir::tensor::ExtractSliceOp ATile = extractContiguousSlice(
           builder, origLoc, A, {iT, iU}, {inductionVars[0], inductionVars[1]});
       // UxV tile from B
-      mlir::tensor::ExtractSliceOp BTile = extractContiguous2DSlice(
+      mlir::tensor::ExtractSliceOp BTile = extractContiguousSlice(
           builder, origLoc, B, {iU, iV}, {inductionVars[1], inductionVars[2]});
 
       // TxV tile from C
-      mlir::tensor::ExtractSliceOp CTile = extractContiguous2DSlice(
+      mlir::tensor::ExtractSliceOp CTile = extractContiguousSlice(
           builder, origLoc, *iterArgs.begin(), {iT, iV},
           {inductionVars[0], inductionVars[2]});
 
@@ -312,22 +338,372 @@ public:
   }
 };
 
-/// Perfoms the actual tiling of `FHELinalg.matmul_eint_int`
-/// operations that have been marked with a "tile-sizes" attribute.
+/// Returns the tile sizes of `op` from its "tile-sizes" attribute, which
+/// must hold `expected` sizes dividing the dimensions `shape`.
+mlir::FailureOr<llvm::SmallVector<int64_t>>
+getTileSizes(mlir::Operation *op, llvm::ArrayRef<int64_t> shape) {
+  mlir::ArrayAttr tileSizes = op->getAttrOfType<mlir::ArrayAttr>("tile-sizes");
+
+  if (!tileSizes) {
+    op->emitError("Wrong type for attribute \"tile-size\"");
+    return mlir::failure();
+  }
+
+  if (tileSizes.size() != shape.size()) {
+    op->emitError("Need ") << shape.size() << " tile sizes, but got "
+                           << tileSizes.size();
+    return mlir::failure();
+  }
+
+  llvm::SmallVector<int64_t> sizes;
+  for (auto [attr, dimSize] : llvm::zip(tileSizes, shape)) {
+    mlir::IntegerAttr size = attr.dyn_cast_or_null<mlir::IntegerAttr>();
+
+    if (!size) {
+      op->emitError("Wrong type for tile sizes");
+      return mlir::failure();
+    }
+
+    if (size.getInt() <= 0 || dimSize % size.getInt() != 0) {
+      op->emitError() << "Dimensions of the tensors must be a multiple of "
+                         "the tile size. Partial tiles are currently not "
+                         "supported.";
+      return mlir::failure();
+    }
+
+    sizes.push_back(size.getInt());
+  }
+
+  return sizes;
+}
+
+/// Returns the attributes of `op` to be set on the operations
+/// processing its tiles, i.e., all attributes but the tile sizes
+/// and with the marker preventing recursive tiling.
+llvm::SmallVector<mlir::NamedAttribute>
+getTileOpAttributes(mlir::PatternRewriter &rewriter, mlir::Operation *op) {
+  llvm::SmallVector<mlir::NamedAttribute> attrs;
+
+  for (mlir::NamedAttribute attr : op->getAttrs()) {
+    if (attr.getName() != "tile-sizes")
+      attrs.push_back(attr);
+  }
+
+  attrs.push_back(
+      rewriter.getNamedAttr(kTransformMarker, rewriter.getUnitAttr()));
+
+  return attrs;
+}
+
+/// Drops the tile sizes of `op`, for operations made of a single tile
+/// which are left as is.
+mlir::LogicalResult removeTileSizes(mlir::PatternRewriter &rewriter,
+                                    mlir::Operation *op) {
+  rewriter.updateRootInPlace(op, [&]() { op->removeAttr("tile-sizes"); });
+  return mlir::success();
+}
+
+/// Rewrite an `FHELinalg.apply_lookup_table` operation as a perfect
+/// loop nest of SCF for loops with a `FHELinalg.apply_lookup_table`
+/// operation applying the lookup table on a single tile.
+///
+/// The tile sizes hold one size per dimension of the input tensor,
+/// and a loop is only generated for the dimensions that are actually
+/// tiled. The lookups of a tile are batched together, such that a tile
+/// corresponds to a single batched bootstrap when batching is enabled.
+class ApplyLookupTableTilingPattern
+    : public mlir::OpRewritePattern<
+          mlir::concretelang::FHELinalg::ApplyLookupTableEintOp> {
+public:
+  ApplyLookupTableTilingPattern(mlir::MLIRContext *context)
+      : mlir::OpRewritePattern<
+            mlir::concretelang::FHELinalg::ApplyLookupTableEintOp>(
+            context, ::mlir::concretelang::DEFAULT_PATTERN_BENEFIT) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::concretelang::FHELinalg::ApplyLookupTableEintOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (op->hasAttr(kTransformMarker) || !op->hasAttr("tile-sizes"))
+      return mlir::failure();
+
+    mlir::Location origLoc = op->getLoc();
+    mlir::RankedTensorType inTy =
+        op.getT().getType().cast<mlir::RankedTensorType>();
+    mlir::RankedTensorType outTy =
+        op.getResult().getType().cast<mlir::RankedTensorType>();
+
+    mlir::FailureOr<llvm::SmallVector<int64_t>> tileSizes =
+        getTileSizes(op, inTy.getShape());
+
+    if (mlir::failed(tileSizes))
+      return mlir::failure();
+
+    // Only dimensions with more than one tile are iterated
+    llvm::SmallVector<size_t> tiledDims;
+    for (size_t dim = 0; dim < tileSizes->size(); dim++) {
+      if ((*tileSizes)[dim] != inTy.getDimSize(dim))
+        tiledDims.push_back(dim);
+    }
+
+    if (tiledDims.empty())
+      return removeTileSizes(rewriter, op);
+
+    mlir::OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(op);
+
+    mlir::Value init =
+        rewriter.create<mlir::concretelang::FHE::ZeroTensorOp>(origLoc, outTy);
+
+    mlir::Value lb = rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, 0);
+    llvm::SmallVector<mlir::Value> lbs, ubs, steps;
+
+    for (size_t dim : tiledDims) {
+      lbs.push_back(lb);
+      ubs.push_back(rewriter.create<mlir::arith::ConstantIndexOp>(
+          origLoc, inTy.getDimSize(dim)));
+      steps.push_back(rewriter.create<mlir::arith::ConstantIndexOp>(
+          origLoc, (*tileSizes)[dim]));
+    }
+
+    llvm::SmallVector<mlir::NamedAttribute> attrs =
+        getTileOpAttributes(rewriter, op);
+
+    auto innermostBodyBuilder = [&](mlir::OpBuilder &builder,
+                                    mlir::Location location,
+                                    mlir::ValueRange inductionVars,
+                                    mlir::ValueRange iterArgs) {
+      llvm::SmallVector<mlir::OpFoldResult> offsets(
+          tileSizes->size(), builder.getI64IntegerAttr(0));
+
+      for (auto [dim, inductionVar] : llvm::zip(tiledDims, inductionVars))
+        offsets[dim] = inductionVar;
+
+      mlir::tensor::ExtractSliceOp inTile =
+          extractContiguousSlice(builder, origLoc, op.getT(), *tileSizes,
+                                 offsets);
+
+      mlir::Value outTile =
+          builder.create<mlir::concretelang::FHELinalg::ApplyLookupTableEintOp>(
+              origLoc,
+              mlir::RankedTensorType::get(*tileSizes, outTy.getElementType()),
+              mlir::ValueRange{inTile, op.getLut()}, attrs);
+
+      mlir::tensor::InsertSliceOp updated = insertContiguousSlice(
+          builder, origLoc, outTile, *iterArgs.begin(), offsets);
+
+      builder.create<mlir::scf::YieldOp>(origLoc, updated.getResult());
+    };
+
+    mlir::scf::ForOp outermost = buildLoopNestWithLoopCarriedDependency(
+        rewriter, origLoc, lbs, ubs, steps, init, innermostBodyBuilder);
+
+    rewriter.replaceOp(op, outermost.getResult(0));
+
+    return mlir::success();
+  }
+};
+
+/// Rewrite an `FHELinalg.dot_eint_int` operation as an SCF for loop
+/// accumulating the dot products of tiles of the operands.
+///
+/// The tile sizes hold a single size for the tiles of both operands.
+class DotTilingPattern
+    : public mlir::OpRewritePattern<mlir::concretelang::FHELinalg::Dot> {
+public:
+  DotTilingPattern(mlir::MLIRContext *context)
+      : mlir::OpRewritePattern<mlir::concretelang::FHELinalg::Dot>(
+            context, ::mlir::concretelang::DEFAULT_PATTERN_BENEFIT) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::concretelang::FHELinalg::Dot op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (op->hasAttr(kTransformMarker) || !op->hasAttr("tile-sizes"))
+      return mlir::failure();
+
+    mlir::Location origLoc = op->getLoc();
+    mlir::RankedTensorType lhsTy =
+        op.getLhs().getType().cast<mlir::RankedTensorType>();
+
+    mlir::FailureOr<llvm::SmallVector<int64_t>> tileSizes =
+        getTileSizes(op, lhsTy.getShape());
+
+    if (mlir::failed(tileSizes))
+      return mlir::failure();
+
+    int64_t iU = (*tileSizes)[0];
+
+    if (iU == lhsTy.getDimSize(0))
+      return removeTileSizes(rewriter, op);
+
+    mlir::OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(op);
+
+    mlir::Value init = rewriter.create<mlir::concretelang::FHE::ZeroEintOp>(
+        origLoc, op.getResult().getType());
+
+    mlir::Value lb = rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, 0);
+    mlir::Value ub = rewriter.create<mlir::arith::ConstantIndexOp>(
+        origLoc, lhsTy.getDimSize(0));
+    mlir::Value step =
+        rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, iU);
+
+    llvm::SmallVector<mlir::NamedAttribute> attrs =
+        getTileOpAttributes(rewriter, op);
+
+    auto innermostBodyBuilder = [&](mlir::OpBuilder &builder,
+                                    mlir::Location location,
+                                    mlir::ValueRange inductionVars,
+                                    mlir::ValueRange iterArgs) {
+      mlir::tensor::ExtractSliceOp lhsTile = extractContiguousSlice(
+          builder, origLoc, op.getLhs(), {iU}, {inductionVars[0]});
+      mlir::tensor::ExtractSliceOp rhsTile = extractContiguousSlice(
+          builder, origLoc, op.getRhs(), {iU}, {inductionVars[0]});
+
+      mlir::Value tiledDot =
+          builder.create<mlir::concretelang::FHELinalg::Dot>(
+              origLoc, op.getResult().getType(),
+              mlir::ValueRange{lhsTile, rhsTile}, attrs);
+
+      mlir::Value accu = builder.create<mlir::concretelang::FHE::AddEintOp>(
+          origLoc, *iterArgs.begin(), tiledDot);
+
+      builder.create<mlir::scf::YieldOp>(origLoc, accu);
+    };
+
+    mlir::scf::ForOp loop = buildLoopNestWithLoopCarriedDependency(
+        rewriter, origLoc, lb, ub, step, init, innermostBodyBuilder);
+
+    rewriter.replaceOp(op, loop.getResult(0));
+
+    return mlir::success();
+  }
+};
+
+/// Rewrite an `FHELinalg.conv2d` operation as an SCF for loop over
+/// tiles of output channels, with a `FHELinalg.conv2d` operation
+/// computing the output channels of a single tile from the entire
+/// input.
+///
+/// The tile sizes hold a single size for the tiles of the output
+/// channels. Only convolutions with a single group are tiled.
+class Conv2dTilingPattern
+    : public mlir::OpRewritePattern<mlir::concretelang::FHELinalg::Conv2dOp> {
+public:
+  Conv2dTilingPattern(mlir::MLIRContext *context)
+      : mlir::OpRewritePattern<mlir::concretelang::FHELinalg::Conv2dOp>(
+            context, ::mlir::concretelang::DEFAULT_PATTERN_BENEFIT) {}
+
+  mlir::LogicalResult
+  matchAndRewrite(mlir::concretelang::FHELinalg::Conv2dOp op,
+                  mlir::PatternRewriter &rewriter) const override {
+    if (op->hasAttr(kTransformMarker) || !op->hasAttr("tile-sizes"))
+      return mlir::failure();
+
+    if (op.getGroup().value_or(1) != 1) {
+      op.emitError() << "Can only tile convolutions with a single group";
+      return mlir::failure();
+    }
+
+    mlir::Location origLoc = op->getLoc();
+    mlir::RankedTensorType weightTy =
+        op.getWeight().getType().cast<mlir::RankedTensorType>();
+    mlir::RankedTensorType outTy =
+        op.getResult().getType().cast<mlir::RankedTensorType>();
+    int64_t numChannels = weightTy.getDimSize(0);
+
+    mlir::FailureOr<llvm::SmallVector<int64_t>> tileSizes =
+        getTileSizes(op, {numChannels});
+
+    if (mlir::failed(tileSizes))
+      return mlir::failure();
+
+    int64_t iF = (*tileSizes)[0];
+
+    if (iF == numChannels)
+      return removeTileSizes(rewriter, op);
+
+    mlir::OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(op);
+
+    mlir::Value init =
+        rewriter.create<mlir::concretelang::FHE::ZeroTensorOp>(origLoc, outTy);
+
+    mlir::Value lb = rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, 0);
+    mlir::Value ub =
+        rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, numChannels);
+    mlir::Value step =
+        rewriter.create<mlir::arith::ConstantIndexOp>(origLoc, iF);
+
+    llvm::SmallVector<mlir::NamedAttribute> attrs =
+        getTileOpAttributes(rewriter, op);
+
+    auto innermostBodyBuilder = [&](mlir::OpBuilder &builder,
+                                    mlir::Location location,
+                                    mlir::ValueRange inductionVars,
+                                    mlir::ValueRange iterArgs) {
+      mlir::OpFoldResult zero = builder.getI64IntegerAttr(0);
+
+      // FxCxHxW tile of the weights
+      llvm::SmallVector<int64_t> weightTileSizes(weightTy.getShape());
+      weightTileSizes[0] = iF;
+      mlir::tensor::ExtractSliceOp weightTile = extractContiguousSlice(
+          builder, origLoc, op.getWeight(), weightTileSizes,
+          {inductionVars[0], zero, zero, zero});
+
+      llvm::SmallVector<mlir::Value> operands{op.getInput(), weightTile};
+
+      // F tile of the bias
+      if (op.getBias()) {
+        operands.push_back(extractContiguousSlice(
+            builder, origLoc, op.getBias(), {iF}, {inductionVars[0]}));
+      }
+
+      // NxFxHxW tile of the output
+      llvm::SmallVector<int64_t> outTileSizes(outTy.getShape());
+      outTileSizes[1] = iF;
+
+      mlir::Value outTile =
+          builder.create<mlir::concretelang::FHELinalg::Conv2dOp>(
+              origLoc,
+              mlir::RankedTensorType::get(outTileSizes,
+                                          outTy.getElementType()),
+              operands, attrs);
+
+      mlir::tensor::InsertSliceOp updated =
+          insertContiguousSlice(builder, origLoc, outTile, *iterArgs.begin(),
+                                {zero, inductionVars[0], zero, zero});
+
+      builder.create<mlir::scf::YieldOp>(origLoc, updated.getResult());
+    };
+
+    mlir::scf::ForOp loop = buildLoopNestWithLoopCarriedDependency(
+        rewriter, origLoc, lb, ub, step, init, innermostBodyBuilder);
+
+    rewriter.replaceOp(op, loop.getResult(0));
+
+    return mlir::success();
+  }
+};
+
+/// Perfoms the actual tiling of `FHELinalg.matmul_eint_int`,
+/// `FHELinalg.apply_lookup_table`, `FHELinalg.dot_eint_int` and
+/// `FHELinalg.conv2d` operations that have been marked with a
+/// "tile-sizes" attribute.
 class FHELinalgTilingPass : public FHELinalgTilingBase<FHELinalgTilingPass> {
 public:
   void runOnOperation() override {
     mlir::Operation *op = getOperation();
 
     mlir::RewritePatternSet patterns(op->getContext());
-    patterns.add<MatMulTilingPattern>(op->getContext());
+    patterns.add<MatMulTilingPattern, ApplyLookupTableTilingPattern,
+                 DotTilingPattern, Conv2dTilingPattern>(op->getContext());
 
     if (mlir::applyPatternsAndFoldGreedily(op, std::move(patterns)).failed()) {
       this->signalPassFailure();
     }
 
-    op->walk([](mlir::concretelang::FHELinalg::MatMulEintIntOp matmulOp) {
-      matmulOp.getOperation()->removeAttr(kTransformMarker);
+    op->walk([](mlir::Operation *tiledOp) {
+      tiledOp->removeAttr(kTransformMarker);
     });
   }
 };
@@ -354,6 +730,196 @@ public:
 protected:
   std::vector<int64_t> tileSizes;
 };
+
+/// Returns the divisors of `size` in decreasing order, i.e., the
+/// sizes of the tiles without partial tiles.
+llvm::SmallVector<int64_t> getDivisors(int64_t size) {
+  llvm::SmallVector<int64_t> divisors;
+  for (int64_t divisor = size; divisor >= 1; divisor--) {
+    if (size % divisor == 0)
+      divisors.push_back(divisor);
+  }
+  return divisors;
+}
+
+/// Returns the largest divisor of `size` for which `isValid` holds,
+/// if any.
+std::optional<int64_t>
+getLargestValidTileSize(int64_t size,
+                        llvm::function_ref<bool(int64_t)> isValid) {
+  for (int64_t tileSize : getDivisors(size)) {
+    if (isValid(tileSize))
+      return tileSize;
+  }
+  return std::nullopt;
+}
+
+/// Marks the `FHELinalg.matmul_eint_int`, `FHELinalg.apply_lookup_table`,
+/// `FHELinalg.dot_eint_int` and `FHELinalg.conv2d` operations that
+/// are not marked yet with a "tile-sizes" attribute containing tile
+/// sizes chosen such that:
+///
+///   - the ciphertexts a tile works on, of `ciphertextSize` bytes
+///     each, fit in `cacheBudget` bytes, and
+///   - there are at least as many independent tiles as `numWorkers`,
+///     such that every worker gets a tile to process.
+///
+/// The largest tiles satisfying both conditions are chosen, such that
+/// as many operations as possible are batched in a tile, and the
+/// smallest ones if no tile satisfies them. Operations that fit in a
+/// single tile are not marked.
+class FHELinalgAutoTilingMarkerPass
+    : public FHELinalgAutoTilingMarkerBase<FHELinalgAutoTilingMarkerPass> {
+public:
+  FHELinalgAutoTilingMarkerPass(uint64_t ciphertextSize, uint64_t cacheBudget,
+                                uint64_t numWorkers)
+      : ciphertextSize(ciphertextSize), cacheBudget(cacheBudget),
+        numWorkers(numWorkers) {}
+
+  void runOnOperation() override {
+    mlir::Operation *op = getOperation();
+    mlir::Builder builder(&this->getContext());
+
+    op->walk([&](mlir::Operation *tiledOp) {
+      if (tiledOp->hasAttr("tile-sizes"))
+        return;
+
+      std::optional<llvm::SmallVector<int64_t>> tileSizes =
+          llvm::TypeSwitch<mlir::Operation *,
+                           std::optional<llvm::SmallVector<int64_t>>>(tiledOp)
+              .Case<mlir::concretelang::FHELinalg::MatMulEintIntOp>(
+                  [&](auto matmulOp) { return getMatMulTileSizes(matmulOp); })
+              .Case<mlir::concretelang::FHELinalg::ApplyLookupTableEintOp>(
+                  [&](auto lutOp) { return getLookupTableTileSizes(lutOp); })
+              .Case<mlir::concretelang::FHELinalg::Dot>(
+                  [&](auto dotOp) { return getDotTileSizes(dotOp); })
+              .Case<mlir::concretelang::FHELinalg::Conv2dOp>(
+                  [&](auto convOp) { return getConv2dTileSizes(convOp); })
+              .Default([](auto) { return std::nullopt; });
+
+      if (tileSizes.has_value())
+        tiledOp->setAttr("tile-sizes", builder.getI64ArrayAttr(*tileSizes));
+    });
+  }
+
+protected:
+  /// Returns true if `numCiphertexts` ciphertexts fit in the budget
+  bool fits(int64_t numCiphertexts) const {
+    return (uint64_t)numCiphertexts * ciphertextSize <= cacheBudget;
+  }
+
+  /// Returns true if `numTiles` independent tiles, out of at most
+  /// `maxTiles`, keep all workers busy
+  bool isParallel(int64_t numTiles, int64_t maxTiles) const {
+    return numTiles >= std::min<int64_t>(numWorkers, maxTiles);
+  }
+
+  /// A tile of a matrix multiplication of a `NxM` encrypted matrix by
+  /// a `MxK` matrix works on a `TxU` tile of the encrypted matrix and
+  /// on two `TxV` tiles of the result, the partial product and the
+  /// accumulator. Tiles along `M` are accumulated and are thus not
+  /// independent.
+  std::optional<llvm::SmallVector<int64_t>>
+  getMatMulTileSizes(mlir::concretelang::FHELinalg::MatMulEintIntOp op) const {
+    auto lhsTy = op.getLhs().getType().cast<mlir::RankedTensorType>();
+    auto rhsTy = op.getRhs().getType().cast<mlir::RankedTensorType>();
+    int64_t N = lhsTy.getDimSize(0);
+    int64_t M = lhsTy.getDimSize(1);
+    int64_t K = rhsTy.getDimSize(1);
+
+    llvm::SmallVector<int64_t> best{1, 1, 1};
+    int64_t bestVolume = 0;
+    for (int64_t T : getDivisors(N)) {
+      for (int64_t U : getDivisors(M)) {
+        for (int64_t V : getDivisors(K)) {
+          if (T * U * V <= bestVolume || !fits(T * U + 2 * T * V) ||
+              !isParallel((N / T) * (K / V), N * K))
+            continue;
+          best = {T, U, V};
+          bestVolume = T * U * V;
+        }
+      }
+    }
+
+    if (best[0] == N && best[1] == M && best[2] == K)
+      return std::nullopt;
+    return best;
+  }
+
+  /// A tile of a lookup table works on a tile of the input and on a
+  /// tile of the output. The leading dimensions are tiled first, such
+  /// that tiles are made of contiguous elements.
+  std::optional<llvm::SmallVector<int64_t>> getLookupTableTileSizes(
+      mlir::concretelang::FHELinalg::ApplyLookupTableEintOp op) const {
+    auto inTy = op.getT().getType().cast<mlir::RankedTensorType>();
+    int64_t numElements = inTy.getNumElements();
+    llvm::SmallVector<int64_t> tileSizes(inTy.getShape());
+
+    for (size_t dim = 0; dim < tileSizes.size(); dim++) {
+      int64_t otherElements = 1;
+      for (size_t other = dim + 1; other < tileSizes.size(); other++)
+        otherElements *= tileSizes[other];
+
+      std::optional<int64_t> tileSize = getLargestValidTileSize(
+          inTy.getDimSize(dim), [&](int64_t size) {
+            int64_t tileElements = size * otherElements;
+            return fits(2 * tileElements) &&
+                   isParallel(numElements / tileElements, numElements);
+          });
+
+      if (tileSize.has_value()) {
+        tileSizes[dim] = *tileSize;
+        break;
+      }
+      tileSizes[dim] = 1;
+    }
+
+    if (llvm::ArrayRef<int64_t>(tileSizes) == inTy.getShape())
+      return std::nullopt;
+    return tileSizes;
+  }
+
+  /// A tile of a dot product works on a tile of the encrypted vector.
+  /// Tiles are accumulated and are thus not independent.
+  std::optional<llvm::SmallVector<int64_t>>
+  getDotTileSizes(mlir::concretelang::FHELinalg::Dot op) const {
+    int64_t M =
+        op.getLhs().getType().cast<mlir::RankedTensorType>().getDimSize(0);
+
+    int64_t U = getLargestValidTileSize(M, [&](int64_t size) {
+                  return fits(size);
+                }).value_or(1);
+
+    if (U == M)
+      return std::nullopt;
+    return llvm::SmallVector<int64_t>{U};
+  }
+
+  /// A tile of a convolution computes a tile of the output channels
+  /// from the entire input, which is shared by all tiles.
+  std::optional<llvm::SmallVector<int64_t>>
+  getConv2dTileSizes(mlir::concretelang::FHELinalg::Conv2dOp op) const {
+    if (op.getGroup().value_or(1) != 1)
+      return std::nullopt;
+
+    auto outTy = op.getResult().getType().cast<mlir::RankedTensorType>();
+    int64_t F = outTy.getDimSize(1);
+    int64_t channelElements = outTy.getNumElements() / F;
+
+    int64_t tileSize = getLargestValidTileSize(F, [&](int64_t size) {
+                         return fits(size * channelElements) &&
+                                isParallel(F / size, F);
+                       }).value_or(1);
+
+    if (tileSize == F)
+      return std::nullopt;
+    return llvm::SmallVector<int64_t>{tileSize};
+  }
+
+  uint64_t ciphertextSize;
+  uint64_t cacheBudget;
+  uint64_t numWorkers;
+};
 } // end anonymous namespace
 
 std::unique_ptr<mlir::OperationPass<>> createFHELinalgTilingPass() {
@@ -364,5 +930,13 @@ std::unique_ptr<mlir::OperationPass<>>
 createFHELinalgTilingMarkerPass(llvm::ArrayRef<int64_t> tileSizes) {
   return std::make_unique<FHELinalgTilingMarkerPass>(tileSizes);
 }
+
+std::unique_ptr<mlir::OperationPass<>>
+createFHELinalgAutoTilingMarkerPass(uint64_t ciphertextSize,
+                                    uint64_t cacheBudget,
+                                    uint64_t numWorkers) {
+  return std::make_unique<FHELinalgAutoTilingMarkerPass>(
+      ciphertextSize, cacheBudget, numWorkers);
+}
 } // namespace concretelang
 } // namespace mlir
@@ -3,6 +3,7 @@
 // https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
 // for license information.
 
+#include <cmath>
 #include <iostream>
 
 #include "concretelang/Dialect/FHE/Interfaces/FHEInterfaces.h"
@@ -19,6 +20,8 @@
 
 #include <mlir/Dialect/Arith/IR/Arith.h>
 #include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/Linalg/IR/Linalg.h>
+#include <mlir/Dialect/Tensor/IR/Tensor.h>
 #include <mlir/IR/Attributes.h>
 #include <mlir/IR/Builders.h>
 #include <mlir/IR/BuiltinAttributes.h>
@@ -33,6 +36,7 @@
 #include <mlir/Transforms/GreedyPatternRewriteDriver.h>
 #include <mlir/Transforms/Passes.h>
 #include <mlir/Transforms/RegionUtils.h>
+#include <llvm/Support/MathExtras.h>
 
 #define GEN_PASS_CLASSES
 #include <concretelang/Dialect/RT/Analysis/Autopar.h.inc>
@@ -42,7 +46,6 @@ namespace concretelang {
 
 namespace {
 
-// TODO: adjust these two functions based on cost model
 static bool isCandidateForTask(Operation *op) {
   // if it's a linalg.genric operation with encrypted inputs
   if (auto genericOp = mlir::dyn_cast<mlir::linalg::GenericOp>(op)) {
@@ -59,9 +62,47 @@ static bool isCandidateForTask(Operation *op) {
   return isa<FHE::ApplyLookupTableEintOp>(op);
 }
 
+/// Returns the number of bootstraps performed by `op` once lowered to TFHE.
+static int64_t getNumBootstraps(Operation *op) {
+  if (isa<FHE::MulEintOp, FHE::MuxOp>(op))
+    return 2;
+  if (isa<FHE::ApplyLookupTableEintOp, FHE::MaxEintOp, FHE::RoundEintOp,
+          FHE::LsbEintOp, FHE::GenGateOp, FHE::BoolAndOp, FHE::BoolOrOp,
+          FHE::BoolNandOp, FHE::BoolXorOp>(op))
+    return 1;
+  return 0;
+}
+
+/// Estimates the cost of executing `op` with `costModel`, as the optimizer
+/// does: bootstraps and leveled operations are accounted for, everything else
+/// is negligible.
+static double estimateCost(Operation *op,
+                           const DataflowTaskCostModel &costModel) {
+  if (auto genericOp = mlir::dyn_cast<mlir::linalg::GenericOp>(op)) {
+    double bodyCost = 0.;
+    for (Operation &bodyOp : genericOp.getBody()->without_terminator())
+      bodyCost += estimateCost(&bodyOp, costModel);
+    double numIterations = 1.;
+    for (int64_t range : genericOp.getStaticLoopRanges())
+      if (!ShapedType::isDynamic(range))
+        numIterations *= range;
+    return numIterations * bodyCost;
+  }
+  if (int64_t numBootstraps = getNumBootstraps(op))
+    return numBootstraps * costModel.bootstrapCost;
+  if (isa<FHE::FHEDialect>(op->getDialect()))
+    return costModel.leveledCost;
+  return 0.;
+}
+
 /// Identify operations that are beneficial to aggregate into tasks.  These
-/// operations must not have side-effects and not be `isCandidateForTask`
-static bool isAggregatingBeneficiary(Operation *op) {
+/// operations must not have side-effects and not be `isCandidateForTask`,
+/// unless they are too cheap to be a task on their own, in which case
+/// duplicating them in the tasks using their results costs less than a task.
+static bool isAggregatingBeneficiary(Operation *op,
+                                     const DataflowTaskCostModel &costModel) {
+  if (isCandidateForTask(op))
+    return estimateCost(op, costModel) < costModel.minTaskCost;
   return isa<FHE::ZeroEintOp, FHE::ZeroTensorOp, FHE::AddEintIntOp,
              FHE::AddEintOp, FHE::SubIntEintOp, FHE::SubEintIntOp,
              FHE::MulEintIntOp, FHE::SubEintOp, FHE::NegEintOp,
@@ -69,13 +110,122 @@ static bool isAggregatingBeneficiary(Operation *op) {
              mlir::arith::CmpIOp>(op);
 }
 
+/// Returns the loop along which `genericOp` can be split in independent
+/// operations computing slices of its results: the largest parallel loop
+/// with a static range, only used as a plain index of the operands.
+static std::optional<unsigned>
+getSplittableLoop(mlir::linalg::GenericOp genericOp) {
+  if (!genericOp.hasTensorSemantics() ||
+      !genericOp.getBody()->getOps<mlir::linalg::IndexOp>().empty())
+    return std::nullopt;
+
+  SmallVector<int64_t> ranges = genericOp.getStaticLoopRanges();
+  SmallVector<utils::IteratorType> iteratorTypes =
+      genericOp.getIteratorTypesArray();
+  SmallVector<AffineMap> maps = genericOp.getIndexingMapsArray();
+  std::optional<unsigned> splittableLoop;
+  for (unsigned loop = 0; loop < ranges.size(); loop++) {
+    if (iteratorTypes[loop] != utils::IteratorType::parallel ||
+        ShapedType::isDynamic(ranges[loop]) || ranges[loop] < 2)
+      continue;
+    bool plainIndex = llvm::all_of(maps, [&](AffineMap map) {
+      return llvm::all_of(map.getResults(), [&](AffineExpr expr) {
+        return !expr.isFunctionOfDim(loop) || expr.isa<AffineDimExpr>();
+      });
+    });
+    bool indexesOutputs =
+        llvm::all_of(genericOp.getDpsInitOperands(), [&](OpOperand *output) {
+          return genericOp.getMatchingIndexingMap(output).isFunctionOfDim(
+              loop);
+        });
+    if (plainIndex && indexesOutputs &&
+        (!splittableLoop || ranges[loop] > ranges[*splittableLoop]))
+      splittableLoop = loop;
+  }
+  return splittableLoop;
+}
+
+/// Splits `genericOp` along `loop` in `numSlices` operations, each computing
+/// a slice of the results from slices of the operands. The slices of the
+/// results are then inserted in the outputs of `genericOp`.
+static void splitGenericOp(mlir::linalg::GenericOp genericOp, unsigned loop,
+                           int64_t numSlices) {
+  OpBuilder builder(genericOp);
+  Location loc = genericOp.getLoc();
+  int64_t range = genericOp.getStaticLoopRanges()[loop];
+  int64_t sliceSize = llvm::divideCeil(range, numSlices);
+
+  // Offsets, sizes and strides of the slice [`offset`, `offset` + `size`[
+  // along `loop` of an operand indexed by `map`.
+  auto getSlice = [&](AffineMap map, RankedTensorType type, int64_t offset,
+                      int64_t size, SmallVectorImpl<OpFoldResult> &offsets,
+                      SmallVectorImpl<OpFoldResult> &sizes,
+                      SmallVectorImpl<OpFoldResult> &strides) {
+    for (auto [dim, expr] : llvm::enumerate(map.getResults())) {
+      bool sliced = expr.isFunctionOfDim(loop);
+      offsets.push_back(builder.getIndexAttr(sliced ? offset : 0));
+      sizes.push_back(
+          builder.getIndexAttr(sliced ? size : type.getDimSize(dim)));
+      strides.push_back(builder.getIndexAttr(1));
+    }
+  };
+
+  SmallVector<Value> results(genericOp.getOutputs());
+  SmallVector<std::pair<mlir::linalg::GenericOp, int64_t>> slices;
+  for (int64_t offset = 0; offset < range; offset += sliceSize) {
+    int64_t size = std::min(sliceSize, range - offset);
+    SmallVector<Value> operands;
+    for (OpOperand &operand : genericOp->getOpOperands()) {
+      auto type = operand.get().getType().dyn_cast<RankedTensorType>();
+      if (type == nullptr) {
+        operands.push_back(operand.get());
+        continue;
+      }
+      SmallVector<OpFoldResult> offsets, sizes, strides;
+      getSlice(genericOp.getMatchingIndexingMap(&operand), type, offset, size,
+               offsets, sizes, strides);
+      operands.push_back(builder.create<tensor::ExtractSliceOp>(
+          loc, operand.get(), offsets, sizes, strides));
+    }
+    ValueRange inputs =
+        ValueRange(operands).take_front(genericOp.getNumDpsInputs());
+    ValueRange outputs =
+        ValueRange(operands).drop_front(genericOp.getNumDpsInputs());
+    auto slice = builder.create<mlir::linalg::GenericOp>(
+        loc, outputs.getTypes(), inputs, outputs,
+        genericOp.getIndexingMapsArray(), genericOp.getIteratorTypesArray());
+    IRMapping map;
+    genericOp.getRegion().cloneInto(&slice.getRegion(), map);
+    slices.push_back({slice, offset});
+  }
+
+  // The slices are inserted once all of them are created, such that their
+  // tasks don't wait for one another.
+  for (auto [slice, offset] : slices) {
+    int64_t size = std::min(sliceSize, range - offset);
+    for (auto [result, output] :
+         llvm::zip(slice->getResults(), genericOp.getDpsInitOperands())) {
+      auto type = output->get().getType().cast<RankedTensorType>();
+      SmallVector<OpFoldResult> offsets, sizes, strides;
+      getSlice(genericOp.getMatchingIndexingMap(output), type, offset, size,
+               offsets, sizes, strides);
+      Value &full = results[result.getResultNumber()];
+      full = builder.create<tensor::InsertSliceOp>(loc, result, full, offsets,
+                                                   sizes, strides);
+    }
+  }
+  genericOp->replaceAllUsesWith(results);
+  genericOp->erase();
+}
+
 static bool
 aggregateBeneficiaryOps(Operation *op, SetVector<Operation *> &beneficiaryOps,
-                        llvm::SmallPtrSetImpl<Value> &availableValues) {
+                        llvm::SmallPtrSetImpl<Value> &availableValues,
+                        const DataflowTaskCostModel &costModel) {
   if (beneficiaryOps.count(op))
     return true;
 
-  if (!isAggregatingBeneficiary(op))
+  if (!isAggregatingBeneficiary(op, costModel))
     return false;
 
   // Gather the new potential dependences created by sinking this op.
@@ -88,7 +238,8 @@ aggregateBeneficiaryOps(Operation *op, SetVector<Operation *> &beneficiaryOps,
   for (auto dep : newDependencesIfSunk) {
     Operation *definingOp = dep.getDefiningOp();
     if (definingOp)
-      aggregateBeneficiaryOps(definingOp, beneficiaryOps, availableValues);
+      aggregateBeneficiaryOps(definingOp, beneficiaryOps, availableValues,
+                              costModel);
   }
 
   // We will sink the operation, mark its results as now available.
@@ -98,7 +249,8 @@ aggregateBeneficiaryOps(Operation *op, SetVector<Operation *> &beneficiaryOps,
   return true;
 }
 
-LogicalResult coarsenDFTask(RT::DataflowTaskOp taskOp) {
+LogicalResult coarsenDFTask(RT::DataflowTaskOp taskOp,
+                            const DataflowTaskCostModel &costModel) {
   Region &taskOpBody = taskOp.getBody();
 
   // Identify uses from values defined outside of the scope.
@@ -112,7 +264,7 @@ LogicalResult coarsenDFTask(RT::DataflowTaskOp taskOp) {
     Operation *operandOp = operand.getDefiningOp();
     if (!operandOp)
       continue;
-    aggregateBeneficiaryOps(operandOp, toBeSunk, availableValues);
+    aggregateBeneficiaryOps(operandOp, toBeSunk, availableValues, costModel);
   }
 
   // Insert operations so that the defs get cloned before uses.
@@ -141,10 +293,12 @@ struct BuildDataflowTaskGraphPass
     auto module = getOperation();
 
     module.walk([&](mlir::func::FuncOp func) {
-      if (!func->getAttr("_dfr_work_function_attribute"))
+      if (!func->getAttr("_dfr_work_function_attribute")) {
+        this->splitCostlyOperations(func);
         func.walk<mlir::WalkOrder::PreOrder>([&](mlir::Operation *childOp) {
           return this->processOperation(childOp);
         });
+      }
 
       // Perform simplifications, in particular DCE here in case some
       // of the operations sunk in tasks are no longer needed in the
@@ -157,11 +311,39 @@ struct BuildDataflowTaskGraphPass
       (void)mlir::simplifyRegions(rewriter, func->getRegions());
     });
   }
-  BuildDataflowTaskGraphPass(bool debug) : debug(debug){};
+  BuildDataflowTaskGraphPass(bool debug, DataflowTaskCostModel costModel)
+      : debug(debug), costModel(costModel){};
 
 protected:
+  /// Splits the operations of `func` costlier than the maximal cost of a
+  /// task, such that they are executed by several tasks in parallel.
+  void splitCostlyOperations(mlir::func::FuncOp func) {
+    if (costModel.maxTaskCost <= 0.)
+      return;
+
+    SmallVector<mlir::linalg::GenericOp> costlyOps;
+    func.walk([&](mlir::linalg::GenericOp genericOp) {
+      if (isCandidateForTask(genericOp) &&
+          estimateCost(genericOp, costModel) > costModel.maxTaskCost)
+        costlyOps.push_back(genericOp);
+    });
+    for (auto genericOp : costlyOps) {
+      std::optional<unsigned> loop = getSplittableLoop(genericOp);
+      if (!loop.has_value())
+        continue;
+      int64_t numSlices = std::min<int64_t>(
+          std::ceil(estimateCost(genericOp, costModel) /
+                    costModel.maxTaskCost),
+          genericOp.getStaticLoopRanges()[*loop]);
+      splitGenericOp(genericOp, *loop, numSlices);
+    }
+  }
+
   mlir::WalkResult processOperation(mlir::Operation *op) {
-    if (isCandidateForTask(op)) {
+    // Operations too cheap to be a task are left to be sunk in the tasks
+    // using their results.
+    if (isCandidateForTask(op) &&
+        estimateCost(op, costModel) >= costModel.minTaskCost) {
       IRMapping map;
       Region &opBody = getOperation().getBody();
       OpBuilder builder(opBody);
@@ -177,7 +359,7 @@ protected:
 
       // Coarsen granularity by aggregating all dependence related
       // lower-weight operations.
-      assert(!failed(coarsenDFTask(dftop)) &&
+      assert(!failed(coarsenDFTask(dftop, costModel)) &&
              "Failing to sink operations into DFT");
 
       // Add terminator
@@ -193,16 +375,19 @@ protected:
                                    opBody);
       // Once uses are re-targeted to the task, delete the operation
       op->erase();
+      return mlir::WalkResult::skip();
     }
     return mlir::WalkResult::advance();
   }
 
   bool debug;
+  DataflowTaskCostModel costModel;
 };
 } // end anonymous namespace
 
-std::unique_ptr<mlir::Pass> createBuildDataflowTaskGraphPass(bool debug) {
-  return std::make_unique<BuildDataflowTaskGraphPass>(debug);
+std::unique_ptr<mlir::Pass>
+createBuildDataflowTaskGraphPass(bool debug, DataflowTaskCostModel costModel) {
+  return std::make_unique<BuildDataflowTaskGraphPass>(debug, costModel);
 }
 
 } // end namespace concretelang
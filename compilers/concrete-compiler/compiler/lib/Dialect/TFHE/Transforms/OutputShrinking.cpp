@@ -0,0 +1,152 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include <mlir/Dialect/Arith/IR/Arith.h>
+#include <mlir/Dialect/Func/IR/FuncOps.h>
+#include <mlir/Dialect/SCF/IR/SCF.h>
+#include <mlir/Dialect/Tensor/IR/Tensor.h>
+#include <mlir/IR/SymbolTable.h>
+
+#include <concretelang/Dialect/TFHE/IR/TFHEOps.h>
+#include <concretelang/Dialect/TFHE/IR/TFHETypes.h>
+#include <concretelang/Dialect/TFHE/Transforms/Transforms.h>
+
+
+namespace mlir {
+namespace concretelang {
+
+namespace {
+
+/// Returns the keyswitch key of the module taking `key` as input, and whose
+/// output key is the input key of a bootstrap producing ciphertexts under
+/// `key`. This is the keyswitch of the partition of `key` the optimizer
+/// accounts for on shrunk outputs.
+std::optional<TFHE::GLWEKeyswitchKeyAttr>
+findShrinkingKeyswitchKey(llvm::ArrayRef<TFHE::GLWEKeyswitchKeyAttr> ksks,
+                          llvm::ArrayRef<TFHE::GLWEBootstrapKeyAttr> bsks,
+                          TFHE::GLWESecretKey key) {
+  for (auto ksk : ksks) {
+    if (!(ksk.getInputKey() == key))
+      continue;
+    for (auto bsk : bsks) {
+      if (bsk.getOutputKey() == key && bsk.getInputKey() == ksk.getOutputKey())
+        return ksk;
+    }
+  }
+  return std::nullopt;
+}
+
+/// Keyswitches every ciphertext of `value`, scalar or tensor, with `ksk`.
+mlir::Value keyswitchValue(mlir::OpBuilder &builder, mlir::Location loc,
+                           mlir::Value value, TFHE::GLWEKeyswitchKeyAttr ksk) {
+  auto outputType =
+      TFHE::GLWECipherTextType::get(builder.getContext(), ksk.getOutputKey());
+  auto tensorType = value.getType().dyn_cast<mlir::RankedTensorType>();
+  if (tensorType == nullptr) {
+    return builder.create<TFHE::KeySwitchGLWEOp>(loc, outputType, value, ksk);
+  }
+
+  // Tensors are keyswitched element-wise by a loop nest, such that the
+  // batching pass and the simulation lowering see the same operations as for
+  // any other keyswitch.
+  auto outputTensorType =
+      mlir::RankedTensorType::get(tensorType.getShape(), outputType);
+  mlir::Value init = builder.create<mlir::tensor::EmptyOp>(
+      loc, outputTensorType.getShape(), outputType);
+  mlir::SmallVector<mlir::Value> lbs, ubs, steps;
+  auto zero = builder.create<mlir::arith::ConstantIndexOp>(loc, 0);
+  auto one = builder.create<mlir::arith::ConstantIndexOp>(loc, 1);
+  for (auto dimension : tensorType.getShape()) {
+    lbs.push_back(zero);
+    ubs.push_back(builder.create<mlir::arith::ConstantIndexOp>(loc, dimension));
+    steps.push_back(one);
+  }
+  auto loopNest = mlir::scf::buildLoopNest(
+      builder, loc, lbs, ubs, steps, mlir::ValueRange{init},
+      [&](mlir::OpBuilder &nestedBuilder, mlir::Location nestedLoc,
+          mlir::ValueRange ivs, mlir::ValueRange iterArgs) {
+        mlir::Value element = nestedBuilder.create<mlir::tensor::ExtractOp>(
+            nestedLoc, value, ivs);
+        mlir::Value keyswitched = nestedBuilder.create<TFHE::KeySwitchGLWEOp>(
+            nestedLoc, outputType, element, ksk);
+        mlir::Value inserted = nestedBuilder.create<mlir::tensor::InsertOp>(
+            nestedLoc, keyswitched, iterArgs[0], ivs);
+        return mlir::scf::ValueVector{inserted};
+      });
+  return loopNest.results[0];
+}
+
+/// Keyswitches the ciphertexts returned by circuits to the input key of the
+/// bootstrap of their partition, such that they can be sent back to the client
+/// in a smaller format. The optimizer accounted for these keyswitches when the
+/// outputs were tagged as shrunk in its dag.
+class TFHEOutputShrinkingPass
+    : public TFHEOutputShrinkingBase<TFHEOutputShrinkingPass> {
+public:
+  void runOnOperation() override {
+    mlir::ModuleOp module = this->getOperation();
+
+    // Only the keyswitch keys already used by the circuits are considered,
+    // such that no additional evaluation key has to be generated.
+    llvm::SmallVector<TFHE::GLWEKeyswitchKeyAttr> ksks;
+    module.walk([&](TFHE::KeySwitchGLWEOp op) {
+      ksks.push_back(op.getKeyAttr());
+    });
+    module.walk([&](TFHE::BatchedKeySwitchGLWEOp op) {
+      ksks.push_back(op.getKeyAttr());
+    });
+    llvm::SmallVector<TFHE::GLWEBootstrapKeyAttr> bsks;
+    module.walk([&](TFHE::BootstrapGLWEOp op) {
+      bsks.push_back(op.getKeyAttr());
+    });
+    module.walk([&](TFHE::BatchedBootstrapGLWEOp op) {
+      bsks.push_back(op.getKeyAttr());
+    });
+    module.walk([&](TFHE::BatchedMappedBootstrapGLWEOp op) {
+      bsks.push_back(op.getKeyAttr());
+    });
+    if (ksks.empty() || bsks.empty())
+      return;
+
+    module.walk([&](mlir::func::FuncOp funcOp) {
+      // Functions called from another function keep their signature.
+      if (funcOp.isExternal() ||
+          !mlir::SymbolTable::symbolKnownUseEmpty(funcOp, module))
+        return;
+      auto returnOps = funcOp.getOps<mlir::func::ReturnOp>();
+      if (std::distance(returnOps.begin(), returnOps.end()) != 1)
+        return;
+      auto returnOp = *returnOps.begin();
+
+      mlir::OpBuilder builder(returnOp);
+      for (auto &operand : returnOp->getOpOperands()) {
+        auto glweType = mlir::getElementTypeOrSelf(operand.get().getType())
+                            .dyn_cast<TFHE::GLWECipherTextType>();
+        if (glweType == nullptr ||
+            !glweType.getKey().getParameterized().has_value())
+          continue;
+        auto ksk = findShrinkingKeyswitchKey(ksks, bsks, glweType.getKey());
+        if (!ksk.has_value())
+          continue;
+        operand.set(
+            keyswitchValue(builder, returnOp.getLoc(), operand.get(), *ksk));
+      }
+
+      funcOp.setType(mlir::FunctionType::get(
+          funcOp.getContext(), funcOp.getArgumentTypes(),
+          returnOp->getOperandTypes()));
+    });
+  }
+};
+
+} // namespace
+
+std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>>
+createTFHEOutputShrinkingPass() {
+  return std::make_unique<TFHEOutputShrinkingPass>();
+}
+
+} // namespace concretelang
+} // namespace mlir
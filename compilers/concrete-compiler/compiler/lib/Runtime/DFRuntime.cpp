@@ -16,11 +16,13 @@
 #include <hpx/future.hpp>
 #include <hpx/hpx_start.hpp>
 #include <hpx/hpx_suspend.hpp>
+#include <hpx/modules/threading_base.hpp>
 #include <hwloc.h>
 #include <omp.h>
 
 #include "concretelang/Runtime/DFRuntime.hpp"
 #include "concretelang/Runtime/distributed_generic_task_server.hpp"
+#include "concretelang/Runtime/numa.h"
 #include "concretelang/Runtime/runtime_api.h"
 #include "concretelang/Runtime/time_util.h"
 
@@ -179,6 +181,7 @@ bool _dfr_is_jit() { return is_jit_p; }
 bool _dfr_is_root_node() { return is_root_node_p; }
 bool _dfr_use_omp() { return use_omp_p; }
 bool _dfr_is_distributed() { return num_nodes > 1; }
+bool _dfr_in_task() { return hpx::threads::get_self_ptr() != nullptr; }
 } // namespace dfr
 } // namespace concretelang
 } // namespace mlir
@@ -226,7 +229,7 @@ static inline void _dfr_start_impl(int argc, char *argv[]) {
 
   if (argc == 0) {
     int nCores, nOMPThreads, nHPXThreads;
-    std::string hpxThreadNum;
+    std::string hpxThreadNum, hpxBind;
 
     std::vector<char *> parameters;
     parameters.push_back(const_cast<char *>("__dummy_dfr_HPX_program_name__"));
@@ -252,6 +255,18 @@ static inline void _dfr_start_impl(int argc, char *argv[]) {
     else
       nOMPThreads = 1;
 
+    // With pinned threads, the OpenMP workers take the first cores and the
+    // HPX workers the following ones, so unless OMP_NUM_THREADS is set the
+    // OpenMP team leaves DFR_NUM_THREADS cores, or else one core, to HPX.
+    bool pinning = mlir::concretelang::numa::pinning_enabled();
+    char *hpxEnv = getenv("DFR_NUM_THREADS");
+    if (pinning && _dfr_use_omp() && env == nullptr && nCores > 1) {
+      int reserved = hpxEnv != nullptr ? strtoul(hpxEnv, NULL, 10) : 1;
+      nOMPThreads = std::max(nCores - reserved, 1);
+      omp_set_num_threads(nOMPThreads);
+    }
+    int firstHPXCore = _dfr_use_omp() ? nOMPThreads : 0;
+
     // Unless specified, we will consider that within each node loop
     // parallelism is the priority, so we would allocate either
     // ncores/OMP_NUM_THREADS or ncores-OMP_NUM_THREADS+1.  Both make
@@ -260,17 +275,40 @@ static inline void _dfr_start_impl(int argc, char *argv[]) {
     // exploit all cores, at the risk of oversubscribing.  Ideally the
     // distribution of hardware resources to the runtime systems
     // should be explicitly defined by the user.
-    env = getenv("DFR_NUM_THREADS");
-    if (env != nullptr) {
-      nHPXThreads = strtoul(env, NULL, 10);
+    if (hpxEnv != nullptr) {
+      nHPXThreads = strtoul(hpxEnv, NULL, 10);
       parameters.push_back(const_cast<char *>("--hpx:threads"));
       hpxThreadNum = std::to_string(nHPXThreads);
       parameters.push_back(const_cast<char *>(hpxThreadNum.c_str()));
-    } else
+    } else if (pinning)
+      nHPXThreads = nCores - firstHPXCore;
+    else
       nHPXThreads = nCores + 1 - nOMPThreads;
     if (nHPXThreads < 1)
       nHPXThreads = 1;
 
+    if (pinning) {
+      if (_dfr_use_omp())
+        mlir::concretelang::numa::pin_openmp_workers();
+      if (firstHPXCore + nHPXThreads <= nCores) {
+        // Bind the HPX workers to the cores left by the OpenMP team, in the
+        // same order, such that both use the keys replicated on their node.
+        hpxBind = "--hpx:bind=thread:0-" + std::to_string(nHPXThreads - 1) +
+                  "=core:" + std::to_string(firstHPXCore) + "-" +
+                  std::to_string(firstHPXCore + nHPXThreads - 1) + ".pu:0";
+        parameters.push_back(const_cast<char *>(hpxBind.c_str()));
+        if (hpxEnv == nullptr) {
+          parameters.push_back(const_cast<char *>("--hpx:threads"));
+          hpxThreadNum = std::to_string(nHPXThreads);
+          parameters.push_back(const_cast<char *>(hpxThreadNum.c_str()));
+        }
+      } else {
+        // The threads requested oversubscribe the cores, let HPX balance its
+        // workers over the NUMA nodes.
+        parameters.push_back(const_cast<char *>("--hpx:bind=numa-balanced"));
+      }
+    }
+
     // If the user does not provide their own config file, one is by
     // default located at the root of the concrete-compiler directory.
     env = getenv("HPX_CONFIG_FILE");
@@ -308,6 +346,8 @@ static inline void _dfr_start_impl(int argc, char *argv[]) {
       hpx::start(nullptr, parameters.size(), parameters.data());
     }
   } else {
+    if (_dfr_use_omp())
+      mlir::concretelang::numa::pin_openmp_workers();
     hpx::start(nullptr, argc, argv);
   }
 
@@ -324,7 +364,13 @@ static inline void _dfr_start_impl(int argc, char *argv[]) {
         !strncmp(env, "On", 2) || !strncmp(env, "on", 2) ||
         !strncmp(env, "1", 1))
       lazy = true;
-  new RuntimeContextManager(lazy);
+  // Number of evaluation keysets kept on each node, such that
+  // executions with an already distributed keyset skip the broadcast.
+  env = getenv("DFR_KEYSET_CACHE_SIZE");
+  size_t keysetCacheSize = 1;
+  if (env != nullptr)
+    keysetCacheSize = strtoul(env, NULL, 10);
+  new RuntimeContextManager(lazy, keysetCacheSize);
 
   _dfr_jit_phase_barrier = new hpx::distributed::barrier(
       "phase_barrier", num_nodes, hpx::get_locality_id());
@@ -484,6 +530,7 @@ bool _dfr_is_jit() { return is_jit_p; }
 bool _dfr_is_root_node() { return true; }
 bool _dfr_use_omp() { return use_omp_p; }
 bool _dfr_is_distributed() { return num_nodes > 1; }
+bool _dfr_in_task() { return false; }
 
 } // namespace dfr
 } // namespace concretelang
@@ -6,8 +6,11 @@
 #include <atomic>
 #include <cmath>
 #include <cstdarg>
+#include <cstring>
 #include <err.h>
+#ifdef CONCRETELANG_HWLOC_SUPPORT
 #include <hwloc.h>
+#endif
 #include <iostream>
 #include <list>
 #include <memory>
@@ -26,6 +29,12 @@
 #include "device.h"
 #include "keyswitch.h"
 #include "linear_algebra.h"
+#else
+// Without CUDA support there are no devices: every process executes
+// on the host, chunked across worker threads, and the device streams
+// are never created.
+typedef struct CUstream_st *cudaStream_t;
+#endif
 
 using RuntimeContext = mlir::concretelang::RuntimeContext;
 
@@ -36,10 +45,12 @@ namespace {
 
 using MemRef2 = MemRefDescriptor<2>;
 
+#ifdef CONCRETELANG_CUDA_SUPPORT
 // When not using all accelerators on the machine, we distribute work
 // by assigning the default accelerator for each SDFG to next_device
 // round-robin.
 static std::atomic<size_t> next_device = {0};
+#endif
 
 // Resources available (or set as requested by user through
 // environment variables) on the machine. Defaults to using all
@@ -47,8 +58,10 @@ static std::atomic<size_t> next_device = {0};
 static size_t num_devices = 0;            // Set SDFG_NUM_GPUS to configure
 static size_t num_cores = 1;              // Set SDFG_NUM_THREADS to configure
 static size_t device_compute_factor = 16; // Set SDFG_DEVICE_TO_CORE_RATIO
+#ifdef CONCRETELANG_CUDA_SUPPORT
 // How much more memory than just input size is required on GPU to execute
 static float gpu_memory_inflation_factor = 1.5;
+#endif
 
 // Get the byte size of a rank 2 MemRef
 static inline size_t memref_get_data_size(MemRef2 &m) {
@@ -100,6 +113,7 @@ static const int32_t single_chunk = -1;
 static const int32_t split_chunks = -2;
 struct Stream;
 struct Dependence;
+#ifdef CONCRETELANG_CUDA_SUPPORT
 // Track buffer/scratchpad for the PBS to avoid re-allocating it on
 // the device. Reuse where possible or reallocate if a larger buffer
 // is required.
@@ -172,6 +186,13 @@ struct GPU_state {
     return gpu_stream;
   }
 };
+#else
+// Reached if a process is scheduled on a device in a build without
+// devices.
+[[noreturn]] static void no_device_support() {
+  errx(1, "SDFG: no device support, compile with CONCRETELANG_CUDA_SUPPORT.");
+}
+#endif
 
 // Track resources required for the execution of a single DFG,
 // including the GPU states of devices involved in its execution,
@@ -179,13 +200,18 @@ struct GPU_state {
 // accelerators before it can be freed.  As execution on accelerators
 // is asynchronous, this must wait for the next synchronization point.
 struct GPU_DFG {
+#ifdef CONCRETELANG_CUDA_SUPPORT
   std::vector<GPU_state> gpus;
+#endif
   uint32_t gpu_idx;
   void *gpu_stream;
-  GPU_DFG(uint32_t idx) : gpu_idx(idx), pbs_buffer(nullptr) {
+  GPU_DFG(uint32_t idx) : gpu_idx(idx), gpu_stream(nullptr) {
+#ifdef CONCRETELANG_CUDA_SUPPORT
+    pbs_buffer = nullptr;
     for (uint32_t i = 0; i < num_devices; ++i)
       gpus.push_back(std::move(GPU_state(i)));
     gpu_stream = gpus[idx].get_gpu_stream();
+#endif
   }
   ~GPU_DFG() {
     free_streams();
@@ -202,6 +228,7 @@ struct GPU_DFG {
       free(p);
     to_free_list.clear();
   }
+#ifdef CONCRETELANG_CUDA_SUPPORT
   inline int8_t *get_pbs_buffer(uint32_t glwe_dimension,
                                 uint32_t polynomial_size,
                                 uint32_t input_lwe_ciphertext_count) {
@@ -215,28 +242,32 @@ struct GPU_DFG {
                                       polynomial_size,
                                       input_lwe_ciphertext_count);
   }
-  void free_streams() {
-    streams.sort();
-    streams.unique();
-    for (auto s : streams)
-      delete s;
-  }
+#endif
+  void free_streams();
   inline void *get_gpu_stream(int32_t loc) {
     if (loc < 0)
       return nullptr;
+#ifdef CONCRETELANG_CUDA_SUPPORT
     return gpus[loc].get_gpu_stream();
+#else
+    no_device_support();
+#endif
   }
 
 private:
   std::list<void *> to_free_list;
   std::mutex free_list_guard;
   std::list<Stream *> streams;
+#ifdef CONCRETELANG_CUDA_SUPPORT
   PBS_buffer *pbs_buffer;
+#endif
 };
 
 struct Dependence;
 static void sdfg_gpu_debug_print_mref(const char *c, MemRef2 m);
+#ifdef CONCRETELANG_CUDA_SUPPORT
 static MemRef2 sdfg_gpu_debug_dependence(Dependence *d, cudaStream_t *s);
+#endif
 static bool sdfg_gpu_debug_compare_memref(MemRef2 &a, MemRef2 &b,
                                           char const *msg);
 
@@ -354,10 +385,14 @@ struct Dependence {
                csize);
       } else {
         assert(c->location > host_location);
+#ifdef CONCRETELANG_CUDA_SUPPORT
         cudaStream_t *s = (cudaStream_t *)dfg->get_gpu_stream(c->location);
         cuda_memcpy_async_to_cpu(((char *)output.aligned) + output.offset,
                                  c->device_data, csize, s, c->location);
         custreams_used.push_back(s);
+#else
+        no_device_support();
+#endif
       }
       output.offset += csize;
     }
@@ -366,10 +401,12 @@ struct Dependence {
       c->free_data(dfg, true);
     chunks.clear();
 
+#ifdef CONCRETELANG_CUDA_SUPPORT
     custreams_used.sort();
     custreams_used.unique();
     for (auto s : custreams_used)
       cudaStreamSynchronize(*s);
+#endif
 
     location = host_location;
     onHostReady = true;
@@ -381,10 +418,12 @@ struct Dependence {
   }
   void move_chunk_off_device(int32_t chunk_id, GPU_DFG *dfg) {
     chunks[chunk_id]->copy(host_location, dfg);
+#ifdef CONCRETELANG_CUDA_SUPPORT
     cuda_drop_async(
         chunks[chunk_id]->device_data,
         (cudaStream_t *)dfg->get_gpu_stream(chunks[chunk_id]->location),
         chunks[chunk_id]->location);
+#endif
     chunks[chunk_id]->location = host_location;
   }
   void free_chunk_host_data(int32_t chunk_id, GPU_DFG *dfg) {
@@ -398,17 +437,21 @@ struct Dependence {
   void free_chunk_device_data(int32_t chunk_id, GPU_DFG *dfg) {
     assert(chunks[chunk_id]->location > host_location &&
            chunks[chunk_id]->device_data != nullptr);
+#ifdef CONCRETELANG_CUDA_SUPPORT
     cuda_drop_async(
         chunks[chunk_id]->device_data,
         (cudaStream_t *)dfg->get_gpu_stream(chunks[chunk_id]->location),
         chunks[chunk_id]->location);
+#endif
     chunks[chunk_id]->device_data = nullptr;
   }
   inline void free_data(GPU_DFG *dfg, bool immediate = false) {
+#ifdef CONCRETELANG_CUDA_SUPPORT
     if (location >= 0 && device_data != nullptr) {
       cuda_drop_async(device_data,
                       (cudaStream_t *)dfg->get_gpu_stream(location), location);
     }
+#endif
     if (onHostReady && host_data.allocated != nullptr && hostAllocated) {
       // As streams are not synchronized aside from the GET operation,
       // we cannot free host-side data until after the synchronization
@@ -424,12 +467,15 @@ struct Dependence {
     delete (this);
   }
   inline void copy(int32_t loc, GPU_DFG *dfg) {
+#ifdef CONCRETELANG_CUDA_SUPPORT
     size_t data_size = memref_get_data_size(host_data);
+#endif
     if (loc == location)
       return;
     if (loc == host_location) {
       if (onHostReady)
         return;
+#ifdef CONCRETELANG_CUDA_SUPPORT
       if (host_data.allocated == nullptr) {
         host_data.allocated = host_data.aligned = (uint64_t *)malloc(data_size);
         hostAllocated = true;
@@ -439,9 +485,13 @@ struct Dependence {
                                location);
       cudaStreamSynchronize(*s);
       onHostReady = true;
+#else
+      no_device_support();
+#endif
     } else {
       assert(onHostReady &&
              "Device-to-device data transfers not supported yet.");
+#ifdef CONCRETELANG_CUDA_SUPPORT
       cudaStream_t *s = (cudaStream_t *)dfg->get_gpu_stream(loc);
       if (device_data != nullptr)
         cuda_drop_async(device_data, s, location);
@@ -449,6 +499,9 @@ struct Dependence {
       cuda_memcpy_async_to_gpu(
           device_data, host_data.aligned + host_data.offset, data_size, s, loc);
       location = loc;
+#else
+      no_device_support();
+#endif
     }
   }
 };
@@ -515,7 +568,7 @@ struct Stream {
     if (sname == nullptr) {
       static unsigned long stream_id = 0;
       char *n = new char[16];
-      snprintf(n, 16, "stream%llu", stream_id++);
+      snprintf(n, 16, "stream%lu", stream_id++);
       name = n;
     } else {
       name = sname;
@@ -537,7 +590,7 @@ struct Stream {
       assert(dep != nullptr);
       if (dep->chunks[chunk_id] != nullptr)
         dep->chunks[chunk_id]->free_data(dfg, true);
-      assert(dep->chunks.size() > chunk_id);
+      assert(dep->chunks.size() > (size_t)chunk_id);
       dep->chunks[chunk_id] = d;
     } else {
       //  If a dependence was already present, schedule deallocation.
@@ -582,13 +635,15 @@ struct Stream {
           (p->fun == memref_bootstrap_lwe_u64_process) ? 1 : 0;
     }
     // If this subgraph is not batched, then use this DFG's allocated
-    // GPU to offload to.  If this does not bootstrap, just execute on
-    // the host.
+    // GPU to offload to.  If this does not bootstrap, or if there is
+    // no device, just execute on the host.
     if (!is_batched_subgraph) {
       for (auto p : queue) {
-        schedule_kernel(
-            p, (subgraph_bootstraps > 0) ? dfg->gpu_idx : host_location,
-            single_chunk, nullptr);
+        schedule_kernel(p,
+                        (subgraph_bootstraps > 0 && num_devices > 0)
+                            ? (int32_t)dfg->gpu_idx
+                            : host_location,
+                        single_chunk, nullptr);
       }
       return;
     }
@@ -656,7 +711,7 @@ struct Stream {
                       (num_real_inputs ? num_real_inputs : 1);
     size_t num_chunks = 1;
     size_t num_gpu_chunks = 0;
-    int32_t num_devices_to_use = 0;
+#ifdef CONCRETELANG_CUDA_SUPPORT
     // If the subgraph does not have sufficient computational
     // intensity (which we approximate by whether it bootstraps), then
     // we assume (TODO: confirm with profiling) that it is not
@@ -681,10 +736,8 @@ struct Stream {
           ((mem_per_sample ? mem_per_sample : 1) * gpu_memory_inflation_factor);
 
       if (num_samples < num_cores + device_compute_factor * num_devices) {
-        num_devices_to_use = 0;
         num_chunks = std::min(num_cores, num_samples);
       } else {
-        num_devices_to_use = num_devices;
         size_t compute_resources =
             num_cores + num_devices * device_compute_factor;
         size_t gpu_chunk_size =
@@ -698,6 +751,14 @@ struct Stream {
     } else {
       num_chunks = std::min(num_cores, num_samples);
     }
+#else
+    // Without devices, each host worker streams one chunk of the
+    // samples through the whole subgraph, such that the intermediate
+    // values of a chunk can be freed as soon as the chunk completes.
+    (void)mem_per_sample;
+    (void)const_mem_per_sample;
+    num_chunks = std::min(num_cores, num_samples);
+#endif
 
     for (auto i : inputs)
       i->dep->split_dependence(num_chunks, num_gpu_chunks,
@@ -754,7 +815,8 @@ struct Stream {
         }
       }
     }
-    for (dev = 0; dev < num_devices; ++dev) {
+#ifdef CONCRETELANG_CUDA_SUPPORT
+    for (dev = 0; dev < (int32_t)num_devices; ++dev) {
       gpu_schedulers.push_back(std::thread(
           [&](std::list<Process *> queue, int32_t dev) {
             for (size_t c : gpu_chunk_list[dev]) {
@@ -778,6 +840,7 @@ struct Stream {
           },
           queue, dev));
     }
+#endif
     for (auto &w : workers)
       w.join();
     workers.clear();
@@ -802,7 +865,9 @@ struct Stream {
     if (dep->onHostReady) {
       memref_copy_contiguous(out, dep->host_data);
       return dep;
-    } else if (dep->location == split_location) {
+    }
+#ifdef CONCRETELANG_CUDA_SUPPORT
+    else if (dep->location == split_location) {
       char *pos = (char *)(out.aligned + out.offset);
       std::list<int32_t> devices_used;
       for (auto c : dep->chunks) {
@@ -825,6 +890,9 @@ struct Stream {
                                dep->location);
       cudaStreamSynchronize(*(cudaStream_t *)dfg->gpu_stream);
     }
+#else
+    no_device_support();
+#endif
     // After this synchronization point, all of the host-side
     // allocated memory can be freed as we know all asynchronous
     // operations have finished.
@@ -852,7 +920,7 @@ struct Stream {
     if (chunk_id == single_chunk && dep->stream_generation != generation)
       return true;
     if (chunk_id != single_chunk) {
-      assert(chunk_id < dep->chunks.size());
+      assert((size_t)chunk_id < dep->chunks.size());
       if (dep->chunks[chunk_id] == nullptr)
         return true;
       if (dep->chunks[chunk_id]->stream_generation != generation)
@@ -862,6 +930,13 @@ struct Stream {
   }
 };
 
+void GPU_DFG::free_streams() {
+  streams.sort();
+  streams.unique();
+  for (auto s : streams)
+    delete s;
+}
+
 static inline mlir::concretelang::gpu_dfg::Process *
 make_process_1_1(void *dfg, void *sin1, void *sout,
                  void (*fun)(Process *, int32_t, int32_t, uint64_t *)) {
@@ -918,6 +993,7 @@ make_process_2_1(void *dfg, void *sin1, void *sin2, void *sout,
             << m.strides[0] << ", " << m.strides[1] << "]\n";
 }
 
+#ifdef CONCRETELANG_CUDA_SUPPORT
 [[maybe_unused]] static MemRef2 sdfg_gpu_debug_dependence(Dependence *d,
                                                           cudaStream_t *s) {
   if (d->onHostReady)
@@ -933,6 +1009,7 @@ make_process_2_1(void *dfg, void *sin1, void *sin2, void *sout,
   cudaStreamSynchronize(*s);
   return ret;
 }
+#endif
 
 [[maybe_unused]] static bool
 sdfg_gpu_debug_compare_memref(MemRef2 &a, MemRef2 &b, char const *msg) {
@@ -940,7 +1017,6 @@ sdfg_gpu_debug_compare_memref(MemRef2 &a, MemRef2 &b, char const *msg) {
       a.strides[0] != b.strides[0] || a.strides[1] != b.strides[1])
     return false;
   size_t data_size = memref_get_data_size(a);
-  int num = 0;
   for (size_t i = 0; i < data_size / sizeof(uint64_t); ++i)
     if ((a.aligned + a.offset)[i] != (b.aligned + b.offset)[i]) {
       std::cout << msg << " - memrefs differ at position " << i << " "
@@ -954,7 +1030,6 @@ sdfg_gpu_debug_compare_memref(MemRef2 &a, MemRef2 &b, char const *msg) {
 // Stream emulator processes
 void memref_keyswitch_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
                                       uint64_t *out_ptr) {
-  assert(p->sk_index.val == 0 && "multiple ksk is not yet implemented on GPU");
   auto sched = [&](Dependence *d) {
     uint64_t num_samples = d->host_data.sizes[0];
     MemRef2 out = {
@@ -976,7 +1051,10 @@ void memref_keyswitch_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
           new Dependence(loc, out, nullptr, true, true, d->chunk_id);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
       // Schedule the keyswitch kernel on the GPU
+      assert(p->sk_index.val == 0 &&
+             "multiple ksk is not yet implemented on GPU");
       cudaStream_t *s = (cudaStream_t *)p->dfg->get_gpu_stream(loc);
       void *ct0_gpu = d->device_data;
       void *out_gpu = cuda_malloc_async(data_size, s, loc);
@@ -988,6 +1066,9 @@ void memref_keyswitch_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
       Dependence *dep =
           new Dependence(loc, out, out_gpu, false, false, d->chunk_id);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
   Dependence *idep = p->input_streams[0]->get(loc, chunk_id);
@@ -997,29 +1078,13 @@ void memref_keyswitch_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
 
 void memref_bootstrap_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
                                       uint64_t *out_ptr) {
-  assert(p->sk_index.val == 0 && "multiple bsk is not yet implemented on GPU");
   assert(p->output_size.val == p->glwe_dim.val * p->poly_size.val + 1);
 
   Dependence *idep1 = p->input_streams[1]->get(host_location, chunk_id);
   MemRef2 &mtlu = idep1->host_data;
   uint32_t num_lut_vectors = mtlu.sizes[0];
-  uint64_t glwe_ct_len =
-      p->poly_size.val * (p->glwe_dim.val + 1) * num_lut_vectors;
-  uint64_t glwe_ct_size = glwe_ct_len * sizeof(uint64_t);
-  uint64_t *glwe_ct = (uint64_t *)malloc(glwe_ct_size);
-  auto tlu = mtlu.aligned + mtlu.offset;
-  // Glwe trivial encryption
-  size_t pos = 0, postlu = 0;
-  for (size_t l = 0; l < num_lut_vectors; ++l) {
-    for (size_t i = 0; i < p->poly_size.val * p->glwe_dim.val; i++) {
-      glwe_ct[pos++] = 0;
-    }
-    for (size_t i = 0; i < p->poly_size.val; i++) {
-      glwe_ct[pos++] = tlu[postlu++];
-    }
-  }
 
-  auto sched = [&](Dependence *d0, Dependence *d1, uint64_t *glwe_ct,
+  auto sched = [&](Dependence *d0, Dependence *d1,
                    std::vector<size_t> &lut_indexes, cudaStream_t *s,
                    int32_t loc) {
     uint64_t num_samples = d0->host_data.sizes[0];
@@ -1027,17 +1092,6 @@ void memref_bootstrap_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
         0, 0, 0, {num_samples, p->output_size.val}, {p->output_size.val, 1}};
     size_t data_size = memref_get_data_size(out);
 
-    // Move test vector indexes to the GPU, the test vector indexes is set of 0
-    uint32_t lwe_idx = 0,
-             test_vector_idxes_size = num_samples * sizeof(uint64_t);
-    uint64_t *test_vector_idxes = (uint64_t *)malloc(test_vector_idxes_size);
-    if (lut_indexes.size() == 1) {
-      memset((void *)test_vector_idxes, lut_indexes[0], test_vector_idxes_size);
-    } else {
-      assert(lut_indexes.size() == num_samples);
-      for (size_t i = 0; i < num_samples; ++i)
-        test_vector_idxes[i] = lut_indexes[i];
-    }
     if (loc == host_location) {
       // If it is not profitable to offload, schedule kernel on CPU
       out.allocated = out.aligned =
@@ -1067,9 +1121,41 @@ void memref_bootstrap_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
             p->ctx.val);
       Dependence *dep =
           new Dependence(loc, out, nullptr, true, true, d0->chunk_id);
-      free(glwe_ct);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
+      assert(p->sk_index.val == 0 &&
+             "multiple bsk is not yet implemented on GPU");
+      uint64_t glwe_ct_len =
+          p->poly_size.val * (p->glwe_dim.val + 1) * num_lut_vectors;
+      uint64_t glwe_ct_size = glwe_ct_len * sizeof(uint64_t);
+      uint64_t *glwe_ct = (uint64_t *)malloc(glwe_ct_size);
+      auto tlu = mtlu.aligned + mtlu.offset;
+      // Glwe trivial encryption
+      size_t pos = 0, postlu = 0;
+      for (size_t l = 0; l < num_lut_vectors; ++l) {
+        for (size_t i = 0; i < p->poly_size.val * p->glwe_dim.val; i++) {
+          glwe_ct[pos++] = 0;
+        }
+        for (size_t i = 0; i < p->poly_size.val; i++) {
+          glwe_ct[pos++] = tlu[postlu++];
+        }
+      }
+
+      // Move test vector indexes to the GPU, the test vector indexes is set
+      // of 0
+      uint32_t lwe_idx = 0,
+               test_vector_idxes_size = num_samples * sizeof(uint64_t);
+      uint64_t *test_vector_idxes = (uint64_t *)malloc(test_vector_idxes_size);
+      if (lut_indexes.size() == 1) {
+        memset((void *)test_vector_idxes, lut_indexes[0],
+               test_vector_idxes_size);
+      } else {
+        assert(lut_indexes.size() == num_samples);
+        for (size_t i = 0; i < num_samples; ++i)
+          test_vector_idxes[i] = lut_indexes[i];
+      }
+
       // Schedule the bootstrap kernel on the GPU
       void *glwe_ct_gpu = cuda_malloc_async(glwe_ct_size, s, loc);
       cuda_memcpy_async_to_gpu(glwe_ct_gpu, glwe_ct, glwe_ct_size, s, loc);
@@ -1099,6 +1185,9 @@ void memref_bootstrap_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
       p->dfg->register_stream_order_dependent_allocation(test_vector_idxes);
       p->dfg->register_stream_order_dependent_allocation(glwe_ct);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
 
@@ -1117,7 +1206,7 @@ void memref_bootstrap_lwe_u64_process(Process *p, int32_t loc, int32_t chunk_id,
   Dependence *idep0 = p->input_streams[0]->get(loc, chunk_id);
   if (p->output_streams[0]->need_new_gen(chunk_id))
     p->output_streams[0]->put(
-        sched(idep0, idep1, glwe_ct, lut_indexes, cstream, loc), chunk_id);
+        sched(idep0, idep1, lut_indexes, cstream, loc), chunk_id);
 }
 
 void memref_add_lwe_ciphertexts_u64_process(Process *p, int32_t loc,
@@ -1152,6 +1241,7 @@ void memref_add_lwe_ciphertexts_u64_process(Process *p, int32_t loc,
           new Dependence(loc, out, nullptr, true, true, d0->chunk_id);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
       // Schedule the kernel on the GPU
       void *out_gpu = cuda_malloc_async(data_size, s, loc);
       cuda_add_lwe_ciphertext_vector_64(
@@ -1160,6 +1250,9 @@ void memref_add_lwe_ciphertexts_u64_process(Process *p, int32_t loc,
       Dependence *dep =
           new Dependence(loc, out, out_gpu, false, false, d0->chunk_id);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
   Dependence *idep0 = p->input_streams[0]->get(loc, chunk_id);
@@ -1210,6 +1303,7 @@ void memref_add_plaintext_lwe_ciphertext_u64_process(Process *p, int32_t loc,
           new Dependence(loc, out, nullptr, true, true, d0->chunk_id);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
       // Schedule the kernel on the GPU
       void *out_gpu = cuda_malloc_async(data_size, s, loc);
       cuda_add_lwe_ciphertext_vector_plaintext_vector_64(
@@ -1218,6 +1312,9 @@ void memref_add_plaintext_lwe_ciphertext_u64_process(Process *p, int32_t loc,
       Dependence *dep =
           new Dependence(loc, out, out_gpu, false, false, d0->chunk_id);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
   Dependence *idep0 = p->input_streams[0]->get(loc, chunk_id);
@@ -1268,6 +1365,7 @@ void memref_mul_cleartext_lwe_ciphertext_u64_process(Process *p, int32_t loc,
           new Dependence(loc, out, nullptr, true, true, d0->chunk_id);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
       // Schedule the keyswitch kernel on the GPU
       void *out_gpu = cuda_malloc_async(data_size, s, loc);
       cuda_mult_lwe_ciphertext_vector_cleartext_vector_64(
@@ -1276,6 +1374,9 @@ void memref_mul_cleartext_lwe_ciphertext_u64_process(Process *p, int32_t loc,
       Dependence *dep =
           new Dependence(loc, out, out_gpu, false, false, d0->chunk_id);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
   Dependence *idep0 = p->input_streams[0]->get(loc, chunk_id);
@@ -1311,6 +1412,7 @@ void memref_negate_lwe_ciphertext_u64_process(Process *p, int32_t loc,
           new Dependence(loc, out, nullptr, true, true, d0->chunk_id);
       return dep;
     } else {
+#ifdef CONCRETELANG_CUDA_SUPPORT
       // Schedule the kernel on the GPU
       void *out_gpu = cuda_malloc_async(data_size, s, loc);
       cuda_negate_lwe_ciphertext_vector_64(s, loc, out_gpu, d0->device_data,
@@ -1319,6 +1421,9 @@ void memref_negate_lwe_ciphertext_u64_process(Process *p, int32_t loc,
       Dependence *dep =
           new Dependence(loc, out, out_gpu, false, false, d0->chunk_id);
       return dep;
+#else
+      no_device_support();
+#endif
     }
   };
   Dependence *idep0 = p->input_streams[0]->get(loc, chunk_id);
@@ -1598,11 +1703,13 @@ void stream_emulator_get_memref_batch(void *stream, uint64_t *out_allocated,
 }
 
 void *stream_emulator_init() {
+  char *env;
+#ifdef CONCRETELANG_CUDA_SUPPORT
   int num;
   assert(cudaGetDeviceCount(&num) == cudaSuccess);
   num_devices = num;
   assert(num_devices > 0 && "No GPUs available on system.");
-  char *env = getenv("SDFG_NUM_GPUS");
+  env = getenv("SDFG_NUM_GPUS");
   if (env != nullptr) {
     size_t requested_gpus = strtoul(env, NULL, 10);
     if (requested_gpus == 0)
@@ -1620,7 +1727,9 @@ void *stream_emulator_init() {
   env = getenv("SDFG_DEVICE_TO_CORE_RATIO");
   if (env != nullptr)
     device_compute_factor = strtoul(env, NULL, 10);
+#endif
 
+#ifdef CONCRETELANG_HWLOC_SUPPORT
   hwloc_topology_t topology;
   hwloc_topology_init(&topology);
   hwloc_topology_set_all_types_filter(topology, HWLOC_TYPE_FILTER_KEEP_NONE);
@@ -1628,15 +1737,22 @@ void *stream_emulator_init() {
                                  HWLOC_TYPE_FILTER_KEEP_ALL);
   hwloc_topology_load(topology);
   num_cores = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_CORE);
+  hwloc_topology_destroy(topology);
+#else
+  num_cores = std::thread::hardware_concurrency();
+#endif
   env = getenv("SDFG_NUM_THREADS");
   if (env != nullptr && strtoul(env, NULL, 10) != 0)
     num_cores = strtoul(env, NULL, 10);
   if (num_cores < 1)
     num_cores = 1;
 
+#ifdef CONCRETELANG_CUDA_SUPPORT
   int device = next_device.fetch_add(1) % num_devices;
   return new GPU_DFG(device);
+#else
+  return new GPU_DFG(0);
+#endif
 }
 void stream_emulator_run(void *dfg) {}
 void stream_emulator_delete(void *dfg) { delete (GPU_DFG *)dfg; }
-#endif
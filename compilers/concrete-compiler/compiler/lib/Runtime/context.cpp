@@ -7,11 +7,56 @@
 #include "concretelang/Common/Error.h"
 #include "concretelang/Common/Keysets.h"
 #include <assert.h>
+#include <err.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace mlir {
 namespace concretelang {
 
+namespace {
+/// Returns a copy of `length` elements of `data` bound to the memory of the
+/// NUMA node `node`, or nullptr if it couldn't be allocated.
+template <typename T>
+std::shared_ptr<const T> copy_on_node(const T *data, size_t length,
+                                      size_t node) {
+  size_t size = length * sizeof(T);
+  auto copy = (T *)numa::allocate_on_node(size, node);
+  if (copy == nullptr)
+    return nullptr;
+  // The pages are already populated on the node.
+  memcpy(copy, data, size);
+  return std::shared_ptr<const T>(
+      copy, [](const T *ptr) { numa::free_on_node((void *)ptr); });
+}
+
+/// Returns the replica of `length` elements of `data` on the NUMA node `node`:
+/// `data` itself if it already lies on the node, without owning it, or else
+/// its copy on the node, or nullptr if it couldn't be allocated.
+template <typename T>
+std::shared_ptr<const T> replicate_on_node(const T *data, size_t length,
+                                           size_t node, bool &copied) {
+  copied = false;
+  if (numa::node_of_area(data, length * sizeof(T)) == (int)node)
+    return std::shared_ptr<const T>(data, [](const T *) {});
+  copied = true;
+  return copy_on_node(data, length, node);
+}
+
+/// Returns a copy of `length` elements of `data` on huge pages, or nullptr if
+/// it couldn't be allocated.
+template <typename T>
+std::shared_ptr<const T> copy_on_huge_pages(const T *data, size_t length) {
+  size_t size = length * sizeof(T);
+  auto copy = (T *)huge_pages::allocate(size);
+  if (copy == nullptr)
+    return nullptr;
+  memcpy(copy, data, size);
+  return std::shared_ptr<const T>(
+      copy, [](const T *ptr) { huge_pages::deallocate((void *)ptr); });
+}
+} // namespace
+
 FFT::FFT(size_t polynomial_size)
     : fft(nullptr), polynomial_size(polynomial_size) {
   fft = (struct Fft *)aligned_alloc(CONCRETE_FFT_ALIGN, CONCRETE_FFT_SIZE);
@@ -39,6 +84,10 @@ RuntimeContext::RuntimeContext(ServerKeyset serverKeyset)
     fourier_bootstrap_keys.push_back(fdbsk.second);
     ffts.push_back(std::move(fdbsk.first));
   }
+  replicate_on_numa_nodes();
+  copy_keyswitch_keys_on_huge_pages();
+  // The loops parallelized with OpenMP run on the workers of its runtime.
+  numa::pin_openmp_workers();
 
 #ifdef CONCRETELANG_CUDA_SUPPORT
   assert(cudaGetDeviceCount(&num_devices) == cudaSuccess);
@@ -51,7 +100,73 @@ RuntimeContext::RuntimeContext(ServerKeyset serverKeyset)
 #endif
 }
 
-std::pair<FFT, std::shared_ptr<std::vector<std::complex<double>>>>
+void RuntimeContext::replicate_on_numa_nodes() {
+  if (!numa::replication_enabled() || numa::num_nodes() < 2)
+    return;
+  numa_replicas.resize(numa::num_nodes());
+  // The original keys are the replicas of the node they lie on, only the
+  // other nodes get copies, which are the only ones counted in the sizes.
+  bool copied;
+  for (size_t node = 0; node < numa_replicas.size(); node++) {
+    auto &replica = numa_replicas[node];
+    for (auto &ksk : serverKeyset.lweKeyswitchKeys) {
+      auto &buffer = ksk.getBuffer();
+      auto copy = replicate_on_node(buffer.data(), buffer.size(), node, copied);
+      if (copy == nullptr)
+        break;
+      replica.keyswitch_keys.push_back(copy);
+      if (copied)
+        replica.size += huge_pages::mapped_size_of(copy.get());
+    }
+    for (auto &fbsk : fourier_bootstrap_keys) {
+      auto copy = replicate_on_node(fbsk->data(), fbsk->size(), node, copied);
+      if (copy == nullptr)
+        break;
+      replica.fourier_bootstrap_keys.push_back(copy);
+      if (copied)
+        replica.size += huge_pages::mapped_size_of(copy.get());
+    }
+    if (replica.keyswitch_keys.size() < serverKeyset.lweKeyswitchKeys.size() ||
+        replica.fourier_bootstrap_keys.size() <
+            fourier_bootstrap_keys.size()) {
+      // Not enough memory on the node, the threads use the original keys.
+      warnx("WARNING: not enough memory to replicate the evaluation keys on "
+            "NUMA node %zu - keys are not replicated.",
+            node);
+      numa_replicas.clear();
+      return;
+    }
+  }
+}
+
+void RuntimeContext::copy_keyswitch_keys_on_huge_pages() {
+  // The Fourier bootstrap keys are allocated on huge pages, but the buffers
+  // of the keyswitch keys are shared with the keyset, and are copied.
+  if (!huge_pages::enabled() || !numa_replicas.empty())
+    return;
+  for (auto &ksk : serverKeyset.lweKeyswitchKeys) {
+    auto &buffer = ksk.getBuffer();
+    auto copy = copy_on_huge_pages(buffer.data(), buffer.size());
+    if (copy == nullptr) {
+      warnx("WARNING: not enough memory to copy the keyswitch keys on huge "
+            "pages - keys are not copied.");
+      keyswitch_keys.clear();
+      keyswitch_keys_size = 0;
+      return;
+    }
+    keyswitch_keys.push_back(copy);
+    keyswitch_keys_size += huge_pages::mapped_size_of(copy.get());
+  }
+}
+
+size_t RuntimeContext::key_copies_size() const {
+  size_t size = 0;
+  for (auto &replica : numa_replicas)
+    size += replica.size;
+  return size + keyswitch_keys_size;
+}
+
+std::pair<FFT, std::shared_ptr<FourierBootstrapKey>>
 RuntimeContext::convert_to_fourier_domain(LweBootstrapKey &bsk) {
   auto info = bsk.getInfo().asReader();
 
@@ -73,7 +188,7 @@ RuntimeContext::convert_to_fourier_domain(LweBootstrapKey &bsk) {
 
   // Allocate the fourier_bootstrap_key
   auto &bsk_buffer = bsk.getBuffer();
-  auto fourier_data = std::make_shared<std::vector<std::complex<double>>>();
+  auto fourier_data = std::make_shared<FourierBootstrapKey>();
   fourier_data->resize(bsk_buffer.size() / 2);
   auto bsk_data = bsk_buffer.data();
 
@@ -84,7 +199,7 @@ RuntimeContext::convert_to_fourier_domain(LweBootstrapKey &bsk) {
       input_lwe_dimension, fft.fft, scratch, scratch_size);
   free(scratch);
 
-  return std::pair<FFT, std::shared_ptr<std::vector<std::complex<double>>>>(
+  return std::pair<FFT, std::shared_ptr<FourierBootstrapKey>>(
       std::move(fft), fourier_data);
 }
 } // namespace concretelang
@@ -117,6 +232,18 @@ const uint64_t *DistributedRuntimeContext::keyswitch_key_buffer(size_t keyId) {
   return it->second.getBuffer().data();
 }
 
+uint32_t DistributedRuntimeContext::keyswitch_key_precision(size_t keyId) {
+  if (dfr::_dfr_is_root_node())
+    return RuntimeContext::keyswitch_key_precision(keyId);
+
+  // Makes sure the key is available on this node.
+  keyswitch_key_buffer(keyId);
+  std::lock_guard<std::mutex> guard(cm_guard);
+  auto it = ksks.find(keyId);
+  assert(it != ksks.end());
+  return it->second.getInfo().asReader().getParams().getIntegerPrecision();
+}
+
 void DistributedRuntimeContext::getBSKonNode(size_t keyId) {
   assert(fbks.find(keyId) == fbks.end());
   assert(dffts.find(keyId) == dffts.end());
@@ -126,7 +253,7 @@ void DistributedRuntimeContext::getBSKonNode(size_t keyId) {
 
   auto fdbsk = convert_to_fourier_domain(bskw.keys[0]);
   fbks.insert(
-      std::pair<size_t, std::shared_ptr<std::vector<std::complex<double>>>>(
+      std::pair<size_t, std::shared_ptr<FourierBootstrapKey>>(
           keyId, fdbsk.second));
   dffts.insert(std::pair<size_t, FFT>(keyId, std::move(fdbsk.first)));
 }
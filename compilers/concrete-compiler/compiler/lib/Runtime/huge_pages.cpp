@@ -0,0 +1,200 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include "concretelang/Runtime/huge_pages.h"
+#include <atomic>
+#include <err.h>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_SHIFT 26
+#endif
+
+namespace mlir {
+namespace concretelang {
+namespace huge_pages {
+namespace {
+
+const size_t NUM_PAGES = 4;
+
+struct Mapping {
+  size_t size;
+  Pages pages;
+};
+
+std::mutex mappings_guard;
+std::map<const void *, Mapping> mappings;
+std::atomic<size_t> mapped[NUM_PAGES];
+
+void *map(size_t size, int flags) {
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+#if defined(MAP_HUGETLB) || defined(MADV_HUGEPAGE)
+size_t round_up(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+#endif
+
+#ifdef MAP_HUGETLB
+const size_t GIGA_PAGE_SIZE = 1 << 30;
+
+/// Maps `size` bytes on pages of the hugetlb pool of 2^`log_page_size` bytes.
+void *map_hugetlb(size_t size, int log_page_size) {
+  return map(size, MAP_HUGETLB | (log_page_size << MAP_HUGE_SHIFT));
+}
+#endif
+
+#ifdef MADV_HUGEPAGE
+/// Maps `size` bytes, a multiple of the huge page size, aligned on a huge page
+/// such that transparent huge pages can back the whole area.
+void *map_aligned(size_t size) {
+  auto ptr = (uintptr_t)map(size + HUGE_PAGE_SIZE, 0);
+  if (ptr == 0)
+    return nullptr;
+  auto aligned = round_up(ptr, HUGE_PAGE_SIZE);
+  if (aligned > ptr)
+    munmap((void *)ptr, aligned - ptr);
+  munmap((void *)(aligned + size), ptr + HUGE_PAGE_SIZE - aligned);
+  return (void *)aligned;
+}
+#endif
+
+/// Maps `size` bytes on the largest pages available, rounding `size` up to
+/// the size of the pages.
+void *map_pages(size_t &size, Pages &pages) {
+#ifdef MAP_HUGETLB
+  if (size >= GIGA_PAGE_SIZE) {
+    auto gigaSize = round_up(size, GIGA_PAGE_SIZE);
+    if (auto ptr = map_hugetlb(gigaSize, 30)) {
+      size = gigaSize;
+      pages = Pages::HUGETLB_1GB;
+      return ptr;
+    }
+  }
+  auto hugeSize = round_up(size, HUGE_PAGE_SIZE);
+  if (auto ptr = map_hugetlb(hugeSize, 21)) {
+    size = hugeSize;
+    pages = Pages::HUGETLB_2MB;
+    return ptr;
+  }
+#endif
+#ifdef MADV_HUGEPAGE
+  auto alignedSize = round_up(size, HUGE_PAGE_SIZE);
+  if (auto ptr = map_aligned(alignedSize)) {
+    size = alignedSize;
+    pages = madvise(ptr, size, MADV_HUGEPAGE) == 0 ? Pages::TRANSPARENT
+                                                   : Pages::DEFAULT;
+    return ptr;
+  }
+#endif
+  pages = Pages::DEFAULT;
+  return map(size, 0);
+}
+
+} // namespace
+
+bool enabled() {
+  static bool enabled = []() {
+    char *env = getenv("CONCRETE_HUGE_PAGES");
+    return env != nullptr &&
+           (!strncmp(env, "True", 4) || !strncmp(env, "true", 4) ||
+            !strncmp(env, "On", 2) || !strncmp(env, "on", 2) ||
+            !strncmp(env, "1", 1));
+  }();
+  return enabled;
+}
+
+const char *name(Pages pages) {
+  switch (pages) {
+  case Pages::DEFAULT:
+    return "default";
+  case Pages::TRANSPARENT:
+    return "transparent huge";
+  case Pages::HUGETLB_2MB:
+    return "2MB hugetlb";
+  case Pages::HUGETLB_1GB:
+    return "1GB hugetlb";
+  }
+  return "unknown";
+}
+
+void *allocate(size_t size) {
+  Pages pages = Pages::DEFAULT;
+  void *ptr;
+  if (enabled()) {
+    ptr = map_pages(size, pages);
+    if (ptr != nullptr && pages == Pages::DEFAULT) {
+      static std::once_flag warned;
+      std::call_once(warned, []() {
+        warnx("WARNING: no huge pages available - falling back to the "
+              "default pages.");
+      });
+    }
+  } else {
+    ptr = map(size, 0);
+  }
+  if (ptr == nullptr)
+    return nullptr;
+  mapped[(size_t)pages] += size;
+  std::lock_guard<std::mutex> guard(mappings_guard);
+  mappings[ptr] = Mapping{size, pages};
+  return ptr;
+}
+
+void deallocate(void *ptr) {
+  if (ptr == nullptr)
+    return;
+  Mapping mapping;
+  {
+    std::lock_guard<std::mutex> guard(mappings_guard);
+    auto it = mappings.find(ptr);
+    if (it == mappings.end())
+      return;
+    mapping = it->second;
+    mappings.erase(it);
+  }
+  mapped[(size_t)mapping.pages] -= mapping.size;
+  munmap(ptr, mapping.size);
+}
+
+Pages pages_of(const void *ptr) {
+  std::lock_guard<std::mutex> guard(mappings_guard);
+  auto it = mappings.find(ptr);
+  return it == mappings.end() ? Pages::DEFAULT : it->second.pages;
+}
+
+size_t mapped_size(Pages pages) { return mapped[(size_t)pages]; }
+
+size_t mapped_size_of(const void *ptr) {
+  std::lock_guard<std::mutex> guard(mappings_guard);
+  auto it = mappings.find(ptr);
+  return it == mappings.end() ? 0 : it->second.size;
+}
+
+void advise(void *ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+  if (!enabled() || size < HUGE_PAGE_SIZE)
+    return;
+  // The range is rounded inwards, the buffers allocated with malloc share
+  // their first and last huge pages with other allocations.
+  auto begin = round_up((uintptr_t)ptr, HUGE_PAGE_SIZE);
+  auto end = ((uintptr_t)ptr + size) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  // Best effort, the advice fails on memory not mapped anonymously.
+  if (begin < end)
+    madvise((void *)begin, end - begin, MADV_HUGEPAGE);
+#endif
+}
+
+} // namespace huge_pages
+} // namespace concretelang
+} // namespace mlir
@@ -0,0 +1,76 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+// Leveled operations on lwe ciphertexts.
+//
+// This file is self-contained on purpose: besides being part of the runtime
+// library, it is compiled to LLVM bitcode which is linked into the circuits by
+// the compiler, such that these operations are inlined and vectorized in the
+// loops of the generated code. The semantics must be kept identical to the
+// ones of the linear operations of concrete-cpu.
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+
+void memref_add_lwe_ciphertexts_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t *ct1_allocated, uint64_t *ct1_aligned,
+    uint64_t ct1_offset, uint64_t ct1_size, uint64_t ct1_stride) {
+  assert(out_size == ct0_size && out_size == ct1_size &&
+         "size of lwe buffer are incompatible");
+  uint64_t *out = out_aligned + out_offset;
+  const uint64_t *ct0 = ct0_aligned + ct0_offset;
+  const uint64_t *ct1 = ct1_aligned + ct1_offset;
+  for (size_t i = 0; i < out_size; i++) {
+    out[i] = ct0[i] + ct1[i];
+  }
+}
+
+void memref_add_plaintext_lwe_ciphertext_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t plaintext) {
+  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
+  uint64_t *out = out_aligned + out_offset;
+  const uint64_t *ct0 = ct0_aligned + ct0_offset;
+  for (size_t i = 0; i < out_size; i++) {
+    out[i] = ct0[i];
+  }
+  // The plaintext is added to the body, i.e. the last element.
+  out[out_size - 1] += plaintext;
+}
+
+void memref_mul_cleartext_lwe_ciphertext_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t cleartext) {
+  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
+  uint64_t *out = out_aligned + out_offset;
+  const uint64_t *ct0 = ct0_aligned + ct0_offset;
+  for (size_t i = 0; i < out_size; i++) {
+    out[i] = ct0[i] * cleartext;
+  }
+}
+
+void memref_negate_lwe_ciphertext_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride) {
+  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
+  uint64_t *out = out_aligned + out_offset;
+  const uint64_t *ct0 = ct0_aligned + ct0_offset;
+  for (size_t i = 0; i < out_size; i++) {
+    out[i] = -ct0[i];
+  }
+}
+}
@@ -0,0 +1,239 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include "concretelang/Runtime/numa.h"
+#include "concretelang/Runtime/huge_pages.h"
+#include <algorithm>
+#include <errno.h>
+#include <fstream>
+#ifdef CONCRETELANG_HWLOC_SUPPORT
+#include <hwloc.h>
+#endif
+#include <omp.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+
+namespace mlir {
+namespace concretelang {
+namespace numa {
+namespace {
+
+bool env_flag(const char *name) {
+  char *env = getenv(name);
+  return env != nullptr &&
+         (!strncmp(env, "True", 4) || !strncmp(env, "true", 4) ||
+          !strncmp(env, "On", 2) || !strncmp(env, "on", 2) ||
+          !strncmp(env, "1", 1));
+}
+
+#ifdef CONCRETELANG_HWLOC_SUPPORT
+struct Topology {
+  Topology() {
+    hwloc_topology_init(&topology);
+    hwloc_topology_load(topology);
+    int nbNodes = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NUMANODE);
+    for (int i = 0; i < nbNodes; i++)
+      nodes.push_back(hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, i));
+
+    // The logical order of hwloc enumerates the cores node by node.
+    int nbCores = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_CORE);
+    for (int i = 0; i < nbCores; i++) {
+      auto core = hwloc_get_obj_by_type(topology, HWLOC_OBJ_CORE, i);
+      cores.push_back(core);
+      coreNodes.push_back(node_of(core->cpuset));
+    }
+    int nbPUs = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_PU);
+    for (int i = 0; i < nbPUs; i++) {
+      auto pu = hwloc_get_obj_by_type(topology, HWLOC_OBJ_PU, i);
+      if (pu->os_index >= cpuNodes.size())
+        cpuNodes.resize(pu->os_index + 1, 0);
+      cpuNodes[pu->os_index] = node_of(pu->cpuset);
+    }
+  }
+
+  ~Topology() { hwloc_topology_destroy(topology); }
+
+  /// Returns the index of the first node whose cores intersect `cpuset`.
+  size_t node_of(hwloc_const_cpuset_t cpuset) {
+    for (size_t i = 0; i < nodes.size(); i++)
+      if (hwloc_bitmap_intersects(nodes[i]->cpuset, cpuset))
+        return i;
+    return 0;
+  }
+
+  hwloc_topology_t topology;
+  std::vector<hwloc_obj_t> nodes;
+  std::vector<hwloc_obj_t> cores;
+  std::vector<size_t> coreNodes;
+  /// The node of every cpu, by OS index.
+  std::vector<size_t> cpuNodes;
+};
+
+Topology &get_topology() {
+  static Topology topology;
+  return topology;
+}
+
+/// The node the calling thread is pinned to, if pinned.
+thread_local int pinned_node = -1;
+
+/// Returns the free memory of the node `node` in bytes, or SIZE_MAX if
+/// unknown.
+size_t free_memory(size_t node) {
+#ifdef __linux__
+  std::ifstream meminfo("/sys/devices/system/node/node" +
+                        std::to_string(get_topology().nodes[node]->os_index) +
+                        "/meminfo");
+  std::string line;
+  while (std::getline(meminfo, line)) {
+    // e.g. "Node 0 MemFree:         1234 kB"
+    auto field = line.find("MemFree:");
+    if (field != std::string::npos)
+      return strtoull(line.c_str() + field + strlen("MemFree:"), nullptr, 10) *
+             1024;
+  }
+#endif
+  return SIZE_MAX;
+}
+#endif
+
+} // namespace
+
+bool replication_enabled() {
+  static bool enabled = env_flag("CONCRETE_NUMA_REPLICATION");
+  return enabled;
+}
+
+bool pinning_enabled() {
+  static bool enabled = env_flag("CONCRETE_PIN_THREADS");
+  return enabled;
+}
+
+// Without hwloc the machine is seen as a single node, whose threads are never
+// pinned.
+#ifdef CONCRETELANG_HWLOC_SUPPORT
+size_t num_nodes() {
+  static size_t nbNodes = std::max<size_t>(get_topology().nodes.size(), 1);
+  return nbNodes;
+}
+
+size_t current_node() {
+  if (pinned_node >= 0)
+    return pinned_node;
+  if (num_nodes() == 1)
+    return 0;
+  auto &topology = get_topology();
+#ifdef __linux__
+  int cpu = sched_getcpu();
+#else
+  int cpu = -1;
+  hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
+  if (hwloc_get_last_cpu_location(topology.topology, cpuset,
+                                  HWLOC_CPUBIND_THREAD) == 0)
+    cpu = hwloc_bitmap_first(cpuset);
+  hwloc_bitmap_free(cpuset);
+#endif
+  if (cpu < 0 || (size_t)cpu >= topology.cpuNodes.size())
+    return 0;
+  return topology.cpuNodes[cpu];
+}
+
+bool pin_current_thread(size_t index) {
+  auto &topology = get_topology();
+  if (topology.cores.empty())
+    return false;
+  index %= topology.cores.size();
+  if (hwloc_set_cpubind(topology.topology, topology.cores[index]->cpuset,
+                        HWLOC_CPUBIND_THREAD) != 0)
+    return false;
+  pinned_node = topology.coreNodes[index];
+  return true;
+}
+
+int node_of_area(const void *ptr, size_t size) {
+  auto &topology = get_topology();
+  hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+  int node = -1;
+  if (hwloc_get_area_memlocation(topology.topology, ptr, size, nodeset,
+                                 HWLOC_MEMBIND_BYNODESET) == 0 &&
+      hwloc_bitmap_weight(nodeset) == 1) {
+    for (size_t i = 0; i < topology.nodes.size(); i++)
+      if (hwloc_bitmap_isequal(topology.nodes[i]->nodeset, nodeset))
+        node = i;
+  }
+  hwloc_bitmap_free(nodeset);
+  return node;
+}
+
+void *allocate_on_node(size_t size, size_t node) {
+  auto &topology = get_topology();
+  // The pages bound to a node are only allocated when first touched, and a
+  // node short of memory would fail the first write to the area rather than
+  // its allocation, so the memory of the node is checked, and the pages are
+  // populated, here.
+  if (node >= topology.nodes.size() || size > free_memory(node))
+    return nullptr;
+  auto ptr = huge_pages::allocate(size);
+  if (ptr == nullptr)
+    return nullptr;
+  if (hwloc_set_area_membind(topology.topology, ptr, size,
+                             topology.nodes[node]->nodeset, HWLOC_MEMBIND_BIND,
+                             HWLOC_MEMBIND_BYNODESET) != 0) {
+    huge_pages::deallocate(ptr);
+    return nullptr;
+  }
+#ifdef MADV_POPULATE_WRITE
+  // The kernels older than 5.14 reject the advice, and only have the check of
+  // the free memory.
+  if (madvise(ptr, size, MADV_POPULATE_WRITE) != 0 && errno != EINVAL) {
+    huge_pages::deallocate(ptr);
+    return nullptr;
+  }
+#endif
+  return ptr;
+}
+#else
+size_t num_nodes() { return 1; }
+
+size_t current_node() { return 0; }
+
+bool pin_current_thread(size_t index) { return false; }
+
+int node_of_area(const void *ptr, size_t size) { return 0; }
+
+void *allocate_on_node(size_t size, size_t node) {
+  return node == 0 ? huge_pages::allocate(size) : nullptr;
+}
+#endif
+
+void pin_openmp_workers() {
+  // Every thread starting parallel regions has its own workers, which are
+  // pinned once.
+  static thread_local bool pinned = false;
+  if (pinned)
+    return;
+  pinned = true;
+  // The placement requested by the user takes precedence.
+  if (!pinning_enabled() || getenv("OMP_PLACES") != nullptr ||
+      getenv("OMP_PROC_BIND") != nullptr)
+    return;
+  // The calling thread is the primary thread of the team, and stays where it
+  // is, the workers are pinned to the cores following the first one, in the
+  // order of the team.
+#pragma omp parallel
+  if (omp_get_thread_num() != 0)
+    pin_current_thread(omp_get_thread_num());
+}
+
+void free_on_node(void *ptr) { huge_pages::deallocate(ptr); }
+
+} // namespace numa
+} // namespace concretelang
+} // namespace mlir
@@ -8,13 +8,18 @@
 #include "concrete-cpu.h"
 #include "concrete/curves.h"
 #include "concretelang/Common/Csprng.h"
+#include "concretelang/Runtime/DFRuntime.hpp"
 #include "concretelang/Runtime/wrappers.h"
 #include "concretelang/Support/V0Parameters.h"
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <cmath>
+#include <map>
+#include <omp.h>
 #include <random>
-
-using concretelang::csprng::SoftCSPRNG;
+#include <tuple>
+#include <vector>
 
 inline concrete::SecurityCurve *security_curve() {
   return concrete::getSecurityCurve(128, concrete::BINARY);
@@ -25,18 +30,111 @@ uint64_t from_torus(double torus) {
   return (uint64_t)round(torus * pow(2, 64));
 }
 
-// TODO: what's the overhead of creating a csprng everytime? Should we have a
-// single one?
+/// Returns the generator of the calling thread. Generators are seeded from a
+/// global counter, such that single threaded simulations are reproducible.
+static std::mt19937_64 &thread_generator() {
+  static std::atomic<uint64_t> next_seed(0);
+  thread_local std::mt19937_64 generator(next_seed++);
+  return generator;
+}
+
 uint64_t gaussian_noise(double mean, double variance) {
-  uint64_t random_gaussian_buff[2];
-  auto csprng = SoftCSPRNG(0);
-  concrete_cpu_fill_with_random_gaussian(random_gaussian_buff, 2, variance,
-                                         csprng.ptr);
-  return random_gaussian_buff[0];
+  thread_local std::normal_distribution<double> distribution(0., 1.);
+  double torus = mean + distribution(thread_generator()) * std::sqrt(variance);
+  // Wraps the sample around the torus before the conversion to integers.
+  double scaled = std::round(std::ldexp(torus - std::floor(torus), 64));
+  if (scaled >= std::ldexp(1., 64))
+    return 0;
+  return (uint64_t)scaled;
+}
+
+/// Returns the value computed by `compute` for the parameters `key`, which is
+/// computed once per thread. The noise model is expensive compared to the
+/// simulated operations, while circuits only use a handful of parameter sets.
+template <typename Key, typename Compute>
+static double cached_variance(std::map<Key, double> &cache, Key key,
+                              Compute compute) {
+  auto it = cache.find(key);
+  if (it == cache.end())
+    it = cache.insert({key, compute()}).first;
+  return it->second;
+}
+
+static double encryption_variance(uint32_t lwe_dim) {
+  thread_local std::map<uint32_t, double> cache;
+  return cached_variance(cache, lwe_dim, [&]() {
+    return security_curve()->getVariance(1, lwe_dim, 64);
+  });
+}
+
+static double keyswitch_variance(uint32_t level, uint32_t base_log,
+                                 uint32_t input_lwe_dim,
+                                 uint32_t output_lwe_dim) {
+  thread_local std::map<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>,
+                        double>
+      cache;
+  return cached_variance(
+      cache, std::make_tuple(level, base_log, input_lwe_dim, output_lwe_dim),
+      [&]() {
+        double variance_ksk =
+            security_curve()->getVariance(1, output_lwe_dim, 64);
+        return concrete_cpu_variance_keyswitch(input_lwe_dim, base_log, level,
+                                               64, variance_ksk);
+      });
+}
+
+static double modulus_switching_variance(uint32_t input_lwe_dim,
+                                         uint32_t poly_size) {
+  thread_local std::map<std::tuple<uint32_t, uint32_t>, double> cache;
+  return cached_variance(
+      cache, std::make_tuple(input_lwe_dim, poly_size), [&]() {
+        return concrete_cpu_estimate_modulus_switching_noise_with_binary_key(
+            input_lwe_dim, log2(poly_size), 64);
+      });
+}
+
+static double blind_rotate_variance(uint32_t input_lwe_dim,
+                                    uint32_t poly_size, uint32_t level,
+                                    uint32_t base_log, uint32_t glwe_dim) {
+  thread_local std::map<
+      std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>, double>
+      cache;
+  return cached_variance(
+      cache,
+      std::make_tuple(input_lwe_dim, poly_size, level, base_log, glwe_dim),
+      [&]() {
+        double variance_bsk =
+            security_curve()->getVariance(glwe_dim, poly_size, 64);
+        return concrete_cpu_variance_blind_rotate(
+            input_lwe_dim, glwe_dim, poly_size, base_log, level, 64,
+            mlir::concretelang::optimizer::DEFAULT_FFT_PRECISION,
+            variance_bsk);
+      });
+}
+
+/// Calls `body(i)` for every `i` in [0, size), splitting the range over the
+/// OpenMP threads if it is large enough, each thread processing at least
+/// `min_chunk_size` indices. Callers already running in parallel, in an OpenMP
+/// region or in a dataflow task, process the range themselves, as the other
+/// cores are busy.
+template <typename Body>
+static void parallel_for(uint64_t size, Body body,
+                         uint64_t min_chunk_size = 256) {
+  uint64_t num_threads =
+      std::min<uint64_t>(omp_get_max_threads(), size / min_chunk_size);
+  if (num_threads <= 1 || omp_in_parallel() ||
+      mlir::concretelang::dfr::_dfr_in_task()) {
+    for (uint64_t i = 0; i < size; i++)
+      body(i);
+    return;
+  }
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+  for (uint64_t i = 0; i < size; i++)
+    body(i);
 }
 
 uint64_t sim_encrypt_lwe_u64(uint64_t message, uint32_t lwe_dim, void *csprng) {
-  double variance = security_curve()->getVariance(1, lwe_dim, 64);
+  double variance = encryption_variance(lwe_dim);
   uint64_t random_gaussian_buff[2];
   concrete_cpu_fill_with_random_gaussian(random_gaussian_buff, 2, variance,
                                          (Csprng *)csprng);
@@ -47,25 +145,32 @@ uint64_t sim_encrypt_lwe_u64(uint64_t message, uint32_t lwe_dim, void *csprng) {
 uint64_t sim_keyswitch_lwe_u64(uint64_t plaintext, uint32_t level,
                                uint32_t base_log, uint32_t input_lwe_dim,
                                uint32_t output_lwe_dim) {
-  double variance_ksk = security_curve()->getVariance(1, output_lwe_dim, 64);
-  double variance = concrete_cpu_variance_keyswitch(input_lwe_dim, base_log,
-                                                    level, 64, variance_ksk);
+  double variance =
+      keyswitch_variance(level, base_log, input_lwe_dim, output_lwe_dim);
   uint64_t ks_noise = gaussian_noise(0, variance);
   return plaintext + ks_noise;
 }
 
-uint64_t sim_bootstrap_lwe_u64(uint64_t plaintext, uint64_t *tlu_allocated,
-                               uint64_t *tlu_aligned, uint64_t tlu_offset,
-                               uint64_t tlu_size, uint64_t tlu_stride,
-                               uint32_t input_lwe_dim, uint32_t poly_size,
-                               uint32_t level, uint32_t base_log,
-                               uint32_t glwe_dim) {
-  auto tlu = tlu_aligned + tlu_offset;
+void sim_batched_keyswitch_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint32_t level, uint32_t base_log,
+    uint32_t input_lwe_dim, uint32_t output_lwe_dim) {
+  assert(out_size == in_size);
+  double variance =
+      keyswitch_variance(level, base_log, input_lwe_dim, output_lwe_dim);
+  parallel_for(out_size, [=](uint64_t i) {
+    out_aligned[out_offset + i * out_stride] =
+        in_aligned[in_offset + i * in_stride] + gaussian_noise(0, variance);
+  });
+}
 
-  // modulus switching
-  double variance_ms =
-      concrete_cpu_estimate_modulus_switching_noise_with_binary_key(
-          input_lwe_dim, log2(poly_size), 64);
+/// Simulates a bootstrap of `plaintext` with the lookup table `tlu`, using the
+/// precomputed variances of the modulus switching and of the blind rotation.
+static uint64_t simulate_bootstrap(uint64_t plaintext, const uint64_t *tlu,
+                                   uint64_t tlu_stride, uint32_t poly_size,
+                                   double variance_ms, double variance_br) {
   uint64_t shift = (64 - log2(poly_size) - 2);
   // mod_switch noise
   auto noise = gaussian_noise(0, variance_ms);
@@ -84,15 +189,67 @@ uint64_t sim_bootstrap_lwe_u64(uint64_t plaintext, uint64_t *tlu_allocated,
   // instead of doing a plynomial multiplication, then extracting the first
   // coeff, we directly extract the appropriate coeff from the tlu.
   if (mod_switched < poly_size)
-    out = tlu[mod_switched];
+    out = tlu[mod_switched * tlu_stride];
   else
-    out = -tlu[mod_switched % poly_size];
+    out = -tlu[(mod_switched % poly_size) * tlu_stride];
 
-  double variance_bsk = security_curve()->getVariance(glwe_dim, poly_size, 64);
-  double variance = concrete_cpu_variance_blind_rotate(
-      input_lwe_dim, glwe_dim, poly_size, base_log, level, 64,
-      mlir::concretelang::optimizer::DEFAULT_FFT_PRECISION, variance_bsk);
-  return out + gaussian_noise(0, variance);
+  return out + gaussian_noise(0, variance_br);
+}
+
+uint64_t sim_bootstrap_lwe_u64(uint64_t plaintext, uint64_t *tlu_allocated,
+                               uint64_t *tlu_aligned, uint64_t tlu_offset,
+                               uint64_t tlu_size, uint64_t tlu_stride,
+                               uint32_t input_lwe_dim, uint32_t poly_size,
+                               uint32_t level, uint32_t base_log,
+                               uint32_t glwe_dim) {
+  return simulate_bootstrap(
+      plaintext, tlu_aligned + tlu_offset, tlu_stride, poly_size,
+      modulus_switching_variance(input_lwe_dim, poly_size),
+      blind_rotate_variance(input_lwe_dim, poly_size, level, base_log,
+                            glwe_dim));
+}
+
+void sim_batched_bootstrap_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint64_t *tlu_allocated, uint64_t *tlu_aligned,
+    uint64_t tlu_offset, uint64_t tlu_size, uint64_t tlu_stride,
+    uint32_t input_lwe_dim, uint32_t poly_size, uint32_t level,
+    uint32_t base_log, uint32_t glwe_dim) {
+  assert(out_size == in_size);
+  double variance_ms = modulus_switching_variance(input_lwe_dim, poly_size);
+  double variance_br =
+      blind_rotate_variance(input_lwe_dim, poly_size, level, base_log,
+                            glwe_dim);
+  const uint64_t *tlu = tlu_aligned + tlu_offset;
+  parallel_for(out_size, [=](uint64_t i) {
+    out_aligned[out_offset + i * out_stride] =
+        simulate_bootstrap(in_aligned[in_offset + i * in_stride], tlu,
+                           tlu_stride, poly_size, variance_ms, variance_br);
+  });
+}
+
+void sim_batched_mapped_bootstrap_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
+    uint64_t *in_aligned, uint64_t in_offset, uint64_t in_size,
+    uint64_t in_stride, uint64_t *tlu_allocated, uint64_t *tlu_aligned,
+    uint64_t tlu_offset, uint64_t tlu_size0, uint64_t tlu_size1,
+    uint64_t tlu_stride0, uint64_t tlu_stride1, uint32_t input_lwe_dim,
+    uint32_t poly_size, uint32_t level, uint32_t base_log,
+    uint32_t glwe_dim) {
+  assert(out_size == in_size && out_size == tlu_size0);
+  double variance_ms = modulus_switching_variance(input_lwe_dim, poly_size);
+  double variance_br =
+      blind_rotate_variance(input_lwe_dim, poly_size, level, base_log,
+                            glwe_dim);
+  parallel_for(out_size, [=](uint64_t i) {
+    out_aligned[out_offset + i * out_stride] = simulate_bootstrap(
+        in_aligned[in_offset + i * in_stride],
+        tlu_aligned + tlu_offset + i * tlu_stride0, tlu_stride1, poly_size,
+        variance_ms, variance_br);
+  });
 }
 
 void sim_wop_pbs_crt(
@@ -181,6 +338,105 @@ void sim_wop_pbs_crt(
 
 uint64_t sim_neg_lwe_u64(uint64_t plaintext) { return ~plaintext + 1; }
 
+/// The minimal number of elements processed by each thread in the batched
+/// leveled operations, which are bound by the memory bandwidth rather than by
+/// the computation.
+static const uint64_t LEVELED_MIN_CHUNK_SIZE = 1 << 16;
+
+void sim_batched_add_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
+                             uint64_t out_offset, uint64_t out_size,
+                             uint64_t out_stride, uint64_t *ct0_allocated,
+                             uint64_t *ct0_aligned, uint64_t ct0_offset,
+                             uint64_t ct0_size, uint64_t ct0_stride,
+                             uint64_t *ct1_allocated, uint64_t *ct1_aligned,
+                             uint64_t ct1_offset, uint64_t ct1_size,
+                             uint64_t ct1_stride) {
+  assert(out_size == ct0_size && out_size == ct1_size);
+  parallel_for(
+      out_size,
+      [=](uint64_t i) {
+        out_aligned[out_offset + i * out_stride] =
+            ct0_aligned[ct0_offset + i * ct0_stride] +
+            ct1_aligned[ct1_offset + i * ct1_stride];
+      },
+      LEVELED_MIN_CHUNK_SIZE);
+}
+
+void sim_batched_add_plaintext_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t *pt_allocated, uint64_t *pt_aligned,
+    uint64_t pt_offset, uint64_t pt_size, uint64_t pt_stride) {
+  sim_batched_add_lwe_u64(out_allocated, out_aligned, out_offset, out_size,
+                          out_stride, ct0_allocated, ct0_aligned, ct0_offset,
+                          ct0_size, ct0_stride, pt_allocated, pt_aligned,
+                          pt_offset, pt_size, pt_stride);
+}
+
+void sim_batched_add_plaintext_cst_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t plaintext) {
+  assert(out_size == ct0_size);
+  parallel_for(
+      out_size,
+      [=](uint64_t i) {
+        out_aligned[out_offset + i * out_stride] =
+            ct0_aligned[ct0_offset + i * ct0_stride] + plaintext;
+      },
+      LEVELED_MIN_CHUNK_SIZE);
+}
+
+void sim_batched_mul_cleartext_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t *cleartext_allocated,
+    uint64_t *cleartext_aligned, uint64_t cleartext_offset,
+    uint64_t cleartext_size, uint64_t cleartext_stride) {
+  assert(out_size == ct0_size && out_size == cleartext_size);
+  parallel_for(
+      out_size,
+      [=](uint64_t i) {
+        out_aligned[out_offset + i * out_stride] =
+            ct0_aligned[ct0_offset + i * ct0_stride] *
+            cleartext_aligned[cleartext_offset + i * cleartext_stride];
+      },
+      LEVELED_MIN_CHUNK_SIZE);
+}
+
+void sim_batched_mul_cleartext_cst_lwe_u64(
+    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
+    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
+    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
+    uint64_t ct0_stride, uint64_t cleartext) {
+  assert(out_size == ct0_size);
+  parallel_for(
+      out_size,
+      [=](uint64_t i) {
+        out_aligned[out_offset + i * out_stride] =
+            ct0_aligned[ct0_offset + i * ct0_stride] * cleartext;
+      },
+      LEVELED_MIN_CHUNK_SIZE);
+}
+
+void sim_batched_neg_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
+                             uint64_t out_offset, uint64_t out_size,
+                             uint64_t out_stride, uint64_t *ct0_allocated,
+                             uint64_t *ct0_aligned, uint64_t ct0_offset,
+                             uint64_t ct0_size, uint64_t ct0_stride) {
+  assert(out_size == ct0_size);
+  parallel_for(
+      out_size,
+      [=](uint64_t i) {
+        out_aligned[out_offset + i * out_stride] =
+            sim_neg_lwe_u64(ct0_aligned[ct0_offset + i * ct0_stride]);
+      },
+      LEVELED_MIN_CHUNK_SIZE);
+}
+
 void sim_encode_expand_lut_for_boostrap(
     uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
     uint64_t out_size, uint64_t out_stride, uint64_t *in_allocated,
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "concretelang/Common/CRT.h"
+#include "concretelang/Runtime/huge_pages.h"
 #include "concretelang/Runtime/wrappers.h"
 
 #ifdef CONCRETELANG_CUDA_SUPPORT
@@ -546,55 +547,6 @@ void memref_encode_lut_for_crt_woppbs(
   }
 }
 
-void memref_add_lwe_ciphertexts_u64(
-    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
-    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
-    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
-    uint64_t ct0_stride, uint64_t *ct1_allocated, uint64_t *ct1_aligned,
-    uint64_t ct1_offset, uint64_t ct1_size, uint64_t ct1_stride) {
-  assert(out_size == ct0_size && out_size == ct1_size &&
-         "size of lwe buffer are incompatible");
-  size_t lwe_dimension = out_size - 1;
-  concrete_cpu_add_lwe_ciphertext_u64(out_aligned + out_offset,
-                                      ct0_aligned + ct0_offset,
-                                      ct1_aligned + ct1_offset, lwe_dimension);
-}
-
-void memref_add_plaintext_lwe_ciphertext_u64(
-    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
-    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
-    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
-    uint64_t ct0_stride, uint64_t plaintext) {
-  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
-  size_t lwe_dimension = out_size - 1;
-  concrete_cpu_add_plaintext_lwe_ciphertext_u64(out_aligned + out_offset,
-                                                ct0_aligned + ct0_offset,
-                                                plaintext, lwe_dimension);
-}
-
-void memref_mul_cleartext_lwe_ciphertext_u64(
-    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
-    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
-    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
-    uint64_t ct0_stride, uint64_t cleartext) {
-  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
-  size_t lwe_dimension = out_size - 1;
-  concrete_cpu_mul_cleartext_lwe_ciphertext_u64(out_aligned + out_offset,
-                                                ct0_aligned + ct0_offset,
-                                                cleartext, lwe_dimension);
-}
-
-void memref_negate_lwe_ciphertext_u64(
-    uint64_t *out_allocated, uint64_t *out_aligned, uint64_t out_offset,
-    uint64_t out_size, uint64_t out_stride, uint64_t *ct0_allocated,
-    uint64_t *ct0_aligned, uint64_t ct0_offset, uint64_t ct0_size,
-    uint64_t ct0_stride) {
-  assert(out_size == ct0_size && "size of lwe buffer are incompatible");
-  size_t lwe_dimension = {out_size - 1};
-  concrete_cpu_negate_lwe_ciphertext_u64(
-      out_aligned + out_offset, ct0_aligned + ct0_offset, lwe_dimension);
-}
-
 void memref_keyswitch_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
                               uint64_t out_offset, uint64_t out_size,
                               uint64_t out_stride, uint64_t *ct0_allocated,
@@ -608,6 +560,26 @@ void memref_keyswitch_lwe_u64(uint64_t *out_allocated, uint64_t *out_aligned,
   assert(out_stride == 1 && ct0_stride == 1);
   // Get keyswitch key
   const uint64_t *keyswitch_key = context->keyswitch_key_buffer(ksk_index);
+  // Keys on a 32 bits modulus produce ciphertexts in the most significant
+  // bits of the output, which can be bootstrapped as 64 bits ciphertexts.
+  if (context->keyswitch_key_precision(ksk_index) == 32) {
+    size_t scratch_size;
+    size_t scratch_align;
+    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key_scratch(
+        &scratch_size, &scratch_align, input_dimension, output_dimension);
+    // The scratch only holds 32 bits ciphertexts, it is kept per thread such
+    // that keyswitches do not allocate.
+    assert(scratch_align <= alignof(uint32_t));
+    thread_local std::vector<uint32_t> scratch;
+    if (scratch.size() * sizeof(uint32_t) < scratch_size)
+      scratch.resize((scratch_size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    concrete_cpu_keyswitch_lwe_ciphertext_u64_with_u32_key(
+        out_aligned + out_offset, ct0_aligned + ct0_offset,
+        (const uint32_t *)keyswitch_key, decomposition_level_count,
+        decomposition_base_log, input_dimension, output_dimension,
+        (uint8_t *)scratch.data(), scratch_size);
+    return;
+  }
   // Get stack parameter
   concrete_cpu_keyswitch_lwe_ciphertext_u64(
       out_aligned + out_offset, ct0_aligned + ct0_offset, keyswitch_key,
@@ -719,6 +691,9 @@ void memref_batched_keyswitch_lwe_u64(
     uint64_t ct0_stride0, uint64_t ct0_stride1, uint32_t level,
     uint32_t base_log, uint32_t input_lwe_dim, uint32_t output_lwe_dim,
     uint32_t ksk_index, mlir::concretelang::RuntimeContext *context) {
+  mlir::concretelang::huge_pages::advise(out_aligned + out_offset,
+                                         out_size0 * out_size1 *
+                                             sizeof(uint64_t));
   for (size_t i = 0; i < ct0_size0; i++) {
     memref_keyswitch_lwe_u64(
         out_allocated + i * out_size1, out_aligned + i * out_size1, out_offset,
@@ -783,7 +758,9 @@ void memref_batched_bootstrap_lwe_u64(
     uint64_t tlu_stride, uint32_t input_lwe_dim, uint32_t poly_size,
     uint32_t level, uint32_t base_log, uint32_t glwe_dim, uint32_t bsk_index,
     mlir::concretelang::RuntimeContext *context) {
-
+  mlir::concretelang::huge_pages::advise(out_aligned + out_offset,
+                                         out_size0 * out_size1 *
+                                             sizeof(uint64_t));
   for (size_t i = 0; i < out_size0; i++) {
     memref_bootstrap_lwe_u64(
         out_allocated + i * out_size1, out_aligned + i * out_size1, out_offset,
@@ -806,6 +783,9 @@ void memref_batched_mapped_bootstrap_lwe_u64(
     uint32_t base_log, uint32_t glwe_dim, uint32_t bsk_index,
     mlir::concretelang::RuntimeContext *context) {
   assert(out_size0 == tlu_size0 && "Number of LUTs does not match batch size");
+  mlir::concretelang::huge_pages::advise(out_aligned + out_offset,
+                                         out_size0 * out_size1 *
+                                             sizeof(uint64_t));
   for (size_t i = 0; i < out_size0; i++) {
     memref_bootstrap_lwe_u64(
         out_allocated + i * out_size1, out_aligned + i * out_size1, out_offset,
@@ -898,6 +878,9 @@ void memref_wop_pbs_crt_buffer(
 
   const auto &fft = context->fft(bsk_index);
   auto bootstrap_key = context->fourier_bootstrap_key_buffer(bsk_index);
+  // The bit extraction reads the keyswitch key on 64 bits, the program info
+  // keeps the keyswitch keys of the wop-pbs on 64 bits.
+  assert(context->keyswitch_key_precision(ksk_index) == 64);
   auto keyswicth_key = context->keyswitch_key_buffer(ksk_index);
 
   for (int64_t i = crt_decomp_size - 1, extract_bits_output_offset = 0; i >= 0;
@@ -0,0 +1,448 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include "concretelang/ServerLib/BatchingServer.h"
+#include "capnp/any.h"
+#include "concrete-protocol.capnp.h"
+#include "concretelang/Common/Error.h"
+#include "concretelang/Common/Keysets.h"
+#include "concretelang/Common/Protocol.h"
+#include "concretelang/Common/Values.h"
+#include "concretelang/ServerLib/ServerLib.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+using concretelang::error::Result;
+using concretelang::error::StringError;
+using concretelang::keysets::ServerKeyset;
+using concretelang::protocol::dimensionsToProtoShape;
+using concretelang::protocol::Message;
+using concretelang::protocol::protoShapeToDimensions;
+using concretelang::values::Tensor;
+using concretelang::values::TransportValue;
+using concretelang::values::Value;
+
+namespace concretelang {
+namespace serverlib {
+
+/// Removes the leading dimension of a shape, after checking that it matches
+/// the batch size (or setting the batch size if not known yet).
+Result<Message<concreteprotocol::Shape>>
+removeBatchDimension(const Message<concreteprotocol::Shape> &shape,
+                     std::optional<size_t> &batchSize) {
+  auto dimensions = protoShapeToDimensions(shape);
+  if (dimensions.empty()) {
+    return StringError("Tried to unbatch a scalar gate.");
+  }
+  if (!batchSize.has_value()) {
+    batchSize = dimensions[0];
+  }
+  if (dimensions[0] != batchSize.value() || dimensions[0] == 0) {
+    return StringError("Tried to unbatch a gate with leading dimension ")
+           << dimensions[0] << " while the batch size is "
+           << batchSize.value();
+  }
+  dimensions.erase(dimensions.begin());
+  return dimensionsToProtoShape(dimensions);
+}
+
+/// Returns the gate info of a single element of a batched gate.
+Result<Message<concreteprotocol::GateInfo>>
+unbatchGateInfo(const Message<concreteprotocol::GateInfo> &gateInfo,
+                std::optional<size_t> &batchSize) {
+  Message<concreteprotocol::GateInfo> output = gateInfo;
+  auto rawInfo = output.asBuilder().getRawInfo();
+  OUTCOME_TRY(auto rawShape,
+              removeBatchDimension(rawInfo.asReader().getShape(), batchSize));
+  rawInfo.setShape(rawShape.asReader());
+
+  auto typeInfo = output.asBuilder().getTypeInfo();
+  if (typeInfo.hasLweCiphertext()) {
+    auto lweType = typeInfo.getLweCiphertext();
+    OUTCOME_TRY(auto abstractShape,
+                removeBatchDimension(lweType.asReader().getAbstractShape(),
+                                     batchSize));
+    OUTCOME_TRY(auto concreteShape,
+                removeBatchDimension(lweType.asReader().getConcreteShape(),
+                                     batchSize));
+    lweType.setAbstractShape(abstractShape.asReader());
+    lweType.setConcreteShape(concreteShape.asReader());
+  } else if (typeInfo.hasPlaintext()) {
+    auto plaintextType = typeInfo.getPlaintext();
+    OUTCOME_TRY(auto shape,
+                removeBatchDimension(plaintextType.asReader().getShape(),
+                                     batchSize));
+    plaintextType.setShape(shape.asReader());
+  } else if (typeInfo.hasIndex()) {
+    auto indexType = typeInfo.getIndex();
+    OUTCOME_TRY(auto shape, removeBatchDimension(
+                                indexType.asReader().getShape(), batchSize));
+    indexType.setShape(shape.asReader());
+  } else {
+    return StringError("Malformed gate info.");
+  }
+  return output;
+}
+
+/// Stacks the tensors of a batch along a new leading dimension. The batch is
+/// padded with copies of the first tensor up to the batch size.
+template <typename T>
+Result<Value> stackTensors(const std::vector<Value> &values,
+                           size_t batchSize) {
+  auto first = std::get_if<Tensor<T>>(&values[0].inner);
+  Tensor<T> output;
+  output.dimensions.push_back(batchSize);
+  output.dimensions.insert(output.dimensions.end(), first->dimensions.begin(),
+                           first->dimensions.end());
+  output.values.reserve(batchSize * first->values.size());
+  for (size_t i = 0; i < batchSize; i++) {
+    auto &value = values[i < values.size() ? i : 0];
+    auto tensor = std::get_if<Tensor<T>>(&value.inner);
+    if (tensor == nullptr || tensor->dimensions != first->dimensions) {
+      return StringError("Tried to batch values of incompatible types.");
+    }
+    output.values.insert(output.values.end(), tensor->values.begin(),
+                         tensor->values.end());
+  }
+  return Value{output};
+}
+
+Result<Value> stackValues(const std::vector<Value> &values, size_t batchSize) {
+  auto &first = values[0];
+  if (first.hasElementType<uint8_t>()) {
+    return stackTensors<uint8_t>(values, batchSize);
+  } else if (first.hasElementType<uint16_t>()) {
+    return stackTensors<uint16_t>(values, batchSize);
+  } else if (first.hasElementType<uint32_t>()) {
+    return stackTensors<uint32_t>(values, batchSize);
+  } else if (first.hasElementType<uint64_t>()) {
+    return stackTensors<uint64_t>(values, batchSize);
+  } else if (first.hasElementType<int8_t>()) {
+    return stackTensors<int8_t>(values, batchSize);
+  } else if (first.hasElementType<int16_t>()) {
+    return stackTensors<int16_t>(values, batchSize);
+  } else if (first.hasElementType<int32_t>()) {
+    return stackTensors<int32_t>(values, batchSize);
+  } else if (first.hasElementType<int64_t>()) {
+    return stackTensors<int64_t>(values, batchSize);
+  }
+  return StringError("Tried to batch values of unknown element type.");
+}
+
+/// Splits the `count` first elements of a tensor along its leading dimension.
+template <typename T>
+std::vector<Value> unstackTensor(const Tensor<T> &tensor, size_t count) {
+  auto dimensions = std::vector<size_t>(tensor.dimensions.begin() + 1,
+                                        tensor.dimensions.end());
+  auto sliceLength = tensor.values.size() / tensor.dimensions[0];
+  std::vector<Value> output;
+  output.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    auto begin = tensor.values.begin() + i * sliceLength;
+    output.push_back(Value{Tensor<T>(
+        typename Tensor<T>::Storage(begin, begin + sliceLength), dimensions)});
+  }
+  return output;
+}
+
+Result<std::vector<Value>> unstackValue(const Value &value, size_t count) {
+  auto dimensions = value.getDimensions();
+  if (dimensions.empty() || dimensions[0] < count) {
+    return StringError("Tried to unbatch a value without batch dimension.");
+  }
+  if (auto tensor = std::get_if<Tensor<uint8_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<uint16_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<uint32_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<uint64_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<int8_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<int16_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<int32_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  } else if (auto tensor = std::get_if<Tensor<int64_t>>(&value.inner)) {
+    return unstackTensor(*tensor, count);
+  }
+  return StringError("Tried to unbatch a value of unknown element type.");
+}
+
+/// Returns the signature of a single request of a batched circuit, and sets
+/// `batchSize` to the leading dimension of its gates.
+Result<Message<concreteprotocol::CircuitInfo>>
+unbatchCircuitInfo(const Message<concreteprotocol::CircuitInfo> &circuitInfo,
+                   std::optional<size_t> &batchSize) {
+  auto batchedInfo = circuitInfo.asReader();
+  if (batchedInfo.getInputs().size() == 0 ||
+      batchedInfo.getOutputs().size() == 0) {
+    return StringError(
+        "Tried to create a batching server for a circuit without inputs or "
+        "outputs.");
+  }
+
+  Message<concreteprotocol::CircuitInfo> unbatchedInfo;
+  unbatchedInfo.asBuilder().setName(batchedInfo.getName());
+  auto inputs =
+      unbatchedInfo.asBuilder().initInputs(batchedInfo.getInputs().size());
+  for (size_t i = 0; i < batchedInfo.getInputs().size(); i++) {
+    OUTCOME_TRY(auto gateInfo,
+                unbatchGateInfo(batchedInfo.getInputs()[i], batchSize));
+    inputs.setWithCaveats(i, gateInfo.asReader());
+  }
+  auto outputs =
+      unbatchedInfo.asBuilder().initOutputs(batchedInfo.getOutputs().size());
+  for (size_t i = 0; i < batchedInfo.getOutputs().size(); i++) {
+    OUTCOME_TRY(auto gateInfo,
+                unbatchGateInfo(batchedInfo.getOutputs()[i], batchSize));
+    outputs.setWithCaveats(i, gateInfo.asReader());
+  }
+  return unbatchedInfo;
+}
+
+/// Returns whether two lists of gates are the same.
+bool sameGates(capnp::List<concreteprotocol::GateInfo>::Reader gates,
+               capnp::List<concreteprotocol::GateInfo>::Reader otherGates) {
+  if (gates.size() != otherGates.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < gates.size(); i++) {
+    if ((capnp::AnyStruct::Reader)gates[i] !=
+        (capnp::AnyStruct::Reader)otherGates[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Result<std::unique_ptr<BatchingServer>>
+BatchingServer::create(std::vector<ServerCircuit> batchedCircuits,
+                       ServerKeyset serverKeyset,
+                       BatchingServerOptions options, bool useSimulation) {
+  if (batchedCircuits.empty()) {
+    return StringError("Tried to create a batching server without circuits.");
+  }
+
+  // We derive the signature of a single request from the batched ones, which
+  // must all agree on it.
+  struct Batched {
+    size_t batchSize;
+    ServerCircuit circuit;
+    Message<concreteprotocol::CircuitInfo> unbatchedInfo;
+  };
+  std::vector<Batched> batched;
+  for (auto &batchedCircuit : batchedCircuits) {
+    std::optional<size_t> batchSize;
+    OUTCOME_TRY(auto unbatchedInfo,
+                unbatchCircuitInfo(batchedCircuit.getCircuitInfo(),
+                                   batchSize));
+    batched.push_back({batchSize.value(), batchedCircuit, unbatchedInfo});
+  }
+  std::stable_sort(batched.begin(), batched.end(),
+                   [](const Batched &lhs, const Batched &rhs) {
+                     return lhs.batchSize < rhs.batchSize;
+                   });
+
+  auto &unbatchedInfo = batched[0].unbatchedInfo;
+  std::vector<size_t> batchSizes;
+  batchedCircuits.clear();
+  for (auto &circuit : batched) {
+    if (!batchSizes.empty() && circuit.batchSize == batchSizes.back()) {
+      return StringError("Tried to create a batching server with two "
+                         "circuits of batch size ")
+             << circuit.batchSize;
+    }
+    if (!sameGates(unbatchedInfo.asReader().getInputs(),
+                   circuit.unbatchedInfo.asReader().getInputs()) ||
+        !sameGates(unbatchedInfo.asReader().getOutputs(),
+                   circuit.unbatchedInfo.asReader().getOutputs())) {
+      return StringError("Tried to create a batching server with circuits of "
+                         "different un-batched signatures.");
+    }
+    batchSizes.push_back(circuit.batchSize);
+    batchedCircuits.push_back(circuit.circuit);
+  }
+
+  return std::unique_ptr<BatchingServer>(
+      new BatchingServer(batchedCircuits, serverKeyset, options, useSimulation,
+                         batchSizes, unbatchedInfo));
+}
+
+Result<std::unique_ptr<BatchingServer>>
+BatchingServer::create(ServerCircuit batchedCircuit, ServerKeyset serverKeyset,
+                       BatchingServerOptions options, bool useSimulation) {
+  return create(std::vector<ServerCircuit>{batchedCircuit}, serverKeyset,
+                options, useSimulation);
+}
+
+BatchingServer::BatchingServer(
+    std::vector<ServerCircuit> batchedCircuits, ServerKeyset serverKeyset,
+    BatchingServerOptions options, bool useSimulation,
+    std::vector<size_t> batchSizes,
+    Message<concreteprotocol::CircuitInfo> unbatchedCircuitInfo)
+    : batchedCircuits(batchedCircuits), serverKeyset(serverKeyset),
+      options(options), useSimulation(useSimulation), batchSizes(batchSizes),
+      unbatchedCircuitInfo(unbatchedCircuitInfo), stopping(false) {
+  worker = std::thread([this]() { run(); });
+}
+
+BatchingServer::~BatchingServer() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  worker.join();
+}
+
+Result<void> BatchingServer::verify(const std::vector<TransportValue> &args) {
+  auto inputs = unbatchedCircuitInfo.asReader().getInputs();
+  if (args.size() != inputs.size()) {
+    return StringError("Called circuit with wrong number of arguments");
+  }
+  for (size_t i = 0; i < args.size(); i++) {
+    auto arg = args[i].asReader();
+    if (!arg.hasPayload() || !arg.hasRawInfo()) {
+      return StringError("Tried to batch a transport value without payload or "
+                         "raw infos.");
+    }
+    if ((capnp::AnyStruct::Reader)inputs[i].getTypeInfo() !=
+        (capnp::AnyStruct::Reader)arg.getTypeInfo()) {
+      return StringError("Tried to batch a transport value incompatible with "
+                         "the circuit signature.");
+    }
+    // In simulation, the ciphertexts are simulated by 64 bits integers, whose
+    // shape lacks the lwe dimension of the gate raw infos.
+    auto typeInfo = inputs[i].getTypeInfo();
+    if (useSimulation && typeInfo.hasLweCiphertext()) {
+      auto rawInfo = arg.getRawInfo();
+      if ((capnp::AnyStruct::Reader)rawInfo.getShape() !=
+              (capnp::AnyStruct::Reader)typeInfo.getLweCiphertext()
+                  .getAbstractShape() ||
+          rawInfo.getIntegerPrecision() != 64 || rawInfo.getIsSigned()) {
+        return StringError("Tried to batch a simulated ciphertext of "
+                           "incompatible shape or precision.");
+      }
+    } else if ((capnp::AnyStruct::Reader)inputs[i].getRawInfo() !=
+               (capnp::AnyStruct::Reader)arg.getRawInfo()) {
+      return StringError("Tried to batch a transport value incompatible with "
+                         "the circuit signature.");
+    }
+  }
+  return outcome::success();
+}
+
+std::future<Result<std::vector<TransportValue>>>
+BatchingServer::submit(std::vector<TransportValue> args) {
+  auto request = std::make_unique<Request>();
+  auto future = request->promise.get_future();
+  auto verified = verify(args);
+  if (verified.has_failure()) {
+    request->promise.set_value(verified.error());
+    return future;
+  }
+  request->args = std::move(args);
+  request->arrival = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    pending.push_back(std::move(request));
+  }
+  condition.notify_one();
+  return future;
+}
+
+Result<std::vector<TransportValue>>
+BatchingServer::call(std::vector<TransportValue> args) {
+  return submit(std::move(args)).get();
+}
+
+void BatchingServer::run() {
+  while (true) {
+    std::vector<std::unique_ptr<Request>> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this]() { return stopping || !pending.empty(); });
+      if (pending.empty()) {
+        // We were asked to stop, and every request was served.
+        return;
+      }
+      // We wait for the batch to fill up, at most until the oldest request
+      // exceeds its latency budget.
+      auto deadline = pending.front()->arrival + options.maxLatency;
+      condition.wait_until(lock, deadline, [this]() {
+        return stopping || pending.size() >= getBatchSize();
+      });
+      while (!pending.empty() && batch.size() < getBatchSize()) {
+        batch.push_back(std::move(pending.front()));
+        pending.pop_front();
+      }
+    }
+
+    auto results = execute(batch);
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (results.has_failure()) {
+        batch[i]->promise.set_value(results.error());
+      } else {
+        batch[i]->promise.set_value(std::move(results.value()[i]));
+      }
+    }
+  }
+}
+
+Result<std::vector<std::vector<TransportValue>>>
+BatchingServer::execute(const std::vector<std::unique_ptr<Request>> &batch) {
+  // The batch is executed by the smallest circuit it fits in.
+  size_t index = 0;
+  while (batchSizes[index] < batch.size()) {
+    index++;
+  }
+  auto &batchedCircuit = batchedCircuits[index];
+  auto batchSize = batchSizes[index];
+  auto batchedInfo = batchedCircuit.getCircuitInfo();
+
+  // We stack the arguments of the requests along the batch dimension.
+  auto batchedArgs = std::vector<TransportValue>();
+  for (size_t i = 0; i < batchedInfo.asReader().getInputs().size(); i++) {
+    auto values = std::vector<Value>();
+    values.reserve(batch.size());
+    for (auto &request : batch) {
+      values.push_back(Value::fromRawTransportValue(request->args[i]));
+    }
+    OUTCOME_TRY(auto stacked, stackValues(values, batchSize));
+    auto batchedArg = stacked.intoRawTransportValue();
+    batchedArg.asBuilder().setTypeInfo(
+        batchedInfo.asReader().getInputs()[i].getTypeInfo());
+    batchedArgs.push_back(batchedArg);
+  }
+
+  std::vector<TransportValue> batchedReturns;
+  if (useSimulation) {
+    OUTCOME_TRY(batchedReturns, batchedCircuit.simulate(batchedArgs));
+  } else {
+    OUTCOME_TRY(batchedReturns, batchedCircuit.call(serverKeyset, batchedArgs));
+  }
+
+  // We split the results of the batched invocation, dropping the padding.
+  auto outputs = unbatchedCircuitInfo.asReader().getOutputs();
+  auto results = std::vector<std::vector<TransportValue>>(batch.size());
+  for (size_t i = 0; i < batchedReturns.size(); i++) {
+    auto value = Value::fromRawTransportValue(batchedReturns[i]);
+    OUTCOME_TRY(auto slices, unstackValue(value, batch.size()));
+    for (size_t j = 0; j < batch.size(); j++) {
+      auto result = slices[j].intoRawTransportValue();
+      result.asBuilder().setTypeInfo(outputs[i].getTypeInfo());
+      results[j].push_back(result);
+    }
+  }
+  return results;
+}
+
+} // namespace serverlib
+} // namespace concretelang
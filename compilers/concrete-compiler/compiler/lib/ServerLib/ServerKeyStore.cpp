@@ -0,0 +1,375 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include "concretelang/ServerLib/ServerKeyStore.h"
+#include "concrete-protocol.capnp.h"
+#include "concretelang/Common/Keys.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Path.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using concretelang::keys::LweBootstrapKey;
+using concretelang::keys::LweKeyswitchKey;
+using concretelang::keys::PackingKeyswitchKey;
+
+namespace concretelang {
+namespace serverlib {
+
+namespace {
+
+template <typename Key> size_t getKeysSize(const std::vector<Key> &keys) {
+  size_t size = 0;
+  for (const auto &key : keys)
+    size += key.getTransportBuffer().size() * sizeof(uint64_t);
+  return size;
+}
+
+size_t getKeysSize(const ServerKeyset &keyset) {
+  return getKeysSize(keyset.lweBootstrapKeys) +
+         getKeysSize(keyset.lweKeyswitchKeys) +
+         getKeysSize(keyset.packingKeyswitchKeys);
+}
+
+/// Returns a copy of a key which doesn't share the buffer it is decompressed
+/// to with `key`, such that the decompressed key is released along with the
+/// runtime context using it.
+template <typename Key> Key unshareDecompression(const Key &key) {
+  if (key.getInfo().asReader().getCompression() ==
+      concreteprotocol::Compression::NONE)
+    return key;
+  return Key::fromTransportBuffer(
+      std::make_shared<std::vector<uint64_t>>(key.getTransportBuffer()),
+      key.getInfo());
+}
+
+template <typename Key>
+bool equalKeys(const std::vector<Key> &a, const std::vector<Key> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    const auto &bufferA = a[i].getTransportBuffer();
+    const auto &bufferB = b[i].getTransportBuffer();
+    if (&bufferA != &bufferB && bufferA != bufferB)
+      return false;
+    if (a[i].getInfo().writeBinaryToString().value() !=
+        b[i].getInfo().writeBinaryToString().value())
+      return false;
+  }
+  return true;
+}
+
+/// Returns whether two keysets hold the same keys, the buffers shared by both
+/// keysets being compared by address.
+bool equalKeys(const ServerKeyset &a, const ServerKeyset &b) {
+  return equalKeys(a.lweBootstrapKeys, b.lweBootstrapKeys) &&
+         equalKeys(a.lweKeyswitchKeys, b.lweKeyswitchKeys) &&
+         equalKeys(a.packingKeyswitchKeys, b.packingKeyswitchKeys);
+}
+
+/// Builds the runtime context of a keyset, with its keys decompressed and its
+/// bootstrap keys converted to the Fourier domain, and returns the number of
+/// bytes it holds in addition to the keys of the keyset.
+std::pair<std::shared_ptr<RuntimeContext>, size_t>
+buildContext(const ServerKeyset &keyset) {
+  ServerKeyset contextKeyset;
+  size_t size = 0;
+  for (const auto &bsk : keyset.lweBootstrapKeys) {
+    auto key = unshareDecompression(bsk);
+    key.decompress();
+    // The Fourier key has the size of the standard one
+    size += key.getBuffer().size() * sizeof(uint64_t);
+    if (&key.getBuffer() != &key.getTransportBuffer())
+      size += key.getBuffer().size() * sizeof(uint64_t);
+    contextKeyset.lweBootstrapKeys.push_back(key);
+  }
+  for (const auto &ksk : keyset.lweKeyswitchKeys) {
+    auto key = unshareDecompression(ksk);
+    key.decompress();
+    if (&key.getBuffer() != &key.getTransportBuffer())
+      size += key.getBuffer().size() * sizeof(uint64_t);
+    contextKeyset.lweKeyswitchKeys.push_back(key);
+  }
+  contextKeyset.packingKeyswitchKeys = keyset.packingKeyswitchKeys;
+  auto context = std::make_shared<RuntimeContext>(contextKeyset);
+  return {context, size + context->key_copies_size()};
+}
+
+/// Spilled keys are written as, for each kind of key, the number of keys
+/// followed by, for each key, the size of its info, its info padded to a
+/// word, the size of its transport buffer, and its transport buffer.
+template <typename Key>
+Result<void> writeKeys(std::ofstream &out, const std::vector<Key> &keys) {
+  uint64_t count = keys.size();
+  out.write((const char *)&count, sizeof(count));
+  for (const auto &key : keys) {
+    OUTCOME_TRY(auto info, key.getInfo().writeBinaryToString());
+    uint64_t infoSize = info.size();
+    info.resize(llvm::alignTo(info.size(), sizeof(uint64_t)));
+    out.write((const char *)&infoSize, sizeof(infoSize));
+    out.write(info.data(), info.size());
+    const auto &buffer = key.getTransportBuffer();
+    uint64_t bufferSize = buffer.size();
+    out.write((const char *)&bufferSize, sizeof(bufferSize));
+    out.write((const char *)buffer.data(), buffer.size() * sizeof(uint64_t));
+  }
+  return outcome::success();
+}
+
+template <typename Key>
+Result<void> readKeys(const uint64_t *&cursor, const uint64_t *end,
+                      std::vector<Key> &keys) {
+  if (cursor == end)
+    return StringError("Truncated spilled keys");
+  uint64_t count = *cursor++;
+  for (uint64_t i = 0; i < count; i++) {
+    if (cursor == end)
+      return StringError("Truncated spilled keys");
+    uint64_t infoSize = *cursor++;
+    uint64_t infoWords = llvm::divideCeil(infoSize, sizeof(uint64_t));
+    if ((uint64_t)(end - cursor) <= infoWords)
+      return StringError("Truncated spilled keys");
+    typename Key::InfoType info;
+    OUTCOME_TRYV(
+        info.readBinaryFromString(std::string((const char *)cursor, infoSize)));
+    cursor += infoWords;
+    uint64_t bufferSize = *cursor++;
+    if ((uint64_t)(end - cursor) < bufferSize)
+      return StringError("Truncated spilled keys");
+    auto buffer = std::make_shared<std::vector<uint64_t>>(cursor,
+                                                          cursor + bufferSize);
+    cursor += bufferSize;
+    keys.push_back(Key::fromTransportBuffer(buffer, info));
+  }
+  return outcome::success();
+}
+
+Result<void> spillKeys(const ServerKeyset &keyset, const std::string &path) {
+  std::ofstream out(path, std::ofstream::binary);
+  if (out.fail())
+    return StringError("Cannot spill keys at path " + path +
+                       " Error: " + strerror(errno));
+  OUTCOME_TRYV(writeKeys(out, keyset.lweBootstrapKeys));
+  OUTCOME_TRYV(writeKeys(out, keyset.lweKeyswitchKeys));
+  OUTCOME_TRYV(writeKeys(out, keyset.packingKeyswitchKeys));
+  out.close();
+  if (out.fail())
+    return StringError("Cannot spill keys at path " + path);
+  return outcome::success();
+}
+
+/// Reads back spilled keys, mapping the file in memory such that the keys are
+/// copied once from the page cache to their buffers.
+Result<ServerKeyset> readSpilledKeys(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return StringError("Cannot read spilled keys at path " + path +
+                       " Error: " + strerror(errno));
+  auto closeFile = llvm::make_scope_exit([&]() { close(fd); });
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+    return StringError("Cannot read spilled keys at path " + path +
+                       " Error: " + strerror(errno));
+  size_t fileSize = fileStat.st_size;
+  if (fileSize == 0)
+    return StringError("Truncated spilled keys at path " + path);
+  void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED)
+    return StringError("Cannot map spilled keys at path " + path +
+                       " Error: " + strerror(errno));
+  auto unmapFile = llvm::make_scope_exit([&]() { munmap(mapping, fileSize); });
+  madvise(mapping, fileSize, MADV_SEQUENTIAL);
+  const uint64_t *cursor = (const uint64_t *)mapping;
+  const uint64_t *end = cursor + fileSize / sizeof(uint64_t);
+  ServerKeyset keyset;
+  OUTCOME_TRYV(readKeys(cursor, end, keyset.lweBootstrapKeys));
+  OUTCOME_TRYV(readKeys(cursor, end, keyset.lweKeyswitchKeys));
+  OUTCOME_TRYV(readKeys(cursor, end, keyset.packingKeyswitchKeys));
+  return keyset;
+}
+
+} // namespace
+
+ServerKeyStore::~ServerKeyStore() {
+  for (auto &entry : keysets)
+    if (!entry.second.spillPath.empty())
+      llvm::sys::fs::remove(entry.second.spillPath);
+}
+
+Result<void> ServerKeyStore::add(const std::string &keysetId,
+                                 ServerKeyset keyset) {
+  std::string digest = keyset.getDigest();
+  std::lock_guard<std::mutex> guard(lock);
+
+  // A keyset is only shared with a stored keyset holding the same keys, even
+  // when it is registered again under the same identifier.
+  auto found = keysets.find(digest);
+  if (found != keysets.end()) {
+    auto &stored = found->second;
+    OUTCOME_TRYV(load(digest, stored));
+    if (!equalKeys(*stored.keys, keyset))
+      return StringError("Tried to add a keyset under `" + keysetId +
+                         "` whose digest is the one of a different keyset");
+    recency.splice(recency.end(), recency, stored.recency);
+  }
+
+  auto registered = digests.find(keysetId);
+  if (registered != digests.end()) {
+    if (registered->second == digest)
+      return outcome::success();
+    unregister(keysetId);
+  }
+
+  auto &stored = keysets[digest];
+  if (stored.references == 0) {
+    stored.keysSize = getKeysSize(keyset);
+    stored.keys = std::move(keyset);
+    stored.recency = recency.insert(recency.end(), digest);
+    residentSize += stored.keysSize;
+  }
+  stored.references++;
+  digests[keysetId] = digest;
+  return evict(digest);
+}
+
+Result<void> ServerKeyStore::remove(const std::string &keysetId) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (digests.find(keysetId) == digests.end())
+    return StringError("Tried to remove an unknown keyset: `" + keysetId +
+                       "`");
+  unregister(keysetId);
+  return outcome::success();
+}
+
+void ServerKeyStore::unregister(const std::string &keysetId) {
+  auto registered = digests.find(keysetId);
+  std::string digest = registered->second;
+  digests.erase(registered);
+  auto &stored = keysets[digest];
+  if (--stored.references > 0)
+    return;
+  if (stored.keys.has_value())
+    residentSize -= stored.keysSize;
+  if (stored.context != nullptr)
+    residentSize -= stored.contextSize;
+  if (!stored.spillPath.empty())
+    llvm::sys::fs::remove(stored.spillPath);
+  recency.erase(stored.recency);
+  keysets.erase(digest);
+}
+
+Result<std::shared_ptr<RuntimeContext>>
+ServerKeyStore::getContext(const std::string &keysetId) {
+  ServerKeyset keys;
+  std::string digest;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    auto registered = digests.find(keysetId);
+    if (registered == digests.end())
+      return StringError("Tried to use an unknown keyset: `" + keysetId + "`");
+    digest = registered->second;
+    auto &stored = keysets[digest];
+    recency.splice(recency.end(), recency, stored.recency);
+    if (stored.context != nullptr)
+      return stored.context;
+    OUTCOME_TRYV(load(digest, stored));
+    keys = *stored.keys;
+  }
+
+  // The conversion of the bootstrap keys is done without holding the lock,
+  // such that the calls using resident contexts are not delayed.
+  auto [context, contextSize] = buildContext(keys);
+
+  std::lock_guard<std::mutex> guard(lock);
+  auto stored = keysets.find(digest);
+  // The keyset may have been removed, or its context built by a concurrent
+  // call, in the meantime.
+  if (stored == keysets.end())
+    return context;
+  if (stored->second.context != nullptr)
+    return stored->second.context;
+  stored->second.context = context;
+  stored->second.contextSize = contextSize;
+  residentSize += contextSize;
+  OUTCOME_TRYV(evict(digest));
+  return context;
+}
+
+size_t ServerKeyStore::getResidentSize() {
+  std::lock_guard<std::mutex> guard(lock);
+  return residentSize;
+}
+
+Result<void> ServerKeyStore::load(const std::string &digest,
+                                  StoredKeyset &stored) {
+  if (stored.keys.has_value())
+    return outcome::success();
+  OUTCOME_TRY(auto keys, readSpilledKeys(stored.spillPath));
+  stored.keys = std::move(keys);
+  residentSize += stored.keysSize;
+  return evict(digest);
+}
+
+Result<void> ServerKeyStore::evict(const std::string &used) {
+  if (options.memoryBudget == 0)
+    return outcome::success();
+
+  // Contexts are evicted first, as they can be rebuilt from the resident keys
+  for (const auto &digest : recency) {
+    if (residentSize <= options.memoryBudget)
+      return outcome::success();
+    auto &stored = keysets[digest];
+    if (digest == used || stored.context == nullptr)
+      continue;
+    stored.context = nullptr;
+    residentSize -= stored.contextSize;
+  }
+
+  if (options.spillDirectory.empty())
+    return outcome::success();
+  for (const auto &digest : recency) {
+    if (residentSize <= options.memoryBudget)
+      return outcome::success();
+    auto &stored = keysets[digest];
+    if (digest == used || !stored.keys.has_value())
+      continue;
+    // Keys are written once, as they don't change while registered. The
+    // file is created with a unique name, as the spill directory may be
+    // shared by several stores, possibly in several processes.
+    if (stored.spillPath.empty()) {
+      if (auto err = llvm::sys::fs::create_directories(options.spillDirectory))
+        return StringError("Cannot create the spill directory " +
+                           options.spillDirectory + ": " + err.message());
+      llvm::SmallString<256> model(options.spillDirectory);
+      llvm::sys::path::append(model, digest + "-%%%%%%%%.keys");
+      int fd;
+      llvm::SmallString<256> path;
+      if (auto err = llvm::sys::fs::createUniqueFile(model, fd, path))
+        return StringError("Cannot create a spill file in " +
+                           options.spillDirectory + ": " + err.message());
+      close(fd);
+      stored.spillPath = path.str().str();
+      if (auto spilled = spillKeys(*stored.keys, stored.spillPath);
+          spilled.has_error()) {
+        llvm::sys::fs::remove(stored.spillPath);
+        stored.spillPath.clear();
+        return spilled;
+      }
+    }
+    stored.keys.reset();
+    residentSize -= stored.keysSize;
+  }
+  return outcome::success();
+}
+
+} // namespace serverlib
+} // namespace concretelang
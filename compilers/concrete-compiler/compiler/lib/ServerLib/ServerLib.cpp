@@ -3,13 +3,18 @@
 // https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
 // for license information.
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <llvm/ADT/SmallSet.h>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "boost/outcome.h"
+#include "capnp/any.h"
 #include "concrete-protocol.capnp.h"
 #include "concretelang/Common/Error.h"
 #include "concretelang/Common/Keysets.h"
@@ -17,6 +22,8 @@
 #include "concretelang/Common/Transformers.h"
 #include "concretelang/Common/Values.h"
 #include "concretelang/Runtime/context.h"
+#include "concretelang/ServerLib/MemRefDescriptor.h"
+#include "concretelang/ServerLib/ServerKeyStore.h"
 #include "concretelang/ServerLib/ServerLib.h"
 #include "concretelang/Support/CompilerEngine.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -32,146 +39,6 @@ using mlir::concretelang::RuntimeContext;
 namespace concretelang {
 namespace serverlib {
 
-// Depending on the strides of the memref, iteration may not be linear in the
-// memory space (i.e. it may contain jumps). For this reason we have to compute
-// a memory index from the linear index of the iteration space. This structure
-// does just that.
-struct MultiDimIndexer {
-  std::vector<size_t> multiDimensionalIndex;
-  size_t offset;
-  const std::vector<size_t> &sizes;
-  const std::vector<size_t> &strides;
-
-  MultiDimIndexer(size_t offset, const std::vector<size_t> &sizes,
-                  const std::vector<size_t> &strides)
-      : sizes(sizes), strides(strides) {
-    size_t rank = sizes.size();
-    this->multiDimensionalIndex.resize(rank);
-    for (size_t i = 0; i < rank; i++) {
-      this->multiDimensionalIndex[i] = 0;
-    }
-    // this->sizes = sizes;
-    // this->strides = sizes;
-    this->offset = offset;
-  }
-
-  /// Increments the index.
-  void increment() {
-    size_t rank = sizes.size();
-    for (int r = rank - 1; r >= 0; r--) {
-      if (multiDimensionalIndex[r] < sizes[r] - 1) {
-        multiDimensionalIndex[r]++;
-        return;
-      }
-      multiDimensionalIndex[r] = 0;
-    }
-  }
-
-  /// Returns the current index.
-  size_t currentIndex() {
-    size_t rank = sizes.size();
-    size_t g_index = offset;
-    size_t default_stride = 1;
-    for (int r = rank - 1; r >= 0; r--) {
-      g_index += multiDimensionalIndex[r] *
-                 ((strides[r] == 0) ? default_stride : strides[r]);
-      default_stride *= sizes[r];
-    }
-    return g_index;
-  }
-};
-
-// A type representing the memref description of a tensor.
-struct MemRefDescriptor {
-  size_t precision;
-  bool isSigned;
-  void *allocated;
-  void *aligned;
-  size_t offset;
-  std::vector<size_t> sizes;
-  std::vector<size_t> strides;
-
-  /// Creates a memref descriptor referencing the data contained in a tensor.
-  template <typename T> static MemRefDescriptor fromTensor(Tensor<T> &input) {
-    std::vector<size_t> strides;
-    size_t stride = input.values.size();
-    for (size_t dim : input.dimensions) {
-      stride = (dim == 0 ? 0 : (stride / dim));
-      strides.push_back(stride);
-    }
-    return MemRefDescriptor{sizeof(T) * 8,
-                            std::is_signed<T>(),
-                            (void *)nullptr,
-                            (void *)input.values.data(),
-                            0,
-                            input.dimensions,
-                            strides};
-  }
-
-  /// Creates a memref descriptor from a vector of uint64_t, which is the way to
-  /// represent outputs in the current calling convention.
-  static MemRefDescriptor fromU64s(llvm::ArrayRef<uint64_t> raw,
-                                   size_t precision, bool isSigned) {
-    auto rank = (raw.size() - 3) / 2;
-    void *allocated = (void *)raw[0];
-    void *aligned = (void *)raw[1];
-    size_t offset = (size_t)raw[2];
-    std::vector<size_t> sizes(rank);
-    for (size_t i = 0; i < rank; i++) {
-      sizes[i] = (size_t)raw[3 + i];
-    }
-    std::vector<size_t> strides(rank);
-    for (size_t i = 0; i < rank; i++) {
-      strides[i] = (size_t)raw[3 + rank + i];
-    }
-    return MemRefDescriptor{
-        precision, isSigned, allocated, aligned, offset, sizes, strides,
-    };
-  }
-
-  /// Returns the number of elements of the memref.
-  size_t getLength() {
-    size_t output = 1;
-    for (size_t i = 0; i < sizes.size(); i++) {
-      output *= sizes[i];
-    }
-    return output;
-  }
-
-  // Allocates a new tensor, and copy the values referenced by a memref
-  // descriptor.
-  template <typename T> Tensor<T> intoTensor() {
-    assert(sizeof(T) * 8 == precision);
-    assert(std::is_signed<T>() == isSigned);
-
-    // We create the indexer.
-    auto indexer = MultiDimIndexer(offset, sizes, strides);
-
-    // We fill a vector of vales to construct the
-    std::vector<T> values(getLength());
-    for (size_t i = 0; i < values.size(); i++) {
-      T *memrefAligned = reinterpret_cast<T *>(aligned);
-      auto index = indexer.currentIndex();
-      values[i] = memrefAligned[index];
-      indexer.increment();
-    }
-
-    return Tensor<T>{values, sizes};
-  }
-
-  void intoOpaquePtrs(llvm::MutableArrayRef<void *> &opaquePtrs) {
-    opaquePtrs[0] = allocated;
-    opaquePtrs[1] = aligned;
-    opaquePtrs[2] = (void *)offset;
-    for (size_t i = 0; i < sizes.size(); i++) {
-      opaquePtrs[3 + i] = (void *)sizes[i];
-    }
-    for (size_t i = 0; i < strides.size(); i++) {
-      opaquePtrs[3 + sizes.size() + i] = (void *)strides[i];
-    }
-  }
-};
-
 struct ScalarDescriptor {
   size_t precision;
   bool isSigned;
@@ -237,26 +104,29 @@ struct InvocationDescriptor {
     assert(false);
   }
 
-  Value intoValue() {
+  /// Creates a value from the descriptor, copying the values of a memref,
+  /// unless `release` is given, in which case the value adopts the buffer of
+  /// the (contiguous) memref, and calls `release` once done with it.
+  Value intoValue(std::function<void()> release = nullptr) {
     if (getIsSigned()) {
       if (getPrecision() == 8) {
-        return Value{intoTensor<int8_t>()};
+        return Value{intoTensor<int8_t>(release)};
       } else if (getPrecision() == 16) {
-        return Value{intoTensor<int16_t>()};
+        return Value{intoTensor<int16_t>(release)};
       } else if (getPrecision() == 32) {
-        return Value{intoTensor<int32_t>()};
+        return Value{intoTensor<int32_t>(release)};
       } else if (getPrecision() == 64) {
-        return Value{intoTensor<int64_t>()};
+        return Value{intoTensor<int64_t>(release)};
       }
     } else {
       if (getPrecision() == 8) {
-        return Value{intoTensor<uint8_t>()};
+        return Value{intoTensor<uint8_t>(release)};
       } else if (getPrecision() == 16) {
-        return Value{intoTensor<uint16_t>()};
+        return Value{intoTensor<uint16_t>(release)};
       } else if (getPrecision() == 32) {
-        return Value{intoTensor<uint32_t>()};
+        return Value{intoTensor<uint32_t>(release)};
       } else if (getPrecision() == 64) {
-        return Value{intoTensor<uint64_t>()};
+        return Value{intoTensor<uint64_t>(release)};
       }
     }
     assert(false);
@@ -294,12 +164,17 @@ struct InvocationDescriptor {
     // Free the memory.
     void tryFree() {
       for (void *ptr : ptrs) {
-        if (ptr != nullptr && !isReferenceToMLIRGlobalMemory(ptr)) {
+        if (isFreeable(ptr)) {
           ::free(ptr);
         }
       }
     }
 
+    // Whether the memory was allocated by the circuit, and must be freed.
+    static inline bool isFreeable(void *ptr) {
+      return ptr != nullptr && !isReferenceToMLIRGlobalMemory(ptr);
+    }
+
   private:
     llvm::SmallSet<void *, 8> ptrs;
     static inline bool isReferenceToMLIRGlobalMemory(void *ptr) {
@@ -307,6 +182,20 @@ struct InvocationDescriptor {
     }
   };
 
+  // Returns the memory allocated by the circuit for the descriptor, if it can
+  // be adopted by a value rather than copied, that is if it is a contiguous
+  // memref whose memory must be freed.
+  void *getAdoptableMemory() {
+    if (!std::holds_alternative<MemRefDescriptor>(inner)) {
+      return nullptr;
+    }
+    auto &memref = std::get<MemRefDescriptor>(inner);
+    if (!Liberator::isFreeable(memref.allocated) || !memref.isContiguous()) {
+      return nullptr;
+    }
+    return memref.allocated;
+  }
+
 private:
   template <typename T>
   static InvocationDescriptor fromTensor(Tensor<T> &tensor) {
@@ -317,11 +206,12 @@ private:
     }
   }
 
-  template <typename T> Tensor<T> intoTensor() {
+  template <typename T> Tensor<T> intoTensor(std::function<void()> release) {
     if (std::holds_alternative<ScalarDescriptor>(inner)) {
+      assert(!release);
       return std::get<ScalarDescriptor>(inner).intoTensor<T>();
     } else {
-      return std::get<MemRefDescriptor>(inner).intoTensor<T>();
+      return std::get<MemRefDescriptor>(inner).intoTensor<T>(release);
     }
   }
 
@@ -430,6 +320,21 @@ bool getGateIsSigned(const Message<concreteprotocol::GateInfo> &gateInfo) {
 Result<std::vector<TransportValue>>
 ServerCircuit::call(const ServerKeyset &serverKeyset,
                     std::vector<TransportValue> &args) {
+  // We create a runtime context from the keyset.
+  RuntimeContext runtimeContext = RuntimeContext(serverKeyset);
+  return call(&runtimeContext, args);
+}
+
+Result<std::vector<TransportValue>>
+ServerCircuit::call(ServerKeyStore &keyStore, const std::string &keysetId,
+                    std::vector<TransportValue> &args) {
+  OUTCOME_TRY(auto runtimeContext, keyStore.getContext(keysetId));
+  return call(runtimeContext.get(), args);
+}
+
+Result<std::vector<TransportValue>>
+ServerCircuit::call(RuntimeContext *runtimeContext,
+                    std::vector<TransportValue> &args) {
   if (args.size() != argsBuffer.size()) {
     return StringError("Called circuit with wrong number of arguments");
   }
@@ -439,14 +344,40 @@ ServerCircuit::call(const ServerKeyset &serverKeyset,
     OUTCOME_TRY(argsBuffer[i], argTransformers[i](args[i]));
   }
 
+  return callWithArgsBuffer(runtimeContext);
+}
+
+Result<std::vector<TransportValue>>
+ServerCircuit::callFromFds(const ServerKeyset &serverKeyset,
+                           const std::vector<int> &argFds) {
+  if (argFds.size() != argsBuffer.size()) {
+    return StringError("Called circuit with wrong number of arguments");
+  }
+
+  // We load the arguments read from the streams in the args buffer.
+  for (size_t i = 0; i < argsBuffer.size(); i++) {
+    OUTCOME_TRY(argsBuffer[i], argStreamTransformers[i](argFds[i]));
+  }
+
+  RuntimeContext runtimeContext = RuntimeContext(serverKeyset);
+  return callWithArgsBuffer(&runtimeContext);
+}
+
+Result<std::vector<TransportValue>>
+ServerCircuit::callWithArgsBuffer(RuntimeContext *runtimeContext) {
   // The arguments has been pushed in the arg buffer, we are now ready to
   // invoke the circuit function.
-  invoke(serverKeyset);
+  std::vector<Value *> argPtrs;
+  for (auto &arg : argsBuffer) {
+    argPtrs.push_back(&arg);
+  }
+  invoke(runtimeContext, argPtrs);
 
   // We process the return values to turn them into transport values.
   std::vector<TransportValue> returns(returnsBuffer.size());
   for (size_t i = 0; i < returnsBuffer.size(); i++) {
-    OUTCOME_TRY(returns[i], returnTransformers[i](returnsBuffer[i]));
+    OUTCOME_TRY(returns[i],
+                returnTransformers[i](std::move(returnsBuffer[i])));
   }
 
   return returns;
@@ -462,6 +393,10 @@ std::string ServerCircuit::getName() {
   return circuitInfo.asReader().getName();
 }
 
+const Message<concreteprotocol::CircuitInfo> &ServerCircuit::getCircuitInfo() {
+  return circuitInfo;
+}
+
 Result<ServerCircuit> ServerCircuit::fromDynamicModule(
     const Message<concreteprotocol::CircuitInfo> &circuitInfo,
     std::shared_ptr<DynamicModule> dynamicModule, bool useSimulation = false) {
@@ -498,6 +433,9 @@ Result<ServerCircuit> ServerCircuit::fromDynamicModule(
       return StringError("Malformed input gate info.");
     }
     output.argTransformers.push_back(transformer);
+    OUTCOME_TRY(auto streamTransformer,
+                TransformerFactory::getArgStreamTransformer(transformer));
+    output.argStreamTransformers.push_back(streamTransformer);
   }
 
   // We prepare the return transformers used to transform return values into
@@ -542,12 +480,11 @@ Result<ServerCircuit> ServerCircuit::fromDynamicModule(
   return output;
 }
 
-void ServerCircuit::invoke(const ServerKeyset &serverKeyset) {
+void ServerCircuit::invoke(RuntimeContext *runtimeContext,
+                           const std::vector<Value *> &args) {
 
-  // We create a runtime context from the keyset, and place a pointer to it in
-  // the structure.
-  RuntimeContext runtimeContext = RuntimeContext(serverKeyset);
-  RuntimeContext *_runtimeContextPtr = &runtimeContext;
+  // We place a pointer to the runtime context in the structure.
+  RuntimeContext *_runtimeContextPtr = runtimeContext;
 
   auto _argRaws = std::vector<void *>(this->argRawSize);
   auto _argRawMaps = std::vector<llvm::MutableArrayRef<void *>>();
@@ -580,7 +517,7 @@ void ServerCircuit::invoke(const ServerKeyset &serverKeyset) {
   for (unsigned int i = 0; i < circuitInfo.asReader().getInputs().size(); i++) {
     // We construct a descriptor from the input value.
     InvocationDescriptor descriptor =
-        InvocationDescriptor::fromValue(argsBuffer[i]);
+        InvocationDescriptor::fromValue(*args[i]);
     // We write the descriptor in the _argRaws via the maps.
     descriptor.intoOpaquePtrs(_argRawMaps[i]);
   }
@@ -593,15 +530,34 @@ void ServerCircuit::invoke(const ServerKeyset &serverKeyset) {
   // Note that, the addition of multi outputs made it possible to have aliased
   // outputs. We must then deduplicate the output descriptors before freeing
   // their memory to prevent constructing corrupted outputs and double-freeing.
-  auto liberator = InvocationDescriptor::Liberator();
-  for (unsigned int i = 0; i < circuitInfo.asReader().getOutputs().size();
-       i++) {
+  size_t outputsSize = circuitInfo.asReader().getOutputs().size();
+  std::vector<InvocationDescriptor> descriptors;
+  descriptors.reserve(outputsSize);
+  std::map<void *, size_t> allocatedCounts;
+  for (unsigned int i = 0; i < outputsSize; i++) {
     // We read the descriptor from the _returnRaws via the maps.
     size_t precision =
         getGateIntegerPrecision(circuitInfo.asReader().getOutputs()[i]);
     bool isSigned = getGateIsSigned(circuitInfo.asReader().getOutputs()[i]);
-    InvocationDescriptor descriptor =
-        InvocationDescriptor::fromU64s(_returnRawMaps[i], precision, isSigned);
+    descriptors.push_back(
+        InvocationDescriptor::fromU64s(_returnRawMaps[i], precision, isSigned));
+    if (std::holds_alternative<MemRefDescriptor>(descriptors.back().inner)) {
+      allocatedCounts[std::get<MemRefDescriptor>(descriptors.back().inner)
+                          .allocated]++;
+    }
+  }
+  auto liberator = InvocationDescriptor::Liberator();
+  for (size_t i = 0; i < outputsSize; i++) {
+    auto &descriptor = descriptors[i];
+    // An output which is the only one allocated in its memory is adopted by
+    // the value, which frees the memory once done with it, rather than
+    // copied.
+    void *adoptable = descriptor.getAdoptableMemory();
+    if (adoptable != nullptr && allocatedCounts[adoptable] == 1) {
+      returnsBuffer[i] =
+          descriptor.intoValue([adoptable]() { ::free(adoptable); });
+      continue;
+    }
     // We generate a value from the descriptor which we store in the
     // returnsBuffer.
     returnsBuffer[i] = descriptor.intoValue();
@@ -613,6 +569,48 @@ void ServerCircuit::invoke(const ServerKeyset &serverKeyset) {
   liberator.tryFree();
 }
 
+/// A value resident on the server, along with the signature of the gate it
+/// was returned from.
+struct StoredValue {
+  Value value;
+  Message<concreteprotocol::GateInfo> gateInfo;
+  ReturnTransformer returnTransformer;
+};
+
+class ServerValueStore {
+public:
+  ServerValueHandle insert(std::shared_ptr<StoredValue> storedValue) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto id = nextId++;
+    storedValues[id] = storedValue;
+    return ServerValueHandle{id};
+  }
+
+  Result<std::shared_ptr<StoredValue>> get(ServerValueHandle handle) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = storedValues.find(handle.id);
+    if (found == storedValues.end()) {
+      return StringError("Tried to use an unknown server value handle: ")
+             << handle.id;
+    }
+    return found->second;
+  }
+
+  Result<void> erase(ServerValueHandle handle) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (storedValues.erase(handle.id) == 0) {
+      return StringError("Tried to release an unknown server value handle: ")
+             << handle.id;
+    }
+    return outcome::success();
+  }
+
+private:
+  std::mutex lock;
+  uint64_t nextId = 0;
+  std::unordered_map<uint64_t, std::shared_ptr<StoredValue>> storedValues;
+};
+
 Result<ServerProgram>
 ServerProgram::load(const Message<concreteprotocol::ProgramInfo> &programInfo,
                     const std::string &sharedLibPath, bool useSimulation) {
@@ -627,6 +625,7 @@ ServerProgram::load(const Message<concreteprotocol::ProgramInfo> &programInfo,
     serverCircuits.push_back(serverCircuit);
   }
   output.serverCircuits = serverCircuits;
+  output.valueStore = std::make_shared<ServerValueStore>();
   return output;
 }
 
@@ -641,5 +640,143 @@ ServerProgram::getServerCircuit(const std::string &circuitName) {
                      "`");
 }
 
+Result<std::vector<ServerValueHandle>>
+ServerProgram::callWithHandles(const std::string &circuitName,
+                               const ServerKeyset &serverKeyset,
+                               const std::vector<ServerArgument> &args) {
+  RuntimeContext runtimeContext = RuntimeContext(serverKeyset);
+  return callWithHandles(circuitName, &runtimeContext, args);
+}
+
+Result<std::vector<ServerValueHandle>>
+ServerProgram::callWithHandles(const std::string &circuitName,
+                               ServerKeyStore &keyStore,
+                               const std::string &keysetId,
+                               const std::vector<ServerArgument> &args) {
+  OUTCOME_TRY(auto runtimeContext, keyStore.getContext(keysetId));
+  return callWithHandles(circuitName, runtimeContext.get(), args);
+}
+
+/// Returns whether two capnp structs hold the same content.
+template <typename Reader> bool sameStruct(Reader lhs, Reader rhs) {
+  return (capnp::AnyStruct::Reader)lhs == (capnp::AnyStruct::Reader)rhs;
+}
+
+/// Returns whether a value returned at the `output` gate can be used as is at
+/// the `input` gate. Only what the circuit computes on is compared: the key,
+/// the encoding and the shape of the value. The transport of the values (raw
+/// infos, compression, output shrinking) may differ between the two gates.
+bool isCompatibleServerValue(concreteprotocol::GateInfo::Reader output,
+                             concreteprotocol::GateInfo::Reader input) {
+  auto outputType = output.getTypeInfo();
+  auto inputType = input.getTypeInfo();
+  if (outputType.which() != inputType.which()) {
+    return false;
+  }
+  if (outputType.hasLweCiphertext()) {
+    auto outputLwe = outputType.getLweCiphertext();
+    auto inputLwe = inputType.getLweCiphertext();
+    if (outputLwe.getEncryption().getKeyId() !=
+            inputLwe.getEncryption().getKeyId() ||
+        !sameStruct(outputLwe.getAbstractShape(),
+                    inputLwe.getAbstractShape()) ||
+        !sameStruct(outputLwe.getConcreteShape(),
+                    inputLwe.getConcreteShape())) {
+      return false;
+    }
+    auto outputEncoding = outputLwe.getEncoding();
+    auto inputEncoding = inputLwe.getEncoding();
+    if (outputEncoding.which() != inputEncoding.which()) {
+      return false;
+    }
+    if (outputEncoding.hasInteger()) {
+      return sameStruct(outputEncoding.getInteger(),
+                        inputEncoding.getInteger());
+    }
+    return sameStruct(outputEncoding.getBoolean(), inputEncoding.getBoolean());
+  }
+  if (outputType.hasPlaintext()) {
+    auto outputPlaintext = outputType.getPlaintext();
+    auto inputPlaintext = inputType.getPlaintext();
+    return sameStruct(outputPlaintext.getShape(), inputPlaintext.getShape()) &&
+           outputPlaintext.getIsSigned() == inputPlaintext.getIsSigned();
+  }
+  auto outputIndex = outputType.getIndex();
+  auto inputIndex = inputType.getIndex();
+  return sameStruct(outputIndex.getShape(), inputIndex.getShape()) &&
+         outputIndex.getIsSigned() == inputIndex.getIsSigned();
+}
+
+Result<std::vector<ServerValueHandle>>
+ServerProgram::callWithHandles(const std::string &circuitName,
+                               RuntimeContext *runtimeContext,
+                               const std::vector<ServerArgument> &args) {
+  ServerCircuit *circuit = nullptr;
+  for (auto &serverCircuit : serverCircuits) {
+    if (serverCircuit.getName() == circuitName) {
+      circuit = &serverCircuit;
+    }
+  }
+  if (circuit == nullptr) {
+    return StringError("Tried to call unknown server circuit: `" +
+                       circuitName + "`");
+  }
+  if (args.size() != circuit->argsBuffer.size()) {
+    return StringError("Called circuit with wrong number of arguments");
+  }
+
+  // We load the transport values in the args buffer through the arg
+  // transformers, while the server values are passed to the circuit in place,
+  // without being copied, after checking that they were returned from a gate
+  // compatible with the input gate. The stored values are held until the
+  // circuit returns, should they be released meanwhile.
+  auto inputs = circuit->circuitInfo.asReader().getInputs();
+  std::vector<Value *> argPtrs(args.size());
+  std::vector<std::shared_ptr<StoredValue>> storedArgs;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (auto transportVal = std::get_if<TransportValue>(&args[i])) {
+      OUTCOME_TRY(circuit->argsBuffer[i],
+                  circuit->argTransformers[i](*transportVal));
+      argPtrs[i] = &circuit->argsBuffer[i];
+      continue;
+    }
+    OUTCOME_TRY(auto storedValue,
+                valueStore->get(std::get<ServerValueHandle>(args[i])));
+    if (!circuit->useSimulation &&
+        !isCompatibleServerValue(storedValue->gateInfo.asReader(),
+                                 inputs[i])) {
+      return StringError("Tried to call circuit `" + circuitName +
+                         "` with a server value of incompatible type at "
+                         "position ")
+             << i;
+    }
+    argPtrs[i] = &storedValue->value;
+    storedArgs.push_back(storedValue);
+  }
+
+  circuit->invoke(runtimeContext, argPtrs);
+
+  // We keep the results on the server, along with what is needed to turn them
+  // into transport values later on.
+  auto outputs = circuit->circuitInfo.asReader().getOutputs();
+  std::vector<ServerValueHandle> handles;
+  for (size_t i = 0; i < circuit->returnsBuffer.size(); i++) {
+    auto storedValue = std::make_shared<StoredValue>(
+        StoredValue{std::move(circuit->returnsBuffer[i]), outputs[i],
+                    circuit->returnTransformers[i]});
+    handles.push_back(valueStore->insert(storedValue));
+  }
+  return handles;
+}
+
+Result<TransportValue> ServerProgram::fetch(ServerValueHandle handle) {
+  OUTCOME_TRY(auto storedValue, valueStore->get(handle));
+  return storedValue->returnTransformer(storedValue->value);
+}
+
+Result<void> ServerProgram::release(ServerValueHandle handle) {
+  return valueStore->erase(handle);
+}
+
 } // namespace serverlib
 } // namespace concretelang
@@ -0,0 +1,214 @@
+// Part of the Concrete Compiler Project, under the BSD3 License with Zama
+// Exceptions. See
+// https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
+// for license information.
+
+#include <dlfcn.h>
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "concretelang/Support/CompilationCache.h"
+#include "concretelang/Support/Error.h"
+
+namespace mlir {
+namespace concretelang {
+
+namespace {
+
+/// Returns an identifier of the build of the compiler, such that entries of
+/// the cache produced by another build are never reused. It is made of the
+/// source revision of the compiler, if known at configure time, and of the
+/// identity of the binary holding the compiler.
+std::string getCompilerBuildId() {
+  std::string buildId;
+  llvm::raw_string_ostream os(buildId);
+#ifdef CONCRETELANG_GIT_HASH
+  os << CONCRETELANG_GIT_HASH << ";";
+#endif
+  Dl_info info;
+  if (dladdr((void *)&getCompilerBuildId, &info) != 0 &&
+      info.dli_fname != nullptr) {
+    llvm::sys::fs::file_status status;
+    os << info.dli_fname << ";";
+    if (!llvm::sys::fs::status(info.dli_fname, status)) {
+      os << status.getSize() << ";"
+         << status.getLastModificationTime().time_since_epoch().count();
+    }
+  }
+  return os.str();
+}
+
+/// Feeds a length-prefixed string to `hasher`, such that the concatenation of
+/// several strings is unambiguous.
+void hashString(llvm::SHA256 &hasher, llvm::StringRef str) {
+  auto size = std::to_string(str.size()) + ":";
+  hasher.update(size);
+  hasher.update(str);
+}
+
+llvm::Error copyFile(const std::string &from, const std::string &to) {
+  if (auto ec = llvm::sys::fs::copy_file(from, to)) {
+    return StreamStringError("cannot copy ")
+           << from << " to " << to << ": " << ec.message();
+  }
+  return llvm::Error::success();
+}
+
+} // namespace
+
+std::string
+CompilationCache::getKey(const std::vector<std::string> &canonicalModules,
+                         llvm::StringRef configuration) {
+  static const std::string compilerBuildId = getCompilerBuildId();
+  llvm::SHA256 hasher;
+  hashString(hasher, compilerBuildId);
+  hashString(hasher, configuration);
+  for (auto &module : canonicalModules) {
+    hashString(hasher, module);
+  }
+  return llvm::toHex(hasher.final(), true);
+}
+
+std::string CompilationCache::getEntryPath(llvm::StringRef key) {
+  llvm::SmallString<0> entryPath(cacheDirPath);
+  llvm::sys::path::append(entryPath, key);
+  return entryPath.str().str();
+}
+
+llvm::Expected<bool> CompilationCache::restore(
+    llvm::StringRef key, CompilerEngine::Library &library, bool sharedLib,
+    bool staticLib, bool clientParameters, bool compilationFeedback) {
+  using Library = CompilerEngine::Library;
+  auto entryPath = getEntryPath(key);
+  auto outputDirPath = library.getOutputDirPath();
+
+  // The program info and the compilation feedback are always stored, the
+  // libraries only if they were emitted by the compilation of the entry.
+  auto isStored = [&](bool requested, std::string (*getPath)(std::string)) {
+    return !requested || llvm::sys::fs::exists(getPath(entryPath));
+  };
+  if (!isStored(true, Library::getProgramInfoPath) ||
+      !isStored(true, Library::getCompilationFeedbackPath) ||
+      !isStored(sharedLib, Library::getSharedLibraryPath) ||
+      !isStored(staticLib, Library::getStaticLibraryPath)) {
+    return false;
+  }
+
+  std::vector<std::string (*)(std::string)> artifacts;
+  if (sharedLib)
+    artifacts.push_back(Library::getSharedLibraryPath);
+  if (staticLib)
+    artifacts.push_back(Library::getStaticLibraryPath);
+  if (clientParameters)
+    artifacts.push_back(Library::getProgramInfoPath);
+  if (compilationFeedback)
+    artifacts.push_back(Library::getCompilationFeedbackPath);
+
+  llvm::sys::fs::create_directories(outputDirPath);
+  for (auto getPath : artifacts) {
+    if (auto err = copyFile(getPath(entryPath), getPath(outputDirPath))) {
+      return std::move(err);
+    }
+  }
+  if (auto err = library.loadArtifacts(entryPath, sharedLib, staticLib)) {
+    return std::move(err);
+  }
+  return true;
+}
+
+llvm::Error CompilationCache::store(llvm::StringRef key,
+                                    const CompilerEngine::Library &library) {
+  using Library = CompilerEngine::Library;
+  auto entryPath = getEntryPath(key);
+
+  // The entry is first written to a temporary directory, then renamed, such
+  // that concurrent compilations never observe a partial entry.
+  llvm::SmallString<0> tmpPath;
+  llvm::sys::fs::createUniquePath(entryPath + ".tmp-%%%%%%%%", tmpPath,
+                                  false);
+  std::string tmpDirPath = tmpPath.str().str();
+  if (auto ec = llvm::sys::fs::create_directories(tmpDirPath)) {
+    return StreamStringError("cannot create cache entry ")
+           << tmpDirPath << ": " << ec.message();
+  }
+  auto cleanUp = [&](llvm::Error err) {
+    llvm::sys::fs::remove_directories(tmpDirPath);
+    return err;
+  };
+
+  if (!library.sharedLibraryPath.empty()) {
+    if (auto err = copyFile(library.sharedLibraryPath,
+                            Library::getSharedLibraryPath(tmpDirPath))) {
+      return cleanUp(std::move(err));
+    }
+  }
+  if (!library.staticLibraryPath.empty()) {
+    if (auto err = copyFile(library.staticLibraryPath,
+                            Library::getStaticLibraryPath(tmpDirPath))) {
+      return cleanUp(std::move(err));
+    }
+  }
+
+  auto programInfoJson = library.getProgramInfo().writeJsonToString();
+  if (programInfoJson.has_failure()) {
+    return cleanUp(
+        StreamStringError(programInfoJson.as_failure().error().mesg));
+  }
+  std::error_code ec;
+  llvm::raw_fd_ostream programInfoOut(
+      Library::getProgramInfoPath(tmpDirPath), ec);
+  if (ec) {
+    return cleanUp(StreamStringError("cannot write program info: ")
+                   << ec.message());
+  }
+  programInfoOut << programInfoJson.value();
+  programInfoOut.close();
+
+  llvm::raw_fd_ostream feedbackOut(
+      Library::getCompilationFeedbackPath(tmpDirPath), ec);
+  if (ec) {
+    return cleanUp(StreamStringError("cannot write compilation feedback: ")
+                   << ec.message());
+  }
+  feedbackOut << llvm::formatv(
+      "{0:2}", llvm::json::Value(library.getCompilationFeedback()));
+  feedbackOut.close();
+
+  // An entry holding every artifact of the new one is kept as is, such that
+  // compilations restoring it never see it disappear.
+  auto isStored = [&](bool stored, std::string (*getPath)(std::string)) {
+    return !stored || llvm::sys::fs::exists(getPath(entryPath));
+  };
+  if (isStored(true, Library::getProgramInfoPath) &&
+      isStored(true, Library::getCompilationFeedbackPath) &&
+      isStored(!library.sharedLibraryPath.empty(),
+               Library::getSharedLibraryPath) &&
+      isStored(!library.staticLibraryPath.empty(),
+               Library::getStaticLibraryPath)) {
+    llvm::sys::fs::remove_directories(tmpDirPath);
+    return llvm::Error::success();
+  }
+
+  // Renaming a directory over a non-empty one fails, so a previous entry
+  // holding fewer artifacts is first moved aside, which is atomic too.
+  if (llvm::sys::fs::exists(entryPath)) {
+    llvm::SmallString<0> stalePath;
+    llvm::sys::fs::createUniquePath(entryPath + ".stale-%%%%%%%%", stalePath,
+                                    false);
+    if (!llvm::sys::fs::rename(entryPath, stalePath)) {
+      llvm::sys::fs::remove_directories(stalePath);
+    }
+  }
+  if (llvm::sys::fs::rename(tmpDirPath, entryPath)) {
+    // Another compilation stored the same entry in the meantime.
+    llvm::sys::fs::remove_directories(tmpDirPath);
+  }
+  return llvm::Error::success();
+}
+
+} // namespace concretelang
+} // namespace mlir
@@ -233,6 +233,7 @@ llvm::json::Array circuitFeedbacksToJson(
          crtDecompositionToJson(circuit.crtDecompositionsOfOutputs)},
         {"statistics", statisticsToJson(circuit.statistics)},
         {"memoryUsagePerLoc", memoryUsageToJson(circuit.memoryUsagePerLoc)},
+        {"plannedMemoryPeak", circuit.plannedMemoryPeak},
     };
     object.push_back(std::move(circuitObject));
   }
@@ -344,7 +345,8 @@ bool fromJSON(const llvm::json::Value j,
          O.map("totalOutputsSize", v.totalOutputsSize) &&
          O.map("crtDecompositionsOfOutputs", v.crtDecompositionsOfOutputs) &&
          O.map("statistics", v.statistics) &&
-         O.map("memoryUsagePerLoc", v.memoryUsagePerLoc);
+         O.map("memoryUsagePerLoc", v.memoryUsagePerLoc) &&
+         O.mapOptional("plannedMemoryPeak", v.plannedMemoryPeak);
 }
 
 bool fromJSON(const llvm::json::Value j,
@@ -10,6 +10,7 @@
 #include "mlir/Dialect/SCF/Transforms/BufferizableOpInterfaceImpl.h"
 #include "mlir/Dialect/Tensor/Transforms/BufferizableOpInterfaceImpl.h"
 #include "llvm/Support/Debug.h"
+#include <cstring>
 #include <err.h>
 #include <fstream>
 #include <iostream>
@@ -17,6 +18,8 @@
 #include <optional>
 #include <stdio.h>
 #include <string>
+#include <thread>
+#include <unistd.h>
 
 #include "mlir/Dialect/Bufferization/Transforms/FuncBufferizableOpInterfaceImpl.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -31,6 +34,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SMLoc.h"
+#include "llvm/TargetParser/Host.h"
 
 #include "concrete-protocol.capnp.h"
 #include "concretelang/Conversion/Utils/GlobalFHEContext.h"
@@ -49,6 +53,7 @@
 #include "concretelang/Dialect/Tracing/Transforms/BufferizableOpInterfaceImpl.h"
 #include "concretelang/Dialect/TypeInference/IR/TypeInferenceDialect.h"
 #include "concretelang/Runtime/DFRuntime.hpp"
+#include "concretelang/Support/CompilationCache.h"
 #include "concretelang/Support/CompilerEngine.h"
 #include "concretelang/Support/Encodings.h"
 #include "concretelang/Support/Error.h"
@@ -109,7 +114,6 @@ mlir::MLIRContext *CompilationContext::getMLIRContext() {
     this->mlirContext = new mlir::MLIRContext();
     this->mlirContext->appendDialectRegistry(registry);
     this->mlirContext->loadAllAvailableDialects();
-    this->mlirContext->disableMultithreading();
   }
 
   return this->mlirContext;
@@ -146,6 +150,137 @@ void CompilerEngine::setMaxMANP(size_t v) { this->overrideMaxMANP = v; }
 void CompilerEngine::setEnablePass(
     std::function<bool(mlir::Pass *)> enablePass) {
   this->enablePass = enablePass;
+  this->customEnablePass = true;
+}
+
+/// Returns the size in bytes of the L2 cache of the host, the largest cache
+/// private to a core on most architectures.
+uint64_t getHostCacheSize() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (size > 0)
+    return size;
+#endif
+  return 1 << 20;
+}
+
+/// Returns the size in bytes of the largest ciphertext of an encrypted
+/// integer with the parameters of `fheContext`.
+uint64_t getCiphertextSize(const std::optional<V0FHEContext> &fheContext) {
+  uint64_t lweDimension = 2048;
+  uint64_t numBlocks = 1;
+  if (fheContext.has_value()) {
+    auto &solution = fheContext->solution;
+    if (auto mono = std::get_if<V0Parameter>(&solution); mono != nullptr) {
+      lweDimension = mono->getNBigLweDimension();
+      if (mono->largeInteger.has_value())
+        numBlocks = mono->largeInteger->crtDecomposition.size();
+    } else {
+      auto &circuit = std::get<optimizer::CircuitSolution>(solution);
+      lweDimension = 0;
+      for (auto &key : circuit.circuit_keys.secret_keys)
+        lweDimension = std::max<uint64_t>(
+            lweDimension, key.glwe_dimension * key.polynomial_size);
+      if (!circuit.crt_decomposition.empty())
+        numBlocks = circuit.crt_decomposition.size();
+    }
+  }
+  return (lweDimension + 1) * sizeof(uint64_t) * numBlocks;
+}
+
+std::optional<std::string>
+CompilerEngine::getCacheConfiguration(llvm::StringRef runtimeLibraryPath) {
+  CompilationOptions &options = this->compilerOptions;
+
+  // Compilations verifying diagnostics or running only some of the passes
+  // don't produce the artifacts of a regular compilation.
+  if (options.verifyDiagnostics || this->customEnablePass)
+    return std::nullopt;
+
+  std::string configuration;
+  llvm::raw_string_ostream os(configuration);
+  auto printDouble = [&](double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    os << bits << ";";
+  };
+  auto printOptional = [&](const auto &value, auto print) {
+    if (value.has_value()) {
+      os << "some(";
+      print(*value);
+      os << ")";
+    }
+    os << ";";
+  };
+  auto printLargeInteger = [&](const LargeIntegerParameter &p) {
+    for (auto modulus : p.crtDecomposition)
+      os << modulus << ",";
+    auto &pks = p.wopPBS.packingKeySwitch;
+    auto &cbs = p.wopPBS.circuitBootstrap;
+    os << pks.inputLweDimension << "," << pks.outputPolynomialSize << ","
+       << pks.level << "," << pks.baseLog << "," << cbs.level << ","
+       << cbs.baseLog;
+  };
+
+  // The artifacts are built for the host machine
+  os << llvm::sys::getDefaultTargetTriple() << ";"
+     << llvm::sys::getHostCPUName() << ";" << runtimeLibraryPath << ";";
+  if (options.chunkParallelism == 0 || options.fhelinalgAutoTiling)
+    os << std::thread::hardware_concurrency() << ";";
+  if (options.fhelinalgAutoTiling && options.tilingCacheBudget == 0)
+    os << getHostCacheSize() << ";";
+
+  printOptional(options.v0FHEConstraints, [&](const V0FHEConstraint &c) {
+    os << c.norm2 << "," << c.p;
+  });
+  printOptional(options.v0Parameter, [&](const V0Parameter &p) {
+    os << p.glweDimension << "," << p.logPolynomialSize << "," << p.nSmall
+       << "," << p.brLevel << "," << p.brLogBase << "," << p.ksLevel << ","
+       << p.ksLogBase << ",";
+    printOptional(p.largeInteger, printLargeInteger);
+  });
+  printOptional(options.largeIntegerParameter, printLargeInteger);
+  os << options.autoParallelize << options.loopParallelize
+     << options.batchTFHEOps << options.emitSDFGOps
+     << options.unrollLoopsWithSDFGConvertibleOps
+     << options.dataflowParallelize << options.optimizeTFHE
+     << options.simulate << options.emitGPUOps << options.chunkIntegers
+     << options.skipProgramInfo << options.compressEvaluationKeys
+     << options.shrinkOutputs << options.fhelinalgAutoTiling
+     << options.memoryPlanning << ";"
+     << options.tilingCacheBudget << ";" << options.maxBatchSize << ";"
+     << options.chunkSize << ";" << options.chunkWidth << ";"
+     << options.chunkParallelism << ";" << options.keyswitchKeyPrecision
+     << ";";
+  printOptional(options.fhelinalgTileSizes,
+                [&](const std::vector<int64_t> &sizes) {
+                  for (auto size : sizes)
+                    os << size << ",";
+                });
+  printOptional(options.encodings, [&](const auto &encodings) {
+    os << encodings.writeJsonToString().value();
+  });
+
+  auto &config = options.optimizerConfig;
+  printDouble(config.p_error);
+  printDouble(config.global_p_error);
+  printDouble(config.fallback_log_norm_woppbs);
+  os << config.display << config.key_sharing << config.use_gpu_constraints
+     << config.composable << ";" << (int)config.strategy << ";"
+     << (int)config.multi_param_strategy << ";" << (int)config.encoding << ";"
+     << config.security << ";" << config.ciphertext_modulus_log << ";"
+     << config.fft_precision << ";";
+  printDouble(config.cpu_cost_factors.ks);
+  printDouble(config.cpu_cost_factors.pbs);
+  printDouble(config.cpu_cost_factors.levelled);
+
+  auto printSize = [&](const std::optional<size_t> &size) {
+    printOptional(size, [&](size_t value) { os << value; });
+  };
+  printSize(this->overrideMaxEintPrecision);
+  printSize(this->overrideMaxMANP);
+  os << this->generateProgramInfo;
+  return os.str();
 }
 
 /// Returns the optimizer::Description
@@ -161,6 +296,7 @@ CompilerEngine::getConcreteOptimizerDescription(CompilationResult &res) {
     return optimizer::Description{constraint, std::nullopt};
   }
   auto config = this->compilerOptions.optimizerConfig;
+  config.shrink_outputs = this->compilerOptions.shrinkOutputs;
   auto descriptions = mlir::concretelang::pipeline::getFHEContextFromFHE(
       mlirContext, module, config, enablePass);
   if (auto err = descriptions.takeError()) {
@@ -317,6 +453,9 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
 
   mlir::MLIRContext &mlirContext = *this->compilationContext->getMLIRContext();
 
+  // Function-level passes run on the functions of the module in parallel
+  mlirContext.enableMultithreading(options.multithreading);
+
   // enable/disable usage of gpu functions during bufferization
   EMIT_GPU_OPS = options.emitGPUOps;
 
@@ -366,9 +505,17 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
   }
 
   if (options.chunkIntegers) {
+    // Without an explicit parallelism, the table lookups on chunks are
+    // expected to run concurrently only if the circuit is parallelized.
+    unsigned int chunkParallelism = options.chunkParallelism;
+    if (chunkParallelism == 0) {
+      chunkParallelism = (dataflowParallelize || options.emitGPUOps)
+                             ? std::max(1u, std::thread::hardware_concurrency())
+                             : 1;
+    }
     if (mlir::concretelang::pipeline::transformFHEBigInt(
             mlirContext, module, enablePass, options.chunkSize,
-            options.chunkWidth)
+            options.chunkWidth, chunkParallelism)
             .failed()) {
       return StreamStringError("Transforming FHE big integer ops failed");
     }
@@ -409,6 +556,30 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
           "Marking of FHELinalg operations for tiling failed");
   }
 
+  if (options.fhelinalgAutoTiling) {
+    if (options.optimizerConfig.strategy == optimizer::Strategy::DAG_MULTI) {
+      // The optimizer identifies the elements of tensor operations with
+      // multi-parameters, which tiling would mix up.
+      warnx("WARNING: automatic tiling is not compatible with the optimizer "
+            "strategy [dag-multi]. Continuing without automatic tiling.");
+    } else {
+      uint64_t cacheBudget = options.tilingCacheBudget;
+      if (cacheBudget == 0)
+        cacheBudget = getHostCacheSize();
+      // Without parallelization, tiles are processed by a single worker
+      uint64_t numWorkers =
+          (dataflowParallelize || loopParallelize)
+              ? std::max(1u, std::thread::hardware_concurrency())
+              : 1;
+      if (mlir::concretelang::pipeline::markFHELinalgForAutoTiling(
+              mlirContext, module, getCiphertextSize(res.fheContext),
+              cacheBudget, numWorkers, enablePass)
+              .failed())
+        return StreamStringError(
+            "Automatic marking of FHELinalg operations for tiling failed");
+    }
+  }
+
   if (mlir::concretelang::pipeline::tileMarkedFHELinalg(mlirContext, module,
                                                         enablePass)
           .failed()) {
@@ -443,7 +614,9 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
 
   // Dataflow parallelization
   if (dataflowParallelize &&
-      mlir::concretelang::pipeline::autopar(mlirContext, module, enablePass)
+      mlir::concretelang::pipeline::autopar(mlirContext, module,
+                                            res.fheContext,
+                                            options.optimizerConfig, enablePass)
           .failed()) {
     return StreamStringError("Dataflow parallelization failed");
   }
@@ -478,6 +651,40 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
     return StreamStringError("Parametrization of TFHE operations failed");
   }
 
+  // Shrink outputs. Shrunk outputs can not be fed back to the circuits, which
+  // makes the option incompatible with composition. Only the dag strategies
+  // account for the output keyswitch, and the wop-pbs parameters of crt
+  // encoded circuits do not, such circuits keep their outputs.
+  if (options.shrinkOutputs) {
+    if (options.optimizerConfig.composable) {
+      return StreamStringError(
+          "Output shrinking is not supported for composable circuits");
+    }
+    if (options.optimizerConfig.strategy == optimizer::Strategy::V0) {
+      return StreamStringError(
+          "Output shrinking requires the dag-mono or dag-multi strategy");
+    }
+  }
+  if (options.shrinkOutputs && res.fheContext.has_value() &&
+      !getCrtDecompositionFromSolution(res.fheContext->solution)
+           .has_value()) {
+    if (mlir::concretelang::pipeline::shrinkTFHEOutputs(mlirContext, module,
+                                                        enablePass)
+            .failed()) {
+      return StreamStringError("Shrinking of TFHE outputs failed");
+    }
+  }
+
+  if (options.keyswitchKeyPrecision != 32 &&
+      options.keyswitchKeyPrecision != 64) {
+    return StreamStringError("Keyswitch keys precision must be 32 or 64, got ")
+           << options.keyswitchKeyPrecision;
+  }
+  if (options.keyswitchKeyPrecision == 32 && options.emitGPUOps) {
+    return StreamStringError(
+        "32 bits keyswitch keys are not supported on GPU");
+  }
+
   if (target == Target::PARAMETRIZED_TFHE)
     return std::move(res);
 
@@ -507,7 +714,8 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
       auto programInfoOrErr =
           mlir::concretelang::createProgramInfoFromTfheDialect(
               module, options.optimizerConfig.security,
-              options.encodings.value(), options.compressEvaluationKeys);
+              options.encodings.value(), options.compressEvaluationKeys,
+              options.shrinkOutputs, options.keyswitchKeyPrecision);
 
       if (!programInfoOrErr)
         return programInfoOrErr.takeError();
@@ -529,6 +737,15 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
   }
 
   if (options.simulate) {
+    // Batching happens before the simulation, such that batched operations
+    // are simulated by the batched entry points of the simulation runtime.
+    if (options.batchTFHEOps) {
+      if (mlir::concretelang::pipeline::batchTFHE(
+              mlirContext, module, enablePass, options.maxBatchSize)
+              .failed()) {
+        return StreamStringError("Batching of TFHE operations");
+      }
+    }
     if (mlir::concretelang::pipeline::simulateTFHE(mlirContext, module,
                                                    this->enablePass)
             .failed()) {
@@ -539,7 +756,7 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
   if (target == Target::SIMULATED_TFHE)
     return std::move(res);
 
-  if (options.batchTFHEOps) {
+  if (options.batchTFHEOps && !options.simulate) {
     if (mlir::concretelang::pipeline::batchTFHE(mlirContext, module, enablePass,
                                                 options.maxBatchSize)
             .failed()) {
@@ -609,6 +826,14 @@ CompilerEngine::compile(mlir::ModuleOp moduleOp, Target target,
     }
   }
 
+  if (options.memoryPlanning &&
+      mlir::concretelang::pipeline::planMemory(
+          mlirContext, module, this->enablePass,
+          res.feedback.has_value() ? &res.feedback.value() : nullptr)
+          .failed()) {
+    return StreamStringError("Memory planning failed");
+  }
+
   if (mlir::concretelang::pipeline::lowerToCAPI(mlirContext, module, enablePass,
                                                 options.emitGPUOps)
           .failed()) {
@@ -683,53 +908,137 @@ CompilerEngine::compile(std::unique_ptr<llvm::MemoryBuffer> buffer,
   return this->compile(sm, target, lib);
 }
 
-llvm::Expected<CompilerEngine::Library>
-CompilerEngine::compile(std::vector<std::string> inputs,
-                        std::string outputDirPath,
-                        std::string runtimeLibraryPath, bool generateSharedLib,
-                        bool generateStaticLib, bool generateClientParameters,
-                        bool generateCompilationFeedback) {
+/// Returns the canonical form of `module`, used to identify it in the
+/// compilation cache. Comments, formatting and locations of the sources don't
+/// change it.
+std::string printCanonicalModule(mlir::ModuleOp module) {
+  std::string canonical;
+  llvm::raw_string_ostream os(canonical);
+  module.print(os, mlir::OpPrintingFlags().printGenericOpForm());
+  return os.str();
+}
+
+/// Returns the canonical forms of the modules parsed from `sources`, or
+/// std::nullopt if one of them doesn't parse, leaving the compilation report
+/// the errors.
+std::optional<std::vector<std::string>>
+canonicalizeSources(mlir::MLIRContext &context,
+                    const std::vector<llvm::StringRef> &sources) {
+  mlir::ScopedDiagnosticHandler ignoreDiagnostics(
+      &context, [](mlir::Diagnostic &) { return mlir::success(); });
+  std::vector<std::string> canonicalModules;
+  for (auto source : sources) {
+    auto module = mlir::parseSourceString<mlir::ModuleOp>(source, &context);
+    if (!module)
+      return std::nullopt;
+    canonicalModules.push_back(printCanonicalModule(*module));
+  }
+  return canonicalModules;
+}
+
+/// Compiles a library with `compileModules` and emits its artifacts. If the
+/// options of `engine` set a compilation cache, the artifacts of a previous
+/// compilation of the same `canonicalModules` are reused instead, and the
+/// artifacts of a new compilation are stored in the cache.
+llvm::Expected<CompilerEngine::Library> compileLibrary(
+    CompilerEngine *engine,
+    std::optional<std::vector<std::string>> canonicalModules,
+    std::function<llvm::Error(std::shared_ptr<CompilerEngine::Library>)>
+        compileModules,
+    std::string outputDirPath, std::string runtimeLibraryPath,
+    bool generateSharedLib, bool generateStaticLib,
+    bool generateClientParameters, bool generateCompilationFeedback) {
   using Library = mlir::concretelang::CompilerEngine::Library;
   auto outputLib = std::make_shared<Library>(outputDirPath, runtimeLibraryPath);
-  auto target = CompilerEngine::Target::LIBRARY;
-  for (auto input : inputs) {
-    auto compilation = compile(input, target, outputLib);
-    if (!compilation) {
-      return compilation.takeError();
+
+  auto cacheDir = engine->getCompilationOptions().compilationCacheDir;
+  std::optional<std::string> key;
+  if (cacheDir.has_value() && canonicalModules.has_value()) {
+    auto configuration = engine->getCacheConfiguration(runtimeLibraryPath);
+    if (configuration.has_value())
+      key = CompilationCache::getKey(*canonicalModules, *configuration);
+  }
+  if (key.has_value()) {
+    auto restored = CompilationCache(*cacheDir).restore(
+        *key, *outputLib, generateSharedLib, generateStaticLib,
+        generateClientParameters, generateCompilationFeedback);
+    if (!restored) {
+      warnx("WARNING: cannot restore cached compilation, compiling anyway: "
+            "%s",
+            llvm::toString(restored.takeError()).c_str());
+    } else if (*restored) {
+      return *outputLib.get();
     }
   }
+
+  if (auto err = compileModules(outputLib)) {
+    return std::move(err);
+  }
   if (auto err = outputLib->emitArtifacts(generateSharedLib, generateStaticLib,
                                           generateClientParameters,
                                           generateCompilationFeedback)) {
     return StreamStringError("Can't emit artifacts: ")
            << llvm::toString(std::move(err));
   }
+
+  if (key.has_value()) {
+    if (auto err = CompilationCache(*cacheDir).store(*key, *outputLib)) {
+      warnx("WARNING: cannot cache compilation: %s",
+            llvm::toString(std::move(err)).c_str());
+    }
+  }
   return *outputLib.get();
 }
 
+llvm::Expected<CompilerEngine::Library>
+CompilerEngine::compile(std::vector<std::string> inputs,
+                        std::string outputDirPath,
+                        std::string runtimeLibraryPath, bool generateSharedLib,
+                        bool generateStaticLib, bool generateClientParameters,
+                        bool generateCompilationFeedback) {
+  std::optional<std::vector<std::string>> canonicalModules;
+  if (compilerOptions.compilationCacheDir.has_value()) {
+    canonicalModules = canonicalizeSources(
+        *compilationContext->getMLIRContext(),
+        std::vector<llvm::StringRef>(inputs.begin(), inputs.end()));
+  }
+  auto target = CompilerEngine::Target::LIBRARY;
+  return compileLibrary(
+      this, canonicalModules,
+      [&](std::shared_ptr<Library> outputLib) -> llvm::Error {
+        for (auto input : inputs) {
+          auto compilation = compile(input, target, outputLib);
+          if (!compilation) {
+            return compilation.takeError();
+          }
+        }
+        return llvm::Error::success();
+      },
+      outputDirPath, runtimeLibraryPath, generateSharedLib, generateStaticLib,
+      generateClientParameters, generateCompilationFeedback);
+}
+
 template <typename T>
 llvm::Expected<CompilerEngine::Library>
 compileModuleOrSource(CompilerEngine *engine, T module,
+                      std::optional<std::vector<std::string>> canonicalModules,
                       std::string outputDirPath, std::string runtimeLibraryPath,
                       bool generateSharedLib, bool generateStaticLib,
                       bool generateClientParameters,
                       bool generateCompilationFeedback) {
   using Library = mlir::concretelang::CompilerEngine::Library;
-  auto outputLib = std::make_shared<Library>(outputDirPath, runtimeLibraryPath);
   auto target = CompilerEngine::Target::LIBRARY;
-
-  auto compilation = engine->compile(module, target, outputLib);
-  if (!compilation) {
-    return compilation.takeError();
-  }
-
-  if (auto err = outputLib->emitArtifacts(generateSharedLib, generateStaticLib,
-                                          generateClientParameters,
-                                          generateCompilationFeedback)) {
-    return StreamStringError("Can't emit artifacts: ")
-           << llvm::toString(std::move(err));
-  }
-  return *outputLib.get();
+  return compileLibrary(
+      engine, canonicalModules,
+      [&](std::shared_ptr<Library> outputLib) -> llvm::Error {
+        auto compilation = engine->compile(module, target, outputLib);
+        if (!compilation) {
+          return compilation.takeError();
+        }
+        return llvm::Error::success();
+      },
+      outputDirPath, runtimeLibraryPath, generateSharedLib, generateStaticLib,
+      generateClientParameters, generateCompilationFeedback);
 }
 
 llvm::Expected<CompilerEngine::Library>
@@ -737,9 +1046,16 @@ CompilerEngine::compile(llvm::SourceMgr &sm, std::string outputDirPath,
                         std::string runtimeLibraryPath, bool generateSharedLib,
                         bool generateStaticLib, bool generateClientParameters,
                         bool generateCompilationFeedback) {
+  std::optional<std::vector<std::string>> canonicalModules;
+  if (compilerOptions.compilationCacheDir.has_value()) {
+    auto source = sm.getMemoryBuffer(sm.getMainFileID())->getBuffer();
+    canonicalModules =
+        canonicalizeSources(*compilationContext->getMLIRContext(), {source});
+  }
   return compileModuleOrSource<llvm::SourceMgr &>(
-      this, sm, outputDirPath, runtimeLibraryPath, generateSharedLib,
-      generateStaticLib, generateClientParameters, generateCompilationFeedback);
+      this, sm, canonicalModules, outputDirPath, runtimeLibraryPath,
+      generateSharedLib, generateStaticLib, generateClientParameters,
+      generateCompilationFeedback);
 }
 
 llvm::Expected<CompilerEngine::Library>
@@ -747,9 +1063,14 @@ CompilerEngine::compile(mlir::ModuleOp module, std::string outputDirPath,
                         std::string runtimeLibraryPath, bool generateSharedLib,
                         bool generateStaticLib, bool generateClientParameters,
                         bool generateCompilationFeedback) {
+  std::optional<std::vector<std::string>> canonicalModules;
+  if (compilerOptions.compilationCacheDir.has_value()) {
+    canonicalModules = std::vector<std::string>{printCanonicalModule(module)};
+  }
   return compileModuleOrSource<mlir::ModuleOp>(
-      this, module, outputDirPath, runtimeLibraryPath, generateSharedLib,
-      generateStaticLib, generateClientParameters, generateCompilationFeedback);
+      this, module, canonicalModules, outputDirPath, runtimeLibraryPath,
+      generateSharedLib, generateStaticLib, generateClientParameters,
+      generateCompilationFeedback);
 }
 
 /// Returns the path of the shared library
@@ -818,6 +1139,37 @@ const std::string &CompilerEngine::Library::getOutputDirPath() const {
   return outputDirPath;
 }
 
+const ProgramCompilationFeedback &
+CompilerEngine::Library::getCompilationFeedback() const {
+  return compilationFeedback;
+}
+
+llvm::Error CompilerEngine::Library::loadArtifacts(std::string artifactsDirPath,
+                                                   bool sharedLib,
+                                                   bool staticLib) {
+  auto programInfoPath = getProgramInfoPath(artifactsDirPath);
+  std::ifstream file(programInfoPath);
+  std::string content((std::istreambuf_iterator<char>(file)),
+                      (std::istreambuf_iterator<char>()));
+  if (file.fail()) {
+    return StreamStringError("Cannot read file: ") << programInfoPath;
+  }
+  if (programInfo.readJsonFromString(content).has_failure()) {
+    return StreamStringError("Cannot read program info: ") << programInfoPath;
+  }
+  auto feedback = ProgramCompilationFeedback::load(
+      getCompilationFeedbackPath(artifactsDirPath));
+  if (feedback.has_failure()) {
+    return StreamStringError(feedback.as_failure().error().mesg);
+  }
+  compilationFeedback = feedback.value();
+  if (sharedLib)
+    sharedLibraryPath = getSharedLibraryPath(outputDirPath);
+  if (staticLib)
+    staticLibraryPath = getStaticLibraryPath(outputDirPath);
+  return llvm::Error::success();
+}
+
 llvm::Expected<std::string> CompilerEngine::Library::emitProgramInfoJSON() {
   auto programInfoPath = getProgramInfoPath(outputDirPath);
   std::error_code error;
@@ -3,6 +3,11 @@
 // https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
 // for license information.
 
+#include <mutex>
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
 
 #include "concretelang/Support/CompilationFeedback.h"
@@ -16,7 +21,9 @@
 
 #include "mlir/Dialect/Affine/Passes.h"
 #include "mlir/Dialect/Arith/Transforms/Passes.h"
+#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
 #include "mlir/Dialect/Bufferization/Transforms/OneShotAnalysis.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Bufferization/Transforms/Passes.h"
 #include "mlir/Dialect/Linalg/Passes.h"
 #include "mlir/Dialect/SCF/Transforms/Passes.h"
@@ -48,11 +55,16 @@
 #include "concretelang/Dialect/TFHE/Transforms/Transforms.h"
 #include "concretelang/Support/CompilerEngine.h"
 #include "concretelang/Support/Error.h"
+#include "concretelang/Support/LLVMEmitFile.h"
 #include "concretelang/Support/Pipeline.h"
 #include "concretelang/Support/logging.h"
 #include "concretelang/Support/math.h"
 #include "concretelang/Transforms/Passes.h"
 
+// Defines runtimeBitcode and runtimeBitcode_size, the leveled operations of
+// the runtime compiled to LLVM bitcode
+#include "RuntimeBitcode.inc"
+
 namespace mlir {
 namespace concretelang {
 namespace pipeline {
@@ -95,6 +107,8 @@ getFHEContextFromFHE(mlir::MLIRContext &context, mlir::ModuleOp &module,
   std::optional<size_t> oMax2norm;
   std::optional<size_t> oMaxWidth;
   optimizer::FunctionsDag dags;
+  // MaxMANP runs on the functions of the module in parallel
+  std::mutex maxGuard;
 
   mlir::PassManager pm(&context);
 
@@ -106,6 +120,7 @@ getFHEContextFromFHE(mlir::MLIRContext &context, mlir::ModuleOp &module,
       pm,
       mlir::concretelang::createMaxMANPPass(
           [&](const uint64_t manp, unsigned width) {
+            std::lock_guard<std::mutex> guard(maxGuard);
             if (!oMax2norm.has_value() || oMax2norm.value() < manp)
               oMax2norm.emplace(manp);
 
@@ -174,13 +189,77 @@ mlir::LogicalResult materializeOptimizerPartitionFrontiers(
   return pm.run(module.getOperation());
 }
 
+/// Number of bootstraps a dataflow task should perform at most, such that
+/// there are enough tasks to balance the load between the workers, while the
+/// overhead of a task remains negligible.
+static const double kMaxBootstrapsPerTask = 16.;
+
+/// Returns the cost model of the dataflow tasks with the parameters of
+/// `fheContext`, the costs being estimated by the complexity model of the
+/// optimizer configured by `config`.
+static DataflowTaskCostModel
+getDataflowTaskCostModel(std::optional<V0FHEContext> &fheContext,
+                         optimizer::Config config) {
+  DataflowTaskCostModel costModel;
+  if (!fheContext.has_value())
+    return costModel;
+
+  auto options = options_from_config(config);
+  if (auto mono = std::get_if<V0Parameter>(&fheContext->solution)) {
+    costModel.bootstrapCost =
+        concrete_optimizer::utils::keyswitch_complexity(
+            mono->getNBigLweDimension(), mono->nSmall, mono->ksLevel,
+            options) +
+        concrete_optimizer::utils::bootstrap_complexity(
+            mono->nSmall, mono->glweDimension, mono->getPolynomialSize(),
+            mono->brLevel, options);
+    costModel.leveledCost = concrete_optimizer::utils::levelled_complexity(
+        mono->getNBigLweDimension(), options);
+  } else {
+    // With several partitions, the costliest keys are considered
+    auto &keys =
+        std::get<optimizer::CircuitSolution>(fheContext->solution).circuit_keys;
+    auto getDimension = [](const concrete_optimizer::dag::SecretLweKey &key) {
+      return key.glwe_dimension * key.polynomial_size;
+    };
+    double maxKeyswitchCost = 0.;
+    for (auto &ksk : keys.keyswitch_keys)
+      maxKeyswitchCost = std::max(
+          maxKeyswitchCost, concrete_optimizer::utils::keyswitch_complexity(
+                                getDimension(ksk.input_key),
+                                getDimension(ksk.output_key),
+                                ksk.ks_decomposition_parameter.level, options));
+    double maxBootstrapCost = 0.;
+    for (auto &bsk : keys.bootstrap_keys)
+      maxBootstrapCost = std::max(
+          maxBootstrapCost, concrete_optimizer::utils::bootstrap_complexity(
+                                getDimension(bsk.input_key),
+                                bsk.output_key.glwe_dimension,
+                                bsk.output_key.polynomial_size,
+                                bsk.br_decomposition_parameter.level, options));
+    costModel.bootstrapCost = maxKeyswitchCost + maxBootstrapCost;
+    for (auto &key : keys.secret_keys)
+      costModel.leveledCost = std::max(
+          costModel.leveledCost, concrete_optimizer::utils::levelled_complexity(
+                                     getDimension(key), options));
+  }
+  costModel.minTaskCost = costModel.bootstrapCost;
+  costModel.maxTaskCost = kMaxBootstrapsPerTask * costModel.bootstrapCost;
+  return costModel;
+}
+
 mlir::LogicalResult autopar(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                            std::optional<V0FHEContext> &fheContext,
+                            optimizer::Config config,
                             std::function<bool(mlir::Pass *)> enablePass) {
   mlir::PassManager pm(&context);
   pipelinePrinting("AutoPar", pm, context);
 
   addPotentiallyNestedPass(
-      pm, mlir::concretelang::createBuildDataflowTaskGraphPass(), enablePass);
+      pm,
+      mlir::concretelang::createBuildDataflowTaskGraphPass(
+          false, getDataflowTaskCostModel(fheContext, config)),
+      enablePass);
   addPotentiallyNestedPass(
       pm, mlir::concretelang::createLowerDataflowTasksPass(), enablePass);
 
@@ -210,6 +289,21 @@ markFHELinalgForTiling(mlir::MLIRContext &context, mlir::ModuleOp &module,
   return pm.run(module.getOperation());
 }
 
+mlir::LogicalResult
+markFHELinalgForAutoTiling(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                           uint64_t ciphertextSize, uint64_t cacheBudget,
+                           uint64_t numWorkers,
+                           std::function<bool(mlir::Pass *)> enablePass) {
+  mlir::PassManager pm(&context);
+  pipelinePrinting("MarkFHELinalgForAutoTiling", pm, context);
+  addPotentiallyNestedPass(pm,
+                           createFHELinalgAutoTilingMarkerPass(
+                               ciphertextSize, cacheBudget, numWorkers),
+                           enablePass);
+
+  return pm.run(module.getOperation());
+}
+
 mlir::LogicalResult
 transformHighLevelFHEOps(mlir::MLIRContext &context, mlir::ModuleOp &module,
                          std::function<bool(mlir::Pass *)> enablePass) {
@@ -263,12 +357,13 @@ transformFHEBoolean(mlir::MLIRContext &context, mlir::ModuleOp &module,
 mlir::LogicalResult
 transformFHEBigInt(mlir::MLIRContext &context, mlir::ModuleOp &module,
                    std::function<bool(mlir::Pass *)> enablePass,
-                   unsigned int chunkSize, unsigned int chunkWidth) {
+                   unsigned int chunkSize, unsigned int chunkWidth,
+                   unsigned int parallelism) {
   mlir::PassManager pm(&context);
-  addPotentiallyNestedPass(
-      pm,
-      mlir::concretelang::createFHEBigIntTransformPass(chunkSize, chunkWidth),
-      enablePass);
+  addPotentiallyNestedPass(pm,
+                           mlir::concretelang::createFHEBigIntTransformPass(
+                               chunkSize, chunkWidth, parallelism),
+                           enablePass);
   // We want to fully unroll for loops introduced by the BigInt transform since
   // MANP doesn't support loops. This is a workaround that make the IR much
   // bigger than it should be
@@ -346,6 +441,18 @@ parametrizeTFHE(mlir::MLIRContext &context, mlir::ModuleOp &module,
   return pm.run(module.getOperation());
 }
 
+mlir::LogicalResult
+shrinkTFHEOutputs(mlir::MLIRContext &context, mlir::ModuleOp &module,
+                  std::function<bool(mlir::Pass *)> enablePass) {
+  mlir::PassManager pm(&context);
+  pipelinePrinting("TFHEOutputShrinking", pm, context);
+
+  addPotentiallyNestedPass(
+      pm, mlir::concretelang::createTFHEOutputShrinkingPass(), enablePass);
+
+  return pm.run(module.getOperation());
+}
+
 mlir::LogicalResult batchTFHE(mlir::MLIRContext &context,
                               mlir::ModuleOp &module,
                               std::function<bool(mlir::Pass *)> enablePass,
@@ -410,6 +517,19 @@ computeMemoryUsage(mlir::MLIRContext &context, mlir::ModuleOp &module,
   return pm.run(module.getOperation());
 }
 
+mlir::LogicalResult planMemory(mlir::MLIRContext &context,
+                               mlir::ModuleOp &module,
+                               std::function<bool(mlir::Pass *)> enablePass,
+                               ProgramCompilationFeedback *feedback) {
+  mlir::PassManager pm(&context);
+  pipelinePrinting("Memory Planning", pm, context);
+
+  addPotentiallyNestedPass(
+      pm, mlir::concretelang::createMemoryPlanningPass(feedback), enablePass);
+
+  return pm.run(module.getOperation());
+}
+
 mlir::LogicalResult optimizeTFHE(mlir::MLIRContext &context,
                                  mlir::ModuleOp &module,
                                  std::function<bool(mlir::Pass *)> enablePass) {
@@ -473,6 +593,20 @@ mlir::LogicalResult lowerToStd(mlir::MLIRContext &context,
   mlir::PassManager pm(&context);
   pipelinePrinting("Lowering to Std", pm, context);
 
+  // The arguments of the circuits are buffers of the caller, which may pass
+  // the same value to several calls (e.g. the values kept on the server), so
+  // the circuits must not bufferize in place into them.
+  for (auto func : module.getOps<mlir::func::FuncOp>()) {
+    if (!func.isPublic())
+      continue;
+    for (unsigned int i = 0; i < func.getNumArguments(); i++) {
+      if (func.getArgument(i).getType().isa<mlir::TensorType>())
+        func.setArgAttr(
+            i, mlir::bufferization::BufferizationDialect::kWritableAttrName,
+            mlir::BoolAttr::get(&context, false));
+    }
+  }
+
   // Replace non-bufferizable ops (e;g., `tensor.empty` ->
   // `bufferization.alloc_tensor`)
   addPotentiallyNestedPass(
@@ -575,17 +709,71 @@ lowerLLVMDialectToLLVMIR(mlir::MLIRContext &context,
   return mlir::translateModuleToLLVMIR(module, llvmContext);
 }
 
+/// Links into `module` the definitions of the runtime functions it calls and
+/// which are shipped as LLVM bitcode. The linked definitions are internal and
+/// always inlined, such that they are optimized with the loops of the circuits
+/// and don't outlive the optimization of the module.
+mlir::LogicalResult linkRuntimeBitcode(llvm::Module &module) {
+  if (runtimeBitcode_size == 0)
+    return mlir::success();
+
+  auto buffer = llvm::MemoryBuffer::getMemBuffer(
+      llvm::StringRef((const char *)runtimeBitcode, runtimeBitcode_size),
+      "runtime bitcode", false);
+  auto runtimeModule =
+      llvm::parseBitcodeFile(buffer->getMemBufferRef(), module.getContext());
+  if (!runtimeModule) {
+    llvm::consumeError(runtimeModule.takeError());
+    return mlir::failure();
+  }
+  (*runtimeModule)->setDataLayout(module.getDataLayout());
+  (*runtimeModule)->setTargetTriple(module.getTargetTriple());
+
+  llvm::SmallVector<std::string> linkedFunctions;
+  for (auto &func : **runtimeModule) {
+    auto declaration = module.getFunction(func.getName());
+    if (!func.isDeclaration() && declaration != nullptr &&
+        declaration->isDeclaration())
+      linkedFunctions.push_back(func.getName().str());
+  }
+  if (linkedFunctions.empty())
+    return mlir::success();
+
+  if (llvm::Linker::linkModules(module, std::move(*runtimeModule),
+                                llvm::Linker::LinkOnlyNeeded))
+    return mlir::failure();
+
+  for (auto &name : linkedFunctions) {
+    auto func = module.getFunction(name);
+    func->setLinkage(llvm::GlobalValue::InternalLinkage);
+    func->addFnAttr(llvm::Attribute::AlwaysInline);
+    // The target of the module is the host, the functions are optimized for
+    // the same one.
+    func->removeFnAttr("target-cpu");
+    func->removeFnAttr("target-features");
+    func->removeFnAttr("tune-cpu");
+  }
+  return mlir::success();
+}
+
 mlir::LogicalResult optimizeLLVMModule(llvm::LLVMContext &llvmContext,
                                        llvm::Module &module) {
-  // -O3 is done LLVMEmitFile.cpp
-  auto optLevel = llvm::CodeGenOpt::None;
+  auto targetMachine = getTargetMachineAndSetupModule(&module);
+  if (!targetMachine)
+    return mlir::failure();
+
+  if (linkRuntimeBitcode(module).failed())
+    return mlir::failure();
+
+  // The code generation is also done at -O3 in LLVMEmitFile.cpp
   std::function<llvm::Error(llvm::Module *)> optPipeline =
-      mlir::makeOptimizingTransformer(optLevel, 0, nullptr);
+      mlir::makeOptimizingTransformer(3, 0, targetMachine.get());
 
-  if (optPipeline(&module))
+  if (auto err = optPipeline(&module)) {
+    llvm::consumeError(std::move(err));
     return mlir::failure();
-  else
-    return mlir::success();
+  }
+  return mlir::success();
 }
 
 } // namespace pipeline
@@ -3,7 +3,9 @@
 // https://github.com/zama-ai/concrete-compiler-internal/blob/main/LICENSE.txt
 // for license information.
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <map>
 #include <memory>
 #include <optional>
@@ -35,6 +37,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/abi-breaking.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
 
 using concretelang::protocol::Message;
 
@@ -44,10 +47,39 @@ namespace concretelang {
 const auto keyFormat = concrete::BINARY;
 typedef double Variance;
 
+/// Returns the log2 of the modulus the outputs encrypted under the secret key
+/// `keyIndex` are switched to when shrunk, i.e. the modulus 2N of the blind
+/// rotation of the bootstrap key taking this key as input. The output
+/// shrinking keyswitches outputs to such keys, and the optimizer checks the
+/// noise of the keyswitch and of this modulus switch as for a lookup table
+/// input. Outputs under any other key were not shrunk and keep the native
+/// modulus.
+std::optional<unsigned int>
+getShrunkOutputModulusLog(const TFHE::TFHECircuitKeys &circuitKeys,
+                          uint64_t keyIndex) {
+  for (auto bsk : circuitKeys.bootstrapKeys) {
+    if (bsk.getInputKey().getNormalized()->index == keyIndex) {
+      return llvm::Log2_64(bsk.getPolySize()) + 1;
+    }
+  }
+  return std::nullopt;
+}
+
+/// Sets the encryption modulus and the raw info precision of a shrunk output
+/// ciphertext gate.
+void setShrunkOutputModulus(
+    concreteprotocol::LweCiphertextEncryptionInfo::Builder encryptionInfo,
+    concreteprotocol::RawInfo::Builder rawInfo, unsigned int modulusLog) {
+  encryptionInfo.initModulus().initMod().initPowerOfTwo().setPower(modulusLog);
+  rawInfo.setIntegerPrecision(
+      ::concretelang::values::getCorrespondingPrecision(modulusLog));
+}
+
 llvm::Expected<Message<concreteprotocol::GateInfo>>
 generateGate(mlir::Type inputType,
              const Message<concreteprotocol::EncodingInfo> &inputEncodingInfo,
-             concrete::SecurityCurve curve) {
+             concrete::SecurityCurve curve,
+             const TFHE::TFHECircuitKeys *shrinkingKeys = nullptr) {
 
   auto inputEncoding = inputEncodingInfo.asReader().getEncoding();
   if (!inputEncoding.hasIntegerCiphertext() &&
@@ -110,6 +142,15 @@ generateGate(mlir::Type inputType,
     rawShape.setDimensions(gateDimensions.asReader());
     rawInfo.setIntegerPrecision(64);
     rawInfo.setIsSigned(false);
+    // Crt encoded ciphertexts do not use the most significant bits of the
+    // ciphertext, and are kept on the native modulus.
+    auto mode = inputEncoding.getIntegerCiphertext().getMode();
+    if (shrinkingKeys != nullptr && !mode.hasCrt()) {
+      if (auto modulusLog =
+              getShrunkOutputModulusLog(*shrinkingKeys, normKey.index)) {
+        setShrunkOutputModulus(encryptionInfo, rawInfo, *modulusLog);
+      }
+    }
   } else if (inputEncoding.hasBooleanCiphertext()) {
     auto glweType = inputType.cast<TFHE::GLWECipherTextType>();
     auto normKey = glweType.getKey().getNormalized().value();
@@ -139,6 +180,12 @@ generateGate(mlir::Type inputType,
     rawShape.setDimensions(gateDimensions.asReader());
     rawInfo.setIntegerPrecision(64);
     rawInfo.setIsSigned(false);
+    if (shrinkingKeys != nullptr) {
+      if (auto modulusLog =
+              getShrunkOutputModulusLog(*shrinkingKeys, normKey.index)) {
+        setShrunkOutputModulus(encryptionInfo, rawInfo, *modulusLog);
+      }
+    }
   } else if (inputEncoding.hasPlaintext()) {
     auto plaintextGateInfo = output.asBuilder().initTypeInfo().initPlaintext();
     plaintextGateInfo.setShape(inputShape);
@@ -172,7 +219,9 @@ generateGate(mlir::Type inputType,
 
 Message<concreteprotocol::KeysetInfo>
 extractKeysetInfo(TFHE::TFHECircuitKeys circuitKeys,
-                  concrete::SecurityCurve curve, bool compressEvaluationKeys) {
+                  concrete::SecurityCurve curve, bool compressEvaluationKeys,
+                  unsigned int keyswitchKeyPrecision,
+                  llvm::ArrayRef<TFHE::GLWEKeyswitchKeyAttr> wopKeyswitchKeys) {
 
   auto output = Message<concreteprotocol::KeysetInfo>();
 
@@ -208,12 +257,22 @@ extractKeysetInfo(TFHE::TFHECircuitKeys circuitKeys,
       infoMessage.asBuilder().setCompression(
           concreteprotocol::Compression::SEED);
     }
+    // Keyswitch keys are generated on a 32 bits modulus when requested, and
+    // when the decomposition only reads the 32 most significant bits of the
+    // input ciphertexts, in which case the keyswitch noise is unchanged. The
+    // bit extraction of the wop-pbs only reads keys on 64 bits.
+    uint32_t precision = 64;
+    if (keyswitchKeyPrecision == 32 && !compressEvaluationKeys &&
+        ksk.getLevels() * ksk.getBaseLog() <= 32 &&
+        !llvm::is_contained(wopKeyswitchKeys, ksk)) {
+      precision = 32;
+    }
     auto paramsBuilder = infoMessage.asBuilder().initParams();
     paramsBuilder.setLevelCount(ksk.getLevels());
     paramsBuilder.setBaseLog(ksk.getBaseLog());
     paramsBuilder.setVariance(curve.getVariance(
-        1, ksk.getOutputKey().getNormalized().value().dimension, 64));
-    paramsBuilder.setIntegerPrecision(64);
+        1, ksk.getOutputKey().getNormalized().value().dimension, precision));
+    paramsBuilder.setIntegerPrecision(precision);
     paramsBuilder.setInputLweDimension(
         ksk.getInputKey().getNormalized().value().dimension);
     paramsBuilder.setOutputLweDimension(
@@ -298,7 +357,8 @@ extractKeysetInfo(TFHE::TFHECircuitKeys circuitKeys,
 llvm::Expected<Message<concreteprotocol::CircuitInfo>>
 extractCircuitInfo(mlir::func::FuncOp funcOp,
                    concreteprotocol::CircuitEncodingInfo::Reader encodings,
-                   concrete::SecurityCurve curve) {
+                   concrete::SecurityCurve curve,
+                   const TFHE::TFHECircuitKeys *shrinkingKeys) {
 
   auto output = Message<concreteprotocol::CircuitInfo>();
 
@@ -321,7 +381,7 @@ extractCircuitInfo(mlir::func::FuncOp funcOp,
   for (unsigned int i = 0; i < funcType.getNumResults(); i++) {
     auto ty = funcType.getResult(i);
     auto encoding = encodings.getOutputs()[i];
-    auto maybeGate = generateGate(ty, encoding, curve);
+    auto maybeGate = generateGate(ty, encoding, curve, shrinkingKeys);
     if (!maybeGate) {
       return maybeGate.takeError();
     }
@@ -334,7 +394,8 @@ extractCircuitInfo(mlir::func::FuncOp funcOp,
 llvm::Expected<Message<concreteprotocol::ProgramInfo>> extractProgramInfo(
     mlir::ModuleOp module,
     const Message<concreteprotocol::ProgramEncodingInfo> &encodings,
-    concrete::SecurityCurve curve) {
+    concrete::SecurityCurve curve,
+    const TFHE::TFHECircuitKeys *shrinkingKeys) {
 
   auto output = Message<concreteprotocol::ProgramInfo>();
   auto circuitsCount = encodings.asReader().getCircuits().size();
@@ -353,7 +414,8 @@ llvm::Expected<Message<concreteprotocol::ProgramInfo>> extractProgramInfo(
              << functionName.cStr();
     }
 
-    auto maybeCircuitInfo = extractCircuitInfo(*funcOp, circuitEncoding, curve);
+    auto maybeCircuitInfo =
+        extractCircuitInfo(*funcOp, circuitEncoding, curve, shrinkingKeys);
     if (!maybeCircuitInfo) {
       return maybeCircuitInfo.takeError();
     }
@@ -368,7 +430,8 @@ llvm::Expected<Message<concreteprotocol::ProgramInfo>>
 createProgramInfoFromTfheDialect(
     mlir::ModuleOp module, int bitsOfSecurity,
     const Message<concreteprotocol::ProgramEncodingInfo> &encodings,
-    bool compressEvaluationKeys) {
+    bool compressEvaluationKeys, bool shrinkOutputs,
+    unsigned int keyswitchKeyPrecision) {
 
   // Check that security curves exist
   const auto curve = concrete::getSecurityCurve(bitsOfSecurity, keyFormat);
@@ -377,8 +440,12 @@ createProgramInfoFromTfheDialect(
            << bitsOfSecurity << "bits";
   }
 
+  // We extract the keys of the circuit
+  auto circuitKeys = TFHE::extractCircuitKeys(module);
+
   // We generate the circuit infos from the module.
-  auto maybeProgramInfo = extractProgramInfo(module, encodings, *curve);
+  auto maybeProgramInfo = extractProgramInfo(
+      module, encodings, *curve, shrinkOutputs ? &circuitKeys : nullptr);
   if (!maybeProgramInfo) {
     return maybeProgramInfo.takeError();
   }
@@ -386,9 +453,13 @@ createProgramInfoFromTfheDialect(
   // Extract the output Program Info.
   Message<concreteprotocol::ProgramInfo> output = *maybeProgramInfo;
 
-  // We extract the keys of the circuit
-  auto keysetInfo = extractKeysetInfo(TFHE::extractCircuitKeys(module), *curve,
-                                      compressEvaluationKeys);
+  llvm::SmallVector<TFHE::GLWEKeyswitchKeyAttr> wopKeyswitchKeys;
+  module.walk([&](TFHE::WopPBSGLWEOp op) {
+    wopKeyswitchKeys.push_back(op.getKskAttr());
+  });
+  auto keysetInfo =
+      extractKeysetInfo(circuitKeys, *curve, compressEvaluationKeys,
+                        keyswitchKeyPrecision, wopKeyswitchKeys);
   output.asBuilder().setKeyset(keysetInfo.asReader());
 
   return output;
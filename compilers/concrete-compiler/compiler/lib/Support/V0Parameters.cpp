@@ -10,6 +10,7 @@
 
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
 #include <cmath>
 #include <iostream>
 #include <optional>
@@ -36,10 +37,42 @@ concrete_optimizer::Options options_from_config(optimizer::Config config) {
       /* .cache_on_disk = */ config.cache_on_disk,
       /* .ciphertext_modulus_log = */ config.ciphertext_modulus_log,
       /* .fft_precision = */ config.fft_precision,
-      /* .composable = */ config.composable};
+      /* .composable = */ config.composable,
+      /* .cpu_cost_factors = */ config.cpu_cost_factors};
   return options;
 }
 
+namespace optimizer {
+llvm::Expected<concrete_optimizer::CpuCostFactors>
+readCpuCostProfile(llvm::StringRef path) {
+  auto factors = DEFAULT_CPU_COST_FACTORS;
+  auto error = concrete_optimizer::utils::read_cpu_cost_factors(
+      rust::Str(path.data(), path.size()), factors);
+  if (!error.empty()) {
+    return StreamStringError("Invalid cpu cost profile: ")
+           << std::string(error);
+  }
+  return factors;
+}
+
+concrete_optimizer::CpuCostFactors getDefaultCpuCostFactors() {
+  static const concrete_optimizer::CpuCostFactors factors = []() {
+    const char *path = std::getenv(CPU_COST_PROFILE_ENV);
+    if (path == nullptr) {
+      return DEFAULT_CPU_COST_FACTORS;
+    }
+    auto factors = readCpuCostProfile(path);
+    if (!factors) {
+      llvm::errs() << "WARNING: ignoring " << CPU_COST_PROFILE_ENV << ", "
+                   << llvm::toString(factors.takeError()) << "\n";
+      return DEFAULT_CPU_COST_FACTORS;
+    }
+    return *factors;
+  }();
+  return factors;
+}
+} // namespace optimizer
+
 optimizer::DagSolution getV0Solution(V0FHEConstraint constraint,
                                      optimizer::Config config) {
   // the norm2 0 is equivalent to a maximum noise_factor of 2.0
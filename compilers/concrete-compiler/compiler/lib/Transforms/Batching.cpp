@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <limits>
+#include <map>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/TypeSwitch.h>
 #include <mlir/Dialect/Affine/IR/AffineOps.h>
@@ -2477,6 +2478,332 @@ public:
   }
 };
 
+// Assigns to each operation of `block` the number of operations
+// batchable outside of loops on the longest chain of dependencies
+// within the block that ends with the operation, including the
+// operation itself. Two such operations with the same level are
+// independent from each other.
+static llvm::DenseMap<mlir::Operation *, unsigned>
+computeDependencyLevels(mlir::Block &block) {
+  llvm::DenseMap<mlir::Operation *, unsigned> levels;
+
+  auto levelOf = [&](mlir::Value v) -> unsigned {
+    mlir::Operation *definingOp = v.getDefiningOp();
+
+    if (!definingOp || definingOp->getBlock() != &block)
+      return 0;
+
+    return levels.lookup(definingOp);
+  };
+
+  for (mlir::Operation &op : block) {
+    unsigned level = 0;
+
+    for (mlir::Value operand : op.getOperands())
+      level = std::max(level, levelOf(operand));
+
+    // Operations with regions also depend on the values of the block
+    // that are used in their regions
+    if (op.getNumRegions() != 0) {
+      llvm::SetVector<mlir::Value> capturedValues;
+      mlir::getUsedValuesDefinedAbove(op.getRegions(), capturedValues);
+
+      for (mlir::Value v : capturedValues)
+        level = std::max(level, levelOf(v));
+    }
+
+    BatchableOpInterface batchableOp =
+        llvm::dyn_cast<BatchableOpInterface>(&op);
+
+    if (batchableOp && batchableOp.isBatchableOutsideLoops())
+      level++;
+
+    levels.insert({&op, level});
+  }
+
+  return levels;
+}
+
+// Returns a 1D tensor with the scalar values `values`. If the values
+// are the elements of a 1D tensor extracted in order, this tensor is
+// returned directly.
+static mlir::Value gatherScalars(mlir::ImplicitLocOpBuilder &builder,
+                                 llvm::ArrayRef<mlir::Value> values) {
+  mlir::tensor::ExtractOp firstExtractOp =
+      values[0].getDefiningOp<mlir::tensor::ExtractOp>();
+
+  if (firstExtractOp) {
+    mlir::Value source = firstExtractOp.getTensor();
+    mlir::RankedTensorType sourceType =
+        source.getType().cast<mlir::RankedTensorType>();
+
+    if (sourceType.getShape().size() == 1 &&
+        sourceType.getShape()[0] == (int64_t)values.size() &&
+        llvm::all_of(llvm::enumerate(values), [&](auto indexedValue) {
+          mlir::tensor::ExtractOp extractOp =
+              indexedValue.value()
+                  .template getDefiningOp<mlir::tensor::ExtractOp>();
+
+          return extractOp && extractOp.getTensor() == source &&
+                 isConstantIndexValue(extractOp.getIndices()[0],
+                                      indexedValue.index());
+        })) {
+      return source;
+    }
+  }
+
+  return builder.create<mlir::tensor::FromElementsOp>(values);
+}
+
+// Returns a tensor stacking the ranked tensors `values` along a new
+// leading dimension.
+static mlir::Value gatherTensors(mlir::ImplicitLocOpBuilder &builder,
+                                 llvm::ArrayRef<mlir::Value> values) {
+  mlir::RankedTensorType elementType =
+      values[0].getType().cast<mlir::RankedTensorType>();
+  llvm::SmallVector<int64_t> shape{(int64_t)values.size()};
+  shape.append(elementType.getShape().begin(), elementType.getShape().end());
+
+  mlir::Value batch = builder.create<mlir::bufferization::AllocTensorOp>(
+      mlir::RankedTensorType::get(shape, elementType.getElementType()),
+      mlir::ValueRange{});
+
+  for (auto indexedValue : llvm::enumerate(values)) {
+    llvm::SmallVector<OpFoldResult> offsets{
+        builder.getI64IntegerAttr(indexedValue.index())};
+    llvm::SmallVector<OpFoldResult> sizes{builder.getI64IntegerAttr(1)};
+    llvm::SmallVector<OpFoldResult> strides(shape.size(),
+                                            builder.getI64IntegerAttr(1));
+
+    offsets.append(elementType.getShape().size(), builder.getI64IntegerAttr(0));
+
+    for (int64_t dim : elementType.getShape())
+      sizes.push_back(builder.getI64IntegerAttr(dim));
+
+    batch = builder.create<mlir::tensor::InsertSliceOp>(
+        indexedValue.value(), batch, offsets, sizes, strides);
+  }
+
+  return batch;
+}
+
+// Replaces the independent operations of `group`, which all belong
+// to `block` and apply the same operation with the same
+// non-batchable operands, with a single batched operation. Returns
+// the operations that have been replaced.
+//
+// The batched operation is inserted right after the last definition
+// of any of the operands of the group. Operations with users
+// preceding this point are removed from the group.
+static llvm::SmallVector<mlir::Operation *>
+batchGroup(mlir::Block &block, llvm::SmallVector<BatchableOpInterface> group,
+           unsigned variant) {
+  mlir::Operation *lastDefinition;
+  bool changed;
+
+  do {
+    lastDefinition = nullptr;
+
+    for (BatchableOpInterface op : group) {
+      for (mlir::Value operand : op->getOperands()) {
+        mlir::Operation *definingOp = operand.getDefiningOp();
+
+        if (definingOp && definingOp->getBlock() == &block &&
+            (!lastDefinition || lastDefinition->isBeforeInBlock(definingOp)))
+          lastDefinition = definingOp;
+      }
+    }
+
+    size_t groupSize = group.size();
+
+    llvm::erase_if(group, [&](BatchableOpInterface op) {
+      return lastDefinition &&
+             llvm::any_of(op->getUsers(), [&](mlir::Operation *user) {
+               mlir::Operation *ancestor = block.findAncestorOpInBlock(*user);
+               return !ancestor || !lastDefinition->isBeforeInBlock(ancestor);
+             });
+    });
+
+    changed = group.size() != groupSize;
+  } while (changed && group.size() >= 2);
+
+  if (group.size() < 2)
+    return {};
+
+  mlir::ImplicitLocOpBuilder builder(group[0].getLoc(), group[0]);
+
+  if (lastDefinition)
+    builder.setInsertionPointAfter(lastDefinition);
+  else
+    builder.setInsertionPointToStart(&block);
+
+  llvm::SmallVector<mlir::OpOperand *> batchableOperands;
+  llvm::SmallVector<mlir::OpOperand *> nonBatchableOperands;
+  splitOperands(group[0], variant, batchableOperands, nonBatchableOperands);
+
+  llvm::SmallVector<mlir::Value> batchedOperands;
+
+  for (mlir::OpOperand *batchableOperand : batchableOperands) {
+    llvm::SmallVector<mlir::Value> values = map(
+        group, [&](BatchableOpInterface op) {
+          return op->getOperand(batchableOperand->getOperandNumber());
+        });
+
+    if (batchableOperand->get().getType().isa<mlir::RankedTensorType>())
+      batchedOperands.push_back(gatherTensors(builder, values));
+    else
+      batchedOperands.push_back(gatherScalars(builder, values));
+  }
+
+  llvm::SmallVector<mlir::Value> nonBatchedOperands =
+      map(nonBatchableOperands, [](mlir::OpOperand *operand) {
+        return operand->get();
+      });
+
+  mlir::Value batchedResult = group[0].createBatchedOperation(
+      variant, builder, batchedOperands, nonBatchedOperands);
+
+  llvm::SmallVector<mlir::Operation *> replaced;
+  llvm::SetVector<mlir::Value> groupOperands;
+
+  for (BatchableOpInterface op : group)
+    groupOperands.insert(op->getOperands().begin(), op->getOperands().end());
+
+  for (auto indexedOp : llvm::enumerate(group)) {
+    mlir::Value idx =
+        builder.create<mlir::arith::ConstantIndexOp>(indexedOp.index());
+    mlir::Value result = builder.create<mlir::tensor::ExtractOp>(
+        batchedResult, mlir::ValueRange{idx});
+
+    indexedOp.value()->getResult(0).replaceAllUsesWith(result);
+    replaced.push_back(indexedOp.value().getOperation());
+    indexedOp.value()->erase();
+  }
+
+  // Remove extractions from the results of previously batched
+  // operations that have been forwarded as a whole
+  for (mlir::Value operand : groupOperands) {
+    mlir::tensor::ExtractOp extractOp =
+        operand.getDefiningOp<mlir::tensor::ExtractOp>();
+
+    if (extractOp && extractOp->use_empty())
+      extractOp->erase();
+  }
+
+  return replaced;
+}
+
+// Checks whether `op` can take part in the batching of independent
+// operations with the `variant`-th batching variant, i.e., if it
+// produces a single scalar and if all of its batchable operands are
+// scalars or statically shaped tensors.
+static bool isBatchableOutsideLoops(BatchableOpInterface op,
+                                    unsigned variant) {
+  if (!op.isBatchableOutsideLoops() ||
+      variant >= op.getNumBatchingVariants() || op->getNumResults() != 1 ||
+      op->getResult(0).getType().isa<mlir::ShapedType>())
+    return false;
+
+  return llvm::all_of(
+      op.getBatchableOperands(variant), [](mlir::OpOperand &operand) {
+        mlir::ShapedType type =
+            operand.get().getType().dyn_cast<mlir::ShapedType>();
+        return !type ||
+               (type.isa<mlir::RankedTensorType>() && type.hasStaticShape());
+      });
+}
+
+// Batches the independent batchable operations of `block` and of its
+// nested blocks that are not embedded into a loop nest suitable for
+// the `BatchingPattern`, e.g., operations from unrolled loops or
+// operating on values gathered with `tensor.from_elements`.
+//
+// Operations are grouped by dependency level, such that no operation
+// of a group depends on another operation of the same group, and
+// then by operation, attributes, types and non-batchable operands.
+// The batching variants of the operations are tried in sequence on
+// the operations that are not batched yet.
+static void batchIndependentOps(mlir::Block &block, int64_t maxBatchSize) {
+  for (mlir::Operation &op : block) {
+    for (mlir::Region &region : op.getRegions()) {
+      for (mlir::Block &nestedBlock : region)
+        batchIndependentOps(nestedBlock, maxBatchSize);
+    }
+  }
+
+  if (maxBatchSize < 2)
+    return;
+
+  llvm::DenseMap<mlir::Operation *, unsigned> levels =
+      computeDependencyLevels(block);
+
+  llvm::SmallVector<BatchableOpInterface> candidates;
+  unsigned numVariants = 0;
+
+  for (mlir::Operation &op : block) {
+    BatchableOpInterface batchableOp =
+        llvm::dyn_cast<BatchableOpInterface>(&op);
+
+    if (batchableOp && batchableOp.isBatchableOutsideLoops()) {
+      candidates.push_back(batchableOp);
+      numVariants = std::max(numVariants, batchableOp.getNumBatchingVariants());
+    }
+  }
+
+  for (unsigned variant = 0; variant < numVariants; variant++) {
+    // Groups of compatible operations, in the order of their first
+    // operation in the block
+    std::map<std::vector<const void *>, size_t> groupIndexes;
+    llvm::SmallVector<llvm::SmallVector<BatchableOpInterface>> groups;
+
+    for (BatchableOpInterface op : candidates) {
+      if (!isBatchableOutsideLoops(op, variant))
+        continue;
+
+      llvm::SmallVector<mlir::OpOperand *> batchableOperands;
+      llvm::SmallVector<mlir::OpOperand *> nonBatchableOperands;
+      splitOperands(op, variant, batchableOperands, nonBatchableOperands);
+
+      std::vector<const void *> key{
+          reinterpret_cast<const void *>((uintptr_t)levels.lookup(op)),
+          op->getName().getAsOpaquePointer(),
+          op->getAttrDictionary().getAsOpaquePointer(),
+          op->getResult(0).getType().getAsOpaquePointer()};
+
+      for (mlir::OpOperand *operand : batchableOperands)
+        key.push_back(operand->get().getType().getAsOpaquePointer());
+
+      for (mlir::OpOperand *operand : nonBatchableOperands)
+        key.push_back(operand->get().getAsOpaquePointer());
+
+      auto inserted = groupIndexes.insert({key, groups.size()});
+
+      if (inserted.second)
+        groups.emplace_back();
+
+      groups[inserted.first->second].push_back(op);
+    }
+
+    llvm::DenseSet<mlir::Operation *> batched;
+
+    for (llvm::SmallVector<BatchableOpInterface> &group : groups) {
+      for (size_t begin = 0; begin < group.size(); begin += maxBatchSize) {
+        size_t end = std::min<size_t>(group.size(), begin + maxBatchSize);
+        llvm::SmallVector<BatchableOpInterface> chunk(group.begin() + begin,
+                                                      group.begin() + end);
+        llvm::SmallVector<mlir::Operation *> replaced =
+            batchGroup(block, chunk, variant);
+
+        batched.insert(replaced.begin(), replaced.end());
+      }
+    }
+
+    llvm::erase_if(candidates, [&](BatchableOpInterface op) {
+      return batched.contains(op.getOperation());
+    });
+  }
+}
+
 class BatchingPass : public BatchingBase<BatchingPass> {
 public:
   BatchingPass(int64_t maxBatchSize) : maxBatchSize(maxBatchSize) {}
@@ -2492,8 +2819,17 @@ public:
              ConstantDenseFoldingPattern, TensorAllocationCleanupPattern>(
             op->getContext());
 
-    if (mlir::applyPatternsAndFoldGreedily(op, std::move(patterns)).failed())
+    if (mlir::applyPatternsAndFoldGreedily(op, std::move(patterns)).failed()) {
       this->signalPassFailure();
+      return;
+    }
+
+    // Batch the remaining operations that are independent from each
+    // other, but which are not part of a suitable loop nest
+    op->walk([&](mlir::func::FuncOp func) {
+      for (mlir::Block &block : func.getBody())
+        batchIndependentOps(block, maxBatchSize);
+    });
   }
 
 private:
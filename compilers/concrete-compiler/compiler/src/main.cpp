@@ -107,6 +107,12 @@ llvm::cl::opt<bool>
                                 "dialects. (Enabled by default)"),
                  llvm::cl::init<bool>(true));
 
+llvm::cl::opt<bool> multithreading(
+    "multithreading",
+    llvm::cl::desc("enable/disable the execution of function passes on the "
+                   "functions of a module in parallel. (Enabled by default)"),
+    llvm::cl::init<bool>(true));
+
 llvm::cl::opt<bool>
     simulate("simulate",
              llvm::cl::desc("enable/disable simulation of crypto operations "
@@ -125,6 +131,19 @@ llvm::cl::opt<bool> compressEvaluationKeys(
                    "evaluation keys and ciphertexts"),
     llvm::cl::init<bool>(false));
 
+llvm::cl::opt<bool> shrinkOutputs(
+    "shrink-outputs",
+    llvm::cl::desc("Keyswitch and modulus switch the output ciphertexts to "
+                   "the smallest format that still decrypts correctly"),
+    llvm::cl::init<bool>(false));
+
+llvm::cl::opt<unsigned int> keyswitchKeyPrecision(
+    "keyswitch-key-precision",
+    llvm::cl::desc("Precision in bits (32 or 64) of the keyswitch keys, 32 "
+                   "bits keys are used when the decomposition allows it, the "
+                   "ciphertexts stay on 64 bits"),
+    llvm::cl::init<unsigned int>(64));
+
 llvm::cl::list<std::string> passes(
     "passes",
     llvm::cl::desc("Specify the passes to run (use only for compiler tests)"),
@@ -241,6 +260,14 @@ llvm::cl::opt<unsigned int> chunkWidth(
         "Chunk width while decomposing big integers into chunks, default is 2"),
     llvm::cl::init<unsigned int>(2));
 
+llvm::cl::opt<unsigned int> chunkParallelism(
+    "chunk-parallelism",
+    llvm::cl::desc("Number of table lookups on chunks expected to run "
+                   "concurrently, used to choose how carries are propagated "
+                   "between chunks, default is 0 (infer from the "
+                   "parallelization options)"),
+    llvm::cl::init<unsigned int>(0));
+
 llvm::cl::opt<double> pbsErrorProbability(
     "pbs-error-probability",
     llvm::cl::desc("Change the default probability of error for all pbs"),
@@ -330,12 +357,40 @@ llvm::cl::opt<bool> optimizerAllowComposition(
                    "its own output without decryptions."),
     llvm::cl::init(false));
 
+llvm::cl::opt<std::string> optimizerCpuCostProfile(
+    "optimizer-cpu-cost-profile",
+    llvm::cl::desc("Calibrate the cpu cost model of the optimizer with the "
+                   "cost profile of the machine at the given path, instead of "
+                   "the one named by CONCRETE_OPTIMIZER_CPU_COST_PROFILE"),
+    llvm::cl::init(""));
+
 llvm::cl::list<int64_t> fhelinalgTileSizes(
     "fhelinalg-tile-sizes",
     llvm::cl::desc(
         "Force tiling of FHELinalg operation with the given tile sizes"),
     llvm::cl::ZeroOrMore, llvm::cl::MiscFlags::CommaSeparated);
 
+llvm::cl::opt<bool> fhelinalgAutoTiling(
+    "fhelinalg-auto-tiling",
+    llvm::cl::desc("Tile FHELinalg operations with tile sizes chosen from "
+                   "the size of the ciphertexts, the cache budget and the "
+                   "number of workers (Disabled by default)"),
+    llvm::cl::init<bool>(false));
+
+llvm::cl::opt<uint64_t> tilingCacheBudget(
+    "tiling-cache-budget",
+    llvm::cl::desc("Number of bytes of ciphertexts a tile should keep in "
+                   "cache with automatic tiling, default is 0 (size of the "
+                   "L2 cache of the host)"),
+    llvm::cl::init<uint64_t>(0));
+
+llvm::cl::opt<bool> memoryPlanning(
+    "memory-planning",
+    llvm::cl::desc("Place the buffers of the circuits in an arena allocated "
+                   "once per invocation, sharing memory between buffers "
+                   "with disjoint live ranges (Disabled by default)"),
+    llvm::cl::init<bool>(false));
+
 llvm::cl::list<size_t> v0Constraint(
     "v0-constraint",
     llvm::cl::desc(
@@ -418,12 +473,16 @@ cmdlineCompilationOptions() {
   options.unrollLoopsWithSDFGConvertibleOps =
       cmdline::unrollLoopsWithSDFGConvertibleOps;
   options.optimizeTFHE = cmdline::optimizeTFHE;
+  options.multithreading = cmdline::multithreading;
   options.simulate = cmdline::simulate;
   options.emitGPUOps = cmdline::emitGPUOps;
   options.compressEvaluationKeys = cmdline::compressEvaluationKeys;
+  options.shrinkOutputs = cmdline::shrinkOutputs;
+  options.keyswitchKeyPrecision = cmdline::keyswitchKeyPrecision;
   options.chunkIntegers = cmdline::chunkIntegers;
   options.chunkSize = cmdline::chunkSize;
   options.chunkWidth = cmdline::chunkWidth;
+  options.chunkParallelism = cmdline::chunkParallelism;
   options.skipProgramInfo = cmdline::skipProgramInfo;
 
   if (!cmdline::v0Constraint.empty()) {
@@ -440,6 +499,10 @@ cmdlineCompilationOptions() {
   if (!cmdline::fhelinalgTileSizes.empty())
     options.fhelinalgTileSizes.emplace(cmdline::fhelinalgTileSizes);
 
+  options.fhelinalgAutoTiling = cmdline::fhelinalgAutoTiling;
+  options.tilingCacheBudget = cmdline::tilingCacheBudget;
+  options.memoryPlanning = cmdline::memoryPlanning;
+
   // Setup the v0 parameter options
   if (!cmdline::v0Parameter.empty()) {
     if (cmdline::v0Parameter.size() != 7) {
@@ -501,6 +564,13 @@ cmdlineCompilationOptions() {
   options.optimizerConfig.encoding = cmdline::optimizerEncoding;
   options.optimizerConfig.cache_on_disk = !cmdline::optimizerNoCacheOnDisk;
   options.optimizerConfig.composable = cmdline::optimizerAllowComposition;
+  if (!cmdline::optimizerCpuCostProfile.empty()) {
+    auto factors =
+        optimizer::readCpuCostProfile(cmdline::optimizerCpuCostProfile);
+    if (!factors)
+      return factors.takeError();
+    options.optimizerConfig.cpu_cost_factors = *factors;
+  }
 
   if (!std::isnan(options.optimizerConfig.global_p_error) &&
       options.optimizerConfig.strategy == optimizer::Strategy::V0) {
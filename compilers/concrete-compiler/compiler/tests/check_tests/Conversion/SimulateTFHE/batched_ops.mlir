@@ -0,0 +1,78 @@
+// RUN: concretecompiler --simulate --passes simulate-tfhe --action=dump-simulated-tfhe --skip-program-info %s 2>&1| FileCheck %s
+
+// CHECK-LABEL: func.func @batched_keyswitch(%arg0: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_keyswitch(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[3]<1,567>>> {
+  // CHECK: call @sim_batched_keyswitch_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, i32, i32, i32, i32) -> ()
+  %0 = "TFHE.batched_keyswitch_glwe"(%arg0) {key = #TFHE.ksk<sk[1]<1,1024>, sk[3]<1,567>, 2, 3>} : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[3]<1,567>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[3]<1,567>>>
+}
+
+// CHECK-LABEL: func.func @batched_bootstrap(%arg0: tensor<4xi64>, %arg1: tensor<1024xi64>) -> tensor<4xi64>
+func.func @batched_bootstrap(%arg0: tensor<4x!TFHE.glwe<sk[3]<1,567>>>, %arg1: tensor<1024xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_bootstrap_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, tensor<?xi64>, i32, i32, i32, i32, i32) -> ()
+  %0 = "TFHE.batched_bootstrap_glwe"(%arg0, %arg1) {key = #TFHE.bsk<sk[3]<1,567>, sk[1]<1,1024>, 1024, 1, 3, 1>} : (tensor<4x!TFHE.glwe<sk[3]<1,567>>>, tensor<1024xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_mapped_bootstrap(%arg0: tensor<4xi64>, %arg1: tensor<4x1024xi64>) -> tensor<4xi64>
+func.func @batched_mapped_bootstrap(%arg0: tensor<4x!TFHE.glwe<sk[3]<1,567>>>, %arg1: tensor<4x1024xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_mapped_bootstrap_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, tensor<?x?xi64>, i32, i32, i32, i32, i32) -> ()
+  %0 = "TFHE.batched_mapped_bootstrap_glwe"(%arg0, %arg1) {key = #TFHE.bsk<sk[3]<1,567>, sk[1]<1,1024>, 1024, 1, 3, 1>} : (tensor<4x!TFHE.glwe<sk[3]<1,567>>>, tensor<4x1024xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_add_glwe(%arg0: tensor<4xi64>, %arg1: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_add_glwe(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, %arg1: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_add_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, tensor<?xi64>) -> ()
+  %0 = "TFHE.batched_add_glwe"(%arg0, %arg1) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_add_glwe_int(%arg0: tensor<4xi64>, %arg1: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_add_glwe_int(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, %arg1: tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_add_plaintext_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, tensor<?xi64>) -> ()
+  %0 = "TFHE.batched_add_glwe_int"(%arg0, %arg1) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_add_glwe_int_cst(%arg0: tensor<4xi64>, %arg1: i64) -> tensor<4xi64>
+func.func @batched_add_glwe_int_cst(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, %arg1: i64) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_add_plaintext_cst_lwe_u64(%{{.*}}, %{{.*}}, %arg1) : (tensor<?xi64>, tensor<?xi64>, i64) -> ()
+  %0 = "TFHE.batched_add_glwe_int_cst"(%arg0, %arg1) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, i64) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_add_glwe_cst_int(%arg0: i64, %arg1: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_add_glwe_cst_int(%arg0: !TFHE.glwe<sk[1]<1,1024>>, %arg1: tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_add_plaintext_cst_lwe_u64(%{{.*}}, %{{.*}}, %arg0) : (tensor<?xi64>, tensor<?xi64>, i64) -> ()
+  %0 = "TFHE.batched_add_glwe_cst_int"(%arg0, %arg1) : (!TFHE.glwe<sk[1]<1,1024>>, tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_mul_glwe_int(%arg0: tensor<4xi64>, %arg1: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_mul_glwe_int(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, %arg1: tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_mul_cleartext_lwe_u64(%{{.*}}, %{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>, tensor<?xi64>) -> ()
+  %0 = "TFHE.batched_mul_glwe_int"(%arg0, %arg1) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_mul_glwe_int_cst(%arg0: tensor<4xi64>, %arg1: i64) -> tensor<4xi64>
+func.func @batched_mul_glwe_int_cst(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, %arg1: i64) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_mul_cleartext_cst_lwe_u64(%{{.*}}, %{{.*}}, %arg1) : (tensor<?xi64>, tensor<?xi64>, i64) -> ()
+  %0 = "TFHE.batched_mul_glwe_int_cst"(%arg0, %arg1) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>, i64) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_mul_glwe_cst_int(%arg0: i64, %arg1: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_mul_glwe_cst_int(%arg0: !TFHE.glwe<sk[1]<1,1024>>, %arg1: tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_mul_cleartext_cst_lwe_u64(%{{.*}}, %{{.*}}, %arg0) : (tensor<?xi64>, tensor<?xi64>, i64) -> ()
+  %0 = "TFHE.batched_mul_glwe_cst_int"(%arg0, %arg1) : (!TFHE.glwe<sk[1]<1,1024>>, tensor<4xi64>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
+
+// CHECK-LABEL: func.func @batched_neg_glwe(%arg0: tensor<4xi64>) -> tensor<4xi64>
+func.func @batched_neg_glwe(%arg0: tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>> {
+  // CHECK: call @sim_batched_neg_lwe_u64(%{{.*}}, %{{.*}}) : (tensor<?xi64>, tensor<?xi64>) -> ()
+  %0 = "TFHE.batched_neg_glwe"(%arg0) : (tensor<4x!TFHE.glwe<sk[1]<1,1024>>>) -> tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+  return %0 : tensor<4x!TFHE.glwe<sk[1]<1,1024>>>
+}
@@ -0,0 +1,93 @@
+// RUN: concretecompiler --split-input-file --action=dump-llvm-dialect --passes concrete-memory-planning --memory-planning --skip-program-info %s 2>&1| FileCheck %s
+
+// The buffers of 16392 bytes %a and %c have disjoint live ranges and share the
+// offset 0 of the arena, %b overlaps both and is placed at the next aligned
+// offset.
+
+// CHECK-LABEL: func.func @arena_offsets(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>)
+// CHECK-NEXT:    %[[ARENA:.*]] = memref.alloc() {alignment = 64 : i64} : memref<32840xi8>
+// CHECK-NEXT:    %[[O0:.*]] = arith.constant 0 : index
+// CHECK-NEXT:    %[[A:.*]] = memref.view %[[ARENA]][%[[O0]]][] : memref<32840xi8> to memref<2049xi64>
+// CHECK-NEXT:    "Concrete.keyswitch_lwe_buffer"(%[[A]], %arg0)
+// CHECK-NEXT:    %[[O1:.*]] = arith.constant 16448 : index
+// CHECK-NEXT:    %[[B:.*]] = memref.view %[[ARENA]][%[[O1]]][] : memref<32840xi8> to memref<2049xi64>
+// CHECK-NEXT:    "Concrete.keyswitch_lwe_buffer"(%[[B]], %[[A]])
+// CHECK-NEXT:    %[[O2:.*]] = arith.constant 0 : index
+// CHECK-NEXT:    %[[C:.*]] = memref.view %[[ARENA]][%[[O2]]][] : memref<32840xi8> to memref<2049xi64>
+// CHECK-NEXT:    "Concrete.keyswitch_lwe_buffer"(%[[C]], %[[B]])
+// CHECK-NEXT:    memref.copy %[[C]], %arg1 : memref<2049xi64> to memref<2049xi64>
+// CHECK-NEXT:    memref.dealloc %[[ARENA]] : memref<32840xi8>
+// CHECK-NEXT:    return
+func.func @arena_offsets(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>) {
+  %a = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%a, %arg0) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  %b = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%b, %a) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  memref.dealloc %a : memref<2049xi64>
+  %c = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%c, %b) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  memref.dealloc %b : memref<2049xi64>
+  memref.copy %c, %arg1 : memref<2049xi64> to memref<2049xi64>
+  memref.dealloc %c : memref<2049xi64>
+  return
+}
+
+// -----
+
+// The operand of the negation is deallocated right after it, the negation
+// updates it in place and its buffer takes the place of the result.
+
+// CHECK-LABEL: func.func @in_place(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>)
+// CHECK-NEXT:    %[[ARENA:.*]] = memref.alloc() {alignment = 64 : i64} : memref<16392xi8>
+// CHECK-NEXT:    %[[O0:.*]] = arith.constant 0 : index
+// CHECK-NEXT:    %[[A:.*]] = memref.view %[[ARENA]][%[[O0]]][] : memref<16392xi8> to memref<2049xi64>
+// CHECK-NEXT:    "Concrete.keyswitch_lwe_buffer"(%[[A]], %arg0)
+// CHECK-NEXT:    "Concrete.negate_lwe_buffer"(%[[A]], %[[A]])
+// CHECK-NEXT:    memref.copy %[[A]], %arg1 : memref<2049xi64> to memref<2049xi64>
+// CHECK-NEXT:    memref.dealloc %[[ARENA]] : memref<16392xi8>
+// CHECK-NEXT:    return
+func.func @in_place(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>) {
+  %a = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%a, %arg0) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  %b = memref.alloc() : memref<2049xi64>
+  "Concrete.negate_lwe_buffer"(%b, %a) : (memref<2049xi64>, memref<2049xi64>) -> ()
+  memref.dealloc %a : memref<2049xi64>
+  memref.copy %b, %arg1 : memref<2049xi64> to memref<2049xi64>
+  memref.dealloc %b : memref<2049xi64>
+  return
+}
+
+// -----
+
+// The operand of the negation is used after it, it isn't updated in place.
+
+// CHECK-LABEL: func.func @not_in_place(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>)
+// CHECK-NEXT:    %[[ARENA:.*]] = memref.alloc() {alignment = 64 : i64} : memref<32840xi8>
+// CHECK:         %[[A:.*]] = memref.view %[[ARENA]]
+// CHECK:         %[[B:.*]] = memref.view %[[ARENA]]
+// CHECK-NEXT:    "Concrete.negate_lwe_buffer"(%[[B]], %[[A]])
+// CHECK-NEXT:    "Concrete.add_lwe_buffer"(%arg1, %[[B]], %[[A]])
+func.func @not_in_place(%arg0: memref<2049xi64>, %arg1: memref<2049xi64>) {
+  %a = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%a, %arg0) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  %b = memref.alloc() : memref<2049xi64>
+  "Concrete.negate_lwe_buffer"(%b, %a) : (memref<2049xi64>, memref<2049xi64>) -> ()
+  "Concrete.add_lwe_buffer"(%arg1, %b, %a) : (memref<2049xi64>, memref<2049xi64>, memref<2049xi64>) -> ()
+  memref.dealloc %a : memref<2049xi64>
+  memref.dealloc %b : memref<2049xi64>
+  return
+}
+
+// -----
+
+// A returned buffer outlives the invocation, it isn't planned.
+
+// CHECK-LABEL: func.func @escaping(%arg0: memref<2049xi64>) -> memref<2049xi64>
+// CHECK-NEXT:    %[[A:.*]] = memref.alloc() : memref<2049xi64>
+// CHECK-NOT:     memref.view
+// CHECK:         return %[[A]] : memref<2049xi64>
+func.func @escaping(%arg0: memref<2049xi64>) -> memref<2049xi64> {
+  %a = memref.alloc() : memref<2049xi64>
+  "Concrete.keyswitch_lwe_buffer"(%a, %arg0) {baseLog = 2 : i32, kskIndex = 0 : i32, level = 3 : i32, lwe_dim_in = 2048 : i32, lwe_dim_out = 2048 : i32} : (memref<2049xi64>, memref<2049xi64>) -> ()
+  return %a : memref<2049xi64>
+}
@@ -0,0 +1,20 @@
+// RUN: concretecompiler --chunk-integers --chunk-size 4 --chunk-width 2 --chunk-parallelism 64 --passes fhe-big-int-transform --action=dump-fhe  %s 2>&1| FileCheck %s
+
+// CHECK-LABEL: func.func @add_chunked_eint(%arg0: tensor<4x!FHE.eint<4>>, %arg1: tensor<4x!FHE.eint<4>>) -> tensor<4x!FHE.eint<4>>
+func.func @add_chunked_eint(%arg0: !FHE.eint<8>, %arg1: !FHE.eint<8>) -> !FHE.eint<8> {
+  // CHECK-NOT: affine.for
+  // The carry states of the chunks, the first chunk can't propagate a carry
+  // CHECK: %[[FIRST:.*]] = arith.constant dense<[0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1]> : tensor<16xi64>
+  // CHECK-NEXT: "FHE.apply_lookup_table"(%{{.*}}, %[[FIRST]]) : (!FHE.eint<4>, tensor<16xi64>) -> !FHE.eint<4>
+  // CHECK-COUNT-3: arith.constant dense<[0, 0, 0, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1]> : tensor<16xi64>
+  // The combination of the carry states of two ranges of chunks
+  // CHECK: %[[c3_i5:.*]] = arith.constant 3 : i5
+  // CHECK-NEXT: %[[COMBINE:.*]] = arith.constant dense<[0, 0, 0, 1, 1, 1, 0, 1, 2, 3, 3, 3, 4, 4, 4, 5]> : tensor<16xi64>
+  // CHECK-COUNT-5: "FHE.apply_lookup_table"(%{{.*}}, %[[COMBINE]])
+  // CHECK-NOT: "FHE.apply_lookup_table"
+  // CHECK: %[[RES:.*]] = tensor.from_elements %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}} : tensor<4x!FHE.eint<4>>
+  // CHECK-NEXT: return %[[RES]] : tensor<4x!FHE.eint<4>>
+
+  %1 = "FHE.add_eint"(%arg0, %arg1): (!FHE.eint<8>, !FHE.eint<8>) -> (!FHE.eint<8>)
+  return %1: !FHE.eint<8>
+}
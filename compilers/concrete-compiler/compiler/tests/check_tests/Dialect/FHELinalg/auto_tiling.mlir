@@ -0,0 +1,30 @@
+// RUN: concretecompiler --action=dump-fhe --fhelinalg-auto-tiling --tiling-cache-budget=1 %s 2>&1 --split-input-file | FileCheck %s --check-prefix=SMALL
+// RUN: concretecompiler --action=dump-fhe --fhelinalg-auto-tiling --tiling-cache-budget=1000000000 %s 2>&1 --split-input-file | FileCheck %s --check-prefix=LARGE
+
+// When no tile fits the budget, the smallest tiles are chosen
+// SMALL-LABEL: func.func @auto_tiled_lut
+// SMALL:       scf.for
+// SMALL:       scf.for
+// SMALL:       "FHELinalg.apply_lookup_table"(%{{.*}}, %{{.*}}) : (tensor<1x1x!FHE.eint<3>>, tensor<8xi64>) -> tensor<1x1x!FHE.eint<3>>
+
+// Operations fitting the budget are not tiled
+// LARGE-LABEL: func.func @auto_tiled_lut
+// LARGE-NOT:   scf.for
+// LARGE:       "FHELinalg.apply_lookup_table"(%{{.*}}, %{{.*}}) : (tensor<4x4x!FHE.eint<3>>, tensor<8xi64>) -> tensor<4x4x!FHE.eint<3>>
+func.func @auto_tiled_lut(%a: tensor<4x4x!FHE.eint<3>>, %lut: tensor<8xi64>) -> tensor<4x4x!FHE.eint<3>> {
+  %0 = "FHELinalg.apply_lookup_table"(%a, %lut) : (tensor<4x4x!FHE.eint<3>>, tensor<8xi64>) -> tensor<4x4x!FHE.eint<3>>
+  return %0 : tensor<4x4x!FHE.eint<3>>
+}
+
+// -----
+
+// SMALL-LABEL: func.func @auto_tiled_matmul
+// SMALL:       "FHELinalg.matmul_eint_int"(%{{.*}}, %{{.*}}) : (tensor<1x1x!FHE.eint<6>>, tensor<1x1xi7>) -> tensor<1x1x!FHE.eint<6>>
+
+// LARGE-LABEL: func.func @auto_tiled_matmul
+// LARGE-NOT:   scf.for
+// LARGE:       "FHELinalg.matmul_eint_int"(%{{.*}}, %{{.*}}) : (tensor<8x4x!FHE.eint<6>>, tensor<4x2xi7>) -> tensor<8x2x!FHE.eint<6>>
+func.func @auto_tiled_matmul(%a: tensor<8x4x!FHE.eint<6>>, %b: tensor<4x2xi7>) -> tensor<8x2x!FHE.eint<6>> {
+  %0 = "FHELinalg.matmul_eint_int"(%a, %b) : (tensor<8x4x!FHE.eint<6>>, tensor<4x2xi7>) -> tensor<8x2x!FHE.eint<6>>
+  return %0 : tensor<8x2x!FHE.eint<6>>
+}
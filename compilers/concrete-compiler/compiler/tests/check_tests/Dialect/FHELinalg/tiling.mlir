@@ -58,3 +58,53 @@ func.func @tiled_one_big_tile(%a: tensor<8x4x!FHE.eint<6>>, %b: tensor<4x2xi7>)
   return %0 : tensor<8x2x!FHE.eint<6>>
 }
 
+
+// -----
+
+// CHECK:      func.func @tiled_lut(%[[Varg0:.*]]: tensor<4x6x!FHE.eint<3>>, %[[Varg1:.*]]: tensor<8xi64>) -> tensor<4x6x!FHE.eint<3>> {
+// CHECK:        %[[V0:.*]] = "FHE.zero_tensor"() : () -> tensor<4x6x!FHE.eint<3>>
+// CHECK:        %[[V1:.*]] = scf.for %[[Varg2:.*]] = %{{.*}} to %{{.*}} step %{{.*}} iter_args(%[[Varg3:.*]] = %[[V0]]) -> (tensor<4x6x!FHE.eint<3>>) {
+// CHECK-NEXT:     %[[V2:.*]] = tensor.extract_slice %[[Varg0]][%[[Varg2]], 0] [2, 6] [1, 1] : tensor<4x6x!FHE.eint<3>> to tensor<2x6x!FHE.eint<3>>
+// CHECK-NEXT:     %[[V3:.*]] = "FHELinalg.apply_lookup_table"(%[[V2]], %[[Varg1]]) : (tensor<2x6x!FHE.eint<3>>, tensor<8xi64>) -> tensor<2x6x!FHE.eint<3>>
+// CHECK-NEXT:     %[[V4:.*]] = tensor.insert_slice %[[V3]] into %[[Varg3]][%[[Varg2]], 0] [2, 6] [1, 1] : tensor<2x6x!FHE.eint<3>> into tensor<4x6x!FHE.eint<3>>
+// CHECK-NEXT:     scf.yield %[[V4]] : tensor<4x6x!FHE.eint<3>>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return %[[V1]] : tensor<4x6x!FHE.eint<3>>
+func.func @tiled_lut(%a: tensor<4x6x!FHE.eint<3>>, %lut: tensor<8xi64>) -> tensor<4x6x!FHE.eint<3>> {
+  %0 = "FHELinalg.apply_lookup_table"(%a, %lut) { "tile-sizes" = [2,6] } : (tensor<4x6x!FHE.eint<3>>, tensor<8xi64>) -> tensor<4x6x!FHE.eint<3>>
+  return %0 : tensor<4x6x!FHE.eint<3>>
+}
+
+// -----
+
+// CHECK:      func.func @tiled_dot(%[[Varg0:.*]]: tensor<8x!FHE.eint<6>>, %[[Varg1:.*]]: tensor<8xi7>) -> !FHE.eint<6> {
+// CHECK:        %[[V0:.*]] = "FHE.zero"() : () -> !FHE.eint<6>
+// CHECK:        %[[V1:.*]] = scf.for %[[Varg2:.*]] = %{{.*}} to %{{.*}} step %{{.*}} iter_args(%[[Varg3:.*]] = %[[V0]]) -> (!FHE.eint<6>) {
+// CHECK-NEXT:     %[[V2:.*]] = tensor.extract_slice %[[Varg0]][%[[Varg2]]] [4] [1] : tensor<8x!FHE.eint<6>> to tensor<4x!FHE.eint<6>>
+// CHECK-NEXT:     %[[V3:.*]] = tensor.extract_slice %[[Varg1]][%[[Varg2]]] [4] [1] : tensor<8xi7> to tensor<4xi7>
+// CHECK-NEXT:     %[[V4:.*]] = "FHELinalg.dot_eint_int"(%[[V2]], %[[V3]]) : (tensor<4x!FHE.eint<6>>, tensor<4xi7>) -> !FHE.eint<6>
+// CHECK-NEXT:     %[[V5:.*]] = "FHE.add_eint"(%[[Varg3]], %[[V4]]) : (!FHE.eint<6>, !FHE.eint<6>) -> !FHE.eint<6>
+// CHECK-NEXT:     scf.yield %[[V5]] : !FHE.eint<6>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return %[[V1]] : !FHE.eint<6>
+func.func @tiled_dot(%a: tensor<8x!FHE.eint<6>>, %b: tensor<8xi7>) -> !FHE.eint<6> {
+  %0 = "FHELinalg.dot_eint_int"(%a, %b) { "tile-sizes" = [4] } : (tensor<8x!FHE.eint<6>>, tensor<8xi7>) -> !FHE.eint<6>
+  return %0 : !FHE.eint<6>
+}
+
+// -----
+
+// CHECK:      func.func @tiled_conv2d(%[[Varg0:.*]]: tensor<1x1x4x4x!FHE.eint<6>>, %[[Varg1:.*]]: tensor<4x1x2x2xi7>, %[[Varg2:.*]]: tensor<4xi7>) -> tensor<1x4x3x3x!FHE.eint<6>> {
+// CHECK:        %[[V0:.*]] = "FHE.zero_tensor"() : () -> tensor<1x4x3x3x!FHE.eint<6>>
+// CHECK:        %[[V1:.*]] = scf.for %[[Varg3:.*]] = %{{.*}} to %{{.*}} step %{{.*}} iter_args(%[[Varg4:.*]] = %[[V0]]) -> (tensor<1x4x3x3x!FHE.eint<6>>) {
+// CHECK-NEXT:     %[[V2:.*]] = tensor.extract_slice %[[Varg1]][%[[Varg3]], 0, 0, 0] [2, 1, 2, 2] [1, 1, 1, 1] : tensor<4x1x2x2xi7> to tensor<2x1x2x2xi7>
+// CHECK-NEXT:     %[[V3:.*]] = tensor.extract_slice %[[Varg2]][%[[Varg3]]] [2] [1] : tensor<4xi7> to tensor<2xi7>
+// CHECK-NEXT:     %[[V4:.*]] = "FHELinalg.conv2d"(%[[Varg0]], %[[V2]], %[[V3]]){{.*}} : (tensor<1x1x4x4x!FHE.eint<6>>, tensor<2x1x2x2xi7>, tensor<2xi7>) -> tensor<1x2x3x3x!FHE.eint<6>>
+// CHECK-NEXT:     %[[V5:.*]] = tensor.insert_slice %[[V4]] into %[[Varg4]][0, %[[Varg3]], 0, 0] [1, 2, 3, 3] [1, 1, 1, 1] : tensor<1x2x3x3x!FHE.eint<6>> into tensor<1x4x3x3x!FHE.eint<6>>
+// CHECK-NEXT:     scf.yield %[[V5]] : tensor<1x4x3x3x!FHE.eint<6>>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return %[[V1]] : tensor<1x4x3x3x!FHE.eint<6>>
+func.func @tiled_conv2d(%input: tensor<1x1x4x4x!FHE.eint<6>>, %weight: tensor<4x1x2x2xi7>, %bias: tensor<4xi7>) -> tensor<1x4x3x3x!FHE.eint<6>> {
+  %0 = "FHELinalg.conv2d"(%input, %weight, %bias) { "tile-sizes" = [2] } : (tensor<1x1x4x4x!FHE.eint<6>>, tensor<4x1x2x2xi7>, tensor<4xi7>) -> tensor<1x4x3x3x!FHE.eint<6>>
+  return %0 : tensor<1x4x3x3x!FHE.eint<6>>
+}
@@ -0,0 +1,88 @@
+// RUN: concretecompiler --split-input-file --action=dump-tfhe --passes BuildDataflowTaskGraph --parallelize-dataflow --v0-parameter=2,10,750,1,23,3,4 %s 2>&1 | FileCheck %s
+
+// A lookup table on 64 ciphertexts costs 64 bootstraps, more than the 16
+// bootstraps of a task: it is split in 4 slices computed by 4 tasks, which are
+// inserted back in the result once all tasks are created.
+
+// CHECK-LABEL: func.func @split_costly_generic(%arg0: tensor<64x!FHE.eint<2>>) -> tensor<64x!FHE.eint<2>>
+// CHECK:         tensor.extract_slice %arg0[0] [16] [1] : tensor<64x!FHE.eint<2>> to tensor<16x!FHE.eint<2>>
+// CHECK:         "RT.dataflow_task"
+// CHECK:           linalg.generic {{.*}} ins(%{{.*}} : tensor<16x!FHE.eint<2>>) outs(%{{.*}} : tensor<16x!FHE.eint<2>>)
+// CHECK:             "FHE.apply_lookup_table"
+// CHECK:         tensor.extract_slice %arg0[16] [16] [1] : tensor<64x!FHE.eint<2>> to tensor<16x!FHE.eint<2>>
+// CHECK:         "RT.dataflow_task"
+// CHECK:         tensor.extract_slice %arg0[32] [16] [1] : tensor<64x!FHE.eint<2>> to tensor<16x!FHE.eint<2>>
+// CHECK:         "RT.dataflow_task"
+// CHECK:         tensor.extract_slice %arg0[48] [16] [1] : tensor<64x!FHE.eint<2>> to tensor<16x!FHE.eint<2>>
+// CHECK:         "RT.dataflow_task"
+// CHECK-NOT:     "RT.dataflow_task"
+// CHECK:         tensor.insert_slice %{{.*}} into %{{.*}}[0] [16] [1] : tensor<16x!FHE.eint<2>> into tensor<64x!FHE.eint<2>>
+// CHECK:         tensor.insert_slice %{{.*}} into %{{.*}}[16] [16] [1] : tensor<16x!FHE.eint<2>> into tensor<64x!FHE.eint<2>>
+// CHECK:         tensor.insert_slice %{{.*}} into %{{.*}}[32] [16] [1] : tensor<16x!FHE.eint<2>> into tensor<64x!FHE.eint<2>>
+// CHECK:         %[[RES:.*]] = tensor.insert_slice %{{.*}} into %{{.*}}[48] [16] [1] : tensor<16x!FHE.eint<2>> into tensor<64x!FHE.eint<2>>
+// CHECK-NOT:     tensor<64x!FHE.eint<2>>) outs
+// CHECK:         return %[[RES]] : tensor<64x!FHE.eint<2>>
+#map = affine_map<(d0) -> (d0)>
+func.func @split_costly_generic(%arg0: tensor<64x!FHE.eint<2>>) -> tensor<64x!FHE.eint<2>> {
+  %lut = arith.constant dense<[1, 0, 3, 2]> : tensor<4xi64>
+  %init = tensor.empty() : tensor<64x!FHE.eint<2>>
+  %0 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%arg0 : tensor<64x!FHE.eint<2>>) outs(%init : tensor<64x!FHE.eint<2>>) {
+  ^bb0(%in: !FHE.eint<2>, %out: !FHE.eint<2>):
+    %1 = "FHE.apply_lookup_table"(%in, %lut) : (!FHE.eint<2>, tensor<4xi64>) -> !FHE.eint<2>
+    linalg.yield %1 : !FHE.eint<2>
+  } -> tensor<64x!FHE.eint<2>>
+  return %0 : tensor<64x!FHE.eint<2>>
+}
+
+// -----
+
+// An addition on 4 ciphertexts costs less than a bootstrap: it doesn't become
+// a task of its own, it is sunk in the task of the lookup table using it.
+
+// CHECK-LABEL: func.func @sink_cheap_generic(%arg0: tensor<4x!FHE.eint<2>>, %arg1: tensor<4x!FHE.eint<2>>) -> tensor<4x!FHE.eint<2>>
+// CHECK-NOT:     "FHE.add_eint"
+// CHECK:         %[[RES:.*]] = "RT.dataflow_task"
+// CHECK:           linalg.generic
+// CHECK:             "FHE.add_eint"
+// CHECK:           linalg.generic
+// CHECK:             "FHE.apply_lookup_table"
+// CHECK:           "RT.dataflow_yield"
+// CHECK-NOT:     "RT.dataflow_task"
+// CHECK:         return %[[RES]] : tensor<4x!FHE.eint<2>>
+#map = affine_map<(d0) -> (d0)>
+func.func @sink_cheap_generic(%arg0: tensor<4x!FHE.eint<2>>, %arg1: tensor<4x!FHE.eint<2>>) -> tensor<4x!FHE.eint<2>> {
+  %lut = arith.constant dense<[1, 0, 3, 2]> : tensor<4xi64>
+  %init = tensor.empty() : tensor<4x!FHE.eint<2>>
+  %0 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%arg0, %arg1 : tensor<4x!FHE.eint<2>>, tensor<4x!FHE.eint<2>>) outs(%init : tensor<4x!FHE.eint<2>>) {
+  ^bb0(%in0: !FHE.eint<2>, %in1: !FHE.eint<2>, %out: !FHE.eint<2>):
+    %1 = "FHE.add_eint"(%in0, %in1) : (!FHE.eint<2>, !FHE.eint<2>) -> !FHE.eint<2>
+    linalg.yield %1 : !FHE.eint<2>
+  } -> tensor<4x!FHE.eint<2>>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%0 : tensor<4x!FHE.eint<2>>) outs(%init : tensor<4x!FHE.eint<2>>) {
+  ^bb0(%in: !FHE.eint<2>, %out: !FHE.eint<2>):
+    %3 = "FHE.apply_lookup_table"(%in, %lut) : (!FHE.eint<2>, tensor<4xi64>) -> !FHE.eint<2>
+    linalg.yield %3 : !FHE.eint<2>
+  } -> tensor<4x!FHE.eint<2>>
+  return %2 : tensor<4x!FHE.eint<2>>
+}
+
+// -----
+
+// Leveled operations alone never cost a bootstrap: no task is created.
+
+// CHECK-LABEL: func.func @leveled_generic(%arg0: tensor<4x!FHE.eint<2>>, %arg1: tensor<4x!FHE.eint<2>>) -> tensor<4x!FHE.eint<2>>
+// CHECK-NOT:     "RT.dataflow_task"
+// CHECK:         linalg.generic
+// CHECK:           "FHE.add_eint"
+// CHECK-NOT:     "RT.dataflow_task"
+// CHECK:         return
+#map = affine_map<(d0) -> (d0)>
+func.func @leveled_generic(%arg0: tensor<4x!FHE.eint<2>>, %arg1: tensor<4x!FHE.eint<2>>) -> tensor<4x!FHE.eint<2>> {
+  %init = tensor.empty() : tensor<4x!FHE.eint<2>>
+  %0 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%arg0, %arg1 : tensor<4x!FHE.eint<2>>, tensor<4x!FHE.eint<2>>) outs(%init : tensor<4x!FHE.eint<2>>) {
+  ^bb0(%in0: !FHE.eint<2>, %in1: !FHE.eint<2>, %out: !FHE.eint<2>):
+    %1 = "FHE.add_eint"(%in0, %in1) : (!FHE.eint<2>, !FHE.eint<2>) -> !FHE.eint<2>
+    linalg.yield %1 : !FHE.eint<2>
+  } -> tensor<4x!FHE.eint<2>>
+  return %0 : tensor<4x!FHE.eint<2>>
+}
@@ -325,3 +325,36 @@ func.func @apply_lookup_table_contiguous_hoistable_nonbatchable(%arg0: tensor<2x
   }
   return %1 : tensor<2x3x4x!TFHE.glwe<sk<0,1,2048>>>
 }
+
+// -----
+
+// CHECK-LABEL: func.func @batch_independent_keyswitch_bootstrap
+// CHECK:   %[[V0:.*]] = tensor.from_elements %arg0, %arg1 : tensor<2x!TFHE.glwe<sk{{\[}}[[SK_IN:.*]]{{\]}}<1,2048>>>
+// CHECK-NEXT:   %[[V1:.*]] = "TFHE.batched_keyswitch_glwe"(%[[V0]]) {{.*}} : (tensor<2x!TFHE.glwe<sk{{\[}}[[SK_IN]]{{\]}}<1,2048>>>) -> tensor<2x!TFHE.glwe<sk{{\[}}[[SK_OUT:.*]]{{\]}}<1,750>>>
+// CHECK:   %[[V2:.*]] = "TFHE.batched_bootstrap_glwe"(%[[V1]], %arg2) {{.*}} : (tensor<2x!TFHE.glwe<sk{{\[}}[[SK_OUT]]{{\]}}<1,750>>>, tensor<1024xi64>) -> tensor<2x!TFHE.glwe<sk{{\[}}[[SK_IN]]{{\]}}<1,2048>>>
+// CHECK-NOT:   "TFHE.keyswitch_glwe"
+// CHECK-NOT:   "TFHE.bootstrap_glwe"
+// CHECK:   %[[R0:.*]] = tensor.extract %[[V2]][%{{.*}}] : tensor<2x!TFHE.glwe<sk{{\[}}[[SK_IN]]{{\]}}<1,2048>>>
+// CHECK:   %[[R1:.*]] = tensor.extract %[[V2]][%{{.*}}] : tensor<2x!TFHE.glwe<sk{{\[}}[[SK_IN]]{{\]}}<1,2048>>>
+// CHECK:   return %[[R0]], %[[R1]]
+func.func @batch_independent_keyswitch_bootstrap(%arg0: !TFHE.glwe<sk<0,1,2048>>, %arg1: !TFHE.glwe<sk<0,1,2048>>, %arg2: tensor<1024xi64>) -> (!TFHE.glwe<sk<0,1,2048>>, !TFHE.glwe<sk<0,1,2048>>) {
+  %0 = "TFHE.keyswitch_glwe"(%arg0) {key = #TFHE.ksk<sk<0,1,2048>, sk<1,1,750>, 3, 4>} : (!TFHE.glwe<sk<0,1,2048>>) -> !TFHE.glwe<sk<1,1,750>>
+  %1 = "TFHE.bootstrap_glwe"(%0, %arg2) {key = #TFHE.bsk<sk<1,1,750>, sk<0,1,2048>, 1024, 2, 1, 23>} : (!TFHE.glwe<sk<1,1,750>>, tensor<1024xi64>) -> !TFHE.glwe<sk<0,1,2048>>
+  %2 = "TFHE.keyswitch_glwe"(%arg1) {key = #TFHE.ksk<sk<0,1,2048>, sk<1,1,750>, 3, 4>} : (!TFHE.glwe<sk<0,1,2048>>) -> !TFHE.glwe<sk<1,1,750>>
+  %3 = "TFHE.bootstrap_glwe"(%2, %arg2) {key = #TFHE.bsk<sk<1,1,750>, sk<0,1,2048>, 1024, 2, 1, 23>} : (!TFHE.glwe<sk<1,1,750>>, tensor<1024xi64>) -> !TFHE.glwe<sk<0,1,2048>>
+  return %1, %3 : !TFHE.glwe<sk<0,1,2048>>, !TFHE.glwe<sk<0,1,2048>>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @batch_independent_dependent_keyswitch
+// CHECK:   "TFHE.batched_keyswitch_glwe"
+// CHECK-NOT:   "TFHE.batched_keyswitch_glwe"
+// CHECK:   "TFHE.keyswitch_glwe"
+func.func @batch_independent_dependent_keyswitch(%arg0: !TFHE.glwe<sk<0,1,2048>>, %arg1: !TFHE.glwe<sk<0,1,2048>>, %arg2: tensor<1024xi64>) -> (!TFHE.glwe<sk<1,1,750>>, !TFHE.glwe<sk<1,1,750>>, !TFHE.glwe<sk<1,1,750>>) {
+  %0 = "TFHE.keyswitch_glwe"(%arg0) {key = #TFHE.ksk<sk<0,1,2048>, sk<1,1,750>, 3, 4>} : (!TFHE.glwe<sk<0,1,2048>>) -> !TFHE.glwe<sk<1,1,750>>
+  %1 = "TFHE.keyswitch_glwe"(%arg1) {key = #TFHE.ksk<sk<0,1,2048>, sk<1,1,750>, 3, 4>} : (!TFHE.glwe<sk<0,1,2048>>) -> !TFHE.glwe<sk<1,1,750>>
+  %2 = "TFHE.bootstrap_glwe"(%0, %arg2) {key = #TFHE.bsk<sk<1,1,750>, sk<0,1,2048>, 1024, 2, 1, 23>} : (!TFHE.glwe<sk<1,1,750>>, tensor<1024xi64>) -> !TFHE.glwe<sk<0,1,2048>>
+  %3 = "TFHE.keyswitch_glwe"(%2) {key = #TFHE.ksk<sk<0,1,2048>, sk<1,1,750>, 3, 4>} : (!TFHE.glwe<sk<0,1,2048>>) -> !TFHE.glwe<sk<1,1,750>>
+  return %0, %1, %3 : !TFHE.glwe<sk<1,1,750>>, !TFHE.glwe<sk<1,1,750>>, !TFHE.glwe<sk<1,1,750>>
+}
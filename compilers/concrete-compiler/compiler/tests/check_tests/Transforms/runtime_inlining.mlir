@@ -0,0 +1,12 @@
+// RUN: concretecompiler --action=dump-optimized-llvm-ir %s 2>&1| FileCheck %s
+// REQUIRES: runtime-bitcode
+
+// The leveled operations of the runtime are linked in the circuit and inlined
+// CHECK: define {{.*}}@main(
+// CHECK-NOT: memref_add_lwe_ciphertexts_u64
+// CHECK-NOT: memref_negate_lwe_ciphertext_u64
+func.func @main(%arg0: tensor<4x!FHE.eint<3>>, %arg1: tensor<4x!FHE.eint<3>>) -> tensor<4x!FHE.eint<3>> {
+  %0 = "FHELinalg.add_eint"(%arg0, %arg1) : (tensor<4x!FHE.eint<3>>, tensor<4x!FHE.eint<3>>) -> tensor<4x!FHE.eint<3>>
+  %1 = "FHELinalg.neg_eint"(%0) : (tensor<4x!FHE.eint<3>>) -> tensor<4x!FHE.eint<3>>
+  return %1 : tensor<4x!FHE.eint<3>>
+}
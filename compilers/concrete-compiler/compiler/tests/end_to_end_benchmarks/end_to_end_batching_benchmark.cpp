@@ -0,0 +1,189 @@
+#include "concretelang/ClientLib/ClientLib.h"
+#include "concretelang/Common/Compat.h"
+#include "concretelang/ServerLib/BatchingServer.h"
+#include "concretelang/ServerLib/ServerLib.h"
+#include "concretelang/Support/CompilerEngine.h"
+#include <concretelang/Runtime/DFRuntime.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#define BENCHMARK_HAS_CXX11
+#include "llvm/Support/FileSystem.h"
+
+#include "tests_tools/keySetCache.h"
+
+using concretelang::clientlib::ClientCircuit;
+using concretelang::serverlib::BatchingServer;
+using concretelang::serverlib::BatchingServerOptions;
+using concretelang::serverlib::ServerProgram;
+using concretelang::values::Tensor;
+using concretelang::values::TransportValue;
+using concretelang::values::Value;
+
+/// The number of encrypted elements processed by a single request.
+const size_t REQUEST_SIZE = 4;
+
+/// The number of requests sent by every client in a benchmark iteration.
+const size_t REQUESTS_PER_CLIENT = 16;
+
+/// Returns a program applying a lookup table on a batch of `batchSize`
+/// requests of `REQUEST_SIZE` 6-bits integers.
+std::string getBatchedProgram(size_t batchSize) {
+  std::ostringstream lut;
+  for (size_t i = 0; i < 64; i++) {
+    lut << (i == 0 ? "" : ", ") << (63 - i);
+  }
+  std::ostringstream type;
+  type << "tensor<" << batchSize << "x" << REQUEST_SIZE << "x!FHE.eint<6>>";
+  std::ostringstream program;
+  program << "func.func @main(%arg0: " << type.str() << ") -> " << type.str()
+          << " {\n"
+          << "  %lut = arith.constant dense<[" << lut.str()
+          << "]> : tensor<64xi64>\n"
+          << "  %0 = \"FHELinalg.apply_lookup_table\"(%arg0, %lut): ("
+          << type.str() << ", tensor<64xi64>) -> " << type.str() << "\n"
+          << "  return %0: " << type.str() << "\n"
+          << "}\n";
+  return program.str();
+}
+
+/// Returns the given percentile of a sorted list of latencies.
+double getPercentile(const std::vector<double> &sortedLatencies,
+                     double percentile) {
+  if (sortedLatencies.empty()) {
+    return 0.;
+  }
+  auto index = (size_t)(percentile * (sortedLatencies.size() - 1));
+  return sortedLatencies[index];
+}
+
+/// Benchmark a batching server under the load of concurrent clients. The
+/// first argument is the batch size the circuit is compiled for, the second
+/// one is the number of clients sending requests in a closed loop, and the
+/// third one is the latency window of the server in microseconds.
+static void BM_BatchingServer(benchmark::State &state) {
+  auto batchSize = (size_t)state.range(0);
+  auto nbClients = (size_t)state.range(1);
+  BatchingServerOptions options;
+  options.maxLatency = std::chrono::microseconds(state.range(2));
+
+  llvm::SmallString<0> artifactFolder;
+  if (auto ec = llvm::sys::fs::createUniqueDirectory("batching_benchmark",
+                                                     artifactFolder)) {
+    state.SkipWithError(ec.message().c_str());
+    return;
+  }
+  auto engine = mlir::concretelang::CompilerEngine(
+      mlir::concretelang::CompilationContext::createShared());
+  engine.setCompilationOptions(mlir::concretelang::CompilationOptions());
+  auto compiled = engine.compile({getBatchedProgram(batchSize)},
+                                 std::string(artifactFolder));
+  if (!compiled) {
+    state.SkipWithError(llvm::toString(compiled.takeError()).c_str());
+    return;
+  }
+  auto programInfo = compiled->getProgramInfo();
+  auto keyset = getTestKeySetCachePtr()
+                    ->getKeyset(programInfo.asReader().getKeyset(), 0, 0)
+                    .value();
+  auto serverProgram =
+      ServerProgram::load(programInfo,
+                          compiled->getSharedLibraryPath(
+                              std::string(artifactFolder)),
+                          false)
+          .value();
+  auto serverCircuit = serverProgram.getServerCircuit("main").value();
+  auto server =
+      BatchingServer::create(serverCircuit, keyset.server, options).value();
+
+  // Every client encrypts its request against the un-batched signature.
+  auto csprng = std::make_shared<concretelang::csprng::EncryptionCSPRNG>(0);
+  auto clientCircuit =
+      ClientCircuit::create(server->getUnbatchedCircuitInfo(), keyset.client,
+                            csprng, false)
+          .value();
+  auto input = Value{Tensor<uint64_t>({1, 2, 3, 4}, {REQUEST_SIZE})};
+  auto request = std::vector<TransportValue>{
+      clientCircuit.prepareInput(input, 0).value()};
+
+  // Warmup
+  if (!server->call(request)) {
+    state.SkipWithError("Failed to call the batching server.");
+    return;
+  }
+
+  std::vector<double> latencies;
+  std::mutex latenciesGuard;
+  std::atomic<size_t> nbFailures(0);
+  size_t nbRequests = 0;
+  double elapsed = 0.;
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < nbClients; c++) {
+      clients.push_back(std::thread([&]() {
+        std::vector<double> clientLatencies;
+        for (size_t r = 0; r < REQUESTS_PER_CLIENT; r++) {
+          auto sent = std::chrono::steady_clock::now();
+          auto results = server->call(request);
+          if (results.has_failure()) {
+            nbFailures++;
+          }
+          std::chrono::duration<double, std::milli> latency =
+              std::chrono::steady_clock::now() - sent;
+          clientLatencies.push_back(latency.count());
+        }
+        std::lock_guard<std::mutex> guard(latenciesGuard);
+        latencies.insert(latencies.end(), clientLatencies.begin(),
+                         clientLatencies.end());
+      }));
+    }
+    for (auto &client : clients) {
+      client.join();
+    }
+    std::chrono::duration<double> iterationTime =
+        std::chrono::steady_clock::now() - start;
+    elapsed += iterationTime.count();
+    nbRequests += nbClients * REQUESTS_PER_CLIENT;
+    if (nbFailures > 0) {
+      state.SkipWithError("Failed to call the batching server.");
+      break;
+    }
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["requests_per_second"] = nbRequests / elapsed;
+  state.counters["p50_latency_ms"] = getPercentile(latencies, 0.50);
+  state.counters["p99_latency_ms"] = getPercentile(latencies, 0.99);
+
+  server.reset();
+  std::filesystem::remove_all(std::string(artifactFolder));
+}
+
+BENCHMARK(BM_BatchingServer)
+    ->ArgNames({"batch", "clients", "window_us"})
+    ->Args({1, 1, 0})
+    ->Args({1, 16, 0})
+    ->Args({4, 16, 2000})
+    ->Args({16, 16, 2000})
+    ->Args({16, 64, 2000})
+    ->Args({64, 64, 5000})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char **argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  _dfr_terminate();
+  return 0;
+}
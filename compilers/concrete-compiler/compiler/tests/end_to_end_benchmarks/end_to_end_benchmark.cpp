@@ -2,9 +2,13 @@
 #include "concretelang/Common/Compat.h"
 #include "concretelang/TestLib/TestProgram.h"
 #include <concretelang/Runtime/DFRuntime.hpp>
+#include <concretelang/Runtime/huge_pages.h>
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <filesystem>
+#include <sstream>
+#include <thread>
 
 #define BENCHMARK_HAS_CXX11
 #include "llvm/Support/Path.h"
@@ -29,14 +33,54 @@ static void BM_Compile(benchmark::State &state, EndToEndDesc description,
   }
 }
 
-/// Benchmark time of the key generation
+/// Returns a program made of `numFunctions` circuits, each applying a chain
+/// of lookup tables on a tensor, such as the functions of large unrolled
+/// models.
+std::string getManyFunctionsProgram(size_t numFunctions) {
+  std::ostringstream program;
+  for (size_t f = 0; f < numFunctions; f++) {
+    program << "func.func @f" << f
+            << "(%arg0: tensor<8x!FHE.eint<4>>) -> tensor<8x!FHE.eint<4>> {\n"
+            << "  %lut = arith.constant dense<[" << f % 16
+            << ", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15]> : "
+               "tensor<16xi64>\n"
+            << "  %0 = \"FHELinalg.apply_lookup_table\"(%arg0, %lut) : "
+               "(tensor<8x!FHE.eint<4>>, tensor<16xi64>) -> "
+               "tensor<8x!FHE.eint<4>>\n"
+            << "  %1 = \"FHELinalg.add_eint\"(%0, %arg0) : "
+               "(tensor<8x!FHE.eint<4>>, tensor<8x!FHE.eint<4>>) -> "
+               "tensor<8x!FHE.eint<4>>\n"
+            << "  %2 = \"FHELinalg.apply_lookup_table\"(%1, %lut) : "
+               "(tensor<8x!FHE.eint<4>>, tensor<16xi64>) -> "
+               "tensor<8x!FHE.eint<4>>\n"
+            << "  return %2 : tensor<8x!FHE.eint<4>>\n"
+            << "}\n";
+  }
+  return program.str();
+}
+
+/// Benchmark time of the compilation of a program with many functions. The
+/// first argument is the number of functions, the second one whether the
+/// passes run on the functions in parallel.
+static void BM_CompileManyFunctions(benchmark::State &state) {
+  auto options = mlir::concretelang::CompilationOptions();
+  options.multithreading = state.range(1);
+  auto program = getManyFunctionsProgram(state.range(0));
+  TestProgram tc(options);
+  for (auto _ : state) {
+    assert(tc.compile(program));
+  }
+}
+
+/// Benchmark time of the key generation. The argument is the number of
+/// threads generating the keys.
 static void BM_KeyGen(benchmark::State &state, EndToEndDesc description,
                       mlir::concretelang::CompilationOptions options) {
   TestProgram tc(options);
   assert(tc.compile(description.program));
 
   for (auto _ : state) {
-    assert(tc.generateKeyset(0, 0, false));
+    assert(tc.generateKeyset(0, 0, false, state.range(0)));
   }
 }
 
@@ -94,6 +138,18 @@ static void BM_Evaluate(benchmark::State &state, EndToEndDesc description,
   for (auto _ : state) {
     assert(tc.callServer(inputArguments));
   }
+
+  // Reports the pages backing the evaluation keys
+  using mlir::concretelang::huge_pages::Pages;
+  for (auto pages : {Pages::DEFAULT, Pages::TRANSPARENT, Pages::HUGETLB_2MB,
+                     Pages::HUGETLB_1GB}) {
+    auto size = mlir::concretelang::huge_pages::mapped_size(pages);
+    if (size > 0) {
+      std::ostringstream counter;
+      counter << mlir::concretelang::huge_pages::name(pages) << " pages MB";
+      state.counters[counter.str()] = (double)size / (1 << 20);
+    }
+  }
 }
 
 enum Action {
@@ -124,18 +180,34 @@ void registerEndToEndBenchmark(std::string suiteName,
     };
     for (auto action : actions) {
       switch (action) {
-      case Action::COMPILE:
+      case Action::COMPILE: {
         benchmark::RegisterBenchmark(benchName("compile").c_str(),
                                      [=](::benchmark::State &st) {
                                        BM_Compile(st, description, options);
                                      });
+        auto singleThreadOptions = options;
+        singleThreadOptions.multithreading = false;
+        benchmark::RegisterBenchmark(
+            benchName("compile_single_thread").c_str(),
+            [=](::benchmark::State &st) {
+              BM_Compile(st, description, singleThreadOptions);
+            });
         break;
-      case Action::KEYGEN:
-        benchmark::RegisterBenchmark(benchName("keygen").c_str(),
-                                     [=](::benchmark::State &st) {
-                                       BM_KeyGen(st, description, options);
-                                     });
+      }
+      case Action::KEYGEN: {
+        auto bench = benchmark::RegisterBenchmark(
+            benchName("keygen").c_str(), [=](::benchmark::State &st) {
+              BM_KeyGen(st, description, options);
+            });
+        // Scaling of the generation with the number of threads
+        bench->UseRealTime();
+        for (unsigned threads = 1;
+             threads <= std::max(1u, std::thread::hardware_concurrency());
+             threads *= 2) {
+          bench->Arg(threads);
+        }
         break;
+      }
       case Action::ENCRYPT:
         benchmark::RegisterBenchmark(
             benchName("encrypt").c_str(), [=](::benchmark::State &st) {
@@ -183,6 +255,16 @@ int main(int argc, char **argv) {
                Action::EVALUATE};
   }
 
+  if (std::find(actions.begin(), actions.end(), Action::COMPILE) !=
+      actions.end()) {
+    benchmark::RegisterBenchmark("compile_many_functions",
+                                 BM_CompileManyFunctions)
+        ->ArgNames({"functions", "multithreading"})
+        ->ArgsProduct({{16, 64, 256}, {0, 1}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+
   auto stackSizeRequirement = 0;
   for (auto descFile : descriptionFiles) {
     auto suiteName = llvm::sys::path::stem(descFile.path).str();
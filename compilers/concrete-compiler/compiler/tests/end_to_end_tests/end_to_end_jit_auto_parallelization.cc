@@ -121,7 +121,7 @@ TEST(ParallelizeAndRunFHE, nn_small_parallel) {
     ASSERT_OUTCOME_HAS_VALUE(maybeResult);
     auto result = maybeResult.value()[0].template getTensor<uint64_t>().value();
     ASSERT_EQ(result.dimensions, outputShape);
-    parallel_results = result.values;
+    parallel_results.assign(result.values.begin(), result.values.end());
   } else {
     ASSERT_OUTCOME_HAS_FAILURE(lambda.call({}));
   }
@@ -28,3 +28,56 @@ TEST(Lambda_chunked_int, chunked_int_add_eint) {
       lambda({Tensor<uint64_t>(2057594037927936), Tensor<uint64_t>(1111)}),
       (uint64_t)2057594037929047);
 }
+
+TEST(Lambda_chunked_int, chunked_int_add_eint_carries) {
+  checkedJit(testCircuit, R"XXX(
+    func.func @main(%arg0: !FHE.eint<16>, %arg1: !FHE.eint<16>) -> !FHE.eint<16> {
+      %1 = "FHE.add_eint"(%arg0, %arg1): (!FHE.eint<16>, !FHE.eint<16>) -> (!FHE.eint<16>)
+      return %1: !FHE.eint<16>
+    }
+    )XXX",
+             "main", DEFAULT_useDefaultFHEConstraints,
+             DEFAULT_dataflowParallelize, DEFAULT_loopParallelize,
+             DEFAULT_batchTFHEOps, DEFAULT_global_p_error, true, 4, 2);
+  auto lambda = [&](std::vector<concretelang::values::Value> args) {
+    return testCircuit.call(args)
+        .value()[0]
+        .template getTensor<uint64_t>()
+        .value()[0];
+  };
+  ASSERT_EQ(lambda({Tensor<uint64_t>(3), Tensor<uint64_t>(1)}), (uint64_t)4);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(255), Tensor<uint64_t>(1)}),
+            (uint64_t)256);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(32767), Tensor<uint64_t>(32769)}),
+            (uint64_t)0);
+}
+
+TEST(Lambda_chunked_int, chunked_int_add_eint_parallel_prefix) {
+  auto options = mlir::concretelang::CompilationOptions();
+  options.chunkIntegers = true;
+  options.chunkSize = 4;
+  options.chunkWidth = 2;
+  options.chunkParallelism = 64;
+  TestProgram testCircuit(options);
+  ASSERT_OUTCOME_HAS_VALUE(testCircuit.compile(R"XXX(
+    func.func @main(%arg0: !FHE.eint<16>, %arg1: !FHE.eint<16>) -> !FHE.eint<16> {
+      %1 = "FHE.add_eint"(%arg0, %arg1): (!FHE.eint<16>, !FHE.eint<16>) -> (!FHE.eint<16>)
+      return %1: !FHE.eint<16>
+    }
+    )XXX"));
+  ASSERT_OUTCOME_HAS_VALUE(testCircuit.generateKeyset());
+  auto lambda = [&](std::vector<concretelang::values::Value> args) {
+    return testCircuit.call(args)
+        .value()[0]
+        .template getTensor<uint64_t>()
+        .value()[0];
+  };
+  ASSERT_EQ(lambda({Tensor<uint64_t>(1), Tensor<uint64_t>(2)}), (uint64_t)3);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(3), Tensor<uint64_t>(1)}), (uint64_t)4);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(255), Tensor<uint64_t>(1)}),
+            (uint64_t)256);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(12345), Tensor<uint64_t>(20223)}),
+            (uint64_t)32568);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(32767), Tensor<uint64_t>(32769)}),
+            (uint64_t)0);
+}
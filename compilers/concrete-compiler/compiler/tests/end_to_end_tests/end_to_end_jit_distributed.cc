@@ -98,7 +98,7 @@ func.func @main(%arg0: tensor<200x4x!FHE.eint<4>>) -> tensor<200x8x!FHE.eint<4>>
     ASSERT_OUTCOME_HAS_VALUE(maybeResult);
     auto result = maybeResult.value()[0].template getTensor<uint64_t>().value();
     ASSERT_EQ(result.dimensions, outputShape);
-    distributed_results = result.values;
+    distributed_results.assign(result.values.begin(), result.values.end());
   } else {
     ASSERT_OUTCOME_HAS_FAILURE(lambda.call({}));
   }
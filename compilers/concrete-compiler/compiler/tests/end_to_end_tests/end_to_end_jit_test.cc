@@ -1,12 +1,18 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <future>
 #include <gtest/gtest.h>
 #include <type_traits>
+#include <unistd.h>
 
+#include "concretelang/ServerLib/BatchingServer.h"
 #include "concretelang/TestLib/TestProgram.h"
 #include "end_to_end_jit_test.h"
 #include "tests_tools/GtestEnvironment.h"
+#include "llvm/Support/FileSystem.h"
 
 TEST(CompileAndRunClear, add_u64) {
   checkedJit(testCircuit, R"XXX(
@@ -394,6 +400,322 @@ func.func @main(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
   ASSERT_EQ(lambda({Tensor<uint64_t>(0)}, 8), (uint64_t)0);
 }
 
+TEST(CompileAndRunComposed, compose_add_eint_with_server_handles) {
+  checkedJit(testCircuit, R"XXX(
+func.func @main(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
+  %cst_1 = arith.constant 1 : i4
+  %cst_2 = arith.constant dense<[0, 1, 2, 3, 4, 5, 6, 7]> : tensor<8xi64>
+  %1 = "FHE.add_eint_int"(%arg0, %cst_1) : (!FHE.eint<3>, i4) -> !FHE.eint<3>
+  %2 = "FHE.apply_lookup_table"(%1, %cst_2): (!FHE.eint<3>, tensor<8xi64>) -> (!FHE.eint<3>)
+  return %2: !FHE.eint<3>
+}
+)XXX",
+             "main", false, DEFAULT_dataflowParallelize,
+             DEFAULT_loopParallelize, DEFAULT_batchTFHEOps,
+             DEFAULT_global_p_error, DEFAULT_chunkedIntegers, DEFAULT_chunkSize,
+             DEFAULT_chunkWidth, true);
+  auto lambda = [&](std::vector<concretelang::values::Value> args, size_t n) {
+    return testCircuit.compose_n_times_on_server(args, n)
+        .value()[0]
+        .template getTensor<uint64_t>()
+        .value()[0];
+  };
+  ASSERT_EQ(lambda({Tensor<uint64_t>(0)}, 1), (uint64_t)1);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(0)}, 2), (uint64_t)2);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(0)}, 5), (uint64_t)5);
+  ASSERT_EQ(lambda({Tensor<uint64_t>(0)}, 8), (uint64_t)0);
+}
+
+TEST(CompileAndRunComposed, server_handle_reused_by_circuit_updating_input) {
+  checkedJit(testCircuit, R"XXX(
+func.func @main(%in: tensor<2x!FHE.eint<3>>) -> tensor<2x!FHE.eint<3>> {
+  %c_0 = arith.constant 0 : index
+  %cst_1 = arith.constant 1 : i4
+  %a = tensor.extract %in[%c_0] : tensor<2x!FHE.eint<3>>
+  %b = "FHE.add_eint_int"(%a, %cst_1) : (!FHE.eint<3>, i4) -> !FHE.eint<3>
+  %out = tensor.insert %b into %in[%c_0] : tensor<2x!FHE.eint<3>>
+  return %out: tensor<2x!FHE.eint<3>>
+}
+)XXX",
+             "main", false, DEFAULT_dataflowParallelize,
+             DEFAULT_loopParallelize, DEFAULT_batchTFHEOps,
+             DEFAULT_global_p_error, DEFAULT_chunkedIntegers, DEFAULT_chunkSize,
+             DEFAULT_chunkWidth, true);
+  ASSERT_ASSIGN_OUTCOME_VALUE(clientCircuit, testCircuit.getClientCircuit());
+  ASSERT_ASSIGN_OUTCOME_VALUE(serverProgram, testCircuit.getServerProgram());
+  ASSERT_ASSIGN_OUTCOME_VALUE(keyset, testCircuit.getKeyset());
+  auto valueOf = [&](ServerValueHandle handle) {
+    auto transportValue = serverProgram.fetch(handle).value();
+    return clientCircuit.processOutput(transportValue, 0)
+        .value()
+        .getTensor<uint64_t>()
+        .value();
+  };
+
+  Tensor<uint64_t> in({2, 5}, {2});
+  ASSERT_ASSIGN_OUTCOME_VALUE(input, clientCircuit.prepareInput(Value{in}, 0));
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      first, serverProgram.callWithHandles("main", keyset.server, {input}));
+
+  // The value kept on the server is passed in place to both calls, which must
+  // not update it.
+  std::vector<ServerArgument> args = {first[0]};
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      second, serverProgram.callWithHandles("main", keyset.server, args));
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      third, serverProgram.callWithHandles("main", keyset.server, args));
+  ASSERT_EQ(valueOf(first[0]).values, std::vector<uint64_t>({3, 5}));
+  ASSERT_EQ(valueOf(second[0]).values, std::vector<uint64_t>({4, 5}));
+  ASSERT_EQ(valueOf(third[0]).values, std::vector<uint64_t>({4, 5}));
+}
+
+TEST(CompileAndRunStreamed, inputs_streamed_to_fds) {
+  checkedJit(testCircuit, R"XXX(
+func.func @main(%a: tensor<4x!FHE.eint<3>>, %b: tensor<4x!FHE.eint<3>>) -> tensor<4x!FHE.eint<3>> {
+  %0 = "FHELinalg.add_eint"(%a, %b) : (tensor<4x!FHE.eint<3>>, tensor<4x!FHE.eint<3>>) -> tensor<4x!FHE.eint<3>>
+  return %0 : tensor<4x!FHE.eint<3>>
+}
+)XXX");
+  ASSERT_ASSIGN_OUTCOME_VALUE(clientCircuit, testCircuit.getClientCircuit());
+  ASSERT_ASSIGN_OUTCOME_VALUE(serverCircuit, testCircuit.getServerCircuit());
+  ASSERT_ASSIGN_OUTCOME_VALUE(keyset, testCircuit.getKeyset());
+
+  // The client encrypts the inputs to files, which the server reads back.
+  std::vector<Tensor<uint64_t>> args = {Tensor<uint64_t>({1, 2, 3, 4}, {4}),
+                                        Tensor<uint64_t>({3, 2, 1, 0}, {4})};
+  std::vector<FILE *> files;
+  std::vector<int> argFds;
+  for (size_t i = 0; i < args.size(); i++) {
+    auto file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    files.push_back(file);
+    argFds.push_back(fileno(file));
+    ASSERT_OUTCOME_HAS_VALUE(
+        clientCircuit.prepareInputToFd(Value{args[i]}, i, fileno(file)));
+    ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  }
+  ASSERT_ASSIGN_OUTCOME_VALUE(returns,
+                              serverCircuit.callFromFds(keyset.server, argFds));
+  ASSERT_ASSIGN_OUTCOME_VALUE(output,
+                              clientCircuit.processOutput(returns[0], 0));
+  ASSERT_EQ(output.getTensor<uint64_t>().value().values,
+            std::vector<uint64_t>({4, 4, 4, 4}));
+  for (auto file : files) {
+    fclose(file);
+  }
+}
+
+TEST(CompileAndRunKeyStore, evict_and_reload_keysets) {
+  checkedJit(circuit3, R"XXX(
+func.func @main(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
+  %cst = arith.constant dense<[1, 2, 3, 4, 5, 6, 7, 0]> : tensor<8xi64>
+  %1 = "FHE.apply_lookup_table"(%arg0, %cst): (!FHE.eint<3>, tensor<8xi64>) -> (!FHE.eint<3>)
+  return %1: !FHE.eint<3>
+}
+)XXX");
+  checkedJit(circuit6, R"XXX(
+func.func @main(%arg0: !FHE.eint<6>) -> !FHE.eint<6> {
+  %cst = arith.constant dense<[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 0]> : tensor<64xi64>
+  %1 = "FHE.apply_lookup_table"(%arg0, %cst): (!FHE.eint<6>, tensor<64xi64>) -> (!FHE.eint<6>)
+  return %1: !FHE.eint<6>
+}
+)XXX");
+  llvm::SmallString<128> spillDirectory;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("key_store", spillDirectory));
+  // A budget of one byte keeps only the keyset in use resident, the other
+  // one is spilled to disk and read back when used again.
+  concretelang::serverlib::ServerKeyStoreOptions options;
+  options.memoryBudget = 1;
+  options.spillDirectory = spillDirectory.str().str();
+  ServerKeyStore keyStore(options);
+  auto callStore = [&](ServerKeyStore &store, TestProgram &circuit,
+                       const std::string &keysetId, uint64_t arg) {
+    return circuit
+        .call_with_key_store({Tensor<uint64_t>(arg)}, store, keysetId)
+        .value()[0]
+        .template getTensor<uint64_t>()
+        .value()[0];
+  };
+  auto call = [&](TestProgram &circuit, const std::string &keysetId,
+                  uint64_t arg) {
+    return callStore(keyStore, circuit, keysetId, arg);
+  };
+  for (uint64_t i = 0; i < 3; i++) {
+    ASSERT_EQ(call(circuit3, "client3", i), i + 1);
+    ASSERT_EQ(call(circuit6, "client6", i), i + 1);
+  }
+  // A store sharing the spill directory spills the same keyset to another
+  // file, which it removes without affecting the first store.
+  {
+    ServerKeyStore otherKeyStore(options);
+    ASSERT_EQ(callStore(otherKeyStore, circuit3, "client3", 4), (uint64_t)5);
+    ASSERT_EQ(callStore(otherKeyStore, circuit6, "client6", 4), (uint64_t)5);
+  }
+  ASSERT_EQ(call(circuit3, "client3", 5), (uint64_t)6);
+  // The same keyset registered under another identifier is shared
+  size_t residentSize = keyStore.getResidentSize();
+  ASSERT_EQ(call(circuit6, "other_client6", 62), (uint64_t)63);
+  ASSERT_EQ(keyStore.getResidentSize(), residentSize);
+  ASSERT_TRUE(keyStore.remove("client3").has_value());
+  ASSERT_FALSE(keyStore.remove("client3").has_value());
+  llvm::sys::fs::remove_directories(spillDirectory);
+}
+
+/// Compiles a lookup table on requests of 2 3-bits integers, batched by 4.
+void compileBatchedLookupTable(TestProgram &circuit) {
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<4x2x!FHE.eint<3>>) -> tensor<4x2x!FHE.eint<3>> {
+  %lut = arith.constant dense<[7, 6, 5, 4, 3, 2, 1, 0]> : tensor<8xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<4x2x!FHE.eint<3>>, tensor<8xi64>) -> (tensor<4x2x!FHE.eint<3>>)
+  return %1: tensor<4x2x!FHE.eint<3>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+}
+
+/// Submits `nbRequests` requests to `server`, without waiting for their
+/// results, and checks the results of each request.
+void checkBatchedRequests(TestProgram &circuit,
+                          concretelang::serverlib::BatchingServer &server,
+                          size_t nbRequests) {
+  auto keyset = circuit.getKeyset().value();
+  auto csprng = std::make_shared<concretelang::csprng::EncryptionCSPRNG>(0);
+  auto clientCircuit = ClientCircuit::create(server.getUnbatchedCircuitInfo(),
+                                             keyset.client, csprng, false)
+                           .value();
+  std::vector<Tensor<uint64_t>> inputs;
+  std::vector<std::future<Result<std::vector<TransportValue>>>> futures;
+  for (size_t i = 0; i < nbRequests; i++) {
+    inputs.push_back(Tensor<uint64_t>({i % 8, (i * 3 + 1) % 8}, {2}));
+    auto arg = clientCircuit.prepareInput(Value{inputs[i]}, 0).value();
+    futures.push_back(server.submit({arg}));
+  }
+  for (size_t i = 0; i < nbRequests; i++) {
+    ASSERT_EQ(futures[i].wait_for(std::chrono::seconds(60)),
+              std::future_status::ready);
+    ASSERT_ASSIGN_OUTCOME_VALUE(results, futures[i].get());
+    ASSERT_EQ(results.size(), (size_t)1);
+    auto output = clientCircuit.processOutput(results[0], 0)
+                      .value()
+                      .getTensor<uint64_t>()
+                      .value();
+    ASSERT_EQ(output.dimensions, inputs[i].dimensions);
+    for (size_t j = 0; j < 2; j++) {
+      ASSERT_EQ(output.values[j], 7 - inputs[i].values[j]);
+    }
+  }
+}
+
+TEST(BatchingServer, full_batches_match_individual_requests) {
+  mlir::concretelang::CompilationOptions compilationOptions;
+  TestProgram circuit(compilationOptions);
+  compileBatchedLookupTable(circuit);
+  // The latency window is long enough for the batches to only be executed
+  // once full.
+  concretelang::serverlib::BatchingServerOptions options;
+  options.maxLatency = std::chrono::seconds(600);
+  auto server = concretelang::serverlib::BatchingServer::create(
+                    circuit.getServerCircuit().value(),
+                    circuit.getKeyset().value().server, options)
+                    .value();
+  ASSERT_EQ(server->getBatchSize(), (size_t)4);
+  checkBatchedRequests(circuit, *server, 8);
+}
+
+TEST(BatchingServer, partial_batch_flushed_on_timeout) {
+  mlir::concretelang::CompilationOptions compilationOptions;
+  TestProgram circuit(compilationOptions);
+  compileBatchedLookupTable(circuit);
+  concretelang::serverlib::BatchingServerOptions options;
+  options.maxLatency = std::chrono::milliseconds(50);
+  auto server = concretelang::serverlib::BatchingServer::create(
+                    circuit.getServerCircuit().value(),
+                    circuit.getKeyset().value().server, options)
+                    .value();
+  // 3 requests never fill a batch of 4, they are padded and executed once
+  // the window of the oldest one expires.
+  checkBatchedRequests(circuit, *server, 3);
+  // A full batch followed by a partial one.
+  checkBatchedRequests(circuit, *server, 6);
+}
+
+TEST(BatchingServer, partial_batch_uses_smaller_circuit) {
+  mlir::concretelang::CompilationOptions compilationOptions;
+  TestProgram circuit(compilationOptions);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<4x2x!FHE.eint<3>>) -> tensor<4x2x!FHE.eint<3>> {
+  %lut = arith.constant dense<[7, 6, 5, 4, 3, 2, 1, 0]> : tensor<8xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<4x2x!FHE.eint<3>>, tensor<8xi64>) -> (tensor<4x2x!FHE.eint<3>>)
+  return %1: tensor<4x2x!FHE.eint<3>>
+}
+func.func @single(%arg0: tensor<1x2x!FHE.eint<3>>) -> tensor<1x2x!FHE.eint<3>> {
+  %lut = arith.constant dense<[7, 6, 5, 4, 3, 2, 1, 0]> : tensor<8xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<1x2x!FHE.eint<3>>, tensor<8xi64>) -> (tensor<1x2x!FHE.eint<3>>)
+  return %1: tensor<1x2x!FHE.eint<3>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+  concretelang::serverlib::BatchingServerOptions options;
+  options.maxLatency = std::chrono::milliseconds(50);
+  auto server = concretelang::serverlib::BatchingServer::create(
+                    {circuit.getServerCircuit("main").value(),
+                     circuit.getServerCircuit("single").value()},
+                    circuit.getKeyset().value().server, options)
+                    .value();
+  ASSERT_EQ(server->getBatchSizes(), (std::vector<size_t>{1, 4}));
+  // A lone request is executed by the circuit of batch size 1, as is the
+  // fifth of 5 requests once the first 4 filled the circuit of batch size 4.
+  checkBatchedRequests(circuit, *server, 1);
+  checkBatchedRequests(circuit, *server, 5);
+}
+
+TEST(BatchingServer, simulation_rejects_malformed_request) {
+  mlir::concretelang::CompilationOptions compilationOptions;
+  compilationOptions.simulate = true;
+  TestProgram circuit(compilationOptions);
+  compileBatchedLookupTable(circuit);
+  concretelang::serverlib::BatchingServerOptions options;
+  options.maxLatency = std::chrono::milliseconds(50);
+  auto server = concretelang::serverlib::BatchingServer::create(
+                    circuit.getServerCircuit().value(),
+                    circuit.getKeyset().value().server, options, true)
+                    .value();
+  auto csprng = std::make_shared<concretelang::csprng::EncryptionCSPRNG>(0);
+  auto clientCircuit =
+      ClientCircuit::create(server->getUnbatchedCircuitInfo(),
+                            circuit.getKeyset().value().client, csprng, true)
+          .value();
+  auto input = Tensor<uint64_t>({1, 2}, {2});
+  auto arg = clientCircuit.prepareInput(Value{input}, 0).value();
+  // A simulated ciphertext of a wrong shape is rejected, instead of failing
+  // the batch it would have joined.
+  TransportValue malformed = arg;
+  malformed.asBuilder().getRawInfo().getShape().initDimensions(1).set(0, 3);
+  auto rejected = server->submit({malformed});
+  auto accepted = server->submit({arg});
+  ASSERT_OUTCOME_HAS_FAILURE(rejected.get());
+  ASSERT_ASSIGN_OUTCOME_VALUE(results, accepted.get());
+  auto output = clientCircuit.processOutput(results[0], 0)
+                    .value()
+                    .getTensor<uint64_t>()
+                    .value();
+  ASSERT_EQ(output.values, (std::vector<uint64_t>{6, 5}));
+}
+
+TEST(BatchingServer, reject_incompatible_request) {
+  mlir::concretelang::CompilationOptions compilationOptions;
+  TestProgram circuit(compilationOptions);
+  compileBatchedLookupTable(circuit);
+  auto server = concretelang::serverlib::BatchingServer::create(
+                    circuit.getServerCircuit().value(),
+                    circuit.getKeyset().value().server)
+                    .value();
+  ASSERT_OUTCOME_HAS_FAILURE(server->call({}));
+}
+
 TEST(CompileNotComposable, not_composable_1) {
   mlir::concretelang::CompilationOptions options;
   options.optimizerConfig.composable = true;
@@ -496,3 +818,232 @@ func.func @dec(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
   ASSERT_EQ(lambda_dec({Tensor<uint64_t>(1)}), (uint64_t)0);
   ASSERT_EQ(lambda_dec({Tensor<uint64_t>(4)}), (uint64_t)3);
 }
+
+TEST(CompileAndRunShrunkOutputs, apply_lookup_table_tensor) {
+  mlir::concretelang::CompilationOptions options;
+  options.shrinkOutputs = true;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<4x!FHE.eint<4>>) -> tensor<4x!FHE.eint<4>> {
+  %lut = arith.constant dense<[15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0]> : tensor<16xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<4x!FHE.eint<4>>, tensor<16xi64>) -> (tensor<4x!FHE.eint<4>>)
+  return %1: tensor<4x!FHE.eint<4>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+
+  // The output is sent back on a reduced modulus, stored on fewer bits.
+  auto serverCircuit = circuit.getServerCircuit().value();
+  auto outputGate = serverCircuit.getCircuitInfo().asReader().getOutputs()[0];
+  ASSERT_TRUE(outputGate.getTypeInfo()
+                  .getLweCiphertext()
+                  .getEncryption()
+                  .getModulus()
+                  .getMod()
+                  .isPowerOfTwo());
+  ASSERT_LT(outputGate.getRawInfo().getIntegerPrecision(), (uint32_t)64);
+
+  Tensor<uint64_t> in({0, 1, 7, 15}, {4});
+  auto res = circuit.call({in}).value()[0].getTensor<uint64_t>().value();
+  ASSERT_EQ(res.values.size(), (size_t)4);
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_EQ(res.values[i], (uint64_t)(15 - in.values[i]));
+  }
+}
+
+TEST(CompileAndRunShrunkOutputs, levelled_output) {
+  mlir::concretelang::CompilationOptions options;
+  options.shrinkOutputs = true;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<4x!FHE.eint<4>>) -> tensor<4x!FHE.eint<4>> {
+  %lut = arith.constant dense<[0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7]> : tensor<16xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<4x!FHE.eint<4>>, tensor<16xi64>) -> (tensor<4x!FHE.eint<4>>)
+  %2 = "FHELinalg.add_eint"(%1, %arg0): (tensor<4x!FHE.eint<4>>, tensor<4x!FHE.eint<4>>) -> (tensor<4x!FHE.eint<4>>)
+  return %2: tensor<4x!FHE.eint<4>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+
+  // The output keyswitch was optimized with the circuit, the output is then
+  // encrypted under the input key of the bootstrap, on the modulus 2N of its
+  // blind rotation.
+  auto serverCircuit = circuit.getServerCircuit().value();
+  auto outputGate = serverCircuit.getCircuitInfo().asReader().getOutputs()[0];
+  auto encryption =
+      outputGate.getTypeInfo().getLweCiphertext().getEncryption();
+  auto keyset = circuit.getKeyset().value();
+  auto bsk = keyset.server.lweBootstrapKeys[0].getInfo().asReader();
+  ASSERT_EQ(encryption.getKeyId(), bsk.getInputId());
+  ASSERT_TRUE(encryption.getModulus().getMod().isPowerOfTwo());
+  auto modulusLog = encryption.getModulus().getMod().getPowerOfTwo().getPower();
+  ASSERT_EQ((uint64_t)1 << modulusLog, 2 * bsk.getParams().getPolynomialSize());
+
+  Tensor<uint64_t> in({0, 1, 6, 7}, {4});
+  auto res = circuit.call({in}).value()[0].getTensor<uint64_t>().value();
+  ASSERT_EQ(res.values.size(), (size_t)4);
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_EQ(res.values[i], (uint64_t)(in.values[i] / 2 + in.values[i]));
+  }
+}
+
+TEST(CompileAndRunSimulation, batched_apply_lookup_table) {
+  mlir::concretelang::CompilationOptions options;
+  options.simulate = true;
+  options.batchTFHEOps = true;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<8x!FHE.eint<4>>) -> tensor<8x!FHE.eint<4>> {
+  %lut = arith.constant dense<[15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0]> : tensor<16xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<8x!FHE.eint<4>>, tensor<16xi64>) -> (tensor<8x!FHE.eint<4>>)
+  return %1: tensor<8x!FHE.eint<4>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+
+  Tensor<uint64_t> in({0, 1, 2, 3, 7, 8, 14, 15}, {8});
+  auto res = circuit.call({in}).value()[0].getTensor<uint64_t>().value();
+  ASSERT_EQ(res.values.size(), (size_t)8);
+  for (size_t i = 0; i < 8; i++) {
+    ASSERT_EQ(res.values[i], (uint64_t)(15 - in.values[i]));
+  }
+}
+
+TEST(CompileAndRunSimulation, batched_leveled_operations) {
+  mlir::concretelang::CompilationOptions options;
+  options.simulate = true;
+  options.batchTFHEOps = true;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<8x!FHE.eint<4>>, %arg1: tensor<8x!FHE.eint<4>>) -> tensor<8x!FHE.eint<4>> {
+  %cst = arith.constant dense<[1, 0, 1, 0, 1, 0, 1, 0]> : tensor<8xi5>
+  %two = arith.constant dense<2> : tensor<8xi5>
+  %0 = "FHELinalg.add_eint"(%arg0, %arg1) : (tensor<8x!FHE.eint<4>>, tensor<8x!FHE.eint<4>>) -> tensor<8x!FHE.eint<4>>
+  %1 = "FHELinalg.add_eint_int"(%0, %cst) : (tensor<8x!FHE.eint<4>>, tensor<8xi5>) -> tensor<8x!FHE.eint<4>>
+  %2 = "FHELinalg.mul_eint_int"(%1, %two) : (tensor<8x!FHE.eint<4>>, tensor<8xi5>) -> tensor<8x!FHE.eint<4>>
+  return %2: tensor<8x!FHE.eint<4>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+
+  Tensor<uint64_t> a({0, 1, 2, 3, 0, 1, 2, 3}, {8});
+  Tensor<uint64_t> b({0, 0, 1, 1, 2, 2, 3, 3}, {8});
+  auto res = circuit.call({a, b}).value()[0].getTensor<uint64_t>().value();
+  ASSERT_EQ(res.values.size(), (size_t)8);
+  for (size_t i = 0; i < 8; i++) {
+    ASSERT_EQ(res.values[i],
+              (uint64_t)((a.values[i] + b.values[i] + (i + 1) % 2) * 2));
+  }
+}
+
+TEST(CompileAndRunKeyswitchKeyPrecision, apply_lookup_table_u32_ksk) {
+  mlir::concretelang::CompilationOptions options;
+  options.keyswitchKeyPrecision = 32;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: tensor<4x!FHE.eint<4>>) -> tensor<4x!FHE.eint<4>> {
+  %lut = arith.constant dense<[15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0]> : tensor<16xi64>
+  %1 = "FHELinalg.apply_lookup_table"(%arg0, %lut): (tensor<4x!FHE.eint<4>>, tensor<16xi64>) -> (tensor<4x!FHE.eint<4>>)
+  %2 = "FHELinalg.apply_lookup_table"(%1, %lut): (tensor<4x!FHE.eint<4>>, tensor<16xi64>) -> (tensor<4x!FHE.eint<4>>)
+  return %2: tensor<4x!FHE.eint<4>>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset(0, 0, false));
+
+  // The keys whose decomposition fits in 32 bits are generated on 32 bits.
+  auto keyset = circuit.getKeyset().value();
+  size_t nbKeysOn32Bits = 0;
+  for (auto &ksk : keyset.server.lweKeyswitchKeys) {
+    auto params = ksk.getInfo().asReader().getParams();
+    auto expected =
+        params.getLevelCount() * params.getBaseLog() <= 32 ? 32u : 64u;
+    ASSERT_EQ(params.getIntegerPrecision(), expected);
+    nbKeysOn32Bits += params.getIntegerPrecision() == 32;
+  }
+  ASSERT_GT(nbKeysOn32Bits, (size_t)0);
+
+  Tensor<uint64_t> in({0, 1, 7, 15}, {4});
+  auto res = circuit.call({in}).value()[0].getTensor<uint64_t>().value();
+  ASSERT_EQ(res.values, in.values);
+}
+
+TEST(CompileAndRunKeyswitchKeyPrecision, wop_pbs_keeps_u64_ksk) {
+  mlir::concretelang::CompilationOptions options;
+  options.keyswitchKeyPrecision = 32;
+  options.optimizerConfig.encoding = concrete_optimizer::Encoding::Crt;
+  TestProgram circuit(options);
+  auto err = circuit.compile(R"XXX(
+func.func @main(%arg0: !FHE.eint<4>) -> !FHE.eint<4> {
+  %lut = arith.constant dense<[15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0]> : tensor<16xi64>
+  %1 = "FHE.apply_lookup_table"(%arg0, %lut): (!FHE.eint<4>, tensor<16xi64>) -> (!FHE.eint<4>)
+  return %1: !FHE.eint<4>
+}
+)XXX");
+  ASSERT_OUTCOME_HAS_VALUE(err);
+  ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset(0, 0, false));
+
+  // The bit extraction of the wop-pbs reads its keyswitch key on 64 bits.
+  auto keyset = circuit.getKeyset().value();
+  for (auto &ksk : keyset.server.lweKeyswitchKeys) {
+    ASSERT_EQ(ksk.getInfo().asReader().getParams().getIntegerPrecision(),
+              (uint32_t)64);
+  }
+
+  auto res = circuit.call({Tensor<uint64_t>(3)}).value()[0];
+  ASSERT_EQ(res.getTensor<uint64_t>().value()[0], (uint64_t)12);
+}
+
+TEST(CompileAndRunCompilationCache, reuse_cached_artifacts) {
+  llvm::SmallString<0> cacheDir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("compilation_cache", cacheDir));
+  auto countEntries = [&]() {
+    auto entries = std::filesystem::directory_iterator(cacheDir.str().str());
+    return std::distance(std::filesystem::begin(entries),
+                         std::filesystem::end(entries));
+  };
+  auto program = R"XXX(
+func.func @main(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
+  %lut = arith.constant dense<[7, 6, 5, 4, 3, 2, 1, 0]> : tensor<8xi64>
+  %1 = "FHE.apply_lookup_table"(%arg0, %lut): (!FHE.eint<3>, tensor<8xi64>) -> (!FHE.eint<3>)
+  return %1: !FHE.eint<3>
+}
+)XXX";
+  // Same program, but formatted differently
+  auto reformattedProgram = R"XXX(
+// The same lookup table
+func.func @main(%arg0: !FHE.eint<3>) -> !FHE.eint<3> {
+  %lut = arith.constant dense<[7, 6, 5, 4, 3, 2, 1, 0]> : tensor<8xi64>
+  %1 = "FHE.apply_lookup_table"(%arg0, %lut) : (!FHE.eint<3>, tensor<8xi64>) -> !FHE.eint<3>
+  return %1 : !FHE.eint<3>
+}
+)XXX";
+
+  mlir::concretelang::CompilationOptions options;
+  options.compilationCacheDir = cacheDir.str().str();
+  {
+    TestProgram circuit(options);
+    ASSERT_OUTCOME_HAS_VALUE(circuit.compile(program));
+    ASSERT_EQ(countEntries(), 1);
+  }
+  {
+    TestProgram circuit(options);
+    ASSERT_OUTCOME_HAS_VALUE(circuit.compile(reformattedProgram));
+    ASSERT_EQ(countEntries(), 1);
+    ASSERT_OUTCOME_HAS_VALUE(circuit.generateKeyset());
+    auto res = circuit.call({Tensor<uint64_t>(2)}).value()[0];
+    ASSERT_EQ(res.getTensor<uint64_t>().value()[0], (uint64_t)5);
+  }
+  options.optimizerConfig.global_p_error = 1e-6;
+  {
+    TestProgram circuit(options);
+    ASSERT_OUTCOME_HAS_VALUE(circuit.compile(program));
+    ASSERT_EQ(countEntries(), 2);
+  }
+  std::filesystem::remove_all(cacheDir.str().str());
+}
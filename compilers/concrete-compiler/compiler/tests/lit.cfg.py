@@ -1,3 +1,5 @@
+import shutil
+
 import lit.formats
 
 # Lit configuration
@@ -12,3 +14,11 @@ config.environment['PATH'] = os.pathsep.join([
     config.environment['PATH']]
 )
 print(config.environment['PATH'])
+
+# Features of the build, written by CMake in the build directory
+compiler = shutil.which("concretecompiler", path=config.environment['PATH'])
+if compiler:
+    features = os.path.join(os.path.dirname(os.path.dirname(compiler)), "lit.features")
+    if os.path.exists(features):
+        with open(features) as f:
+            config.available_features.update(f.read().split())
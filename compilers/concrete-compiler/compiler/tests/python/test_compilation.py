@@ -489,3 +489,32 @@ def test_memory_usage(mlir: str, expected_memory_usage_per_loc: dict):
     )
 
     shutil.rmtree(artifact_dir)
+
+
+def test_memory_planning(keyset_cache):
+    mlir = """
+    func.func @main(%arg0: tensor<4x4x!FHE.eint<6>>, %arg1: tensor<4x2xi7>) -> tensor<4x2x!FHE.eint<6>> {
+        %0 = "FHELinalg.matmul_eint_int"(%arg0, %arg1): (tensor<4x4x!FHE.eint<6>>, tensor<4x2xi7>) -> (tensor<4x2x!FHE.eint<6>>)
+        %tlu = arith.constant dense<[0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63]> : tensor<64xi64>
+        %result = "FHELinalg.apply_lookup_table"(%0, %tlu): (tensor<4x2x!FHE.eint<6>>, tensor<64xi64>) -> (tensor<4x2x!FHE.eint<6>>)
+        return %result: tensor<4x2x!FHE.eint<6>>
+    }
+    """
+    args = (
+        np.array([[1, 2, 3, 4], [4, 2, 1, 0], [2, 3, 1, 5], [0, 1, 0, 1]]),
+        np.array([[1, 2], [2, 1], [1, 0], [0, 1]]),
+    )
+    expected_result = np.array([[8, 8], [9, 10], [9, 12], [2, 2]])
+
+    artifact_dir = "./py_test_memory_planning"
+    engine = LibrarySupport.new(artifact_dir)
+    options = CompilationOptions.new()
+    options.set_memory_planning(True)
+    compilation_result = engine.compile(mlir, options)
+    result = run(engine, args, compilation_result, keyset_cache)
+    assert_result(result, expected_result)
+
+    compilation_feedback = engine.load_compilation_feedback(compilation_result)
+    assert compilation_feedback.circuit_feedbacks[0].planned_memory_peak > 0
+
+    shutil.rmtree(artifact_dir)
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include "concretelang/Common/Keysets.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "tests_tools/assert.h"
+
+namespace {
+using concretelang::keysets::Keyset;
+using concretelang::keysets::KeysetCache;
+using concretelang::keysets::KeysetGenerationOptions;
+
+const __uint128_t SECRET_SEED = 0x0123456789ABCDEF;
+const __uint128_t ENCRYPTION_SEED = 0xFEDCBA9876543210;
+
+/// Returns the infos of a small keyset, with a big and a small secret key,
+/// and two bootstrap keys and two keyswitch keys between them, such that
+/// several server keys are generated concurrently.
+Message<concreteprotocol::KeysetInfo> makeKeysetInfo() {
+  const uint32_t smallDimension = 32;
+  const uint32_t polynomialSize = 256;
+  auto output = Message<concreteprotocol::KeysetInfo>();
+
+  auto secretKeys = output.asBuilder().initLweSecretKeys(2);
+  uint32_t dimensions[] = {polynomialSize, smallDimension};
+  for (uint32_t id = 0; id < 2; id++) {
+    secretKeys[id].setId(id);
+    auto params = secretKeys[id].initParams();
+    params.setIntegerPrecision(64);
+    params.setLweDimension(dimensions[id]);
+    params.setKeyType(concreteprotocol::KeyType::BINARY);
+  }
+
+  auto bootstrapKeys = output.asBuilder().initLweBootstrapKeys(2);
+  for (uint32_t id = 0; id < 2; id++) {
+    bootstrapKeys[id].setId(id);
+    bootstrapKeys[id].setInputId(1);
+    bootstrapKeys[id].setOutputId(0);
+    bootstrapKeys[id].setCompression(concreteprotocol::Compression::NONE);
+    auto params = bootstrapKeys[id].initParams();
+    params.setLevelCount(id + 1);
+    params.setBaseLog(8);
+    params.setGlweDimension(1);
+    params.setPolynomialSize(polynomialSize);
+    params.setInputLweDimension(smallDimension);
+    params.setVariance(1e-20);
+    params.setIntegerPrecision(64);
+    params.setKeyType(concreteprotocol::KeyType::BINARY);
+    params.initModulus().initMod().initNative();
+  }
+
+  auto keyswitchKeys = output.asBuilder().initLweKeyswitchKeys(2);
+  for (uint32_t id = 0; id < 2; id++) {
+    keyswitchKeys[id].setId(id);
+    keyswitchKeys[id].setInputId(0);
+    keyswitchKeys[id].setOutputId(1);
+    keyswitchKeys[id].setCompression(concreteprotocol::Compression::NONE);
+    auto params = keyswitchKeys[id].initParams();
+    params.setLevelCount(id + 2);
+    params.setBaseLog(4);
+    params.setVariance(1e-10);
+    params.setIntegerPrecision(64);
+    params.setInputLweDimension(polynomialSize);
+    params.setOutputLweDimension(smallDimension);
+    params.setKeyType(concreteprotocol::KeyType::BINARY);
+    params.initModulus().initMod().initNative();
+  }
+
+  return output;
+}
+
+template <typename Key>
+void assertSameKeys(const std::vector<Key> &keys,
+                    const std::vector<Key> &expected) {
+  ASSERT_EQ(keys.size(), expected.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_EQ(keys[i].getTransportBuffer(), expected[i].getTransportBuffer());
+  }
+}
+
+void assertSameKeyset(const Keyset &keyset, const Keyset &expected) {
+  assertSameKeys(keyset.client.lweSecretKeys, expected.client.lweSecretKeys);
+  assertSameKeys(keyset.server.lweBootstrapKeys,
+                 expected.server.lweBootstrapKeys);
+  assertSameKeys(keyset.server.lweKeyswitchKeys,
+                 expected.server.lweKeyswitchKeys);
+  assertSameKeys(keyset.server.packingKeyswitchKeys,
+                 expected.server.packingKeyswitchKeys);
+  ASSERT_EQ(keyset.server.getDigest(), expected.server.getDigest());
+}
+
+TEST(Keysets, generate_does_not_depend_on_threads) {
+  auto info = makeKeysetInfo();
+  KeysetGenerationOptions sequential;
+  sequential.threads = 1;
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      expected, Keyset::generate(info, SECRET_SEED, ENCRYPTION_SEED,
+                                 sequential));
+  ASSERT_EQ(expected.server.lweBootstrapKeys.size(), 2u);
+  ASSERT_EQ(expected.server.lweKeyswitchKeys.size(), 2u);
+
+  for (size_t threads : {2, 4, 0}) {
+    KeysetGenerationOptions concurrent;
+    concurrent.threads = threads;
+    ASSERT_ASSIGN_OUTCOME_VALUE(
+        keyset, Keyset::generate(info, SECRET_SEED, ENCRYPTION_SEED,
+                                 concurrent));
+    assertSameKeyset(keyset, expected);
+  }
+
+  // Other seeds give other keys.
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      other, Keyset::generate(info, SECRET_SEED, ENCRYPTION_SEED + 1,
+                              sequential));
+  ASSERT_NE(other.server.getDigest(), expected.server.getDigest());
+}
+
+TEST(Keysets, cache_reloads_the_generated_keyset) {
+  llvm::SmallString<0> directory;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("keyset_cache_test",
+                                                    directory));
+  auto info = makeKeysetInfo();
+  KeysetGenerationOptions sequential;
+  sequential.threads = 1;
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      expected, Keyset::generate(info, SECRET_SEED, ENCRYPTION_SEED,
+                                 sequential));
+
+  // The first cache generates the keyset, and saves its keys.
+  KeysetCache generatingCache((std::string)directory);
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      generated, generatingCache.getKeyset(info, SECRET_SEED, ENCRYPTION_SEED));
+  assertSameKeyset(generated, expected);
+
+  // Only the complete entry is left in the directory.
+  std::error_code err;
+  std::vector<std::string> entries;
+  for (llvm::sys::fs::directory_iterator entry(directory, err), end;
+       !err && entry != end; entry.increment(err)) {
+    entries.push_back(entry->path());
+  }
+  ASSERT_FALSE(err);
+  ASSERT_EQ(entries.size(), 1u);
+  for (auto name : {"secretKey_0", "secretKey_1", "pbsKey_0", "pbsKey_1",
+                    "ksKey_0", "ksKey_1"}) {
+    llvm::SmallString<0> path(entries[0]);
+    llvm::sys::path::append(path, name);
+    ASSERT_TRUE(llvm::sys::fs::exists(path)) << (std::string)path;
+  }
+
+  // Another cache on the same directory reloads the saved keys.
+  KeysetCache reloadingCache((std::string)directory);
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      reloaded, reloadingCache.getKeyset(info, SECRET_SEED, ENCRYPTION_SEED));
+  assertSameKeyset(reloaded, expected);
+
+  llvm::sys::fs::remove_directories(directory);
+}
+
+} // namespace
@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+#include "capnp/any.h"
+#include "concretelang/Common/Csprng.h"
+#include "concretelang/Common/Keysets.h"
+#include "concretelang/Common/Protocol.h"
+#include "concretelang/Common/Transformers.h"
+#include "concretelang/Common/Values.h"
+#include "tests_tools/assert.h"
+
+namespace {
+using concretelang::csprng::EncryptionCSPRNG;
+using concretelang::keysets::Keyset;
+using concretelang::protocol::protoPayloadBlobSizes;
+using concretelang::protocol::readValueFromFd;
+using concretelang::protocol::ValueStreamReader;
+using concretelang::protocol::ValueStreamWriter;
+using concretelang::protocol::writeValueToFd;
+using concretelang::transformers::TransformerFactory;
+using concretelang::values::Tensor;
+using concretelang::values::Value;
+
+Value makeValue(size_t length) {
+  std::vector<uint64_t> values(length);
+  for (size_t i = 0; i < length; i++) {
+    values[i] = i * 0x9E3779B97F4A7C15;
+  }
+  return Value{Tensor<uint64_t>(values, {length / 3, 3})};
+}
+
+TEST(ValueStream, write_and_read_value) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = makeValue(3000);
+
+  ASSERT_OUTCOME_HAS_VALUE(
+      writeValueToFd(fileno(file), value.intoRawTransportValue()));
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ASSERT_ASSIGN_OUTCOME_VALUE(read, readValueFromFd(fileno(file)));
+
+  ASSERT_EQ(Value::fromRawTransportValue(read), value);
+  fclose(file);
+}
+
+TEST(ValueStream, write_and_read_payload_by_chunks) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = makeValue(3000);
+  auto tensor = value.getTensor<uint64_t>().value();
+  auto transportValue = value.intoRawTransportValue();
+
+  // The payload is written by pieces, as if it was being computed.
+  ValueStreamWriter writer(fileno(file));
+  ASSERT_OUTCOME_HAS_VALUE(writer.writeHeader(
+      transportValue.asReader(),
+      protoPayloadBlobSizes<uint64_t>(tensor.values.size())));
+  for (size_t i = 0; i < tensor.values.size(); i += 1000) {
+    ASSERT_OUTCOME_HAS_FAILURE(writer.finish());
+    ASSERT_OUTCOME_HAS_VALUE(
+        writer.writePayload(&tensor.values[i], 1000 * sizeof(uint64_t)));
+  }
+  ASSERT_OUTCOME_HAS_VALUE(writer.finish());
+  ASSERT_OUTCOME_HAS_FAILURE(writer.writePayload(tensor.values.data(), 1));
+
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ValueStreamReader reader(fileno(file));
+  ASSERT_ASSIGN_OUTCOME_VALUE(read, reader.readHeader());
+  size_t chunks = 0;
+  size_t readSize = 0;
+  ASSERT_OUTCOME_HAS_VALUE(reader.readPayload(read, 4096, [&](size_t size) {
+    chunks++;
+    readSize = size;
+  }));
+  ASSERT_EQ(readSize, tensor.values.size() * sizeof(uint64_t));
+  ASSERT_EQ(chunks, (readSize + 4095) / 4096);
+
+  ASSERT_EQ(Value::fromRawTransportValue(read), value);
+  fclose(file);
+}
+
+TEST(ValueStream, read_truncated_value) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = makeValue(300);
+
+  ASSERT_OUTCOME_HAS_VALUE(
+      writeValueToFd(fileno(file), value.intoRawTransportValue()));
+  auto size = lseek(fileno(file), 0, SEEK_CUR);
+  ASSERT_EQ(ftruncate(fileno(file), size - 8), 0);
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+
+  ASSERT_OUTCOME_HAS_FAILURE(readValueFromFd(fileno(file)));
+  fclose(file);
+}
+
+TEST(ValueStream, read_value_with_mismatched_blob_sizes) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = makeValue(3000);
+  auto transportValue = value.intoRawTransportValue();
+
+  // The blob sizes announce one less integer than the shape of the value.
+  ValueStreamWriter writer(fileno(file));
+  ASSERT_OUTCOME_HAS_VALUE(writer.writeHeader(
+      transportValue.asReader(), protoPayloadBlobSizes<uint64_t>(2999)));
+
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ValueStreamReader reader(fileno(file));
+  ASSERT_OUTCOME_HAS_FAILURE(reader.readHeader());
+  fclose(file);
+}
+
+TEST(ValueStream, read_value_with_too_large_payload) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = Tensor<uint64_t>({0}, {1});
+  auto transportValue = Value{value}.intoRawTransportValue();
+  auto dimensions =
+      transportValue.asBuilder().getRawInfo().getShape().initDimensions(2);
+  dimensions.set(0, 1 << 30);
+  dimensions.set(1, 1 << 30);
+
+  // The header is rejected before the sizes of the blobs are read.
+  ValueStreamWriter writer(fileno(file));
+  ASSERT_OUTCOME_HAS_VALUE(writer.writeHeader(transportValue.asReader(), {}));
+
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ValueStreamReader reader(fileno(file));
+  ASSERT_OUTCOME_HAS_FAILURE(reader.readHeader());
+  fclose(file);
+}
+
+TEST(ValueStream, read_value_above_the_maximal_payload_size) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto value = makeValue(3000);
+  ASSERT_OUTCOME_HAS_VALUE(
+      writeValueToFd(fileno(file), value.intoRawTransportValue()));
+
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ASSERT_OUTCOME_HAS_FAILURE(
+      readValueFromFd(fileno(file), 3000 * sizeof(uint64_t) - 1));
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      read, readValueFromFd(fileno(file), 3000 * sizeof(uint64_t)));
+  ASSERT_EQ(Value::fromRawTransportValue(read), value);
+  fclose(file);
+}
+
+const uint32_t LWE_DIMENSION = 32;
+
+/// Returns the infos of a keyset made of a single small secret key.
+Message<concreteprotocol::KeysetInfo> makeKeysetInfo() {
+  auto output = Message<concreteprotocol::KeysetInfo>();
+  auto secretKey = output.asBuilder().initLweSecretKeys(1)[0];
+  secretKey.setId(0);
+  auto params = secretKey.initParams();
+  params.setIntegerPrecision(64);
+  params.setLweDimension(LWE_DIMENSION);
+  params.setKeyType(concreteprotocol::KeyType::BINARY);
+  return output;
+}
+
+/// Returns the infos of an input gate of `length` 3 bits integers, encrypted
+/// under the key of `makeKeysetInfo`.
+Message<concreteprotocol::GateInfo> makeCiphertextGateInfo(uint32_t length) {
+  auto output = Message<concreteprotocol::GateInfo>();
+  auto rawInfo = output.asBuilder().initRawInfo();
+  auto rawDimensions = rawInfo.initShape().initDimensions(2);
+  rawDimensions.set(0, length);
+  rawDimensions.set(1, LWE_DIMENSION + 1);
+  rawInfo.setIntegerPrecision(64);
+  rawInfo.setIsSigned(false);
+
+  auto type = output.asBuilder().initTypeInfo().initLweCiphertext();
+  type.initAbstractShape().initDimensions(1).set(0, length);
+  type.setConcreteShape(rawInfo.getShape());
+  type.setIntegerPrecision(64);
+  auto encryption = type.initEncryption();
+  encryption.setKeyId(0);
+  encryption.setVariance(1e-10);
+  encryption.setLweDimension(LWE_DIMENSION);
+  encryption.initModulus().initMod().initNative();
+  type.setCompression(concreteprotocol::Compression::NONE);
+  auto encoding = type.initEncoding().initInteger();
+  encoding.setWidth(3);
+  encoding.setIsSigned(false);
+  encoding.initMode().initNative();
+  return output;
+}
+
+TEST(ValueStream, stream_encrypted_inputs_to_arguments) {
+  auto file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  // The ciphertexts are encrypted and written in several batches.
+  const uint32_t length = 40000;
+  auto gateInfo = makeCiphertextGateInfo(length);
+  ASSERT_ASSIGN_OUTCOME_VALUE(keyset,
+                              Keyset::generate(makeKeysetInfo(), 0x1, 0x2));
+  std::vector<uint64_t> values(length);
+  for (size_t i = 0; i < length; i++) {
+    values[i] = i % 8;
+  }
+  auto input = Value{Tensor<uint64_t>(values, {length})};
+
+  // Both transformers encrypt the same ciphertexts from the same seed.
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      transformer, TransformerFactory::getLweCiphertextInputTransformer(
+                       keyset.client, gateInfo,
+                       std::make_shared<EncryptionCSPRNG>(0x3), false));
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      streamTransformer,
+      TransformerFactory::getLweCiphertextInputStreamTransformer(
+          keyset.client, gateInfo, std::make_shared<EncryptionCSPRNG>(0x3),
+          false));
+  ASSERT_ASSIGN_OUTCOME_VALUE(expected, transformer(input));
+  ASSERT_OUTCOME_HAS_VALUE(streamTransformer(input, fileno(file)));
+
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ASSERT_ASSIGN_OUTCOME_VALUE(read, readValueFromFd(fileno(file)));
+  ASSERT_EQ(Value::fromRawTransportValue(read),
+            Value::fromRawTransportValue(expected));
+  ASSERT_TRUE((capnp::AnyStruct::Reader)read.asReader().getTypeInfo() ==
+              (capnp::AnyStruct::Reader)expected.asReader().getTypeInfo());
+
+  // The server reads the stream back as an argument.
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      argTransformer,
+      TransformerFactory::getLweCiphertextArgTransformer(gateInfo, false));
+  ASSERT_ASSIGN_OUTCOME_VALUE(
+      argStreamTransformer,
+      TransformerFactory::getArgStreamTransformer(argTransformer));
+  ASSERT_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  ASSERT_ASSIGN_OUTCOME_VALUE(arg, argStreamTransformer(fileno(file)));
+  ASSERT_ASSIGN_OUTCOME_VALUE(expectedArg, argTransformer(expected));
+  ASSERT_EQ(arg, expectedArg);
+  fclose(file);
+}
+
+} // namespace
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "concretelang/Runtime/huge_pages.h"
+
+namespace {
+namespace huge_pages = mlir::concretelang::huge_pages;
+using huge_pages::HUGE_PAGE_SIZE;
+using huge_pages::Pages;
+
+const Pages ALL_PAGES[] = {Pages::DEFAULT, Pages::TRANSPARENT,
+                           Pages::HUGETLB_2MB, Pages::HUGETLB_1GB};
+
+/// Enables the huge pages before their first use, which reads the variable
+/// once.
+class HugePagesEnvironment : public ::testing::Environment {
+public:
+  void SetUp() override { setenv("CONCRETE_HUGE_PAGES", "1", 1); }
+};
+
+const auto *environment =
+    ::testing::AddGlobalTestEnvironment(new HugePagesEnvironment());
+
+/// Returns the number of free pages of `pageSize` kB in the hugetlb pool.
+size_t freeHugetlbPages(size_t pageSize) {
+  std::ifstream file("/sys/kernel/mm/hugepages/hugepages-" +
+                     std::to_string(pageSize) + "kB/free_hugepages");
+  size_t pages = 0;
+  file >> pages;
+  return pages;
+}
+
+std::vector<size_t> mappedSizes() {
+  std::vector<size_t> sizes;
+  for (auto pages : ALL_PAGES)
+    sizes.push_back(huge_pages::mapped_size(pages));
+  return sizes;
+}
+
+TEST(HugePages, enabled) { ASSERT_TRUE(huge_pages::enabled()); }
+
+TEST(HugePages, allocate_and_deallocate_update_the_mapped_sizes) {
+  for (size_t size : {(size_t)1, HUGE_PAGE_SIZE - 1, HUGE_PAGE_SIZE,
+                      3 * HUGE_PAGE_SIZE + 1}) {
+    auto before = mappedSizes();
+    auto ptr = (uint8_t *)huge_pages::allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    auto pages = huge_pages::pages_of(ptr);
+    auto mapped = huge_pages::mapped_size_of(ptr);
+    ASSERT_GE(mapped, size);
+
+    // Only the size mapped on the pages of the allocation changes.
+    auto during = mappedSizes();
+    for (size_t i = 0; i < during.size(); i++) {
+      size_t expected = before[i] + (ALL_PAGES[i] == pages ? mapped : 0);
+      ASSERT_EQ(during[i], expected) << huge_pages::name(ALL_PAGES[i]);
+    }
+
+    // The memory is zeroed and writable.
+    ASSERT_EQ(ptr[0], 0);
+    ASSERT_EQ(ptr[size - 1], 0);
+    ptr[0] = ptr[size - 1] = 1;
+
+    huge_pages::deallocate(ptr);
+    ASSERT_EQ(mappedSizes(), before);
+    ASSERT_EQ(huge_pages::mapped_size_of(ptr), 0u);
+  }
+}
+
+TEST(HugePages, mapped_size_is_rounded_to_the_pages) {
+  auto ptr = huge_pages::allocate(HUGE_PAGE_SIZE + 1);
+  ASSERT_NE(ptr, nullptr);
+  auto mapped = huge_pages::mapped_size_of(ptr);
+  switch (huge_pages::pages_of(ptr)) {
+  case Pages::DEFAULT:
+    ASSERT_GE(mapped, HUGE_PAGE_SIZE + 1);
+    break;
+  case Pages::TRANSPARENT:
+  case Pages::HUGETLB_2MB:
+    ASSERT_EQ(mapped, 2 * HUGE_PAGE_SIZE);
+    break;
+  case Pages::HUGETLB_1GB:
+    FAIL() << "1GB pages are only used from 1GB";
+  }
+  huge_pages::deallocate(ptr);
+}
+
+TEST(HugePages, falls_back_without_hugetlb_pages) {
+  if (freeHugetlbPages(2048) > 0 || freeHugetlbPages(1 << 20) > 0) {
+    GTEST_SKIP() << "the hugetlb pool has free pages";
+  }
+  auto ptr = huge_pages::allocate(HUGE_PAGE_SIZE);
+  ASSERT_NE(ptr, nullptr);
+  auto pages = huge_pages::pages_of(ptr);
+  ASSERT_TRUE(pages == Pages::TRANSPARENT || pages == Pages::DEFAULT)
+      << huge_pages::name(pages);
+  huge_pages::deallocate(ptr);
+}
+
+TEST(HugePages, uses_the_hugetlb_pages) {
+  if (freeHugetlbPages(2048) == 0) {
+    GTEST_SKIP() << "the hugetlb pool has no free 2MB pages";
+  }
+  auto ptr = huge_pages::allocate(HUGE_PAGE_SIZE);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(huge_pages::pages_of(ptr), Pages::HUGETLB_2MB);
+  huge_pages::deallocate(ptr);
+}
+
+TEST(HugePages, ignores_memory_not_allocated) {
+  auto before = mappedSizes();
+  int local = 0;
+  ASSERT_EQ(huge_pages::pages_of(&local), Pages::DEFAULT);
+  ASSERT_EQ(huge_pages::mapped_size_of(&local), 0u);
+  huge_pages::deallocate(&local);
+  huge_pages::deallocate(nullptr);
+  ASSERT_EQ(mappedSizes(), before);
+}
+
+TEST(HugePages, allocator_maps_large_allocations) {
+  auto before = mappedSizes();
+  std::vector<uint64_t, huge_pages::Allocator<uint64_t>> small(16);
+  ASSERT_EQ(huge_pages::mapped_size_of(small.data()), 0u);
+  ASSERT_EQ(mappedSizes(), before);
+
+  std::vector<uint64_t, huge_pages::Allocator<uint64_t>> large(
+      HUGE_PAGE_SIZE / sizeof(uint64_t));
+  ASSERT_GE(huge_pages::mapped_size_of(large.data()), HUGE_PAGE_SIZE);
+  large.clear();
+  large.shrink_to_fit();
+  ASSERT_EQ(mappedSizes(), before);
+}
+
+} // namespace
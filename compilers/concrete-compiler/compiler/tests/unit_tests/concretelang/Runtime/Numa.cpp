@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include "concretelang/Runtime/huge_pages.h"
+#include "concretelang/Runtime/numa.h"
+
+namespace {
+namespace numa = mlir::concretelang::numa;
+using mlir::concretelang::huge_pages::HUGE_PAGE_SIZE;
+
+TEST(Numa, allocate_on_node_binds_the_memory_to_the_node) {
+  for (size_t node = 0; node < numa::num_nodes(); node++) {
+    auto ptr = (uint8_t *)numa::allocate_on_node(HUGE_PAGE_SIZE, node);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(numa::node_of_area(ptr, HUGE_PAGE_SIZE), (int)node);
+    numa::free_on_node(ptr);
+  }
+}
+
+TEST(Numa, allocate_on_node_rejects_unknown_nodes) {
+  ASSERT_EQ(numa::allocate_on_node(HUGE_PAGE_SIZE, numa::num_nodes()),
+            nullptr);
+}
+
+} // namespace
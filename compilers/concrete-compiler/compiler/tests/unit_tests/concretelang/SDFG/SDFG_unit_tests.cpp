@@ -25,8 +25,8 @@ Result<TestProgram> setupTestProgram(std::string source,
   mlir::concretelang::CompilationOptions options;
 #ifdef CONCRETELANG_CUDA_SUPPORT
   options.emitGPUOps = true;
-  options.emitSDFGOps = true;
 #endif
+  options.emitSDFGOps = true;
   options.batchTFHEOps = true;
   TestProgram testCircuit(options);
   OUTCOME_TRYV(testCircuit.compile({source}));
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "concretelang/Common/Values.h"
+#include "concretelang/ServerLib/MemRefDescriptor.h"
+
+namespace {
+using concretelang::serverlib::MemRefDescriptor;
+using concretelang::values::Tensor;
+
+std::vector<uint64_t> iota(size_t length) {
+  std::vector<uint64_t> values(length);
+  std::iota(values.begin(), values.end(), 0);
+  return values;
+}
+
+MemRefDescriptor makeDescriptor(std::vector<uint64_t> &buffer, size_t offset,
+                                std::vector<size_t> sizes,
+                                std::vector<size_t> strides) {
+  return MemRefDescriptor{64,     false, buffer.data(), buffer.data(),
+                          offset, sizes, strides};
+}
+
+TEST(MemRefDescriptor, into_tensor_contiguous) {
+  auto buffer = iota(24);
+  auto descriptor = makeDescriptor(buffer, 0, {2, 3, 4}, {12, 4, 1});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_EQ(tensor, Tensor<uint64_t>(buffer, {2, 3, 4}));
+}
+
+TEST(MemRefDescriptor, into_tensor_contiguous_default_strides) {
+  auto buffer = iota(6);
+  auto descriptor = makeDescriptor(buffer, 0, {2, 3}, {0, 0});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_EQ(tensor, Tensor<uint64_t>(buffer, {2, 3}));
+}
+
+TEST(MemRefDescriptor, into_tensor_round_trip) {
+  auto input = Tensor<uint64_t>(iota(12), {3, 4});
+  auto descriptor = MemRefDescriptor::fromTensor(input);
+  ASSERT_EQ(descriptor.intoTensor<uint64_t>(), input);
+}
+
+TEST(MemRefDescriptor, into_tensor_transposed) {
+  // A 2x3 row-major buffer viewed as its 3x2 transpose.
+  auto buffer = iota(6);
+  auto descriptor = makeDescriptor(buffer, 0, {3, 2}, {1, 3});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_EQ(tensor, Tensor<uint64_t>({0, 3, 1, 4, 2, 5}, {3, 2}));
+}
+
+TEST(MemRefDescriptor, into_tensor_slice) {
+  // The 2x2 block starting at (1, 1) of a 4x4 row-major buffer.
+  auto buffer = iota(16);
+  auto descriptor = makeDescriptor(buffer, 5, {2, 2}, {4, 1});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_EQ(tensor, Tensor<uint64_t>({5, 6, 9, 10}, {2, 2}));
+}
+
+TEST(MemRefDescriptor, into_tensor_slice_with_inner_contiguous_dims) {
+  // Every other 2x3 plane of a 4x2x3 row-major buffer, starting at the
+  // second one: the inner planes are copied as blocks.
+  auto buffer = iota(24);
+  auto descriptor = makeDescriptor(buffer, 6, {2, 2, 3}, {12, 3, 1});
+  auto expected =
+      Tensor<uint64_t>({6, 7, 8, 9, 10, 11, 18, 19, 20, 21, 22, 23}, {2, 2, 3});
+  ASSERT_EQ(descriptor.intoTensor<uint64_t>(), expected);
+}
+
+TEST(MemRefDescriptor, into_tensor_unit_dims) {
+  // Unit dimensions do not break the contiguity of a block, whatever their
+  // stride.
+  auto buffer = iota(8);
+  auto descriptor = makeDescriptor(buffer, 2, {1, 3, 1}, {42, 1, 7});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_EQ(tensor, Tensor<uint64_t>({2, 3, 4}, {1, 3, 1}));
+}
+
+TEST(MemRefDescriptor, into_tensor_empty) {
+  std::vector<uint64_t> buffer;
+  auto descriptor = makeDescriptor(buffer, 0, {0, 3}, {3, 1});
+  auto tensor = descriptor.intoTensor<uint64_t>();
+  ASSERT_TRUE(tensor.values.empty());
+  ASSERT_EQ(tensor.dimensions, (std::vector<size_t>{0, 3}));
+}
+
+
+TEST(MemRefDescriptor, contiguity) {
+  auto buffer = iota(24);
+  ASSERT_TRUE(makeDescriptor(buffer, 0, {2, 3, 4}, {12, 4, 1}).isContiguous());
+  ASSERT_TRUE(makeDescriptor(buffer, 2, {1, 3, 1}, {42, 1, 7}).isContiguous());
+  ASSERT_FALSE(makeDescriptor(buffer, 0, {3, 2}, {1, 3}).isContiguous());
+  ASSERT_FALSE(makeDescriptor(buffer, 5, {2, 2}, {4, 1}).isContiguous());
+}
+
+TEST(MemRefDescriptor, into_tensor_adopts_the_buffer) {
+  auto buffer = new uint64_t[8];
+  std::iota(buffer, buffer + 8, 0);
+  MemRefDescriptor descriptor{64, false, buffer, buffer, 2, {2, 3}, {3, 1}};
+  size_t releases = 0;
+  {
+    auto tensor = descriptor.intoTensor<uint64_t>([&]() {
+      releases++;
+      delete[] buffer;
+    });
+    // The tensor holds the values of the buffer, without copying them.
+    ASSERT_EQ(tensor.values.data(), buffer + 2);
+    ASSERT_EQ(tensor, Tensor<uint64_t>({2, 3, 4, 5, 6, 7}, {2, 3}));
+
+    // The copies allocate their own values, and the moves keep the buffer.
+    auto copy = tensor;
+    ASSERT_NE(copy.values.data(), buffer + 2);
+    ASSERT_EQ(copy, tensor);
+    auto moved = std::move(tensor);
+    ASSERT_EQ(moved.values.data(), buffer + 2);
+    ASSERT_EQ(releases, 0u);
+
+    // The buffer is released once the values outgrow it.
+    moved.values.push_back(8);
+    ASSERT_EQ(releases, 1u);
+    ASSERT_EQ(moved.values, (std::vector<uint64_t>{2, 3, 4, 5, 6, 7, 8}));
+  }
+  ASSERT_EQ(releases, 1u);
+}
+
+TEST(MemRefDescriptor, into_tensor_releases_the_adopted_buffer_once) {
+  auto buffer = new uint64_t[6];
+  MemRefDescriptor descriptor{64, false, buffer, buffer, 0, {2, 3}, {3, 1}};
+  size_t releases = 0;
+  {
+    auto tensor = descriptor.intoTensor<uint64_t>([&]() {
+      releases++;
+      delete[] buffer;
+    });
+    Tensor<uint64_t> other;
+    other = std::move(tensor);
+    ASSERT_EQ(releases, 0u);
+  }
+  ASSERT_EQ(releases, 1u);
+}
+
+TEST(MemRefDescriptor, into_tensor_releases_an_empty_buffer) {
+  auto buffer = new uint64_t[1];
+  MemRefDescriptor descriptor{64, false, buffer, buffer, 0, {0, 3}, {3, 1}};
+  size_t releases = 0;
+  auto tensor = descriptor.intoTensor<uint64_t>([&]() {
+    releases++;
+    delete[] buffer;
+  });
+  ASSERT_TRUE(tensor.values.empty());
+  ASSERT_EQ(releases, 1u);
+}
+
+} // namespace
@@ -1,4 +1,8 @@
+use std::sync::Arc;
+
+use concrete_optimizer::computing_cost::complexity_model::ComplexityModel;
 use concrete_optimizer::computing_cost::cpu::CpuComplexity;
+use concrete_optimizer::computing_cost::cpu_profile::{CostFactors, CpuProfile};
 use concrete_optimizer::config;
 use concrete_optimizer::config::ProcessingUnit;
 use concrete_optimizer::dag::operator::{
@@ -13,7 +17,10 @@ use concrete_optimizer::optimization::dag::solo_key::optimize_generic::{
     Encoding, Solution as DagSolution,
 };
 use concrete_optimizer::optimization::decomposition;
-use concrete_optimizer::parameters::{BrDecompositionParameters, KsDecompositionParameters};
+use concrete_optimizer::parameters::{
+    BrDecompositionParameters, GlweParameters, KeyswitchParameters, KsDecompositionParameters,
+    LweDimension, PbsParameters,
+};
 use concrete_optimizer::utils::cache::persistent::default_cache_dir;
 
 fn no_solution() -> ffi::Solution {
@@ -30,8 +37,39 @@ fn no_dag_solution() -> ffi::DagSolution {
     }
 }
 
+fn cpu_complexity(options: ffi::Options) -> CpuComplexity {
+    let factors = options.cpu_cost_factors;
+    CpuComplexity {
+        factors: CostFactors {
+            ks: factors.ks,
+            pbs: factors.pbs,
+            levelled: factors.levelled,
+        },
+        ..CpuComplexity::default()
+    }
+}
+
+// Sets the factors fitted on the cost profile of the machine, and returns an error message which
+// is empty on success
+fn read_cpu_cost_factors(profile_path: &str, factors: &mut ffi::CpuCostFactors) -> String {
+    match CpuProfile::read(profile_path).and_then(|profile| CpuComplexity::calibrated(&profile)) {
+        Ok(complexity) => {
+            *factors = ffi::CpuCostFactors {
+                ks: complexity.factors.ks,
+                pbs: complexity.factors.pbs,
+                levelled: complexity.factors.levelled,
+            };
+            String::new()
+        }
+        Err(err) => err,
+    }
+}
+
 fn caches_from(options: ffi::Options) -> decomposition::PersistDecompCaches {
-    if !options.cache_on_disk {
+    let complexity_model = cpu_complexity(options);
+    // The caches on disk hold the costs of the default model
+    let cache_on_disk = options.cache_on_disk && complexity_model.factors == CostFactors::default();
+    if !cache_on_disk {
         println!("optimizer: Using stateless cache.");
         let cache_dir = default_cache_dir();
         println!("optimizer: To clear the cache, remove directory {cache_dir}");
@@ -40,8 +78,8 @@ fn caches_from(options: ffi::Options) -> decomposition::PersistDecompCaches {
     decomposition::cache(
         options.security_level,
         processing_unit,
-        Some(ProcessingUnit::Cpu.complexity_model()),
-        options.cache_on_disk,
+        Some(Arc::new(complexity_model)),
+        cache_on_disk,
         options.ciphertext_modulus_log,
         options.fft_precision,
     )
@@ -51,13 +89,14 @@ fn optimize_bootstrap(precision: u64, noise_factor: f64, options: ffi::Options)
     // Support composable since there is no dag
     let processing_unit = processing_unit(options);
 
+    let complexity_model = cpu_complexity(options);
     let config = Config {
         security_level: options.security_level,
         maximum_acceptable_error_probability: options.maximum_acceptable_error_probability,
         key_sharing: options.key_sharing,
         ciphertext_modulus_log: options.ciphertext_modulus_log,
         fft_precision: options.fft_precision,
-        complexity_model: &CpuComplexity::default(),
+        complexity_model: &complexity_model,
         composable: options.composable,
     };
 
@@ -82,6 +121,55 @@ fn convert_to_dag_solution(sol: &ffi::Solution) -> ffi::DagSolution {
     sol.into()
 }
 
+// The decomposition base has no impact on the complexities
+const IGNORED_LOG2_BASE: u64 = 0;
+
+fn keyswitch_complexity(
+    input_lwe_dimension: u64,
+    output_lwe_dimension: u64,
+    level: u64,
+    options: ffi::Options,
+) -> f64 {
+    let params = KeyswitchParameters {
+        input_lwe_dimension: LweDimension(input_lwe_dimension),
+        output_lwe_dimension: LweDimension(output_lwe_dimension),
+        ks_decomposition_parameter: KsDecompositionParameters {
+            level,
+            log2_base: IGNORED_LOG2_BASE,
+        },
+    };
+    cpu_complexity(options).ks_complexity(params, options.ciphertext_modulus_log)
+}
+
+fn bootstrap_complexity(
+    internal_lwe_dimension: u64,
+    glwe_dimension: u64,
+    polynomial_size: u64,
+    level: u64,
+    options: ffi::Options,
+) -> f64 {
+    let params = PbsParameters {
+        internal_lwe_dimension: LweDimension(internal_lwe_dimension),
+        br_decomposition_parameter: BrDecompositionParameters {
+            level,
+            log2_base: IGNORED_LOG2_BASE,
+        },
+        output_glwe_params: GlweParameters {
+            log2_polynomial_size: u64::from(polynomial_size.ilog2()),
+            glwe_dimension,
+        },
+    };
+    cpu_complexity(options).pbs_complexity(params, options.ciphertext_modulus_log)
+}
+
+fn levelled_complexity(lwe_dimension: u64, options: ffi::Options) -> f64 {
+    cpu_complexity(options).levelled_complexity(
+        1,
+        LweDimension(lwe_dimension),
+        options.ciphertext_modulus_log,
+    )
+}
+
 impl From<&ffi::Solution> for ffi::DagSolution {
     fn from(sol: &ffi::Solution) -> Self {
         Self {
@@ -555,13 +643,14 @@ impl OperationDag {
 
     fn optimize(&self, options: ffi::Options) -> ffi::DagSolution {
         let processing_unit = processing_unit(options);
+        let complexity_model = cpu_complexity(options);
         let config = Config {
             security_level: options.security_level,
             maximum_acceptable_error_probability: options.maximum_acceptable_error_probability,
             key_sharing: options.key_sharing,
             ciphertext_modulus_log: options.ciphertext_modulus_log,
             fft_precision: options.fft_precision,
-            complexity_model: &CpuComplexity::default(),
+            complexity_model: &complexity_model,
             composable: options.composable,
         };
 
@@ -607,15 +696,20 @@ impl OperationDag {
         self.0.tag_operator_as_output(op.into());
     }
 
+    fn tag_operator_as_shrunk_output(&mut self, op: ffi::OperatorIndex) {
+        self.0.tag_operator_as_shrunk_output(op.into());
+    }
+
     fn optimize_multi(&self, options: ffi::Options) -> ffi::CircuitSolution {
         let processing_unit = processing_unit(options);
+        let complexity_model = cpu_complexity(options);
         let config = Config {
             security_level: options.security_level,
             maximum_acceptable_error_probability: options.maximum_acceptable_error_probability,
             key_sharing: options.key_sharing,
             ciphertext_modulus_log: options.ciphertext_modulus_log,
             fft_precision: options.fft_precision,
-            complexity_model: &CpuComplexity::default(),
+            complexity_model: &complexity_model,
             composable: options.composable,
         };
         let search_space = SearchSpace::default(processing_unit);
@@ -695,6 +789,29 @@ mod ffi {
             dag: &OperationDag,
         ) -> CircuitSolution;
 
+        #[namespace = "concrete_optimizer::utils"]
+        fn keyswitch_complexity(
+            input_lwe_dimension: u64,
+            output_lwe_dimension: u64,
+            level: u64,
+            options: Options,
+        ) -> f64;
+
+        #[namespace = "concrete_optimizer::utils"]
+        fn bootstrap_complexity(
+            internal_lwe_dimension: u64,
+            glwe_dimension: u64,
+            polynomial_size: u64,
+            level: u64,
+            options: Options,
+        ) -> f64;
+
+        #[namespace = "concrete_optimizer::utils"]
+        fn levelled_complexity(lwe_dimension: u64, options: Options) -> f64;
+
+        #[namespace = "concrete_optimizer::utils"]
+        fn read_cpu_cost_factors(profile_path: &str, factors: &mut CpuCostFactors) -> String;
+
         type OperationDag;
 
         #[namespace = "concrete_optimizer::dag"]
@@ -763,6 +880,8 @@ mod ffi {
 
         fn tag_operator_as_output(self: &mut OperationDag, op: OperatorIndex);
 
+        fn tag_operator_as_shrunk_output(self: &mut OperationDag, op: OperatorIndex);
+
         fn optimize_multi(self: &OperationDag, options: Options) -> CircuitSolution;
 
         fn NO_KEY_ID() -> u64;
@@ -828,6 +947,15 @@ mod ffi {
         ByPrecisionAndNorm2,
     }
 
+    // Factors applied to the analytic cpu costs, see CpuProfile
+    #[namespace = "concrete_optimizer"]
+    #[derive(Debug, Clone, Copy)]
+    pub struct CpuCostFactors {
+        pub ks: f64,
+        pub pbs: f64,
+        pub levelled: f64,
+    }
+
     #[namespace = "concrete_optimizer"]
     #[derive(Debug, Clone, Copy)]
     pub struct Options {
@@ -842,6 +970,7 @@ mod ffi {
         pub ciphertext_modulus_log: u32,
         pub fft_precision: u32,
         pub composable: bool,
+        pub cpu_cost_factors: CpuCostFactors,
     }
 
     #[namespace = "concrete_optimizer::dag"]
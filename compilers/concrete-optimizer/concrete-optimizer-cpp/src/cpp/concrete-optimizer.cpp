@@ -945,6 +945,7 @@ namespace concrete_optimizer {
   struct Weights;
   enum class Encoding : ::std::uint8_t;
   enum class MultiParamStrategy : ::std::uint8_t;
+  struct CpuCostFactors;
   struct Options;
   namespace dag {
     struct OperatorIndex;
@@ -978,6 +979,7 @@ struct OperationDag final : public ::rust::Opaque {
   ::rust::String dump() const noexcept;
   void concat(::concrete_optimizer::OperationDag const &other) noexcept;
   void tag_operator_as_output(::concrete_optimizer::dag::OperatorIndex op) noexcept;
+  void tag_operator_as_shrunk_output(::concrete_optimizer::dag::OperatorIndex op) noexcept;
   ::concrete_optimizer::dag::CircuitSolution optimize_multi(::concrete_optimizer::Options options) const noexcept;
   ~OperationDag() = delete;
 
@@ -1081,6 +1083,17 @@ enum class MultiParamStrategy : ::std::uint8_t {
 };
 #endif // CXXBRIDGE1_ENUM_concrete_optimizer$MultiParamStrategy
 
+#ifndef CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+#define CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+struct CpuCostFactors final {
+  double ks;
+  double pbs;
+  double levelled;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+
 #ifndef CXXBRIDGE1_STRUCT_concrete_optimizer$Options
 #define CXXBRIDGE1_STRUCT_concrete_optimizer$Options
 struct Options final {
@@ -1095,6 +1108,7 @@ struct Options final {
   ::std::uint32_t ciphertext_modulus_log;
   ::std::uint32_t fft_precision;
   bool composable;
+  ::concrete_optimizer::CpuCostFactors cpu_cost_factors;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -1260,6 +1274,14 @@ extern "C" {
 void concrete_optimizer$utils$cxxbridge1$convert_to_dag_solution(::concrete_optimizer::v0::Solution const &solution, ::concrete_optimizer::dag::DagSolution *return$) noexcept;
 
 void concrete_optimizer$utils$cxxbridge1$convert_to_circuit_solution(::concrete_optimizer::dag::DagSolution const &solution, ::concrete_optimizer::OperationDag const &dag, ::concrete_optimizer::dag::CircuitSolution *return$) noexcept;
+
+double concrete_optimizer$utils$cxxbridge1$keyswitch_complexity(::std::uint64_t input_lwe_dimension, ::std::uint64_t output_lwe_dimension, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept;
+
+double concrete_optimizer$utils$cxxbridge1$bootstrap_complexity(::std::uint64_t internal_lwe_dimension, ::std::uint64_t glwe_dimension, ::std::uint64_t polynomial_size, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept;
+
+double concrete_optimizer$utils$cxxbridge1$levelled_complexity(::std::uint64_t lwe_dimension, ::concrete_optimizer::Options options) noexcept;
+
+void concrete_optimizer$utils$cxxbridge1$read_cpu_cost_factors(::rust::Str profile_path, ::concrete_optimizer::CpuCostFactors &factors, ::rust::String *return$) noexcept;
 } // extern "C"
 } // namespace utils
 
@@ -1318,6 +1340,8 @@ extern "C" {
 extern "C" {
 void concrete_optimizer$cxxbridge1$OperationDag$tag_operator_as_output(::concrete_optimizer::OperationDag &self, ::concrete_optimizer::dag::OperatorIndex op) noexcept;
 
+void concrete_optimizer$cxxbridge1$OperationDag$tag_operator_as_shrunk_output(::concrete_optimizer::OperationDag &self, ::concrete_optimizer::dag::OperatorIndex op) noexcept;
+
 void concrete_optimizer$cxxbridge1$OperationDag$optimize_multi(::concrete_optimizer::OperationDag const &self, ::concrete_optimizer::Options options, ::concrete_optimizer::dag::CircuitSolution *return$) noexcept;
 
 ::std::uint64_t concrete_optimizer$cxxbridge1$NO_KEY_ID() noexcept;
@@ -1341,6 +1365,24 @@ namespace utils {
   concrete_optimizer$utils$cxxbridge1$convert_to_circuit_solution(solution, dag, &return$.value);
   return ::std::move(return$.value);
 }
+
+double keyswitch_complexity(::std::uint64_t input_lwe_dimension, ::std::uint64_t output_lwe_dimension, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept {
+  return concrete_optimizer$utils$cxxbridge1$keyswitch_complexity(input_lwe_dimension, output_lwe_dimension, level, options);
+}
+
+double bootstrap_complexity(::std::uint64_t internal_lwe_dimension, ::std::uint64_t glwe_dimension, ::std::uint64_t polynomial_size, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept {
+  return concrete_optimizer$utils$cxxbridge1$bootstrap_complexity(internal_lwe_dimension, glwe_dimension, polynomial_size, level, options);
+}
+
+double levelled_complexity(::std::uint64_t lwe_dimension, ::concrete_optimizer::Options options) noexcept {
+  return concrete_optimizer$utils$cxxbridge1$levelled_complexity(lwe_dimension, options);
+}
+
+::rust::String read_cpu_cost_factors(::rust::Str profile_path, ::concrete_optimizer::CpuCostFactors &factors) noexcept {
+  ::rust::MaybeUninit<::rust::String> return$;
+  concrete_optimizer$utils$cxxbridge1$read_cpu_cost_factors(profile_path, factors, &return$.value);
+  return ::std::move(return$.value);
+}
 } // namespace utils
 
 ::std::size_t OperationDag::layout::size() noexcept {
@@ -1433,6 +1475,10 @@ void OperationDag::tag_operator_as_output(::concrete_optimizer::dag::OperatorInd
   concrete_optimizer$cxxbridge1$OperationDag$tag_operator_as_output(*this, op);
 }
 
+void OperationDag::tag_operator_as_shrunk_output(::concrete_optimizer::dag::OperatorIndex op) noexcept {
+  concrete_optimizer$cxxbridge1$OperationDag$tag_operator_as_shrunk_output(*this, op);
+}
+
 ::concrete_optimizer::dag::CircuitSolution OperationDag::optimize_multi(::concrete_optimizer::Options options) const noexcept {
   ::rust::MaybeUninit<::concrete_optimizer::dag::CircuitSolution> return$;
   concrete_optimizer$cxxbridge1$OperationDag$optimize_multi(*this, options, &return$.value);
@@ -926,6 +926,7 @@ namespace concrete_optimizer {
   struct Weights;
   enum class Encoding : ::std::uint8_t;
   enum class MultiParamStrategy : ::std::uint8_t;
+  struct CpuCostFactors;
   struct Options;
   namespace dag {
     struct OperatorIndex;
@@ -959,6 +960,7 @@ struct OperationDag final : public ::rust::Opaque {
   ::rust::String dump() const noexcept;
   void concat(::concrete_optimizer::OperationDag const &other) noexcept;
   void tag_operator_as_output(::concrete_optimizer::dag::OperatorIndex op) noexcept;
+  void tag_operator_as_shrunk_output(::concrete_optimizer::dag::OperatorIndex op) noexcept;
   ::concrete_optimizer::dag::CircuitSolution optimize_multi(::concrete_optimizer::Options options) const noexcept;
   ~OperationDag() = delete;
 
@@ -1062,6 +1064,17 @@ enum class MultiParamStrategy : ::std::uint8_t {
 };
 #endif // CXXBRIDGE1_ENUM_concrete_optimizer$MultiParamStrategy
 
+#ifndef CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+#define CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+struct CpuCostFactors final {
+  double ks;
+  double pbs;
+  double levelled;
+
+  using IsRelocatable = ::std::true_type;
+};
+#endif // CXXBRIDGE1_STRUCT_concrete_optimizer$CpuCostFactors
+
 #ifndef CXXBRIDGE1_STRUCT_concrete_optimizer$Options
 #define CXXBRIDGE1_STRUCT_concrete_optimizer$Options
 struct Options final {
@@ -1076,6 +1089,7 @@ struct Options final {
   ::std::uint32_t ciphertext_modulus_log;
   ::std::uint32_t fft_precision;
   bool composable;
+  ::concrete_optimizer::CpuCostFactors cpu_cost_factors;
 
   using IsRelocatable = ::std::true_type;
 };
@@ -1238,6 +1252,14 @@ namespace utils {
 ::concrete_optimizer::dag::DagSolution convert_to_dag_solution(::concrete_optimizer::v0::Solution const &solution) noexcept;
 
 ::concrete_optimizer::dag::CircuitSolution convert_to_circuit_solution(::concrete_optimizer::dag::DagSolution const &solution, ::concrete_optimizer::OperationDag const &dag) noexcept;
+
+double keyswitch_complexity(::std::uint64_t input_lwe_dimension, ::std::uint64_t output_lwe_dimension, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept;
+
+double bootstrap_complexity(::std::uint64_t internal_lwe_dimension, ::std::uint64_t glwe_dimension, ::std::uint64_t polynomial_size, ::std::uint64_t level, ::concrete_optimizer::Options options) noexcept;
+
+double levelled_complexity(::std::uint64_t lwe_dimension, ::concrete_optimizer::Options options) noexcept;
+
+::rust::String read_cpu_cost_factors(::rust::Str profile_path, ::concrete_optimizer::CpuCostFactors &factors) noexcept;
 } // namespace utils
 
 namespace dag {
@@ -0,0 +1,80 @@
+use concrete_optimizer::computing_cost::cpu::CpuComplexity;
+use concrete_optimizer::config::ProcessingUnit;
+use concrete_optimizer::dag::operator::{FunctionTable, Shape};
+use concrete_optimizer::dag::unparametrized::OperationDag;
+use concrete_optimizer::optimization::config::{Config, SearchSpace};
+use concrete_optimizer::optimization::dag::multi_parameters::optimize::optimize as optimize_multi;
+use concrete_optimizer::optimization::dag::multi_parameters::partition_cut::PartitionCut;
+use concrete_optimizer::optimization::dag::solo_key::optimize::{optimize, v0_dag};
+use concrete_optimizer::optimization::decomposition;
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+
+const _4_SIGMA: f64 = 0.000_063_342_483_999_973;
+const CIPHERTEXT_MODULUS_LOG: u32 = 64;
+const FFT_PRECISION: u32 = 53;
+
+fn config(complexity_model: &CpuComplexity) -> Config<'_> {
+    Config {
+        security_level: 128,
+        maximum_acceptable_error_probability: _4_SIGMA,
+        key_sharing: true,
+        ciphertext_modulus_log: CIPHERTEXT_MODULUS_LOG,
+        fft_precision: FFT_PRECISION,
+        complexity_model,
+        composable: false,
+    }
+}
+
+// A chain of luts with increasing precisions, one partition per precision
+fn lut_chain_dag(min_precision: u8, max_precision: u8) -> OperationDag {
+    let mut dag = OperationDag::new();
+    let mut lut_input = dag.add_input(min_precision, Shape::number());
+    for precision in min_precision..=max_precision {
+        lut_input = dag.add_lut(lut_input, FunctionTable::UNKWOWN, precision);
+    }
+    _ = dag.add_lut(lut_input, FunctionTable::UNKWOWN, min_precision);
+    dag
+}
+
+fn dag_optimization(c: &mut Criterion) {
+    let complexity_model = CpuComplexity::default();
+    let search_space = SearchSpace::default_cpu();
+    let caches = decomposition::cache(
+        128,
+        ProcessingUnit::Cpu,
+        None,
+        true,
+        CIPHERTEXT_MODULUS_LOG,
+        FFT_PRECISION,
+    );
+
+    let dag = v0_dag(4096, 8, 1.0);
+    c.bench_function("v0 dag optimization", |b| {
+        b.iter(|| {
+            black_box(optimize(
+                &dag,
+                config(&complexity_model),
+                &search_space,
+                &caches,
+            ))
+        })
+    });
+
+    let dag = lut_chain_dag(4, 8);
+    let p_cut = Some(PartitionCut::for_each_precision(&dag));
+    c.bench_function("multi partitions dag optimization", |b| {
+        b.iter(|| {
+            black_box(optimize_multi(
+                &dag,
+                config(&complexity_model),
+                &search_space,
+                &caches,
+                &p_cut,
+                0,
+            ))
+        })
+    });
+}
+
+criterion_group!(benches, dag_optimization);
+criterion_main!(benches);
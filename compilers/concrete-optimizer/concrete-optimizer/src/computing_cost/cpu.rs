@@ -1,5 +1,6 @@
 use super::complexity::Complexity;
 use super::complexity_model::ComplexityModel;
+use super::cpu_profile::{CostFactors, CpuProfile};
 use super::operators::keyswitch_lwe::KsComplexity;
 use super::operators::{keyswitch_lwe, multi_bit_pbs, pbs};
 use crate::computing_cost::operators::multi_bit_pbs::MultiBitPbsComplexity;
@@ -10,11 +11,21 @@ pub struct CpuComplexity {
     pub ks_lwe: keyswitch_lwe::KsComplexity,
     pub pbs: pbs::PbsComplexity,
     pub multi_bit_pbs: MultiBitPbsComplexity,
+    pub factors: CostFactors,
+}
+
+impl CpuComplexity {
+    // The analytic costs calibrated with the costs measured on a machine
+    pub fn calibrated(profile: &CpuProfile) -> Result<Self, String> {
+        let default = Self::default();
+        let factors = profile.cost_factors(&default.ks_lwe, &default.pbs)?;
+        Ok(Self { factors, ..default })
+    }
 }
 
 impl ComplexityModel for CpuComplexity {
     fn pbs_complexity(&self, params: PbsParameters, ciphertext_modulus_log: u32) -> Complexity {
-        self.pbs.complexity(params, ciphertext_modulus_log)
+        self.factors.pbs * self.pbs.complexity(params, ciphertext_modulus_log)
     }
     fn multi_bit_pbs_complexity(
         &self,
@@ -23,12 +34,17 @@ impl ComplexityModel for CpuComplexity {
         grouping_factor: u32,
         jit_fft: bool,
     ) -> Complexity {
-        self.multi_bit_pbs
-            .complexity(params, ciphertext_modulus_log, grouping_factor, jit_fft)
+        self.factors.pbs
+            * self.multi_bit_pbs.complexity(
+                params,
+                ciphertext_modulus_log,
+                grouping_factor,
+                jit_fft,
+            )
     }
 
     fn cmux_complexity(&self, params: CmuxParameters, ciphertext_modulus_log: u32) -> Complexity {
-        self.pbs.cmux.complexity(params, ciphertext_modulus_log)
+        self.factors.pbs * self.pbs.cmux.complexity(params, ciphertext_modulus_log)
     }
 
     fn ks_complexity(
@@ -36,13 +52,15 @@ impl ComplexityModel for CpuComplexity {
         params: KeyswitchParameters,
         ciphertext_modulus_log: u32,
     ) -> Complexity {
-        self.ks_lwe.complexity(params, ciphertext_modulus_log)
+        self.factors.ks * self.ks_lwe.complexity(params, ciphertext_modulus_log)
     }
 
     fn fft_complexity(&self, glwe_polynomial_size: f64, ciphertext_modulus_log: u32) -> Complexity {
-        self.pbs
-            .cmux
-            .fft_complexity(glwe_polynomial_size, ciphertext_modulus_log)
+        self.factors.pbs
+            * self
+                .pbs
+                .cmux
+                .fft_complexity(glwe_polynomial_size, ciphertext_modulus_log)
     }
 
     fn levelled_complexity(
@@ -51,7 +69,7 @@ impl ComplexityModel for CpuComplexity {
         lwe_dimension: LweDimension,
         _ciphertext_modulus_log: u32,
     ) -> Complexity {
-        sum_size as f64 * lwe_dimension.0 as f64
+        self.factors.levelled * sum_size as f64 * lwe_dimension.0 as f64
     }
 }
 
@@ -61,6 +79,7 @@ impl Default for CpuComplexity {
             ks_lwe: KsComplexity,
             pbs: pbs::PbsComplexity::default(),
             multi_bit_pbs: multi_bit_pbs::MultiBitPbsComplexity::default(),
+            factors: CostFactors::default(),
         }
     }
 }
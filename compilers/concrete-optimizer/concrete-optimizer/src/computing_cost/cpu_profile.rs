@@ -0,0 +1,266 @@
+// Cost profile of the cpu operations, measured on the deployment machine.
+//
+// The profile is a text file, produced by the calibration example of concrete-cpu, with one
+// measure per line and `#` comments:
+//   ks <input_lwe_dimension> <output_lwe_dimension> <level> <nanoseconds>
+//   pbs <internal_lwe_dimension> <glwe_dimension> <log2_polynomial_size> <level> <nanoseconds>
+//   levelled <lwe_dimension> <nanoseconds>
+// where levelled is the addition of two lwe ciphertexts.
+
+use std::path::Path;
+
+use super::complexity::Complexity;
+use super::operators::keyswitch_lwe::KsComplexity;
+use super::operators::pbs::PbsComplexity;
+use crate::parameters::{
+    BrDecompositionParameters, GlweParameters, KeyswitchParameters, KsDecompositionParameters,
+    LweDimension, PbsParameters,
+};
+
+// The decomposition base has no impact on the costs
+const IGNORED_LOG2_BASE: u64 = 0;
+
+#[derive(Clone, Copy)]
+pub enum Measure {
+    Ks {
+        params: KeyswitchParameters,
+        time: f64,
+    },
+    Pbs {
+        params: PbsParameters,
+        time: f64,
+    },
+    Levelled {
+        lwe_dimension: LweDimension,
+        time: f64,
+    },
+}
+
+#[derive(Clone, Default)]
+pub struct CpuProfile {
+    pub measures: Vec<Measure>,
+}
+
+/** Factors applied to the analytic costs of the operations, relatively to the pbs */
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct CostFactors {
+    pub ks: f64,
+    pub pbs: f64,
+    pub levelled: f64,
+}
+
+impl Default for CostFactors {
+    fn default() -> Self {
+        Self {
+            ks: 1.0,
+            pbs: 1.0,
+            levelled: 1.0,
+        }
+    }
+}
+
+fn parse_values<const N: usize>(fields: &[&str], line: &str) -> Result<[f64; N], String> {
+    if fields.len() != N {
+        return Err(format!("expected {N} values in '{line}'"));
+    }
+    let mut values = [0.0; N];
+    for (value, field) in values.iter_mut().zip(fields) {
+        let parsed: f64 = field
+            .parse()
+            .map_err(|_| format!("invalid value '{field}' in '{line}'"))?;
+        if !parsed.is_finite() || parsed <= 0.0 {
+            return Err(format!("non positive value '{field}' in '{line}'"));
+        }
+        *value = parsed;
+    }
+    Ok(values)
+}
+
+impl CpuProfile {
+    pub fn parse(content: &str) -> Result<Self, String> {
+        let mut measures = vec![];
+        for line in content.lines() {
+            let line = line.split('#').next().unwrap_or_default().trim();
+            if line.is_empty() {
+                continue;
+            }
+            let fields: Vec<&str> = line.split_whitespace().collect();
+            let measure = match fields[0] {
+                "ks" => {
+                    let [input_dim, output_dim, level, time] = parse_values(&fields[1..], line)?;
+                    Measure::Ks {
+                        params: KeyswitchParameters {
+                            input_lwe_dimension: LweDimension(input_dim as u64),
+                            output_lwe_dimension: LweDimension(output_dim as u64),
+                            ks_decomposition_parameter: KsDecompositionParameters {
+                                level: level as u64,
+                                log2_base: IGNORED_LOG2_BASE,
+                            },
+                        },
+                        time,
+                    }
+                }
+                "pbs" => {
+                    let [internal_dim, glwe_dimension, log2_polynomial_size, level, time] =
+                        parse_values(&fields[1..], line)?;
+                    Measure::Pbs {
+                        params: PbsParameters {
+                            internal_lwe_dimension: LweDimension(internal_dim as u64),
+                            br_decomposition_parameter: BrDecompositionParameters {
+                                level: level as u64,
+                                log2_base: IGNORED_LOG2_BASE,
+                            },
+                            output_glwe_params: GlweParameters {
+                                log2_polynomial_size: log2_polynomial_size as u64,
+                                glwe_dimension: glwe_dimension as u64,
+                            },
+                        },
+                        time,
+                    }
+                }
+                "levelled" => {
+                    let [lwe_dimension, time] = parse_values(&fields[1..], line)?;
+                    Measure::Levelled {
+                        lwe_dimension: LweDimension(lwe_dimension as u64),
+                        time,
+                    }
+                }
+                operation => return Err(format!("unknown operation '{operation}'")),
+            };
+            measures.push(measure);
+        }
+        Ok(Self { measures })
+    }
+
+    pub fn read(path: impl AsRef<Path>) -> Result<Self, String> {
+        let path = path.as_ref();
+        let content = std::fs::read_to_string(path)
+            .map_err(|err| format!("cannot read {}: {err}", path.display()))?;
+        Self::parse(&content)
+    }
+
+    // Each factor is the geometric mean of the ratios between the measured and the analytic
+    // costs of an operation, so that all the measures have the same weight whatever their scale.
+    pub fn cost_factors(
+        &self,
+        ks: &KsComplexity,
+        pbs: &PbsComplexity,
+    ) -> Result<CostFactors, String> {
+        const CIPHERTEXT_MODULUS_LOG: u32 = 64;
+        let mut log_ratios = [(0.0, 0); 3];
+        for measure in &self.measures {
+            let (i, time, analytic): (usize, f64, Complexity) = match *measure {
+                Measure::Ks { params, time } => {
+                    (0, time, ks.complexity(params, CIPHERTEXT_MODULUS_LOG))
+                }
+                Measure::Pbs { params, time } => {
+                    (1, time, pbs.complexity(params, CIPHERTEXT_MODULUS_LOG))
+                }
+                Measure::Levelled {
+                    lwe_dimension,
+                    time,
+                } => (2, time, lwe_dimension.0 as f64),
+            };
+            log_ratios[i].0 += (time / analytic).ln();
+            log_ratios[i].1 += 1;
+        }
+        let mut factors = [0.0; 3];
+        for ((factor, (sum, count)), operation) in factors
+            .iter_mut()
+            .zip(log_ratios)
+            .zip(["ks", "pbs", "levelled"])
+        {
+            if count == 0 {
+                return Err(format!("no {operation} measure in the profile"));
+            }
+            *factor = (sum / count as f64).exp();
+        }
+        let [ks, pbs, levelled] = factors;
+        // Only the relative costs matter, the pbs keeps its analytic cost
+        Ok(CostFactors {
+            ks: ks / pbs,
+            pbs: 1.0,
+            levelled: levelled / pbs,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    #[allow(clippy::float_cmp)]
+    fn parse_profile() {
+        let profile = CpuProfile::parse(
+            "# comment\n\
+             ks 2048 750 3 50000.0\n\
+             \n\
+             pbs 750 1 11 2 8000000 # inline comment\n\
+             levelled 2048 400\n",
+        )
+        .unwrap();
+        assert_eq!(profile.measures.len(), 3);
+        assert!(matches!(
+            profile.measures[1],
+            Measure::Pbs { params, time } if params.output_glwe_params.log2_polynomial_size == 11
+                && params.br_decomposition_parameter.level == 2
+                && time == 8_000_000.0
+        ));
+        assert!(CpuProfile::parse("ks 2048 750 3").is_err());
+        assert!(CpuProfile::parse("ks 2048 750 3 -1.0").is_err());
+        assert!(CpuProfile::parse("fft 1024 10.0").is_err());
+    }
+
+    #[test]
+    fn cost_factors_are_relative_to_pbs() {
+        let ks_complexity = KsComplexity;
+        let pbs_complexity = PbsComplexity::default();
+        let ks_params = KeyswitchParameters {
+            input_lwe_dimension: LweDimension(2048),
+            output_lwe_dimension: LweDimension(750),
+            ks_decomposition_parameter: KsDecompositionParameters {
+                level: 3,
+                log2_base: IGNORED_LOG2_BASE,
+            },
+        };
+        let pbs_params = PbsParameters {
+            internal_lwe_dimension: LweDimension(750),
+            br_decomposition_parameter: BrDecompositionParameters {
+                level: 2,
+                log2_base: IGNORED_LOG2_BASE,
+            },
+            output_glwe_params: GlweParameters {
+                log2_polynomial_size: 11,
+                glwe_dimension: 1,
+            },
+        };
+        let profile = CpuProfile {
+            measures: vec![
+                Measure::Ks {
+                    params: ks_params,
+                    time: 6.0 * ks_complexity.complexity(ks_params, 64),
+                },
+                Measure::Pbs {
+                    params: pbs_params,
+                    time: 2.0 * pbs_complexity.complexity(pbs_params, 64),
+                },
+                Measure::Levelled {
+                    lwe_dimension: LweDimension(2048),
+                    time: 2048.0,
+                },
+            ],
+        };
+        let factors = profile
+            .cost_factors(&ks_complexity, &pbs_complexity)
+            .unwrap();
+        approx::assert_relative_eq!(factors.ks, 3.0, max_relative = 1e-12);
+        approx::assert_relative_eq!(factors.pbs, 1.0);
+        approx::assert_relative_eq!(factors.levelled, 0.5, max_relative = 1e-12);
+
+        let no_ks = CpuProfile {
+            measures: profile.measures[1..].to_vec(),
+        };
+        assert!(no_ks.cost_factors(&ks_complexity, &pbs_complexity).is_err());
+    }
+}
@@ -2,6 +2,7 @@ mod atomic_pattern;
 pub mod complexity;
 pub mod complexity_model;
 pub mod cpu;
+pub mod cpu_profile;
 mod fft;
 pub mod gpu;
 pub mod operators;
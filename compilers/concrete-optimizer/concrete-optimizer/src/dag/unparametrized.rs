@@ -18,6 +18,8 @@ pub struct OperationDag {
     pub(crate) out_precisions: Vec<Precision>,
     // Collect whether operators are tagged as outputs
     pub(crate) output_tags: Vec<bool>,
+    // Collect whether outputs are keyswitched to a smaller key before being returned
+    pub(crate) shrunk_output_tags: Vec<bool>,
 }
 
 impl fmt::Display for OperationDag {
@@ -36,6 +38,7 @@ impl OperationDag {
             out_shapes: vec![],
             out_precisions: vec![],
             output_tags: vec![],
+            shrunk_output_tags: vec![],
         }
     }
 
@@ -46,6 +49,7 @@ impl OperationDag {
         self.out_shapes.push(self.infer_out_shape(&operator));
         self.operators.push(operator);
         self.output_tags.push(false);
+        self.shrunk_output_tags.push(false);
         OperatorIndex { i }
     }
 
@@ -138,6 +142,13 @@ impl OperationDag {
         self.output_tags[operator.i] = true;
     }
 
+    /// Tags an operator as an output which is keyswitched to the small key of its partition
+    /// before being returned, so that the keyswitch is optimized and its noise checked.
+    pub fn tag_operator_as_shrunk_output(&mut self, operator: OperatorIndex) {
+        self.tag_operator_as_output(operator);
+        self.shrunk_output_tags[operator.i] = true;
+    }
+
     #[allow(clippy::len_without_is_empty)]
     pub fn len(&self) -> usize {
         self.operators.len()
@@ -259,6 +270,8 @@ impl OperationDag {
         self.out_precisions.extend(other.out_precisions.iter());
         self.out_shapes.extend(other.out_shapes.iter().cloned());
         self.output_tags.extend(other.output_tags.iter());
+        self.shrunk_output_tags
+            .extend(other.shrunk_output_tags.iter());
         self.operators[length..]
             .iter_mut()
             .for_each(|node| match node {
@@ -318,6 +331,11 @@ impl OperationDag {
         self.output_tags[oid]
     }
 
+    /// Returns whether the node is an output keyswitched to the small key of its partition.
+    pub(crate) fn is_shrunk_output_node(&self, oid: usize) -> bool {
+        self.shrunk_output_tags[oid]
+    }
+
     fn infer_out_shape(&self, op: &UnparameterizedOperator) -> Shape {
         match op {
             Operator::Input { out_shape, .. } | Operator::LevelledOp { out_shape, .. } => {
@@ -379,6 +379,15 @@ fn collect_all_variance_constraints(
         if dag.is_output_node(op_i) {
             let precision = dag.out_precisions[op_i];
             let variance = out_variances[op_i][partition].clone();
+            // A shrunk output is keyswitched to the small key of its partition and modulus
+            // switched before being returned, exactly like a lut input.
+            let variance = if dag.is_shrunk_output_node(op_i) {
+                variance
+                    .after_partition_keyswitch_to_small(partition, partition)
+                    .after_modulus_switching(partition)
+            } else {
+                variance
+            };
             constraints.push(variance_constraint(
                 dag,
                 noise_config,
@@ -395,6 +404,7 @@ fn collect_all_variance_constraints(
 #[allow(clippy::match_on_vec_items)]
 fn operations_counts(
     dag: &unparametrized::OperationDag,
+    op_index: usize,
     op: &unparametrized::UnparameterizedOperator,
     nb_partitions: usize,
     instr_partition: &InstructionPartition,
@@ -413,6 +423,10 @@ fn operations_counts(
             *counts.fks(partition, conv_partition) += nb_lut;
         }
     }
+    if dag.is_shrunk_output_node(op_index) {
+        let partition = instr_partition.instruction_partition;
+        *counts.ks(partition, partition) += dag.out_shapes[op_index].flat_size() as f64;
+    }
     OperationsCount { counts }
 }
 
@@ -424,7 +438,7 @@ fn collect_operations_count(
     dag.operators
         .iter()
         .enumerate()
-        .map(|(i, op)| operations_counts(dag, op, nb_partitions, &instrs_partition[i]))
+        .map(|(i, op)| operations_counts(dag, i, op, nb_partitions, &instrs_partition[i]))
         .collect()
 }
 
@@ -1031,6 +1045,27 @@ pub mod tests {
         );
     }
 
+    #[test]
+    fn test_shrunk_output_keyswitch() {
+        let mut dag = unparametrized::OperationDag::new();
+        let input1 = dag.add_input(2, Shape::number());
+        let lut1 = dag.add_lut(input1, FunctionTable::UNKWOWN, 2);
+        dag.tag_operator_as_shrunk_output(lut1);
+        let dag = analyze(&dag);
+        assert!(dag.nb_partitions == 1);
+        // The output keyswitch is counted with the lut one
+        assert_eq!(
+            dag.operations_count_per_instrs[lut1.i].to_string(),
+            "2¢K[0] + 1¢Br[0]"
+        );
+        // and its noise is checked after the modulus switching
+        let output_constraint = dag.variance_constraints.last().unwrap().to_string();
+        assert!(
+            output_constraint.starts_with("1σ²Br[0] + 1σ²K[0] + 1σ²M[0] <"),
+            "{output_constraint}"
+        );
+    }
+
     #[test]
     fn test_high_partition_number() {
         let mut dag = unparametrized::OperationDag::new();
@@ -1,5 +1,6 @@
 // OPT: cache for fks and verified pareto
 use concrete_cpu_noise_model::gaussian_noise::noise::modulus_switching::estimate_modulus_switching_noise_with_binary_key;
+use rayon::prelude::*;
 
 use crate::dag::unparametrized;
 use crate::noise_estimator::error;
@@ -68,6 +69,31 @@ struct OperationsCV {
     cost: OperationsValue,
 }
 
+// Best parameters found by the search of the macro parameters of a partition
+struct MacroSearch {
+    parameters: Parameters,
+    complexity: f64,
+    p_error: f64,
+    partition_p_error: f64,
+    lb_message: Option<&'static str>,
+}
+
+impl MacroSearch {
+    // Same criterion as the sequential search, which keeps the first best candidate
+    #[allow(clippy::float_cmp)]
+    fn improves(&self, other: &Self) -> bool {
+        match (self.parameters.is_feasible, other.parameters.is_feasible) {
+            (true, true) => {
+                self.complexity < other.complexity
+                    || (self.complexity == other.complexity && self.p_error < other.p_error)
+            }
+            (true, false) => true,
+            (false, true) => false,
+            (false, false) => self.partition_p_error < other.partition_p_error,
+        }
+    }
+}
+
 type KsSrc = usize;
 type KsDst = usize;
 type FksSrc = usize;
@@ -626,7 +652,7 @@ fn optimize_macro(
     used_conversion_keyswitch: &[Vec<bool>],
     feasible: &Feasible,
     complexity: &Complexity,
-    caches: &mut DecompCaches,
+    caches: &mut [DecompCaches],
     init_parameters: &Parameters,
     best_complexity: f64,
     best_p_error: f64,
@@ -642,11 +668,6 @@ fn optimize_macro(
         )
     };
 
-    let mut best_parameters = init_parameters.clone();
-    let mut best_complexity = best_complexity;
-    let mut best_p_error = best_p_error;
-    let mut best_partition_p_error = f64::INFINITY;
-
     let fks_to_optimize = fks_to_optimize(nb_partitions, used_conversion_keyswitch, partition);
     let operations = OperationsCV {
         variance: feasible.zero_variance(),
@@ -654,24 +675,33 @@ fn optimize_macro(
     };
     let partition_feasible = feasible.filter_constraints(partition);
 
-    let glwe_params_domain = search_space.glwe_dimensions.iter().flat_map(|a| {
-        search_space
-            .glwe_log_polynomial_sizes
-            .iter()
-            .map(|b| (*a, *b))
-    });
-    let mut lb_message = None;
-    for (glwe_dimension, log2_polynomial_size) in glwe_params_domain {
-        let glwe_params = GlweParameters {
+    let glwe_params_domain = glwe_params_domain(search_space);
+    assert_eq!(glwe_params_domain.len(), caches.len());
+
+    // Each glwe parameters candidate is searched independently, only pruned by the best solution
+    // known before the search, and with its own caches.
+    let search_glwe_params = |glwe_params: GlweParameters, caches: &mut DecompCaches| {
+        let GlweParameters {
             log2_polynomial_size,
             glwe_dimension,
-        };
+        } = glwe_params;
+        let mut best_parameters = init_parameters.clone();
+        let mut best_complexity = best_complexity;
+        let mut best_p_error = best_p_error;
+        let mut best_partition_p_error = f64::INFINITY;
+        let mut lb_message = None;
 
         let input_variance = glwe_params.minimal_variance(ciphertext_modulus_log, security_level);
         if glwe_dimension == 1 && log2_polynomial_size == 8 {
             // this is insecure and so minimal variance will be above 1
             assert!(input_variance > 1.0);
-            continue;
+            return MacroSearch {
+                parameters: best_parameters,
+                complexity: best_complexity,
+                p_error: best_p_error,
+                partition_p_error: best_partition_p_error,
+                lb_message,
+            };
         }
 
         for &internal_dim in &search_space.internal_lwe_dimensions {
@@ -887,11 +917,54 @@ fn optimize_macro(
                 assert!(best_parameters.is_feasible);
             }
         }
+        MacroSearch {
+            parameters: best_parameters,
+            complexity: best_complexity,
+            p_error: best_p_error,
+            partition_p_error: best_partition_p_error,
+            lb_message,
+        }
+    };
+
+    let searches: Vec<MacroSearch> = glwe_params_domain
+        .par_iter()
+        .zip(caches.par_iter_mut())
+        .map(|(&glwe_params, caches)| search_glwe_params(glwe_params, caches))
+        .collect();
+
+    // Reduced in the order of the domain, so that ties are broken as in a sequential search
+    let mut best = MacroSearch {
+        parameters: init_parameters.clone(),
+        complexity: best_complexity,
+        p_error: best_p_error,
+        partition_p_error: f64::INFINITY,
+        lb_message: None,
+    };
+    for search in searches {
+        if search.improves(&best) {
+            best = search;
+        }
     }
-    if DEBUG && lb_message.is_some() {
-        eprintln!("{}", lb_message.unwrap());
+    if DEBUG && best.lb_message.is_some() {
+        eprintln!("{}", best.lb_message.unwrap());
     }
-    best_parameters
+    best.parameters
+}
+
+fn glwe_params_domain(search_space: &SearchSpace) -> Vec<GlweParameters> {
+    search_space
+        .glwe_dimensions
+        .iter()
+        .flat_map(|&glwe_dimension| {
+            search_space
+                .glwe_log_polynomial_sizes
+                .iter()
+                .map(move |&log2_polynomial_size| GlweParameters {
+                    log2_polynomial_size,
+                    glwe_dimension,
+                })
+        })
+        .collect()
 }
 
 fn cross_partition(nb_partitions: usize) -> impl Iterator<Item = (usize, usize)> {
@@ -921,7 +994,11 @@ pub fn optimize(
     let kappa =
         error::sigma_scale_of_error_probability(config.maximum_acceptable_error_probability);
 
-    let mut caches = persistent_caches.caches();
+    // One set of caches per glwe parameters candidate, searched in parallel
+    let mut caches: Vec<DecompCaches> = glwe_params_domain(search_space)
+        .iter()
+        .map(|_| persistent_caches.caches())
+        .collect();
 
     let feasible = Feasible::of(&dag.variance_constraints, kappa, None).compressed();
     let complexity = Complexity::of(&dag.operations_count).compressed();
@@ -537,6 +537,29 @@ fn test_partition_increasing_chain() {
     test_partition_chain(true);
 }
 
+#[test]
+fn test_parallel_search_is_deterministic() {
+    // the parameters must not depend on the number of threads of the search
+    let mut dag = unparametrized::OperationDag::new();
+    let mut lut_input = dag.add_input(4, Shape::number());
+    for out_precision in 4..=8 {
+        lut_input = dag.add_lut(lut_input, FunctionTable::UNKWOWN, out_precision);
+    }
+    _ = dag.add_lut(lut_input, FunctionTable::UNKWOWN, 4);
+    let p_cut = Some(PartitionCut::for_each_precision(&dag));
+    let sol = optimize(&dag, &p_cut, 0).unwrap();
+    let sequential_pool = rayon::ThreadPoolBuilder::new()
+        .num_threads(1)
+        .build()
+        .unwrap();
+    let sequential_sol = sequential_pool
+        .install(|| optimize(&dag, &p_cut, 0))
+        .unwrap();
+    assert!(sol.complexity == sequential_sol.complexity);
+    assert!(sol.p_error == sequential_sol.p_error);
+    assert!(sol.macro_params == sequential_sol.macro_params);
+}
+
 const MAX_WEIGHT: &[u64] = &[
     // max v0 weight for each precision
     1_073_741_824,
@@ -127,6 +127,8 @@ pub struct OperationDag {
     // Collect all operators ouput variances
     pub out_variances: Vec<SymbolicVariance>,
     pub nb_luts: u64,
+    // Number of ciphertexts keyswitched to the small key before being returned
+    pub nb_shrunk_outputs: u64,
     // The full dag levelled complexity
     pub levelled_complexity: LevelledComplexity,
     // Dominating variances and bounds per precision
@@ -242,6 +244,24 @@ fn in_luts_variance(
         .collect()
 }
 
+// Shrunk outputs are keyswitched and modulus switched like lut inputs.
+// Without any lut there is no small key to shrink to, they are left untouched.
+fn shrunk_outputs_variance(
+    dag: &unparametrized::OperationDag,
+    out_variances: &[SymbolicVariance],
+) -> Vec<(Precision, Shape, SymbolicVariance)> {
+    dag.get_output_index_iter()
+        .filter(|&i| dag.is_shrunk_output_node(i))
+        .map(|i| {
+            (
+                dag.out_precisions[i],
+                dag.out_shapes[i].clone(),
+                out_variances[i],
+            )
+        })
+        .collect()
+}
+
 fn op_levelled_complexity(
     op: &unparametrized::UnparameterizedOperator,
     out_shapes: &[Shape],
@@ -401,8 +421,18 @@ pub fn analyze(
     let dag = &expand_round(dag);
     assert_no_round(dag);
     let out_variances = out_variances(dag);
-    let in_luts_variance = in_luts_variance(dag, &out_variances);
+    let mut in_luts_variance = in_luts_variance(dag, &out_variances);
     let nb_luts = lut_count_from_dag(dag);
+    let shrunk_outputs_variance = if nb_luts > 0 {
+        shrunk_outputs_variance(dag, &out_variances)
+    } else {
+        vec![]
+    };
+    let nb_shrunk_outputs: u64 = shrunk_outputs_variance
+        .iter()
+        .map(|(_precision, shape, _variance)| shape.flat_size())
+        .sum();
+    in_luts_variance.extend(shrunk_outputs_variance);
     let extra_final_variances = extra_final_variances(dag, &out_variances);
     let levelled_complexity = levelled_complexity(dag);
     let constraints_by_precisions = constraints_by_precisions(
@@ -415,6 +445,7 @@ pub fn analyze(
         operators: dag.operators.clone(),
         out_variances,
         nb_luts,
+        nb_shrunk_outputs,
         levelled_complexity,
         constraints_by_precisions,
     };
@@ -600,6 +631,10 @@ impl OperationDag {
         luts_cost + levelled_cost
     }
 
+    pub fn shrunk_outputs_complexity(&self, keyswitch_cost: f64) -> f64 {
+        keyswitch_cost * (self.nb_shrunk_outputs as f64)
+    }
+
     pub fn levelled_complexity(&self, input_lwe_dimension: u64) -> f64 {
         self.levelled_complexity.cost(input_lwe_dimension)
     }
@@ -660,6 +695,25 @@ pub mod tests {
         assert!(constraint.pareto_in_lut.is_empty());
     }
 
+    #[test]
+    fn test_1_lut_shrunk_output() {
+        let mut graph = unparametrized::OperationDag::new();
+        let input1 = graph.add_input(1, Shape::number());
+        let lut1 = graph.add_lut(input1, FunctionTable::UNKWOWN, 1);
+        graph.tag_operator_as_shrunk_output(lut1);
+        let analysis = analyze(&graph);
+        assert!(analysis.nb_luts == 1);
+        assert!(analysis.nb_shrunk_outputs == 1);
+        assert_f64_eq(analysis.shrunk_outputs_complexity(10.0), 10.0);
+        // The lut output is keyswitched and modulus switched like the lut input
+        let constraint = analysis.constraint();
+        assert_eq!(constraint.pareto_in_lut.len(), 2);
+        assert!(constraint
+            .pareto_in_lut
+            .iter()
+            .any(|vf| vf.origin() == VO::Lut));
+    }
+
     #[test]
     fn test_1_lut() {
         let mut graph = unparametrized::OperationDag::new();
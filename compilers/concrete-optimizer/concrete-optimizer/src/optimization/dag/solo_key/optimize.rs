@@ -1,5 +1,6 @@
 use concrete_cpu_noise_model::gaussian_noise::noise::modulus_switching::estimate_modulus_switching_noise_with_binary_key;
 use concrete_security_curves::gaussian::security::minimal_variance_lwe;
+use rayon::prelude::*;
 
 use super::analyze;
 use crate::dag::operator::{LevelledComplexity, Precision};
@@ -62,7 +63,8 @@ fn update_best_solution_with_best_decompositions(
         for &ks_quantity in ks_pareto {
             let complexity_keyswitch = ks_quantity.complexity(input_lwe_dimension);
             let one_lut_cost = complexity_keyswitch + pbs_cost;
-            let complexity = dag.complexity(input_lwe_dimension, one_lut_cost);
+            let complexity = dag.complexity(input_lwe_dimension, one_lut_cost)
+                + dag.shrunk_outputs_complexity(complexity_keyswitch);
             let worse_complexity = complexity > best_complexity;
             if worse_complexity {
                 // Since ks_pareto is scanned by increasing complexity, we can stop
@@ -300,8 +302,6 @@ pub fn optimize(
     if dag.nb_luts == 0 {
         return optimize_no_luts(state, &consts, &dag, search_space);
     }
-    let mut caches = persistent_caches.caches();
-
     let noise_modulus_switching = |glwe_log2_poly_size, internal_lwe_dimensions| {
         estimate_modulus_switching_noise_with_binary_key(
             internal_lwe_dimensions,
@@ -314,64 +314,94 @@ pub fn optimize(
         !dag.feasible(input_noise_out, 0.0, 0.0, noise_modulus_switching)
     };
 
-    for &glwe_dim in &search_space.glwe_dimensions {
-        for &glwe_log_poly_size in &search_space.glwe_log_polynomial_sizes {
-            let glwe_params = GlweParameters {
-                log2_polynomial_size: glwe_log_poly_size,
-                glwe_dimension: glwe_dim,
-            };
-            let input_noise_out = minimal_variance(&config, glwe_params);
+    // Each glwe parameters candidate is searched independently, with its own caches
+    let search_glwe_params = |glwe_params: GlweParameters| {
+        let mut state = OptimizationState {
+            best_solution: None,
+        };
+        let mut caches = persistent_caches.caches();
 
-            let cmux_pareto = caches.cmux.pareto_quantities(glwe_params);
+        let input_noise_out = minimal_variance(&config, glwe_params);
 
-            for &internal_dim in &search_space.internal_lwe_dimensions {
-                let ks_pareto = caches.keyswitch.pareto_quantities(internal_dim);
+        let cmux_pareto = caches.cmux.pareto_quantities(glwe_params);
 
-                let noise_modulus_switching =
-                    noise_modulus_switching(glwe_log_poly_size, internal_dim);
-                if not_feasible(input_noise_out, noise_modulus_switching) {
-                    // noise_modulus_switching is increasing with internal_dim
-                    break;
-                }
-                if too_complex_macro_parameters(
-                    &state,
-                    &dag,
-                    internal_dim,
-                    glwe_params,
-                    cmux_pareto,
-                    ks_pareto,
-                ) {
-                    break;
-                }
-                if not_feasible_macro_parameters(
-                    &dag,
-                    internal_dim,
-                    input_noise_out,
-                    noise_modulus_switching,
-                    cmux_pareto,
-                    ks_pareto,
-                ) {
-                    continue;
-                }
-                update_best_solution_with_best_decompositions(
-                    &mut state,
-                    &consts,
-                    &dag,
-                    internal_dim,
-                    glwe_params,
-                    input_noise_out,
-                    noise_modulus_switching,
-                    cmux_pareto,
-                    ks_pareto,
-                );
-                if dag.nb_luts == 0 && state.best_solution.is_some() {
-                    return state;
-                }
+        for &internal_dim in &search_space.internal_lwe_dimensions {
+            let ks_pareto = caches.keyswitch.pareto_quantities(internal_dim);
+
+            let noise_modulus_switching =
+                noise_modulus_switching(glwe_params.log2_polynomial_size, internal_dim);
+            if not_feasible(input_noise_out, noise_modulus_switching) {
+                // noise_modulus_switching is increasing with internal_dim
+                break;
+            }
+            if too_complex_macro_parameters(
+                &state,
+                &dag,
+                internal_dim,
+                glwe_params,
+                cmux_pareto,
+                ks_pareto,
+            ) {
+                break;
             }
+            if not_feasible_macro_parameters(
+                &dag,
+                internal_dim,
+                input_noise_out,
+                noise_modulus_switching,
+                cmux_pareto,
+                ks_pareto,
+            ) {
+                continue;
+            }
+            update_best_solution_with_best_decompositions(
+                &mut state,
+                &consts,
+                &dag,
+                internal_dim,
+                glwe_params,
+                input_noise_out,
+                noise_modulus_switching,
+                cmux_pareto,
+                ks_pareto,
+            );
         }
-    }
 
-    persistent_caches.backport(caches);
+        persistent_caches.backport(caches);
+
+        state.best_solution
+    };
+
+    let glwe_params_domain: Vec<_> = search_space
+        .glwe_dimensions
+        .iter()
+        .flat_map(|&glwe_dimension| {
+            search_space
+                .glwe_log_polynomial_sizes
+                .iter()
+                .map(move |&log2_polynomial_size| GlweParameters {
+                    log2_polynomial_size,
+                    glwe_dimension,
+                })
+        })
+        .collect();
+
+    let solutions: Vec<_> = glwe_params_domain
+        .into_par_iter()
+        .map(search_glwe_params)
+        .collect();
+
+    // Reduced in the order of the domain, so that ties are broken as in a sequential search
+    for solution in solutions.into_iter().flatten() {
+        #[allow(clippy::float_cmp)]
+        let improves = state.best_solution.map_or(true, |best| {
+            solution.complexity < best.complexity
+                || (solution.complexity == best.complexity && solution.p_error < best.p_error)
+        });
+        if improves {
+            state.best_solution = Some(solution);
+        }
+    }
 
     if let Some(sol) = state.best_solution {
         assert!(0.0 <= sol.p_error && sol.p_error <= 1.0);
@@ -21,6 +21,7 @@ fn v0_pbs_optimization(c: &mut Criterion) {
         ciphertext_modulus_log: 64,
         fft_precision: 53,
         composable: false,
+        cpu_cost_profile: None,
     };
 
     c.bench_function("v0 PBS table generation", |b| {
@@ -48,6 +49,7 @@ fn v0_pbs_optimization_simulate_graph(c: &mut Criterion) {
         ciphertext_modulus_log: 64,
         fft_precision: 53,
         composable: false,
+        cpu_cost_profile: None,
     };
 
     c.bench_function("v0 PBS simulate dag table generation", |b| {
@@ -75,6 +77,7 @@ fn v0_wop_pbs_optimization(c: &mut Criterion) {
         ciphertext_modulus_log: 64,
         fft_precision: 53,
         composable: false,
+        cpu_cost_profile: None,
     };
 
     c.bench_function("v0 WoP-PBS table generation", |b| {
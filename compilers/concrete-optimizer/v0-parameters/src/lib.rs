@@ -10,6 +10,7 @@
 
 use clap::Parser;
 use concrete_optimizer::computing_cost::cpu::CpuComplexity;
+use concrete_optimizer::computing_cost::cpu_profile::CpuProfile;
 use concrete_optimizer::config;
 use concrete_optimizer::global_parameters::DEFAUT_DOMAINS;
 use concrete_optimizer::optimization::config::{Config, SearchSpace};
@@ -22,6 +23,7 @@ use concrete_optimizer::optimization::wop_atomic_pattern::optimize as optimize_w
 use concrete_optimizer::optimization::{atomic_pattern as optimize_atomic_pattern, decomposition};
 use rayon_cond::CondIterator;
 use std::io::Write;
+use std::sync::Arc;
 
 pub const _4_SIGMA: f64 = 1.0 - 0.999_936_657_516;
 const MIN_LOG_POLY_SIZE: u64 = DEFAUT_DOMAINS
@@ -95,6 +97,12 @@ pub struct Args {
 
     #[clap(long)]
     pub composable: bool,
+
+    #[clap(
+        long,
+        help = "cost profile of the machine, from the concrete-cpu calibration"
+    )]
+    pub cpu_cost_profile: Option<String>,
 }
 
 pub fn all_results(args: &Args) -> Vec<Vec<Option<Solution>>> {
@@ -102,9 +110,17 @@ pub fn all_results(args: &Args) -> Vec<Vec<Option<Solution>>> {
     let sum_size = args.sum_size;
     let maximum_acceptable_error_probability = args.p_error;
     let security_level = args.security_level;
-    let cache_on_disk = args.cache_on_disk;
     let composable = args.composable;
 
+    let complexity_model = match &args.cpu_cost_profile {
+        Some(path) => CpuProfile::read(path)
+            .and_then(|profile| CpuComplexity::calibrated(&profile))
+            .unwrap_or_else(|err| panic!("Invalid cpu cost profile: {err}")),
+        None => CpuComplexity::default(),
+    };
+    // The caches on disk hold the costs of the default model
+    let cache_on_disk = args.cache_on_disk && args.cpu_cost_profile.is_none();
+
     let search_space = SearchSpace {
         glwe_log_polynomial_sizes: (args.min_log_poly_size..=args.max_log_poly_size).collect(),
         glwe_dimensions: (args.min_glwe_dim..=args.max_glwe_dim).collect(),
@@ -125,14 +141,14 @@ pub fn all_results(args: &Args) -> Vec<Vec<Option<Solution>>> {
         key_sharing: true,
         ciphertext_modulus_log: args.ciphertext_modulus_log,
         fft_precision: args.fft_precision,
-        complexity_model: &CpuComplexity::default(),
+        complexity_model: &complexity_model,
         composable,
     };
 
     let cache = decomposition::cache(
         security_level,
         processing_unit,
-        None,
+        Some(Arc::new(complexity_model.clone())),
         cache_on_disk,
         args.ciphertext_modulus_log,
         args.fft_precision,
@@ -301,6 +317,7 @@ mod tests {
                 ciphertext_modulus_log: 64,
                 fft_precision: 53,
                 composable: false,
+                cpu_cost_profile: None,
             };
 
             let mut actual_output = Vec::<u8>::new();
@@ -346,6 +363,7 @@ mod tests {
                 ciphertext_modulus_log: 64,
                 fft_precision: 53,
                 composable: false,
+                cpu_cost_profile: None,
             };
 
             let mut actual_output = Vec::<u8>::new();